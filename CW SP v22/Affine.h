@@ -0,0 +1,37 @@
+﻿#pragma once
+
+namespace MyShapes {
+
+    // Аффинное преобразование плоскости:
+    //   x' = a * x + b * y + tx
+    //   y' = c * x + d * y + ty
+    // Углы - в градусах, как у Shape::rotate.
+    struct Affine {
+        double a, b, c, d, tx, ty;
+
+        static Affine identity() { return Affine{ 1, 0, 0, 1, 0, 0 }; }
+
+        static Affine translation(double dx, double dy) { return Affine{ 1, 0, 0, 1, dx, dy }; }
+
+        // Поворот вокруг точки, в ту же сторону, что Point::rotateAround
+        static Affine rotation(double centerX, double centerY, double degrees);
+
+        // Отражение относительно вертикальной (vertical = true, меняется x)
+        // или горизонтальной оси через точку, как у Shape::mirror
+        static Affine mirror(double centerX, double centerY, bool vertical);
+
+        // Сначала other, затем this
+        Affine operator*(const Affine& other) const;
+
+        double determinant() const { return a * d - b * c; }
+
+        // Обратное преобразование; матрица должна быть невырожденной
+        Affine inverse() const;
+
+        void apply(double x, double y, double& outX, double& outY) const {
+            outX = a * x + b * y + tx;
+            outY = c * x + d * y + ty;
+        }
+    };
+
+}
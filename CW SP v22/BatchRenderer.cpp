@@ -0,0 +1,101 @@
+﻿#include "BatchRenderer.h"
+
+namespace MyShapes {
+
+    BatchRenderer::BatchRenderer(Renderer& target)
+        : target(target), pen(0), hasPen(false), targetPen(0), hasTargetPen(false), batchCount(0), vertexCount(0) {
+        // Пакет не растёт по ходу отрисовки: память берётся один раз
+        vertices.reserve(MaxBatchVertices);
+        counts.reserve(MaxBatchVertices / 2);
+    }
+
+    BatchRenderer::~BatchRenderer() {
+        flush();
+    }
+
+    void BatchRenderer::flush() {
+        if (counts.empty()) return;
+
+        selectPen();
+        target.polyPolyline(vertices.data(), counts.data(), (int)counts.size());
+
+        ++batchCount;
+        vertexCount += vertices.size();
+        vertices.clear();
+        counts.clear();
+    }
+
+    void BatchRenderer::selectPen() {
+        if (!hasPen || (hasTargetPen && targetPen == pen)) return;
+        target.setPen(pen);
+        targetPen = pen;
+        hasTargetPen = true;
+    }
+
+    void BatchRenderer::prepareDirect() {
+        flush();
+        selectPen();
+    }
+
+    void BatchRenderer::setPen(const Pen& newPen) {
+        if (hasPen && newPen == pen) return;
+
+        flush();
+        pen = newPen;
+        hasPen = true;
+    }
+
+    void BatchRenderer::pixel(int x, int y, Color color) {
+        prepareDirect();
+        target.pixel(x, y, color);
+    }
+
+    void BatchRenderer::line(int x1, int y1, int x2, int y2) {
+        // Продолжаем ломаную, если отрезок начинается в её последней вершине:
+        // пиксели те же, что у пары отдельных MoveToEx/LineTo
+        if (!counts.empty() && vertices.back().x == x1 && vertices.back().y == y1) {
+            vertices.push_back(Vertex{ x2, y2 });
+            ++counts.back();
+            return;
+        }
+
+        if (vertices.size() + 2 > MaxBatchVertices) {
+            flush();
+        }
+        vertices.push_back(Vertex{ x1, y1 });
+        vertices.push_back(Vertex{ x2, y2 });
+        counts.push_back(2);
+    }
+
+    void BatchRenderer::polyPolyline(const Vertex* source, const uint32_t* sourceCounts, int polylineCount) {
+        for (int i = 0; i < polylineCount; ++i) {
+            if (sourceCounts[i] >= PassThroughVertices) {
+                // Вершины уже подряд: копия ничего не сэкономит
+                prepareDirect();
+                target.polyPolyline(source, sourceCounts + i, 1);
+                ++batchCount;
+                vertexCount += sourceCounts[i];
+                source += sourceCounts[i];
+                continue;
+            }
+            if (vertices.size() + sourceCounts[i] > MaxBatchVertices) {
+                flush();
+            }
+            vertices.insert(vertices.end(), source, source + sourceCounts[i]);
+            counts.push_back(sourceCounts[i]);
+            source += sourceCounts[i];
+        }
+    }
+
+    void BatchRenderer::ellipse(int left, int top, int right, int bottom) {
+        prepareDirect();
+        target.ellipse(left, top, right, bottom);
+    }
+
+    void BatchRenderer::arc(int left, int top, int right, int bottom,
+        int xStart, int yStart, int xEnd, int yEnd) {
+        prepareDirect();
+        target.arc(left, top, right, bottom, xStart, yStart, xEnd, yEnd);
+    }
+
+}
@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Renderer.h"
+
+namespace MyShapes {
+
+    // Рендерер-прослойка, собирающий отрезки в пакеты ломаных.
+    // Отрезок, начинающийся в конце предыдущего, продолжает текущую ломаную,
+    // поэтому Line, Polyline, Polygon, Triangle и Parallelogram превращаются
+    // в ломаные без изменения их draw. Ломаные одного пера копятся в общих
+    // массивах и уходят в target одним вызовом polyPolyline. Пакет сбрасывается
+    // при смене пера, перед эллипсами, дугами и точками (порядок отрисовки
+    // сохраняется) и в деструкторе. Длинная ломаная, которая уже лежит подряд
+    // (polyPolyline из SceneStore или SceneFile), уходит в target без копии.
+    //
+    // Выигрыш - для target, у которого дорог каждый вызов: GdiRenderer
+    // отдаёт MoveToEx/LineTo в gdi32 по одному. Программному растеризатору
+    // и счётчикам пакет ничего не экономит: отрезки он всё равно разбирает
+    // по одному, и прослойка для него - лишняя работа.
+    class BatchRenderer : public Renderer {
+    public:
+        // Больше вершин в одном пакете не копим
+        static const size_t MaxBatchVertices = 16384;
+
+        // Ломаная из стольких вершин и больше не копируется в пакет
+        static const uint32_t PassThroughVertices = 64;
+
+        explicit BatchRenderer(Renderer& target);
+        ~BatchRenderer();
+
+        BatchRenderer(const BatchRenderer&) = delete;
+        BatchRenderer& operator=(const BatchRenderer&) = delete;
+
+        // Отдаёт накопленные ломаные в target
+        void flush();
+
+        using Renderer::setPen;
+        void setPen(const Pen& pen) override;
+        void pixel(int x, int y, Color color) override;
+        void line(int x1, int y1, int x2, int y2) override;
+        void polyPolyline(const Vertex* vertices, const uint32_t* counts, int polylineCount) override;
+        void ellipse(int left, int top, int right, int bottom) override;
+        void arc(int left, int top, int right, int bottom,
+            int xStart, int yStart, int xEnd, int yEnd) override;
+
+        // Статистика: сколько пакетов и вершин отдано в target
+        long long getBatchCount() const { return batchCount; }
+        long long getVertexCount() const { return vertexCount; }
+
+    private:
+        Renderer& target;
+        Pen pen;
+        bool hasPen;
+        Pen targetPen;      // Перо, уже выбранное в target
+        bool hasTargetPen;
+
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> counts;
+
+        long long batchCount;
+        long long vertexCount;
+
+        // Выбор текущего пера в target, если там выбрано другое
+        void selectPen();
+        // Сброс пакета и выбор текущего пера в target перед прямым вызовом
+        void prepareDirect();
+    };
+
+}
@@ -0,0 +1,471 @@
+﻿#include "EditJournal.h"
+
+#include <algorithm>
+
+namespace MyShapes {
+
+    namespace {
+
+        bool isPolyline(ShapeKind kind) {
+            return kind == ShapeKind::Polyline || kind == ShapeKind::Polygon ||
+                kind == ShapeKind::Triangle || kind == ShapeKind::Parallelogram;
+        }
+
+        // Примерная память фигуры, которую держит запись удаления
+        std::vector<Shape*> shapesOf(const std::vector<Scene::Detached>& detached) {
+            std::vector<Shape*> shapes;
+            shapes.reserve(detached.size());
+            for (const Scene::Detached& d : detached) shapes.push_back(d.shape);
+            return shapes;
+        }
+
+        size_t footprint(const Shape* shape) {
+            size_t bytes = 64;
+            if (isPolyline(shape->kind())) {
+                bytes += static_cast<const Polyline*>(shape)->points.capacity() * sizeof(Point);
+            }
+            return bytes;
+        }
+
+        // Коды поправок: 0, +1, -1 и «значение в списке исключений»
+        const uint8_t CodeZero = 0, CodePlus = 1, CodeMinus = 2, CodeListed = 3;
+
+    }
+
+    // ---------------------------------------------------------------- Residual
+
+    void EditJournal::Residual::build(const Vertex* expected, const Vertex* actual, size_t count) {
+        codes.clear();
+        exceptions.clear();
+
+        size_t i = 0;
+        while (i < count && expected[i].x == actual[i].x && expected[i].y == actual[i].y) ++i;
+        if (i == count) return;  // Округление ничего не испортило: поправок нет
+
+        codes.assign((2 * count + 3) / 4, 0);
+        for (; i < count; ++i) {
+            int32_t delta[2] = { expected[i].x - actual[i].x, expected[i].y - actual[i].y };
+            for (int k = 0; k < 2; ++k) {
+                uint8_t code = CodeZero;
+                if (delta[k] == 1) code = CodePlus;
+                else if (delta[k] == -1) code = CodeMinus;
+                else if (delta[k] != 0) {
+                    code = CodeListed;
+                    exceptions.push_back(delta[k]);
+                }
+                size_t at = 2 * i + k;
+                codes[at / 4] |= (uint8_t)(code << (2 * (at % 4)));
+            }
+        }
+        codes.shrink_to_fit();
+        exceptions.shrink_to_fit();
+    }
+
+    void EditJournal::Residual::apply(Vertex* vertices, size_t count) const {
+        if (codes.empty()) return;
+
+        size_t listed = 0;
+        for (size_t i = 0; i < count; ++i) {
+            // Нулевой байт - четыре координаты без поправок
+            uint8_t byte = codes[i / 2];
+            if (byte == 0 && i % 2 == 0) {
+                ++i;
+                continue;
+            }
+            int32_t* coordinate[2] = { &vertices[i].x, &vertices[i].y };
+            for (int k = 0; k < 2; ++k) {
+                size_t at = 2 * i + k;
+                uint8_t code = (codes[at / 4] >> (2 * (at % 4))) & 3;
+                if (code == CodePlus) *coordinate[k] += 1;
+                else if (code == CodeMinus) *coordinate[k] -= 1;
+                else if (code == CodeListed) *coordinate[k] += exceptions[listed++];
+            }
+        }
+    }
+
+    size_t EditJournal::Residual::bytes() const {
+        return codes.capacity() + exceptions.capacity() * sizeof(int32_t);
+    }
+
+    // ---------------------------------------------------------------- EditJournal
+
+    EditJournal::EditJournal(Scene& scene, size_t memoryLimit)
+        : scene(scene), limit(memoryLimit) {}
+
+    EditJournal::~EditJournal() {
+        clear();
+    }
+
+    void EditJournal::add(Shape* shape) {
+        add(std::vector<Shape*>(1, shape));
+    }
+
+    void EditJournal::add(const std::vector<Shape*>& shapes) {
+        if (shapes.empty()) return;
+
+        Edit edit;
+        edit.kind = Kind::Add;
+        edit.shapes = shapes;
+        edit.bytes = sizeof(Edit) + shapes.size() * (sizeof(Shape*) + sizeof(Scene::Detached));
+        push(std::move(edit));
+    }
+
+    void EditJournal::transform(const std::vector<Shape*>& shapes, const Affine& m) {
+        if (shapes.empty()) return;
+
+        Edit edit;
+        edit.kind = Kind::Transform;
+        edit.shapes = shapes;
+        edit.matrix = m;
+
+        writeAnchors(shapes, before);
+        writeAngles(shapes, edit.angles);
+        batch.apply(shapes, m);
+        updateAll(shapes);
+        writeAnchors(shapes, after);
+        writeAngles(shapes, edit.angles);
+
+        // Вперёд: чем m от старых точек отличается от новых (у фигур
+        // в режиме точности, которые считаются от исходной геометрии).
+        // Назад: чем обратная матрица от новых точек отличается от старых.
+        std::vector<Vertex> rounded(before);
+        transformVertices(m, rounded.data(), rounded.size());
+        edit.forward.build(after.data(), rounded.data(), after.size());
+
+        rounded = after;
+        transformVertices(m.inverse(), rounded.data(), rounded.size());
+        edit.backward.build(before.data(), rounded.data(), before.size());
+
+        edit.angles.shrink_to_fit();
+        edit.bytes = sizeof(Edit) + shapes.size() * sizeof(Shape*) + edit.angles.capacity() * sizeof(double) +
+            edit.forward.bytes() + edit.backward.bytes();
+        push(std::move(edit));
+    }
+
+    void EditJournal::trim(const std::vector<Shape*>& shapes, const Point& start, const Point& end) {
+        Edit edit;
+        edit.kind = Kind::Trim;
+        edit.trimStart = start;
+        edit.trimEnd = end;
+        edit.bytes = sizeof(Edit);
+
+        std::vector<Vertex> old, now;
+        std::vector<double> oldAngles, nowAngles;
+        std::vector<Shape*> replaced, pieces, single;
+        for (Shape* shape : shapes) {
+            ShapeKind kind = shape->kind();
+            if (kind == ShapeKind::Point) continue;
+
+            // Круг, кольцо, треугольник: фигура уступает место кускам
+            size_t piecesBefore = pieces.size();
+            if (shape->trimPieces(start, end, pieces)) {
+                replaced.push_back(shape);
+                edit.bytes += sizeof(Scene::Detached) + footprint(shape);
+                for (size_t i = piecesBefore; i < pieces.size(); ++i) {
+                    scene.add(pieces[i]);
+                    edit.pieces.push_back(Scene::Detached{ pieces[i], 0, false });
+                    edit.bytes += sizeof(Scene::Detached) + footprint(pieces[i]);
+                }
+                continue;
+            }
+
+            if (!isPolyline(kind)) {
+                // Отрезок, дуга: копия до обрезки нужна, только если обрезка
+                // что-то изменила. Её собирают из запомненных точек и углов.
+                single.assign(1, shape);
+                writeAnchors(single, old);
+                oldAngles.clear();
+                writeAngles(single, oldAngles);
+                shape->trim(start, end);
+                writeAnchors(single, now);
+                nowAngles.clear();
+                writeAngles(single, nowAngles);
+                bool changed = oldAngles != nowAngles || !std::equal(old.begin(), old.end(), now.begin(), now.end(),
+                    [](const Vertex& a, const Vertex& b) { return a.x == b.x && a.y == b.y; });
+                if (!changed) continue;
+
+                Shape* original = shape->copy();
+                original->readAnchors(old.data(), Affine::identity());
+                single.assign(1, original);
+                readAngles(single, oldAngles.data());
+                edit.originals.emplace_back(original);
+                edit.shapes.push_back(shape);
+                edit.bytes += sizeof(Shape*) + footprint(shape);
+                scene.update(shape);
+                continue;
+            }
+
+            // У ломаной запоминается только участок между общими началом и концом.
+            // Экземпляр, который обрезка задела, после неё хранит свои вершины.
+            old.clear();
+            shape->writeAnchors(old);
+            shape->trim(start, end);
+            now.clear();
+            shape->writeAnchors(now);
+
+            auto same = [](const Vertex& a, const Vertex& b) { return a.x == b.x && a.y == b.y; };
+            size_t common = std::min(old.size(), now.size());
+            size_t prefix = 0;
+            while (prefix < common && same(old[prefix], now[prefix])) ++prefix;
+            size_t suffix = 0;
+            while (suffix < common - prefix && same(old[old.size() - 1 - suffix], now[now.size() - 1 - suffix])) ++suffix;
+            if (prefix == old.size() && prefix == now.size()) continue;  // Обрезка не задела ломаную
+
+            Splice splice;
+            splice.shape = shape;
+            splice.offset = prefix;
+            splice.removed.assign(old.begin() + prefix, old.end() - suffix);
+            splice.inserted.assign(now.begin() + prefix, now.end() - suffix);
+            edit.bytes += sizeof(Splice) + (splice.removed.size() + splice.inserted.size()) * sizeof(Vertex);
+            edit.splices.push_back(std::move(splice));
+            scene.update(shape);
+        }
+
+        scene.detach(replaced, edit.replaced);
+        if (edit.shapes.empty() && edit.splices.empty() && edit.replaced.empty()) return;
+        push(std::move(edit));
+    }
+
+    void EditJournal::remove(const std::vector<Shape*>& shapes) {
+        Edit edit;
+        edit.kind = Kind::Remove;
+        scene.detach(shapes, edit.detached);
+        if (edit.detached.empty()) return;
+
+        edit.bytes = sizeof(Edit) + edit.detached.size() * sizeof(Scene::Detached);
+        for (const Scene::Detached& d : edit.detached) {
+            edit.bytes += footprint(d.shape);
+        }
+        push(std::move(edit));
+    }
+
+    void EditJournal::replace(const std::vector<Shape*>& shapes, const std::vector<Shape*>& pieces) {
+        if (shapes.empty() && pieces.empty()) return;
+
+        Edit edit;
+        edit.kind = Kind::Replace;
+        scene.detach(shapes, edit.replaced);
+        edit.bytes = sizeof(Edit) + (edit.replaced.size() + pieces.size()) * sizeof(Scene::Detached);
+        for (const Scene::Detached& d : edit.replaced) {
+            edit.bytes += footprint(d.shape);
+        }
+        for (Shape* piece : pieces) {
+            scene.add(piece);
+            edit.pieces.push_back(Scene::Detached{ piece, 0, false });
+            edit.bytes += footprint(piece);
+        }
+        push(std::move(edit));
+    }
+
+    void EditJournal::undo() {
+        if (!canUndo()) return;
+
+        Edit& edit = edits[--applied];
+        switch (edit.kind) {
+        case Kind::Add:
+            scene.detach(edit.shapes, edit.detached);
+            break;
+        case Kind::Remove:
+            scene.restore(edit.detached);
+            break;
+        case Kind::Transform:
+            transformBack(edit);
+            break;
+        case Kind::Trim:
+        case Kind::Replace:
+            spliceBack(edit);
+            break;
+        }
+    }
+
+    void EditJournal::redo() {
+        if (!canRedo()) return;
+
+        Edit& edit = edits[applied++];
+        switch (edit.kind) {
+        case Kind::Add:
+            scene.restore(edit.detached);
+            break;
+        case Kind::Remove:
+            scene.detach(shapesOf(edit.detached), edit.detached);
+            break;
+        case Kind::Transform:
+            transformAgain(edit);
+            break;
+        case Kind::Trim:
+        case Kind::Replace:
+            spliceAgain(edit);
+            break;
+        }
+    }
+
+    void EditJournal::clear() {
+        for (size_t i = 0; i < edits.size(); ++i) {
+            release(edits[i], i < applied);
+        }
+        edits.clear();
+        applied = 0;
+        used = 0;
+    }
+
+    void EditJournal::push(Edit&& edit) {
+        // Новая правка отменяет возможность повтора
+        while (edits.size() > applied) {
+            used -= edits.back().bytes;
+            release(edits.back(), false);
+            edits.pop_back();
+        }
+
+        used += edit.bytes;
+        edits.push_back(std::move(edit));
+        ++applied;
+
+        while (used > limit && edits.size() > 1) {
+            used -= edits.front().bytes;
+            release(edits.front(), true);
+            edits.pop_front();
+            --applied;
+        }
+    }
+
+    void EditJournal::release(Edit& edit, bool done) {
+        // Заменённые обрезкой или заменой фигуры или куски вне сцены
+        if (edit.kind == Kind::Trim || edit.kind == Kind::Replace) {
+            for (const Scene::Detached& d : done ? edit.replaced : edit.pieces) {
+                scene.destroy(d);
+            }
+            edit.replaced.clear();
+            edit.pieces.clear();
+            return;
+        }
+
+        // Фигурами вне сцены владеет запись: выполненное удаление
+        // или отменённое добавление
+        bool owns = (edit.kind == Kind::Remove && done) || (edit.kind == Kind::Add && !done);
+        if (!owns) return;
+        for (const Scene::Detached& d : edit.detached) {
+            scene.destroy(d);
+        }
+        edit.detached.clear();
+    }
+
+    void EditJournal::transformBack(Edit& edit) {
+        Affine inverse = edit.matrix.inverse();
+        writeAnchors(edit.shapes, before);
+        transformVertices(inverse, before.data(), before.size());
+        edit.backward.apply(before.data(), before.size());
+
+        const Vertex* next = before.data();
+        for (Shape* shape : edit.shapes) {
+            next = shape->readAnchors(next, inverse);
+        }
+        readAngles(edit.shapes, edit.angles.data());
+        updateAll(edit.shapes);
+    }
+
+    void EditJournal::transformAgain(Edit& edit) {
+        writeAnchors(edit.shapes, after);
+        transformVertices(edit.matrix, after.data(), after.size());
+        edit.forward.apply(after.data(), after.size());
+
+        const Vertex* next = after.data();
+        for (Shape* shape : edit.shapes) {
+            next = shape->readAnchors(next, edit.matrix);
+        }
+        readAngles(edit.shapes, edit.angles.data() + edit.angles.size() / 2);
+        updateAll(edit.shapes);
+    }
+
+    void EditJournal::spliceBack(Edit& edit) {
+        for (auto splice = edit.splices.rbegin(); splice != edit.splices.rend(); ++splice) {
+            Polyline* polyline = static_cast<Polyline*>(splice->shape);
+            std::pmr::vector<Point>& points = polyline->points;
+            auto at = points.begin() + splice->offset;
+            at = points.erase(at, at + splice->inserted.size());
+            points.insert(at, splice->removed.size(), Point());
+            for (size_t i = 0; i < splice->removed.size(); ++i) {
+                Point& p = points[splice->offset + i];
+                p.x = splice->removed[i].x;
+                p.y = splice->removed[i].y;
+            }
+            polyline->markDirty();
+            scene.update(polyline);
+        }
+
+        std::vector<Vertex> anchors;
+        for (size_t i = 0; i < edit.shapes.size(); ++i) {
+            CachedBoundsShape* shape = static_cast<CachedBoundsShape*>(edit.shapes[i]);
+            const Shape& original = *edit.originals[i];
+            anchors.clear();
+            original.writeAnchors(anchors);
+            shape->readAnchors(anchors.data(), Affine::identity());
+            shape->restoreParameters(original);
+            shape->markDirty();
+            scene.update(shape);
+        }
+
+        scene.detach(shapesOf(edit.pieces), edit.pieces);
+        scene.restore(edit.replaced);
+    }
+
+    void EditJournal::spliceAgain(Edit& edit) {
+        for (Splice& splice : edit.splices) {
+            Polyline* polyline = static_cast<Polyline*>(splice.shape);
+            std::pmr::vector<Point>& points = polyline->points;
+            auto at = points.begin() + splice.offset;
+            at = points.erase(at, at + splice.removed.size());
+            points.insert(at, splice.inserted.size(), Point());
+            for (size_t i = 0; i < splice.inserted.size(); ++i) {
+                Point& p = points[splice.offset + i];
+                p.x = splice.inserted[i].x;
+                p.y = splice.inserted[i].y;
+            }
+            polyline->markDirty();
+            scene.update(polyline);
+        }
+
+        // Обрезка остальных фигур повторяется: она зависит только от отрезка
+        for (Shape* shape : edit.shapes) {
+            shape->trim(edit.trimStart, edit.trimEnd);
+            scene.update(shape);
+        }
+
+        scene.detach(shapesOf(edit.replaced), edit.replaced);
+        scene.restore(edit.pieces);
+    }
+
+    void EditJournal::updateAll(const std::vector<Shape*>& shapes) {
+        for (Shape* shape : shapes) {
+            scene.update(shape);
+        }
+    }
+
+    void EditJournal::writeAnchors(const std::vector<Shape*>& shapes, std::vector<Vertex>& anchors) const {
+        anchors.clear();
+        for (Shape* shape : shapes) {
+            shape->writeAnchors(anchors);
+        }
+    }
+
+    void EditJournal::writeAngles(const std::vector<Shape*>& shapes, std::vector<double>& angles) const {
+        for (Shape* shape : shapes) {
+            if (shape->kind() == ShapeKind::Arc) {
+                const Arc* arc = static_cast<const Arc*>(shape);
+                angles.push_back(arc->startAngle);
+                angles.push_back(arc->endAngle);
+            }
+        }
+    }
+
+    void EditJournal::readAngles(const std::vector<Shape*>& shapes, const double* angles) const {
+        for (Shape* shape : shapes) {
+            if (shape->kind() == ShapeKind::Arc) {
+                Arc* arc = static_cast<Arc*>(shape);
+                arc->startAngle = *angles++;
+                arc->endAngle = *angles++;
+                arc->markDirty();
+            }
+        }
+    }
+
+}
@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "Affine.h"
+#include "Scene.h"
+#include "Transform.h"
+
+namespace MyShapes {
+
+    // Журнал правок документа для отмены и повтора. Правки выполняются
+    // через журнал, и он сразу записывает их разницей, а не копией фигур:
+    //
+    //   add, remove - фигуры снимаются со сцены (Scene::detach), а не
+    //                 освобождаются, и лежат в записи до её вытеснения;
+    //   transform   - матрица и поправки к округлению по 2 бита на
+    //                 координату: отмена применяет обратную матрицу и
+    //                 возвращает опорные точки точно на место. Поправки,
+    //                 равные нулю везде, не хранятся; углы дуг хранятся
+    //                 как есть. Радиусы не записываются: журнал рассчитан
+    //                 на сдвиг, поворот и отражение, как в редакторе;
+    //   trim        - у ломаных только изменённый участок вершин (общие
+    //                 начало и конец отбрасываются), у остальных фигур -
+    //                 копия до обрезки, а повтор обрезает заново. Фигуры,
+    //                 которые обрезка заменила кусками (Shape::trimPieces),
+    //                 снимаются со сцены, как при remove, а куски - как при add;
+    //   replace     - то же без обрезки: фигуры, заменённые готовыми
+    //                 (булевы операции PolygonBoolean.h), и замена.
+    //
+    // Отмена и повтор стоят столько же, сколько сама правка. Память записей
+    // ограничена memoryLimit: старые записи вытесняются, последняя
+    // остаётся всегда.
+    class EditJournal {
+    public:
+        explicit EditJournal(Scene& scene, size_t memoryLimit = 64 * 1024 * 1024);
+        ~EditJournal();
+
+        EditJournal(const EditJournal&) = delete;
+        EditJournal& operator=(const EditJournal&) = delete;
+
+        // Записывает фигуры, уже добавленные в сцену
+        void add(Shape* shape);
+        void add(const std::vector<Shape*>& shapes);
+
+        // Выполняют правку и записывают её. Обрезка, которая ничего
+        // не изменила, не записывается.
+        void transform(const std::vector<Shape*>& shapes, const Affine& m);
+        void trim(const std::vector<Shape*>& shapes, const Point& start, const Point& end);
+        void remove(const std::vector<Shape*>& shapes);
+        // Снимает shapes со сцены и добавляет вместо них pieces (журнал
+        // становится их владельцем). Пустая замена не записывается.
+        void replace(const std::vector<Shape*>& shapes, const std::vector<Shape*>& pieces);
+
+        bool canUndo() const { return applied > 0; }
+        bool canRedo() const { return applied < edits.size(); }
+        void undo();
+        void redo();
+
+        // Забывает историю; должен вызываться до Scene::clear
+        void clear();
+
+        size_t memoryUsed() const { return used; }
+        size_t size() const { return edits.size(); }
+
+    private:
+        // Поправки к округлённым координатам: код 0, +1, -1 или «см. список»
+        // по 2 бита на координату. Пустой codes - поправок нет.
+        struct Residual {
+            std::vector<uint8_t> codes;
+            std::vector<int32_t> exceptions;  // Поправки с кодом «см. список» по порядку
+
+            // Поправки, превращающие actual в expected
+            void build(const Vertex* expected, const Vertex* actual, size_t count);
+            void apply(Vertex* vertices, size_t count) const;
+            size_t bytes() const;
+        };
+
+        // Изменённый обрезкой участок вершин ломаной
+        struct Splice {
+            Shape* shape;
+            size_t offset;
+            std::vector<Vertex> removed, inserted;
+        };
+
+        enum class Kind { Add, Remove, Transform, Trim, Replace };
+
+        struct Edit {
+            Kind kind;
+            std::vector<Shape*> shapes;
+            std::vector<Scene::Detached> detached;  // add, remove: фигуры вне сцены
+
+            Affine matrix;
+            Residual forward, backward;
+            std::vector<double> angles;  // Углы всех дуг до правки, затем после
+
+            std::vector<Splice> splices;
+            std::vector<std::unique_ptr<Shape>> originals;  // Копии до обрезки
+            // Заменённые кусками фигуры (вне сцены, пока правка выполнена)
+            // и сами куски (вне сцены, пока она отменена)
+            std::vector<Scene::Detached> replaced, pieces;
+            Point trimStart, trimEnd;
+
+            size_t bytes = 0;
+        };
+
+        Scene& scene;
+        size_t limit;
+        size_t used = 0;
+        std::deque<Edit> edits;
+        size_t applied = 0;  // Записи [0, applied) выполнены, остальные отменены
+        BatchTransform batch;
+        std::vector<Vertex> before, after;
+
+        void push(Edit&& edit);
+        void release(Edit& edit, bool done);
+        void transformBack(Edit& edit);
+        void transformAgain(Edit& edit);
+        void spliceBack(Edit& edit);
+        void spliceAgain(Edit& edit);
+        void updateAll(const std::vector<Shape*>& shapes);
+        void writeAnchors(const std::vector<Shape*>& shapes, std::vector<Vertex>& anchors) const;
+        void readAngles(const std::vector<Shape*>& shapes, const double* angles) const;
+        void writeAngles(const std::vector<Shape*>& shapes, std::vector<double>& angles) const;
+    };
+
+}
@@ -0,0 +1,86 @@
+﻿#define _CRT_SECURE_NO_WARNINGS
+
+#include "Framebuffer.h"
+
+#include <cstdio>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MYSHAPES_SPAN_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MYSHAPES_SPAN_SSE2
+#endif
+
+namespace MyShapes {
+
+    Framebuffer::Framebuffer(int width, int height, Color background)
+        : width(width), height(height), pixels((size_t)width * height, toPixel(background)) {}
+
+    void Framebuffer::fillSpan(int y, int x0, int x1, Color color) {
+        uint32_t value = toPixel(color);
+        uint32_t* p = row(y) + x0;
+        uint32_t* end = row(y) + x1 + 1;
+
+        // Широкие записи без выравнивания, хвост - по одному пикселю
+#if defined(MYSHAPES_SPAN_AVX)
+        __m256i wide = _mm256_set1_epi32((int)value);
+        for (; end - p >= 8; p += 8) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), wide);
+        }
+#elif defined(MYSHAPES_SPAN_SSE2)
+        __m128i wide = _mm_set1_epi32((int)value);
+        for (; end - p >= 4; p += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), wide);
+        }
+#endif
+        for (; p < end; ++p) {
+            *p = value;
+        }
+    }
+
+    void Framebuffer::clear(Color color) {
+        for (int y = 0; y < height; ++y) {
+            fillSpan(y, 0, width - 1, color);
+        }
+    }
+
+    uint64_t Framebuffer::checksum() const {
+        return checksum(getBounds());
+    }
+
+    uint64_t Framebuffer::checksum(const Rect& area) const {
+        Rect r = intersectionOf(area, getBounds());
+        uint64_t hash = 14695981039346656037ull;
+        for (int y = r.top; y <= r.bottom; ++y) {
+            const uint32_t* p = row(y);
+            for (int x = r.left; x <= r.right; ++x) {
+                // Побайтно R, G, B, A - не зависит от порядка байт платформы
+                uint32_t v = p[x];
+                for (int shift = 0; shift < 32; shift += 8) {
+                    hash = (hash ^ ((v >> shift) & 0xFF)) * 1099511628211ull;
+                }
+            }
+        }
+        return hash;
+    }
+
+    bool Framebuffer::writePpm(const std::string& path) const {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) return false;
+
+        fprintf(file, "P6\n%d %d\n255\n", width, height);
+        std::vector<unsigned char> line((size_t)width * 3);
+        for (int y = 0; y < height; ++y) {
+            const uint32_t* p = row(y);
+            for (int x = 0; x < width; ++x) {
+                line[x * 3 + 0] = (unsigned char)colorRed(p[x]);
+                line[x * 3 + 1] = (unsigned char)colorGreen(p[x]);
+                line[x * 3 + 2] = (unsigned char)colorBlue(p[x]);
+            }
+            fwrite(line.data(), 1, line.size(), file);
+        }
+        return fclose(file) == 0;
+    }
+
+}
@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Geometry.h"
+#include "Renderer.h"
+
+namespace MyShapes {
+
+    // Изображение в памяти, 4 байта на пиксель в порядке R, G, B, A.
+    // Пиксель как uint32_t - это Color с непрозрачной альфой (0xFF000000),
+    // на little-endian это и есть RGBA в памяти.
+    class Framebuffer {
+    public:
+        Framebuffer(int width, int height, Color background = makeColor(255, 255, 255));
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        Rect getBounds() const { return Rect(0, 0, width - 1, height - 1); }
+
+        uint32_t* row(int y) { return &pixels[(size_t)y * width]; }
+        const uint32_t* row(int y) const { return &pixels[(size_t)y * width]; }
+        const uint32_t* data() const { return pixels.data(); }
+
+        static uint32_t toPixel(Color color) { return color | 0xFF000000u; }
+        static Color toColor(uint32_t pixel) { return pixel & 0x00FFFFFFu; }
+
+        Color get(int x, int y) const { return toColor(row(y)[x]); }
+        void set(int x, int y, Color color) { row(y)[x] = toPixel(color); }
+
+        // Заливка пикселей [x0, x1] строки y; координаты должны лежать в изображении
+        void fillSpan(int y, int x0, int x1, Color color);
+
+        void clear(Color color);
+
+        // FNV-1a по всем пикселям: одинаковые картинки дают одинаковую сумму
+        // на любой платформе, удобно для эталонных изображений
+        uint64_t checksum() const;
+        uint64_t checksum(const Rect& area) const;
+
+        // Сохраняет изображение в формате PPM (P6) для просмотра и миниатюр
+        bool writePpm(const std::string& path) const;
+
+    private:
+        int width, height;
+        std::vector<uint32_t> pixels;
+    };
+
+}
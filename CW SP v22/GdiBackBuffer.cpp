@@ -0,0 +1,83 @@
+﻿#include "GdiBackBuffer.h"
+
+GdiBackBuffer::GdiBackBuffer()
+    : staticDC(NULL), frameDC(NULL), staticBitmap(NULL), frameBitmap(NULL),
+    oldStaticBitmap(NULL), oldFrameBitmap(NULL), width(0), height(0), frameState(0) {}
+
+GdiBackBuffer::~GdiBackBuffer() {
+    release();
+}
+
+void GdiBackBuffer::release() {
+    if (staticDC) {
+        SelectObject(staticDC, oldStaticBitmap);
+        DeleteObject(staticBitmap);
+        DeleteDC(staticDC);
+    }
+    if (frameDC) {
+        SelectObject(frameDC, oldFrameBitmap);
+        DeleteObject(frameBitmap);
+        DeleteDC(frameDC);
+    }
+    staticDC = frameDC = NULL;
+    staticBitmap = frameBitmap = NULL;
+    width = height = 0;
+}
+
+void GdiBackBuffer::ensureSize(HDC windowDC, int newWidth, int newHeight) {
+    if (staticDC && newWidth == width && newHeight == height) return;
+
+    release();
+    width = newWidth > 0 ? newWidth : 1;
+    height = newHeight > 0 ? newHeight : 1;
+
+    staticDC = CreateCompatibleDC(windowDC);
+    staticBitmap = CreateCompatibleBitmap(windowDC, width, height);
+    oldStaticBitmap = SelectObject(staticDC, staticBitmap);
+
+    frameDC = CreateCompatibleDC(windowDC);
+    frameBitmap = CreateCompatibleBitmap(windowDC, width, height);
+    oldFrameBitmap = SelectObject(frameDC, frameBitmap);
+
+    invalidateStatic();
+}
+
+void GdiBackBuffer::invalidateStatic(const RECT& area) {
+    staticDamage.push_back(area);
+}
+
+void GdiBackBuffer::invalidateStatic() {
+    staticDamage.clear();
+    RECT all = { 0, 0, width, height };
+    staticDamage.push_back(all);
+}
+
+void GdiBackBuffer::updateStatic(const std::function<void(HDC hdc, const RECT& area)>& drawArea) {
+    for (const RECT& damaged : staticDamage) {
+        RECT bounds = { 0, 0, width, height };
+        RECT area;
+        if (!IntersectRect(&area, &damaged, &bounds)) continue;
+
+        int state = SaveDC(staticDC);
+        IntersectClipRect(staticDC, area.left, area.top, area.right, area.bottom);
+        FillRect(staticDC, &area, (HBRUSH)(COLOR_WINDOW + 1));
+        drawArea(staticDC, area);
+        RestoreDC(staticDC, state);
+    }
+    staticDamage.clear();
+}
+
+HDC GdiBackBuffer::beginFrame(const RECT& area) {
+    BitBlt(frameDC, area.left, area.top, area.right - area.left, area.bottom - area.top,
+        staticDC, area.left, area.top, SRCCOPY);
+
+    frameState = SaveDC(frameDC);
+    IntersectClipRect(frameDC, area.left, area.top, area.right, area.bottom);
+    return frameDC;
+}
+
+void GdiBackBuffer::present(HDC target, const RECT& area) {
+    RestoreDC(frameDC, frameState);
+    BitBlt(target, area.left, area.top, area.right - area.left, area.bottom - area.top,
+        frameDC, area.left, area.top, SRCCOPY);
+}
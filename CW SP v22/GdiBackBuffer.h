@@ -0,0 +1,56 @@
+﻿#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#include <functional>
+#include <vector>
+
+// Закадровый буфер окна из двух слоёв.
+// Статический слой хранит отрисованные невыделенные фигуры и перерисовывается
+// только в тех областях, где они изменились. Кадр собирается копированием
+// статического слоя и рисованием динамических элементов поверх него
+// (выделенная фигура, строящаяся фигура), а на экран выводится одним BitBlt.
+class GdiBackBuffer {
+private:
+    HDC staticDC;
+    HDC frameDC;
+    HBITMAP staticBitmap;
+    HBITMAP frameBitmap;
+    HGDIOBJ oldStaticBitmap;
+    HGDIOBJ oldFrameBitmap;
+    int width;
+    int height;
+
+    std::vector<RECT> staticDamage; // Области статического слоя, требующие перерисовки
+    int frameState;                 // Результат SaveDC на время сборки кадра
+
+    void release();
+
+public:
+    GdiBackBuffer();
+    ~GdiBackBuffer();
+
+    GdiBackBuffer(const GdiBackBuffer&) = delete;
+    GdiBackBuffer& operator=(const GdiBackBuffer&) = delete;
+
+    // Подгоняет буферы под размер клиентской области.
+    // При пересоздании весь статический слой помечается устаревшим.
+    void ensureSize(HDC windowDC, int newWidth, int newHeight);
+
+    void invalidateStatic(const RECT& area);
+    void invalidateStatic();
+
+    // Перерисовывает устаревшие области статического слоя. drawArea получает
+    // контекст, уже ограниченный областью и залитый фоном.
+    void updateStatic(const std::function<void(HDC hdc, const RECT& area)>& drawArea);
+
+    // Копирует статический слой в кадр и возвращает контекст кадра,
+    // ограниченный областью area, для рисования динамических элементов
+    HDC beginFrame(const RECT& area);
+
+    // Выводит область кадра в окно одним BitBlt
+    void present(HDC target, const RECT& area);
+};
@@ -0,0 +1,42 @@
+﻿#include "GdiObjectCache.h"
+
+GdiObjectCache::~GdiObjectCache() {
+    clear();
+}
+
+uint64_t GdiObjectCache::penKey(const MyShapes::Pen& pen) {
+    return (uint64_t)pen.color | ((uint64_t)(uint16_t)pen.width << 32) | ((uint64_t)pen.style << 48);
+}
+
+HPEN GdiObjectCache::pen(const MyShapes::Pen& pen) {
+    HPEN& cached = pens[penKey(pen)];
+    if (cached == NULL) {
+        int style = PS_SOLID;
+        switch (pen.style) {
+        case MyShapes::PenStyle::Dash: style = PS_DASH; break;
+        case MyShapes::PenStyle::Dot: style = PS_DOT; break;
+        default: break;
+        }
+        cached = CreatePen(style, pen.width, pen.color);
+    }
+    return cached;
+}
+
+HBRUSH GdiObjectCache::brush(MyShapes::Color color) {
+    HBRUSH& cached = brushes[color];
+    if (cached == NULL) {
+        cached = CreateSolidBrush(color);
+    }
+    return cached;
+}
+
+void GdiObjectCache::clear() {
+    for (auto& item : pens) {
+        DeleteObject(item.second);
+    }
+    for (auto& item : brushes) {
+        DeleteObject(item.second);
+    }
+    pens.clear();
+    brushes.clear();
+}
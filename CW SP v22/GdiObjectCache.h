@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "Renderer.h"
+
+// Кэш перьев и кистей GDI. Объект создаётся при первом запросе и живёт,
+// пока жив кэш, поэтому перерисовка не создаёт и не удаляет перья
+// на каждую фигуру. Выбранные в контекст объекты удалять нельзя:
+// кэш очищают только после того, как рендереры вернули контексту старые.
+class GdiObjectCache {
+public:
+    GdiObjectCache() {}
+    ~GdiObjectCache();
+
+    GdiObjectCache(const GdiObjectCache&) = delete;
+    GdiObjectCache& operator=(const GdiObjectCache&) = delete;
+
+    HPEN pen(const MyShapes::Pen& pen);
+    HBRUSH brush(MyShapes::Color color);
+
+    // Удаляет все созданные объекты GDI
+    void clear();
+
+    size_t penCount() const { return pens.size(); }
+
+private:
+    // Ключ пера: цвет в младших 32 битах, толщина и стиль выше
+    static uint64_t penKey(const MyShapes::Pen& pen);
+
+    std::unordered_map<uint64_t, HPEN> pens;
+    std::unordered_map<MyShapes::Color, HBRUSH> brushes;
+};
@@ -0,0 +1,56 @@
+﻿#include "GdiRenderer.h"
+
+GdiRenderer::GdiRenderer(HDC hdc, GdiObjectCache& cache)
+    : hdc(hdc), cache(cache), pen(0), penSelected(false), oldPen(NULL), oldBrush(NULL) {}
+
+GdiRenderer::~GdiRenderer() {
+    // Возвращаем контексту его объекты; наши перья и кисти остаются в кэше
+    if (penSelected) {
+        SelectObject(hdc, oldPen);
+    }
+    if (oldBrush) {
+        SelectObject(hdc, oldBrush);
+    }
+}
+
+void GdiRenderer::setPen(const MyShapes::Pen& newPen) {
+    if (penSelected && newPen == pen) return; // Перо уже выбрано
+
+    HGDIOBJ previous = SelectObject(hdc, cache.pen(newPen));
+    if (!penSelected) {
+        oldPen = previous;
+        penSelected = true;
+    }
+    pen = newPen;
+}
+
+void GdiRenderer::pixel(int x, int y, MyShapes::Color color) {
+    SetPixel(hdc, x, y, color);
+}
+
+void GdiRenderer::line(int x1, int y1, int x2, int y2) {
+    MoveToEx(hdc, x1, y1, NULL);
+    LineTo(hdc, x2, y2);
+}
+
+void GdiRenderer::polyPolyline(const MyShapes::Vertex* vertices, const uint32_t* counts, int polylineCount) {
+    // Vertex и POINT, uint32_t и DWORD совпадают по раскладке: передаём массивы как есть
+    static_assert(sizeof(MyShapes::Vertex) == sizeof(POINT), "Vertex must match POINT");
+    static_assert(sizeof(uint32_t) == sizeof(DWORD), "counts must match DWORD");
+    ::PolyPolyline(hdc, reinterpret_cast<const POINT*>(vertices),
+        reinterpret_cast<const DWORD*>(counts), (DWORD)polylineCount);
+}
+
+void GdiRenderer::ellipse(int left, int top, int right, int bottom) {
+    // Внутренность заливаем цветом фона окна, кисть выбираем один раз
+    if (oldBrush == NULL) {
+        oldBrush = SelectObject(hdc, cache.brush(GetSysColor(COLOR_WINDOW)));
+    }
+    Ellipse(hdc, left, top, right, bottom);
+}
+
+void GdiRenderer::arc(int left, int top, int right, int bottom,
+    int xStart, int yStart, int xEnd, int yEnd) {
+    // Вызов функции Arc из WinAPI для рисования дуги
+    ::Arc(hdc, left, top, right, bottom, xStart, yStart, xEnd, yEnd);
+}
@@ -0,0 +1,38 @@
+﻿#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#include "GdiObjectCache.h"
+#include "Renderer.h"
+
+// Реализация интерфейса вывода поверх контекста устройства GDI.
+// Перья и кисти берутся из кэша; перо выбирается в контекст только
+// при смене стиля, поэтому подряд идущие фигуры одного цвета его не трогают.
+class GdiRenderer : public MyShapes::Renderer {
+private:
+    HDC hdc;
+    GdiObjectCache& cache;
+    MyShapes::Pen pen;     // Перо, выбранное в контексте
+    bool penSelected;
+    HGDIOBJ oldPen;        // Перо, выбранное в контексте до начала рисования
+    HGDIOBJ oldBrush;      // То же для кисти; NULL, пока кисть не выбиралась
+
+public:
+    GdiRenderer(HDC hdc, GdiObjectCache& cache);
+    ~GdiRenderer();
+
+    GdiRenderer(const GdiRenderer&) = delete;
+    GdiRenderer& operator=(const GdiRenderer&) = delete;
+
+    using MyShapes::Renderer::setPen;
+    void setPen(const MyShapes::Pen& pen) override;
+    void pixel(int x, int y, MyShapes::Color color) override;
+    void line(int x1, int y1, int x2, int y2) override;
+    void polyPolyline(const MyShapes::Vertex* vertices, const uint32_t* counts, int polylineCount) override;
+    void ellipse(int left, int top, int right, int bottom) override;
+    void arc(int left, int top, int right, int bottom,
+        int xStart, int yStart, int xEnd, int yEnd) override;
+};
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include <algorithm>
+#include <climits>
+
+namespace MyShapes {
+
+    // Прямоугольник, выровненный по осям. Границы включительные:
+    // точка (right, bottom) принадлежит прямоугольнику.
+    struct Rect {
+        int left, top, right, bottom;
+
+        Rect() : left(INT_MAX), top(INT_MAX), right(INT_MIN), bottom(INT_MIN) {}  // Пустой
+
+        Rect(int left, int top, int right, int bottom)
+            : left(left), top(top), right(right), bottom(bottom) {}
+
+        bool isEmpty() const {
+            return left > right || top > bottom;
+        }
+
+        int width() const { return isEmpty() ? 0 : right - left + 1; }
+        int height() const { return isEmpty() ? 0 : bottom - top + 1; }
+
+        bool contains(int x, int y) const {
+            return x >= left && x <= right && y >= top && y <= bottom;
+        }
+
+        bool contains(const Rect& other) const {
+            return other.left >= left && other.right <= right &&
+                other.top >= top && other.bottom <= bottom;
+        }
+
+        bool intersects(const Rect& other) const {
+            return left <= other.right && other.left <= right &&
+                top <= other.bottom && other.top <= bottom;
+        }
+
+        // Расширяет прямоугольник так, чтобы он включал точку
+        void include(int x, int y) {
+            left = std::min(left, x);
+            top = std::min(top, y);
+            right = std::max(right, x);
+            bottom = std::max(bottom, y);
+        }
+
+        void unite(const Rect& other) {
+            if (other.isEmpty()) return;
+            include(other.left, other.top);
+            include(other.right, other.bottom);
+        }
+
+        Rect inflated(int d) const {
+            if (isEmpty()) return *this;
+            return Rect(left - d, top - d, right + d, bottom + d);
+        }
+
+        bool operator==(const Rect& other) const {
+            return left == other.left && top == other.top &&
+                right == other.right && bottom == other.bottom;
+        }
+
+        bool operator!=(const Rect& other) const {
+            return !(*this == other);
+        }
+    };
+
+    inline Rect unionOf(const Rect& a, const Rect& b) {
+        Rect r = a;
+        r.unite(b);
+        return r;
+    }
+
+    inline Rect intersectionOf(const Rect& a, const Rect& b) {
+        if (!a.intersects(b)) return Rect();
+        return Rect(std::max(a.left, b.left), std::max(a.top, b.top),
+            std::min(a.right, b.right), std::min(a.bottom, b.bottom));
+    }
+
+}
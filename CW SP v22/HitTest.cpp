@@ -0,0 +1,324 @@
+﻿#include "HitTest.h"
+
+#include "ShapeKernels.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MYSHAPES_HIT_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MYSHAPES_HIT_SSE2
+#endif
+
+namespace MyShapes {
+
+    namespace {
+
+#if defined(MYSHAPES_HIT_AVX) || defined(MYSHAPES_HIT_SSE2)
+#define MYSHAPES_HIT_SIMD
+
+        // Четыре ребра или четыре точки за шаг. Сначала дешёвый отсев в целых
+        // (SSE2 есть и при AVX): почти все рёбра далеко от точки или не пересекают
+        // её горизонталь. Оставшиеся дорожки проверяются точно в double.
+        struct Quad {
+            __m128i x, y;
+        };
+
+        // Четыре вершины подряд, x и y по дорожкам
+        inline Quad loadQuad(const Vertex* v) {
+            __m128i a = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(v)), _MM_SHUFFLE(3, 1, 2, 0));
+            __m128i b = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(v + 2)), _MM_SHUFFLE(3, 1, 2, 0));
+            return Quad{ _mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b) };  // x0..x3, y0..y3
+        }
+
+        inline Quad broadcastQuad(int x, int y) {
+            return Quad{ _mm_set1_epi32(x), _mm_set1_epi32(y) };
+        }
+
+        inline int quadMask(__m128i m) {
+            return _mm_movemask_ps(_mm_castsi128_ps(m));
+        }
+
+        // Рёбра (a, b), которые могут быть ближе допуска к p: отброшены те,
+        // у которых оба конца дальше допуска по одну сторону от точки
+        inline int nearCandidates(const Quad& a, const Quad& b, const Quad& p) {
+            __m128i tolerance = _mm_set1_epi32(ClickTolerance);
+            __m128i left = _mm_sub_epi32(p.x, tolerance), right = _mm_add_epi32(p.x, tolerance);
+            __m128i top = _mm_sub_epi32(p.y, tolerance), bottom = _mm_add_epi32(p.y, tolerance);
+            __m128i far = _mm_and_si128(_mm_cmplt_epi32(a.x, left), _mm_cmplt_epi32(b.x, left));
+            far = _mm_or_si128(far, _mm_and_si128(_mm_cmpgt_epi32(a.x, right), _mm_cmpgt_epi32(b.x, right)));
+            far = _mm_or_si128(far, _mm_and_si128(_mm_cmplt_epi32(a.y, top), _mm_cmplt_epi32(b.y, top)));
+            far = _mm_or_si128(far, _mm_and_si128(_mm_cmpgt_epi32(a.y, bottom), _mm_cmpgt_epi32(b.y, bottom)));
+            return ~quadMask(far) & 0xF;
+        }
+
+        // Рёбра (a, b), которые может пересечь луч из p вправо: концы по разные
+        // стороны горизонтали и хотя бы один не левее точки
+        inline int crossCandidates(const Quad& a, const Quad& b, const Quad& p) {
+            __m128i straddles = _mm_xor_si128(_mm_cmpgt_epi32(a.y, p.y), _mm_cmpgt_epi32(b.y, p.y));
+            __m128i left = _mm_and_si128(_mm_cmplt_epi32(a.x, p.x), _mm_cmplt_epi32(b.x, p.x));
+            return quadMask(_mm_andnot_si128(left, straddles));
+        }
+
+        // Точная часть - обёртка над регистром double, записанная один раз для обоих наборов
+#if defined(MYSHAPES_HIT_AVX)
+        typedef __m256d Lanes;
+
+        inline Lanes broadcast(double v) { return _mm256_set1_pd(v); }
+        inline Lanes add(Lanes a, Lanes b) { return _mm256_add_pd(a, b); }
+        inline Lanes sub(Lanes a, Lanes b) { return _mm256_sub_pd(a, b); }
+        inline Lanes mul(Lanes a, Lanes b) { return _mm256_mul_pd(a, b); }
+        inline Lanes both(Lanes a, Lanes b) { return _mm256_and_pd(a, b); }
+        inline Lanes either(Lanes a, Lanes b) { return _mm256_or_pd(a, b); }
+        inline Lanes butNot(Lanes a, Lanes b) { return _mm256_andnot_pd(b, a); }  // a и не b
+        inline Lanes less(Lanes a, Lanes b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+        inline Lanes greater(Lanes a, Lanes b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+        inline Lanes greaterEqual(Lanes a, Lanes b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+#else
+        typedef __m128d Lanes;
+
+        inline Lanes broadcast(double v) { return _mm_set1_pd(v); }
+        inline Lanes add(Lanes a, Lanes b) { return _mm_add_pd(a, b); }
+        inline Lanes sub(Lanes a, Lanes b) { return _mm_sub_pd(a, b); }
+        inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_pd(a, b); }
+        inline Lanes both(Lanes a, Lanes b) { return _mm_and_pd(a, b); }
+        inline Lanes either(Lanes a, Lanes b) { return _mm_or_pd(a, b); }
+        inline Lanes butNot(Lanes a, Lanes b) { return _mm_andnot_pd(b, a); }  // a и не b
+        inline Lanes less(Lanes a, Lanes b) { return _mm_cmplt_pd(a, b); }
+        inline Lanes greater(Lanes a, Lanes b) { return _mm_cmpgt_pd(a, b); }
+        inline Lanes greaterEqual(Lanes a, Lanes b) { return _mm_cmpge_pd(a, b); }
+#endif
+
+        // Ветви nearSegment считаются все сразу и выбираются масками
+        inline Lanes segmentHits(Lanes ax, Lanes ay, Lanes bx, Lanes by, Lanes x, Lanes y) {
+            Lanes dx = sub(bx, ax), dy = sub(by, ay);
+            Lanes px = sub(x, ax), py = sub(y, ay);
+            Lanes dot = add(mul(px, dx), mul(py, dy));
+            Lanes lengthSq = add(mul(dx, dx), mul(dy, dy));
+            Lanes toleranceSq = broadcast((double)ClickTolerance * ClickTolerance);
+            Lanes ex = sub(px, dx), ey = sub(py, dy);
+            Lanes cross = sub(mul(px, dy), mul(py, dx));
+
+            Lanes afterStart = greater(dot, broadcast(0));
+            Lanes nearStart = butNot(less(add(mul(px, px), mul(py, py)), toleranceSq), afterStart);
+            Lanes nearEnd = both(both(afterStart, greaterEqual(dot, lengthSq)),
+                less(add(mul(ex, ex), mul(ey, ey)), toleranceSq));
+            Lanes nearMiddle = both(both(afterStart, less(dot, lengthSq)),
+                less(mul(cross, cross), mul(toleranceSq, lengthSq)));
+            return either(either(nearStart, nearEnd), nearMiddle);
+        }
+
+        // Формулы crossesRay; дорожки, где концы не по разные стороны, отсеяны заранее
+        inline Lanes rayCrossings(Lanes ax, Lanes ay, Lanes bx, Lanes by, Lanes x, Lanes y) {
+            Lanes lhs = mul(sub(x, ax), sub(by, ay));
+            Lanes rhs = mul(sub(bx, ax), sub(y, ay));
+            Lanes up = greater(by, ay);
+            return either(both(up, less(lhs, rhs)), butNot(greater(lhs, rhs), up));
+        }
+
+        // Точная проверка четырёх дорожек: test(ax, ay, bx, by, px, py) -> маска
+        template <typename Test>
+        inline int exactMask(const Quad& a, const Quad& b, const Quad& p, Test test) {
+#if defined(MYSHAPES_HIT_AVX)
+            return _mm256_movemask_pd(test(_mm256_cvtepi32_pd(a.x), _mm256_cvtepi32_pd(a.y),
+                _mm256_cvtepi32_pd(b.x), _mm256_cvtepi32_pd(b.y),
+                _mm256_cvtepi32_pd(p.x), _mm256_cvtepi32_pd(p.y)));
+#else
+            auto half = [&](int shift) {
+                auto lanes = [&](__m128i v) {
+                    return _mm_cvtepi32_pd(shift ? _mm_srli_si128(v, 8) : v);
+                };
+                return _mm_movemask_pd(test(lanes(a.x), lanes(a.y), lanes(b.x), lanes(b.y), lanes(p.x), lanes(p.y)));
+            };
+            return half(0) | (half(1) << 2);
+#endif
+        }
+
+        inline int nearMask(const Quad& a, const Quad& b, const Quad& p) {
+            int candidates = nearCandidates(a, b, p);
+            return candidates ? exactMask(a, b, p, segmentHits) & candidates : 0;
+        }
+
+        inline int crossMask(const Quad& a, const Quad& b, const Quad& p) {
+            int candidates = crossCandidates(a, b, p);
+            return candidates ? exactMask(a, b, p, rayCrossings) & candidates : 0;
+        }
+
+        inline bool oddBits(int mask) {
+            bool odd = false;
+            for (; mask; mask &= mask - 1) odd = !odd;
+            return odd;
+        }
+#endif
+
+        // Проход по рёбрам нескольких фигур, лежащих подряд. Ребро k соединяет
+        // вершины k и k + 1; "мосты" от последней вершины фигуры к первой
+        // вершине следующей пропускаются. Номера рёбер должны расти.
+        class PackedEdges {
+        public:
+            PackedEdges(const uint32_t* counts, size_t shapeCount)
+                : counts(counts), shapeEnd(shapeCount > 0 ? counts[0] : 0) {}
+
+            // Фигура ребра k или -1 для моста
+            long long shapeOf(size_t k) {
+                while (k >= shapeEnd) {
+                    shapeEnd += counts[++shape];
+                }
+                return k + 1 < shapeEnd ? (long long)shape : -1;
+            }
+
+        private:
+            const uint32_t* counts;
+            size_t shape = 0;
+            size_t shapeEnd;  // Конец вершин фигуры shape
+        };
+
+        size_t totalCount(const uint32_t* counts, size_t shapeCount) {
+            size_t total = 0;
+            for (size_t s = 0; s < shapeCount; ++s) total += counts[s];
+            return total;
+        }
+
+    }
+
+    bool nearPolyline(const Vertex* vertices, size_t count, int x, int y) {
+        if (count < 2) return false;
+
+        size_t segments = count - 1;
+        size_t i = 0;
+#if defined(MYSHAPES_HIT_SIMD)
+        Quad p = broadcastQuad(x, y);
+        for (; i + 4 <= segments; i += 4) {
+            if (nearMask(loadQuad(vertices + i), loadQuad(vertices + i + 1), p)) return true;
+        }
+#endif
+        for (; i < segments; ++i) {
+            if (nearSegment(vertices[i].x, vertices[i].y, vertices[i + 1].x, vertices[i + 1].y, x, y)) return true;
+        }
+        return false;
+    }
+
+    bool insidePolygon(const Vertex* vertices, size_t count, int x, int y) {
+        if (count == 0) return false;
+
+        size_t edges = count - 1;  // Без замыкающего
+        size_t i = 0;
+        bool inside = false;
+#if defined(MYSHAPES_HIT_SIMD)
+        Quad p = broadcastQuad(x, y);
+        int parity = 0;  // Чётность пересечений по каждой дорожке
+        for (; i + 4 <= edges; i += 4) {
+            parity ^= crossMask(loadQuad(vertices + i), loadQuad(vertices + i + 1), p);
+        }
+        inside = oddBits(parity);
+#endif
+        for (; i < edges; ++i) {
+            if (crossesRay(vertices[i].x, vertices[i].y, vertices[i + 1].x, vertices[i + 1].y, x, y)) inside = !inside;
+        }
+        if (crossesRay(vertices[count - 1].x, vertices[count - 1].y, vertices[0].x, vertices[0].y, x, y)) inside = !inside;
+        return inside;
+    }
+
+    void nearPolylines(const Vertex* vertices, const uint32_t* counts, size_t shapeCount,
+        int x, int y, uint8_t* hits) {
+        for (size_t s = 0; s < shapeCount; ++s) hits[s] = 0;
+
+        // Все фигуры - одна длинная ломаная: короткие фигуры не оставляют
+        // векторные дорожки пустыми
+        size_t total = totalCount(counts, shapeCount);
+        size_t segments = total > 0 ? total - 1 : 0;
+        PackedEdges edges(counts, shapeCount);
+        size_t k = 0;
+#if defined(MYSHAPES_HIT_SIMD)
+        Quad p = broadcastQuad(x, y);
+        for (; k + 4 <= segments; k += 4) {
+            int mask = nearMask(loadQuad(vertices + k), loadQuad(vertices + k + 1), p);
+            for (size_t lane = 0; mask; ++lane, mask >>= 1) {
+                if (!(mask & 1)) continue;
+                long long shape = edges.shapeOf(k + lane);
+                if (shape >= 0) hits[shape] = 1;
+            }
+        }
+#endif
+        for (; k < segments; ++k) {
+            if (!nearSegment(vertices[k].x, vertices[k].y, vertices[k + 1].x, vertices[k + 1].y, x, y)) continue;
+            long long shape = edges.shapeOf(k);
+            if (shape >= 0) hits[shape] = 1;
+        }
+    }
+
+    void insidePolygons(const Vertex* vertices, const uint32_t* counts, size_t shapeCount,
+        int x, int y, uint8_t* hits) {
+        // Замыкающие рёбра отдельно, остальные - одним проходом, как у nearPolylines
+        const Vertex* first = vertices;
+        for (size_t s = 0; s < shapeCount; ++s) {
+            uint32_t n = counts[s];
+            hits[s] = n > 0 && crossesRay(first[n - 1].x, first[n - 1].y, first[0].x, first[0].y, x, y);
+            first += n;
+        }
+
+        size_t total = totalCount(counts, shapeCount);
+        size_t edgeCount = total > 0 ? total - 1 : 0;
+        PackedEdges edges(counts, shapeCount);
+        size_t k = 0;
+#if defined(MYSHAPES_HIT_SIMD)
+        Quad p = broadcastQuad(x, y);
+        for (; k + 4 <= edgeCount; k += 4) {
+            int mask = crossMask(loadQuad(vertices + k), loadQuad(vertices + k + 1), p);
+            for (size_t lane = 0; mask; ++lane, mask >>= 1) {
+                if (!(mask & 1)) continue;
+                long long shape = edges.shapeOf(k + lane);
+                if (shape >= 0) hits[shape] ^= 1;
+            }
+        }
+#endif
+        for (; k < edgeCount; ++k) {
+            if (!crossesRay(vertices[k].x, vertices[k].y, vertices[k + 1].x, vertices[k + 1].y, x, y)) continue;
+            long long shape = edges.shapeOf(k);
+            if (shape >= 0) hits[shape] ^= 1;
+        }
+    }
+
+    void nearPolylineMany(const Vertex* vertices, size_t count,
+        const Vertex* points, size_t pointCount, uint8_t* hits) {
+        size_t i = 0;
+#if defined(MYSHAPES_HIT_SIMD)
+        for (; count >= 2 && i + 4 <= pointCount; i += 4) {
+            Quad p = loadQuad(points + i);
+            int mask = 0;
+            for (size_t k = 0; k + 1 < count && mask != 0xF; ++k) {
+                mask |= nearMask(broadcastQuad(vertices[k].x, vertices[k].y),
+                    broadcastQuad(vertices[k + 1].x, vertices[k + 1].y), p);
+            }
+            for (size_t lane = 0; lane < 4; ++lane) {
+                hits[i + lane] = (mask >> lane) & 1;
+            }
+        }
+#endif
+        for (; i < pointCount; ++i) {
+            hits[i] = nearPolyline(vertices, count, points[i].x, points[i].y);
+        }
+    }
+
+    void insidePolygonMany(const Vertex* vertices, size_t count,
+        const Vertex* points, size_t pointCount, uint8_t* hits) {
+        size_t i = 0;
+#if defined(MYSHAPES_HIT_SIMD)
+        for (; count > 0 && i + 4 <= pointCount; i += 4) {
+            Quad p = loadQuad(points + i);
+            int parity = 0;
+            for (size_t k = 0, prev = count - 1; k < count; prev = k++) {
+                parity ^= crossMask(broadcastQuad(vertices[prev].x, vertices[prev].y),
+                    broadcastQuad(vertices[k].x, vertices[k].y), p);
+            }
+            for (size_t lane = 0; lane < 4; ++lane) {
+                hits[i + lane] = (parity >> lane) & 1;
+            }
+        }
+#endif
+        for (; i < pointCount; ++i) {
+            hits[i] = insidePolygon(vertices, count, points[i].x, points[i].y);
+        }
+    }
+
+}
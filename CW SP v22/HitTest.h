@@ -0,0 +1,37 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Renderer.h"
+
+namespace MyShapes {
+
+    // Векторные ядра попадания для плотных массивов вершин (хранилище
+    // SceneStore, буфер ломаной, контур лассо). Ответы совпадают со скалярными
+    // nearSegment и crossesRay (ShapeKernels.h). Рёбра идут по четыре: целочисленный
+    // отсев далёких рёбер, затем те же операции над double, что у скалярных
+    // функций, по четыре (AVX) или по два (SSE2) в регистре.
+
+    // Ломаная из count вершин: есть ли ребро ближе ClickTolerance к (x, y)
+    bool nearPolyline(const Vertex* vertices, size_t count, int x, int y);
+
+    // Многоугольник из count вершин (замыкающее ребро подразумевается):
+    // правило чётности, как у Polygon::isClicked
+    bool insidePolygon(const Vertex* vertices, size_t count, int x, int y);
+
+    // Одна точка против многих фигур. Фигуры лежат подряд, как у
+    // Renderer::polyPolyline: counts[i] вершин i-й фигуры. hits[i] = 1 при попадании.
+    void nearPolylines(const Vertex* vertices, const uint32_t* counts, size_t shapeCount,
+        int x, int y, uint8_t* hits);
+    void insidePolygons(const Vertex* vertices, const uint32_t* counts, size_t shapeCount,
+        int x, int y, uint8_t* hits);
+
+    // Много точек против одной фигуры (выделение лассо): в векторе - соседние
+    // точки, рёбра фигуры перебираются по одному. hits[i] относится к points[i].
+    void nearPolylineMany(const Vertex* vertices, size_t count,
+        const Vertex* points, size_t pointCount, uint8_t* hits);
+    void insidePolygonMany(const Vertex* vertices, size_t count,
+        const Vertex* points, size_t pointCount, uint8_t* hits);
+
+}
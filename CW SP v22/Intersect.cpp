@@ -0,0 +1,258 @@
+﻿#include "Intersect.h"
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MYSHAPES_CROSS_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MYSHAPES_CROSS_SSE2
+#endif
+
+namespace MyShapes {
+
+    namespace {
+
+        // Погрешность определителя в double не больше OrientationBound * (|left| + |right|)
+        // (оценка Шевчука для orient2d; разности целых координат в double точны,
+        // так что оценка с запасом)
+        const double Epsilon = 1.1102230246251565e-16;  // 2^-53
+        const double OrientationBound = (3.0 + 16.0 * Epsilon) * Epsilon;
+
+        // a + b = sum + error точно
+        inline void twoSum(double a, double b, double& sum, double& error) {
+            sum = a + b;
+            double bVirtual = sum - a;
+            double aVirtual = sum - bVirtual;
+            error = (a - aVirtual) + (b - bVirtual);
+        }
+
+        // a * b = product + error точно; fma округляет один раз
+        inline void twoProduct(double a, double b, double& product, double& error) {
+            product = a * b;
+            error = std::fma(a, b, -product);
+        }
+
+        // Знак точной суммы слагаемых. Сумма копится неперекрывающимся
+        // разложением (компоненты по возрастанию модуля), знак - у старшей
+        // ненулевой компоненты.
+        int exactSign(const double* terms, int count) {
+            double expansion[8];
+            int size = 0;
+            for (int i = 0; i < count; ++i) {
+                double q = terms[i];
+                for (int k = 0; k < size; ++k) {
+                    double sum, error;
+                    twoSum(q, expansion[k], sum, error);
+                    expansion[k] = error;
+                    q = sum;
+                }
+                expansion[size++] = q;
+            }
+            for (int k = size - 1; k >= 0; --k) {
+                if (expansion[k] != 0) return expansion[k] > 0 ? 1 : -1;
+            }
+            return 0;
+        }
+
+        // Знак acx * bcy - acy * bcx без округлений
+        int exactOrientation(double acx, double bcy, double acy, double bcx) {
+            double left, leftError, right, rightError;
+            twoProduct(acx, bcy, left, leftError);
+            twoProduct(acy, bcx, right, rightError);
+            const double terms[4] = { leftError, -rightError, left, -right };
+            return exactSign(terms, 4);
+        }
+
+        // Знак acx * bcy - acy * bcx и его приближённое значение
+        int determinantSign(double acx, double bcy, double acy, double bcx, double& determinant) {
+            double left = acx * bcy, right = acy * bcx;
+            determinant = left - right;
+            double bound = OrientationBound * (std::fabs(left) + std::fabs(right));
+            if (determinant > bound) return 1;
+            if (-determinant > bound) return -1;
+            return exactOrientation(acx, bcy, acy, bcx);
+        }
+
+        // Знак orient2d(a, b, c) и приближённое значение определителя
+        int orientationOf(const Vertex& a, const Vertex& b, const Vertex& c, double& determinant) {
+            return determinantSign((double)a.x - c.x, (double)b.y - c.y, (double)a.y - c.y, (double)b.x - c.x, determinant);
+        }
+
+        // Положение общей точки на ребре по сторонам и определителям его концов
+        double crossingParameter(int startSide, int endSide, double startDeterminant, double endDeterminant) {
+            if (startSide == 0) return 0;
+            if (endSide == 0) return 1;
+            double t = startDeterminant / (startDeterminant - endDeterminant);
+            return t > 0 ? (t < 1 ? t : 1) : 0;  // Знаки точные, значения - нет
+        }
+
+        Vertex pointAt(const Vertex& p1, const Vertex& p2, double t) {
+            return Vertex{ (int32_t)std::lrint(p1.x + t * ((double)p2.x - p1.x)),
+                (int32_t)std::lrint(p1.y + t * ((double)p2.y - p1.y)) };
+        }
+
+#if defined(MYSHAPES_CROSS_AVX)
+        // Четыре вершины за шаг
+        typedef __m256d Lanes;
+        const size_t LaneCount = 4;
+
+        inline Lanes broadcast(double v) { return _mm256_set1_pd(v); }
+        inline Lanes add(Lanes a, Lanes b) { return _mm256_add_pd(a, b); }
+        inline Lanes sub(Lanes a, Lanes b) { return _mm256_sub_pd(a, b); }
+        inline Lanes mul(Lanes a, Lanes b) { return _mm256_mul_pd(a, b); }
+        inline Lanes magnitude(Lanes a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+        inline int greaterMask(Lanes a, Lanes b) { return _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ)); }
+        inline void store(double* to, Lanes a) { _mm256_storeu_pd(to, a); }
+
+        inline void loadVertices(const Vertex* v, Lanes& x, Lanes& y) {
+            __m128i a = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(v)), _MM_SHUFFLE(3, 1, 2, 0));
+            __m128i b = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(v + 2)), _MM_SHUFFLE(3, 1, 2, 0));
+            x = _mm256_cvtepi32_pd(_mm_unpacklo_epi64(a, b));
+            y = _mm256_cvtepi32_pd(_mm_unpackhi_epi64(a, b));
+        }
+#elif defined(MYSHAPES_CROSS_SSE2)
+        // Две вершины за шаг
+        typedef __m128d Lanes;
+        const size_t LaneCount = 2;
+
+        inline Lanes broadcast(double v) { return _mm_set1_pd(v); }
+        inline Lanes add(Lanes a, Lanes b) { return _mm_add_pd(a, b); }
+        inline Lanes sub(Lanes a, Lanes b) { return _mm_sub_pd(a, b); }
+        inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_pd(a, b); }
+        inline Lanes magnitude(Lanes a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+        inline int greaterMask(Lanes a, Lanes b) { return _mm_movemask_pd(_mm_cmpgt_pd(a, b)); }
+        inline void store(double* to, Lanes a) { _mm_storeu_pd(to, a); }
+
+        inline void loadVertices(const Vertex* v, Lanes& x, Lanes& y) {
+            __m128i a = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(v)), _MM_SHUFFLE(3, 1, 2, 0));
+            x = _mm_cvtepi32_pd(a);
+            y = _mm_cvtepi32_pd(_mm_srli_si128(a, 8));
+        }
+#endif
+
+        // Стороны всех вершин относительно прямой ab: те же операции, что
+        // у orientationOf, по дорожкам; неуверенные дорожки - точно
+        void sidesOfLine(const Vertex* vertices, size_t count, const Vertex& a, const Vertex& b,
+            double* determinants, int8_t* sides) {
+            size_t i = 0;
+#if defined(MYSHAPES_CROSS_AVX) || defined(MYSHAPES_CROSS_SSE2)
+            Lanes ax = broadcast(a.x), ay = broadcast(a.y), bx = broadcast(b.x), by = broadcast(b.y);
+            Lanes boundFactor = broadcast(OrientationBound), zero = broadcast(0);
+            for (; i + LaneCount <= count; i += LaneCount) {
+                Lanes cx, cy;
+                loadVertices(vertices + i, cx, cy);
+                Lanes acx = sub(ax, cx), bcx = sub(bx, cx);
+                Lanes acy = sub(ay, cy), bcy = sub(by, cy);
+                Lanes left = mul(acx, bcy), right = mul(acy, bcx);
+                Lanes determinant = sub(left, right);
+                Lanes bound = mul(boundFactor, add(magnitude(left), magnitude(right)));
+                store(determinants + i, determinant);
+                int positive = greaterMask(determinant, bound);
+                int negative = greaterMask(sub(zero, determinant), bound);
+                for (size_t k = 0; k < LaneCount; ++k) {
+                    if (positive >> k & 1) sides[i + k] = 1;
+                    else if (negative >> k & 1) sides[i + k] = -1;
+                    else sides[i + k] = (int8_t)orientationOf(a, b, vertices[i + k], determinants[i + k]);
+                }
+            }
+#endif
+            for (; i < count; ++i) {
+                sides[i] = (int8_t)orientationOf(a, b, vertices[i], determinants[i]);
+            }
+        }
+
+    }
+
+    int orientation(const Vertex& a, const Vertex& b, const Vertex& c) {
+        double determinant;
+        return orientationOf(a, b, c, determinant);
+    }
+
+    int crossSign(double dx1, double dy1, double dx2, double dy2) {
+        double determinant;
+        return determinantSign(dx1, dy2, dy1, dx2, determinant);
+    }
+
+    bool segmentCrossing(const Vertex& p1, const Vertex& p2, const Vertex& q1, const Vertex& q2, double& t) {
+        double d1, d2;
+        int s1 = orientationOf(q1, q2, p1, d1);
+        int s2 = orientationOf(q1, q2, p2, d2);
+        if (s1 * s2 > 0 || (s1 == 0 && s2 == 0)) return false;
+        if (orientation(p1, p2, q1) * orientation(p1, p2, q2) > 0) return false;
+        t = crossingParameter(s1, s2, d1, d2);
+        return true;
+    }
+
+    int circleCrossings(const Vertex& a, const Vertex& b, double cx, double cy, double radius, double t[2]) {
+        double dx = (double)b.x - a.x, dy = (double)b.y - a.y;
+        double fx = a.x - cx, fy = a.y - cy;
+        double A = dx * dx + dy * dy;
+        if (A == 0) return 0;
+        double half = dx * fx + dy * fy;  // Половина линейного коэффициента
+        double C = fx * fx + fy * fy - radius * radius;
+        double discriminant = half * half - A * C;
+        if (discriminant < 0) return 0;
+
+        double roots[2];
+        int count;
+        if (discriminant == 0) {
+            roots[0] = -half / A;
+            count = 1;
+        }
+        else {
+            // Корень без вычитания близких чисел, второй - по теореме Виета
+            double q = -(half + std::copysign(std::sqrt(discriminant), half));
+            roots[0] = q / A;
+            roots[1] = C / q;
+            if (roots[0] > roots[1]) std::swap(roots[0], roots[1]);
+            count = 2;
+        }
+
+        int found = 0;
+        for (int i = 0; i < count; ++i) {
+            if (roots[i] >= 0 && roots[i] <= 1) t[found++] = roots[i];
+        }
+        return found;
+    }
+
+    void polylineCrossings(const Vertex* vertices, size_t count, const Vertex& a, const Vertex& b,
+        std::vector<SegmentCrossing>& crossings) {
+        crossings.clear();
+        if (count < 2) return;
+
+        thread_local std::vector<double> determinants;
+        thread_local std::vector<int8_t> sides;
+        determinants.resize(count);
+        sides.resize(count);
+        sidesOfLine(vertices, count, a, b, determinants.data(), sides.data());
+
+        for (size_t i = 0; i + 1 < count; ++i) {
+            int s1 = sides[i], s2 = sides[i + 1];
+            // Оба конца по одну сторону или ребро на самой прямой
+            if (s1 * s2 > 0 || (s1 == 0 && s2 == 0)) continue;
+            if (orientation(vertices[i], vertices[i + 1], a) * orientation(vertices[i], vertices[i + 1], b) > 0) continue;
+
+            double t = crossingParameter(s1, s2, determinants[i], determinants[i + 1]);
+            // Вершина на отрезке уже дана концом предыдущего ребра
+            if (t == 0 && !crossings.empty() && crossings.back().segment + 1 == i && crossings.back().t == 1) continue;
+            crossings.push_back(SegmentCrossing{ i, t, pointAt(vertices[i], vertices[i + 1], t) });
+        }
+    }
+
+    bool pointInPolygon(double x, double y, const Vertex* polygon, size_t count) {
+        bool inside = false;
+        for (size_t i = 0, j = count - 1; i < count; j = i++) {
+            const Vertex& a = polygon[i];
+            const Vertex& b = polygon[j];
+            if ((a.y > y) != (b.y > y) && x < a.x + (y - a.y) * ((double)b.x - a.x) / ((double)b.y - a.y)) {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+}
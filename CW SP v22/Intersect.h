@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Renderer.h"
+
+namespace MyShapes {
+
+    // Точные предикаты пересечения отрезков на целых координатах. Ответ
+    // «по какую сторону», «пересекаются ли» верен при любых int: сначала
+    // считается в double с оценкой погрешности, и только когда знак в неё
+    // не укладывается (почти коллинеарные точки, огромные координаты),
+    // определитель досчитывается точно суммой без округлений. Округляется
+    // лишь сама точка пересечения.
+
+    // Знак (b - a) x (c - a): 1 - c слева от направленной прямой ab
+    // (в осях с y вверх), -1 - справа, 0 - на прямой
+    int orientation(const Vertex& a, const Vertex& b, const Vertex& c);
+
+    // Знак векторного произведения направлений (dx1, dy1) x (dx2, dy2).
+    // Компоненты - разности целых координат: в double они точны.
+    int crossSign(double dx1, double dy1, double dx2, double dy2);
+
+    // Общая точка ребра ломаной с отрезком
+    struct SegmentCrossing {
+        size_t segment;  // Ребро: вершины segment и segment + 1
+        double t;        // Положение на ребре, 0..1
+        Vertex point;    // Точка, округлённая до целых
+    };
+
+    // Отрезки p1p2 и q1q2 имеют ровно одну общую точку (пересекаются или
+    // касаются концом); t - её положение на p1p2. Коллинеарные отрезки,
+    // в том числе частично совпадающие, точкой пересечения не считаются.
+    bool segmentCrossing(const Vertex& p1, const Vertex& p2, const Vertex& q1, const Vertex& q2, double& t);
+
+    // Общие точки отрезка ab с окружностью: их положения t на отрезке (0..1)
+    // по возрастанию, корни квадратного уравнения в закрытой форме. Касание
+    // даёт одну точку. Возвращает число точек: 0, 1 или 2.
+    int circleCrossings(const Vertex& a, const Vertex& b, double cx, double cy, double radius, double t[2]);
+
+    // Все общие точки ломаной из count вершин с отрезком ab по порядку вдоль
+    // ломаной. Вершина на отрезке даётся один раз. Стороны вершин относительно
+    // прямой ab считаются векторно, по две или четыре за шаг; точные рёбра
+    // проверяются только там, где сторона сменилась.
+    void polylineCrossings(const Vertex* vertices, size_t count, const Vertex& a, const Vertex& b,
+        std::vector<SegmentCrossing>& crossings);
+
+    // Точка (в том числе дробная) внутри многоугольника по правилу чёт-нечет
+    bool pointInPolygon(double x, double y, const Vertex* polygon, size_t count);
+
+}
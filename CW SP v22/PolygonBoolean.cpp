@@ -0,0 +1,531 @@
+﻿#include "PolygonBoolean.h"
+
+#include "Intersect.h"
+#include "SegmentSweep.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace MyShapes {
+
+    namespace {
+
+        // Пары рёбер проверяются перебором, пока их не больше; дальше - заметанием
+        const size_t BruteForcePairs = 4096;
+
+        // Положение куска ребра относительно другого многоугольника
+        enum class Side : uint8_t { Unknown, Inside, Outside, Same, Opposite };
+
+        struct Node {
+            double x, y;
+        };
+
+        // Точка деления ребра: положение на нём и узел
+        struct Split {
+            double t;
+            int node;
+        };
+
+        // Кусок ребра между соседними точками деления
+        struct Fragment {
+            int from, to;
+            Side side;
+        };
+
+        bool same(const Vertex& a, const Vertex& b) {
+            return a.x == b.x && a.y == b.y;
+        }
+
+        uint64_t vertexKey(const Vertex& v) {
+            return (uint64_t)(uint32_t)v.x << 32 | (uint32_t)v.y;
+        }
+
+        uint64_t edgeKey(int a, int b) {
+            return a < b ? (uint64_t)a << 32 | (uint32_t)b : (uint64_t)b << 32 | (uint32_t)a;
+        }
+
+        // Без повторов подряд и без вершин на прямой соседей (в том числе
+        // «шипов» a - b - a); меньше трёх вершин - пустой контур
+        void simplify(std::vector<Vertex>& contour) {
+            size_t kept = 0;
+            for (size_t i = 0; i < contour.size(); ++i) {
+                const Vertex v = contour[i];
+                bool skip = false;
+                for (;;) {
+                    if (kept > 0 && same(contour[kept - 1], v)) {
+                        skip = true;
+                        break;
+                    }
+                    if (kept < 2 || orientation(contour[kept - 2], contour[kept - 1], v) != 0) break;
+                    --kept;
+                }
+                if (!skip) contour[kept++] = v;
+            }
+            contour.resize(kept);
+
+            // Стык конца с началом
+            while (contour.size() >= 3) {
+                size_t n = contour.size();
+                if (same(contour[n - 1], contour[0]) || orientation(contour[n - 2], contour[n - 1], contour[0]) == 0) {
+                    contour.pop_back();
+                }
+                else if (orientation(contour[n - 1], contour[0], contour[1]) == 0) {
+                    contour.erase(contour.begin());
+                }
+                else {
+                    break;
+                }
+            }
+            if (contour.size() < 3) contour.clear();
+        }
+
+        double signedArea(const std::vector<Vertex>& contour) {
+            double area = 0;
+            for (size_t i = 0, n = contour.size(); i < n; ++i) {
+                const Vertex& a = contour[i];
+                const Vertex& b = contour[(i + 1) % n];
+                area += (double)a.x * b.y - (double)b.x * a.y;
+            }
+            return area / 2;
+        }
+
+        // Контуры совпадают с точностью до начальной вершины и направления обхода
+        bool sameOutline(const Contour& a, const Contour& b) {
+            size_t n = a.size();
+            if (n != b.size() || n == 0) return false;
+            for (size_t shift = 0; shift < n; ++shift) {
+                if (!same(a[0], b[shift])) continue;
+                bool forward = true, backward = true;
+                for (size_t i = 0; i < n && (forward || backward); ++i) {
+                    forward = forward && same(a[i], b[(shift + i) % n]);
+                    backward = backward && same(a[i], b[(shift + n - i) % n]);
+                }
+                if (forward || backward) return true;
+            }
+            return false;
+        }
+
+        // clear у unordered_map проходит все корзины: после большого наложения
+        // таблица отдаётся целиком, чтобы малые не платили за её размер
+        template <class Map>
+        void resetMap(Map& map, size_t expected) {
+            if (map.bucket_count() > 8 * expected + 64) Map().swap(map);
+            else map.clear();
+            map.reserve(expected);
+        }
+
+        // Наложение двух многоугольников. Экземпляр на поток: массивы
+        // переживают вызовы и перестают выделять память.
+        class Overlay {
+        public:
+            void run(const Vertex* subject, size_t subjectCount, const Vertex* clip, size_t clipCount,
+                BooleanOp op, std::vector<Contour>& result);
+
+        private:
+            std::vector<Vertex> polygons[2];  // 0 - subject, 1 - clip
+            std::vector<int> vertexNodes[2];
+            std::vector<Node> nodes;
+            std::vector<uint8_t> crossing;  // Узел - пересечение внутренних точек двух рёбер
+            std::vector<uint8_t> owners;    // Биты многоугольников, на границе которых узел
+            std::unordered_map<uint64_t, int> nodeAt;  // Целая точка -> узел
+            std::vector<std::vector<Split>> splits[2];
+            std::vector<Fragment> fragments[2];
+            std::unordered_map<uint64_t, size_t> clipFragments;  // Пара узлов -> кусок clip
+            SegmentSweep sweep;
+            std::vector<SweepCrossing> sweepCrossings;
+
+            // Выбранные куски со своим направлением и исходящие из узлов
+            std::vector<int> linkFrom, linkTo, outStart, outFill, outLinks;
+            std::vector<uint8_t> used;
+            Contour contour;
+
+            int vertexNode(const Vertex& v);
+            void touch(int polygon, size_t edge, const Vertex& start, const Vertex& end, const Vertex& v);
+            void testPair(size_t a, size_t b);
+            void findSplits();
+            void buildFragments(int polygon);
+            void markShared();
+            void classify(int polygon);
+            void select(BooleanOp op);
+            void link(std::vector<Contour>& result);
+        };
+
+        int Overlay::vertexNode(const Vertex& v) {
+            auto found = nodeAt.emplace(vertexKey(v), (int)nodes.size());
+            if (found.second) {
+                nodes.push_back(Node{ (double)v.x, (double)v.y });
+                crossing.push_back(0);
+            }
+            return found.first->second;
+        }
+
+        // Вершина v на прямой ребра: делит его, если лежит строго внутри
+        void Overlay::touch(int polygon, size_t edge, const Vertex& start, const Vertex& end, const Vertex& v) {
+            double dx = (double)end.x - start.x, dy = (double)end.y - start.y;
+            double along = ((double)v.x - start.x) * dx + ((double)v.y - start.y) * dy;
+            double length = dx * dx + dy * dy;
+            if (along <= 0 || along >= length) return;
+            splits[polygon][edge].push_back(Split{ along / length, vertexNode(v) });
+        }
+
+        void Overlay::testPair(size_t a, size_t b) {
+            const std::vector<Vertex>& pa = polygons[0];
+            const std::vector<Vertex>& pb = polygons[1];
+            const Vertex& p1 = pa[a];
+            const Vertex& p2 = pa[(a + 1) % pa.size()];
+            const Vertex& q1 = pb[b];
+            const Vertex& q2 = pb[(b + 1) % pb.size()];
+
+            int o1 = orientation(q1, q2, p1), o2 = orientation(q1, q2, p2);
+            if (o1 * o2 > 0) return;
+            int o3 = orientation(p1, p2, q1), o4 = orientation(p1, p2, q2);
+            if (o3 * o4 > 0) return;
+
+            if (o1 * o2 < 0 && o3 * o4 < 0) {
+                // Рёбра пересекаются внутренними точками: новый узел на обоих
+                double ta, tb;
+                segmentCrossing(p1, p2, q1, q2, ta);
+                segmentCrossing(q1, q2, p1, p2, tb);
+                int node = (int)nodes.size();
+                nodes.push_back(Node{ p1.x + ta * ((double)p2.x - p1.x), p1.y + ta * ((double)p2.y - p1.y) });
+                crossing.push_back(1);
+                splits[0][a].push_back(Split{ ta, node });
+                splits[1][b].push_back(Split{ tb, node });
+                return;
+            }
+
+            // Касание или наложение на одной прямой: вершина одного ребра
+            // внутри другого. Совпавшие вершины уже общие узлы.
+            if (o3 == 0) touch(0, a, p1, p2, q1);
+            if (o4 == 0) touch(0, a, p1, p2, q2);
+            if (o1 == 0) touch(1, b, q1, q2, p1);
+            if (o2 == 0) touch(1, b, q1, q2, p2);
+        }
+
+        void Overlay::findSplits() {
+            for (int k = 0; k < 2; ++k) {
+                const std::vector<Vertex>& polygon = polygons[k];
+                size_t n = polygon.size();
+                vertexNodes[k].resize(n);
+                for (size_t i = 0; i < n; ++i) {
+                    vertexNodes[k][i] = vertexNode(polygon[i]);
+                }
+                splits[k].resize(n);
+                for (size_t i = 0; i < n; ++i) {
+                    splits[k][i].clear();
+                    splits[k][i].push_back(Split{ 0, vertexNodes[k][i] });
+                    splits[k][i].push_back(Split{ 1, vertexNodes[k][(i + 1) % n] });
+                }
+            }
+
+            size_t na = polygons[0].size(), nb = polygons[1].size();
+            if (na * nb <= BruteForcePairs) {
+                for (size_t a = 0; a < na; ++a) {
+                    const Vertex& p1 = polygons[0][a];
+                    const Vertex& p2 = polygons[0][(a + 1) % na];
+                    Rect edge(std::min(p1.x, p2.x), std::min(p1.y, p2.y), std::max(p1.x, p2.x), std::max(p1.y, p2.y));
+                    for (size_t b = 0; b < nb; ++b) {
+                        const Vertex& q1 = polygons[1][b];
+                        const Vertex& q2 = polygons[1][(b + 1) % nb];
+                        if (std::max(q1.x, q2.x) < edge.left || std::min(q1.x, q2.x) > edge.right ||
+                            std::max(q1.y, q2.y) < edge.top || std::min(q1.y, q2.y) > edge.bottom) continue;
+                        testPair(a, b);
+                    }
+                }
+                return;
+            }
+
+            // Заметание не сообщает рёбра на одной прямой, но вершина, лежащая
+            // внутри чужого ребра, касается его и своим вторым ребром: соседние
+            // вершины на одной прямой simplify уже убрал
+            sweep.clear();
+            for (int k = 0; k < 2; ++k) {
+                size_t n = polygons[k].size();
+                for (size_t i = 0; i < n; ++i) {
+                    sweep.addSegment(polygons[k][i], polygons[k][(i + 1) % n], (uint32_t)k, (uint32_t)i);
+                }
+            }
+            sweep.run(sweepCrossings);
+            for (const SweepCrossing& c : sweepCrossings) {
+                if (c.firstOwner == c.secondOwner) continue;
+                if (c.firstOwner == 0) testPair(c.firstEdge, c.secondEdge);
+                else testPair(c.secondEdge, c.firstEdge);
+            }
+        }
+
+        void Overlay::buildFragments(int polygon) {
+            std::vector<Fragment>& out = fragments[polygon];
+            out.clear();
+            for (std::vector<Split>& edge : splits[polygon]) {
+                std::sort(edge.begin(), edge.end(), [](const Split& a, const Split& b) { return a.t < b.t; });
+                for (const Split& split : edge) owners[split.node] |= 1 << polygon;
+                int last = edge[0].node;
+                for (size_t j = 1; j < edge.size(); ++j) {
+                    if (edge[j].node == last) continue;  // Касание, найденное с двух рёбер
+                    out.push_back(Fragment{ last, edge[j].node, Side::Unknown });
+                    last = edge[j].node;
+                }
+            }
+        }
+
+        // Куски с одной парой узлов - один и тот же отрезок: общий у обоих
+        void Overlay::markShared() {
+            resetMap(clipFragments, fragments[1].size());
+            for (size_t i = 0; i < fragments[1].size(); ++i) {
+                const Fragment& f = fragments[1][i];
+                clipFragments.emplace(edgeKey(f.from, f.to), i);
+            }
+            for (Fragment& f : fragments[0]) {
+                auto found = clipFragments.find(edgeKey(f.from, f.to));
+                if (found == clipFragments.end()) continue;
+                Fragment& other = fragments[1][found->second];
+                f.side = other.side = other.from == f.from ? Side::Same : Side::Opposite;
+            }
+        }
+
+        // Внутри или снаружи другого многоугольника. Внутренние точки куска
+        // не лежат на чужой границе, поэтому хватает его середины. Сторона
+        // меняется после пересечения рёбер и сохраняется в узле, которого
+        // нет на чужой границе: проверка точки нужна только после касаний.
+        void Overlay::classify(int polygon) {
+            const std::vector<Vertex>& other = polygons[1 - polygon];
+            Side previous = Side::Unknown;
+            for (Fragment& f : fragments[polygon]) {
+                if (f.side == Side::Same || f.side == Side::Opposite) {
+                    previous = Side::Unknown;
+                    continue;
+                }
+                if (previous != Side::Unknown && crossing[f.from]) {
+                    f.side = previous == Side::Inside ? Side::Outside : Side::Inside;
+                }
+                else if (previous != Side::Unknown && owners[f.from] == 1 << polygon) {
+                    f.side = previous;
+                }
+                else {
+                    const Node& a = nodes[f.from];
+                    const Node& b = nodes[f.to];
+                    bool inside = pointInPolygon((a.x + b.x) / 2, (a.y + b.y) / 2, other.data(), other.size());
+                    f.side = inside ? Side::Inside : Side::Outside;
+                }
+                previous = f.side;
+            }
+        }
+
+        void Overlay::select(BooleanOp op) {
+            linkFrom.clear();
+            linkTo.clear();
+            auto take = [&](const Fragment& f, bool reversed) {
+                linkFrom.push_back(reversed ? f.to : f.from);
+                linkTo.push_back(reversed ? f.from : f.to);
+            };
+
+            // Общее ребро берётся один раз - у subject
+            for (const Fragment& f : fragments[0]) {
+                switch (op) {
+                case BooleanOp::Union:
+                    if (f.side == Side::Outside || f.side == Side::Same) take(f, false);
+                    break;
+                case BooleanOp::Intersection:
+                    if (f.side == Side::Inside || f.side == Side::Same) take(f, false);
+                    break;
+                case BooleanOp::Difference:
+                    if (f.side == Side::Outside || f.side == Side::Opposite) take(f, false);
+                    break;
+                }
+            }
+            for (const Fragment& f : fragments[1]) {
+                switch (op) {
+                case BooleanOp::Union:
+                    if (f.side == Side::Outside) take(f, false);
+                    break;
+                case BooleanOp::Intersection:
+                    if (f.side == Side::Inside) take(f, false);
+                    break;
+                case BooleanOp::Difference:
+                    if (f.side == Side::Inside) take(f, true);  // Край дыры - в обратную сторону
+                    break;
+                }
+            }
+        }
+
+        // Сшивка кусков в контуры. В узле, где выходов несколько (касание),
+        // берётся самый левый поворот: каждый контур обходит свою область.
+        void Overlay::link(std::vector<Contour>& result) {
+            size_t count = linkFrom.size();
+            outStart.assign(nodes.size() + 1, 0);
+            for (int from : linkFrom) ++outStart[from + 1];
+            for (size_t i = 1; i < outStart.size(); ++i) outStart[i] += outStart[i - 1];
+            outLinks.resize(count);
+            outFill.assign(outStart.begin(), outStart.end() - 1);
+            for (size_t i = 0; i < count; ++i) {
+                outLinks[outFill[linkFrom[i]]++] = (int)i;
+            }
+            used.assign(count, 0);
+
+            for (size_t first = 0; first < count; ++first) {
+                if (used[first]) continue;
+                contour.clear();
+                int start = linkFrom[first];
+                int current = (int)first;
+                for (;;) {
+                    used[current] = 1;
+                    const Node& p = nodes[linkFrom[current]];
+                    contour.push_back(Vertex{ (int32_t)std::lrint(p.x), (int32_t)std::lrint(p.y) });
+                    int at = linkTo[current];
+                    if (at == start) break;
+
+                    // Угол по часовой от направления назад до выхода: меньше - левее
+                    const Node& v = nodes[at];
+                    double back = std::atan2(p.y - v.y, p.x - v.x);
+                    int next = -1;
+                    double best = 0;
+                    for (int k = outStart[at]; k < outStart[at + 1]; ++k) {
+                        int candidate = outLinks[k];
+                        if (used[candidate]) continue;
+                        const Node& w = nodes[linkTo[candidate]];
+                        double turn = back - std::atan2(w.y - v.y, w.x - v.x);
+                        turn = std::fmod(turn + 4 * M_PI, 2 * M_PI);
+                        if (turn == 0) turn = 2 * M_PI;  // Назад по тому же отрезку - в последнюю очередь
+                        if (next < 0 || turn < best) {
+                            next = candidate;
+                            best = turn;
+                        }
+                    }
+                    if (next < 0) break;  // Незамкнутый след: при простых входах не бывает
+                    current = next;
+                }
+                simplify(contour);
+                if (!contour.empty()) result.push_back(contour);
+            }
+        }
+
+        void Overlay::run(const Vertex* subject, size_t subjectCount, const Vertex* clip, size_t clipCount,
+            BooleanOp op, std::vector<Contour>& result) {
+            polygons[0].assign(subject, subject + subjectCount);
+            polygons[1].assign(clip, clip + clipCount);
+            for (std::vector<Vertex>& polygon : polygons) {
+                simplify(polygon);
+                if (signedArea(polygon) < 0) std::reverse(polygon.begin(), polygon.end());
+            }
+
+            // Пустой многоугольник: ответ - один из входов или ничего
+            if (polygons[0].empty() || polygons[1].empty()) {
+                bool keepSubject = !polygons[0].empty() && op != BooleanOp::Intersection;
+                bool keepClip = !polygons[1].empty() && op == BooleanOp::Union;
+                if (keepSubject) result.push_back(polygons[0]);
+                if (keepClip) result.push_back(polygons[1]);
+                return;
+            }
+
+            nodes.clear();
+            crossing.clear();
+            resetMap(nodeAt, polygons[0].size() + polygons[1].size());
+            findSplits();
+            owners.assign(nodes.size(), 0);
+            buildFragments(0);
+            buildFragments(1);
+            markShared();
+            classify(0);
+            classify(1);
+            select(op);
+            link(result);
+        }
+
+    }
+
+    void polygonBoolean(const Vertex* subject, size_t subjectCount, const Vertex* clip, size_t clipCount,
+        BooleanOp op, std::vector<Contour>& result) {
+        thread_local Overlay overlay;
+        result.clear();
+        overlay.run(subject, subjectCount, clip, clipCount, op, result);
+    }
+
+    void polygonBooleanBatch(ThreadPool& pool, std::vector<BooleanTask>& tasks) {
+        pool.parallelFor((int)tasks.size(), [&](int i) {
+            BooleanTask& task = tasks[i];
+            polygonBoolean(task.subject->data(), task.subject->size(), task.clip->data(), task.clip->size(),
+                task.op, task.result);
+        });
+    }
+
+    bool polygonContour(const Shape& shape, Contour& contour) {
+        ShapeKind kind = shape.kind();
+        if (kind != ShapeKind::Polygon && kind != ShapeKind::Triangle && kind != ShapeKind::Parallelogram) return false;
+        contour.clear();
+        shape.writeAnchors(contour);
+        return true;
+    }
+
+    namespace {
+
+        // Треугольник остаётся треугольником, остальное - многоугольник
+        Shape* shapeOf(const Contour& contour, Color color) {
+            std::vector<Point> points;
+            points.reserve(contour.size());
+            for (const Vertex& v : contour) points.push_back(Point(v.x, v.y));
+            Shape* shape = points.size() == 3 ? static_cast<Shape*>(new Triangle(points[0], points[1], points[2])) :
+                new Polygon(points);
+            shape->setColor(color);
+            return shape;
+        }
+
+    }
+
+    void booleanWithTool(ThreadPool& pool, const std::vector<Shape*>& shapes, const Shape& tool, BooleanOp op,
+        std::vector<Shape*>& replaced, std::vector<Shape*>& pieces) {
+        replaced.clear();
+        pieces.clear();
+        Contour area;
+        if (!polygonContour(tool, area)) return;
+
+        std::vector<Shape*> subjects;
+        std::vector<Contour> contours;
+        for (Shape* shape : shapes) {
+            Contour contour;
+            if (shape == &tool || !polygonContour(*shape, contour)) continue;
+            subjects.push_back(shape);
+            contours.push_back(std::move(contour));
+        }
+
+        std::vector<BooleanTask> tasks(subjects.size());
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            tasks[i].subject = &contours[i];
+            tasks[i].clip = &area;
+            tasks[i].op = op;
+        }
+        polygonBooleanBatch(pool, tasks);
+
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            const std::vector<Contour>& result = tasks[i].result;
+            if (result.size() == 1 && sameOutline(result[0], contours[i])) continue;  // Операция не задела фигуру
+            replaced.push_back(subjects[i]);
+            for (const Contour& contour : result) {
+                pieces.push_back(shapeOf(contour, subjects[i]->getColor()));
+            }
+        }
+    }
+
+    void mergePolygons(const std::vector<Shape*>& shapes, const Shape& tool,
+        std::vector<Shape*>& replaced, std::vector<Shape*>& pieces) {
+        replaced.clear();
+        pieces.clear();
+        Contour merged, contour;
+        if (!polygonContour(tool, merged)) return;
+
+        std::vector<Contour> result;
+        for (Shape* shape : shapes) {
+            if (shape == &tool || !polygonContour(*shape, contour)) continue;
+            polygonBoolean(merged.data(), merged.size(), contour.data(), contour.size(), BooleanOp::Union, result);
+            if (result.size() != 1) continue;  // Не пересекается с уже слитым или окружает дыру
+            merged = result[0];
+            replaced.push_back(shape);
+        }
+        if (replaced.empty()) return;
+        replaced.push_back(const_cast<Shape*>(&tool));
+        pieces.push_back(shapeOf(merged, tool.getColor()));
+    }
+
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Shapes.h"
+
+namespace MyShapes {
+
+    class ThreadPool;
+
+    enum class BooleanOp { Union, Intersection, Difference };
+
+    // Контур многоугольника: вершины по порядку, последняя соединяется с первой
+    typedef std::vector<Vertex> Contour;
+
+    // Булевы операции над простыми многоугольниками в духе Грейнера - Хормана:
+    // рёбра обоих делятся в точках пересечения, куски рёбер размечаются
+    // «внутри / снаружи / на общем ребре» другого многоугольника, нужные
+    // куски сшиваются в контуры. Вырожденные случаи (вершина на ребре, общие
+    // рёбра, касание в вершине) разбираются разметкой кусков, как у Фостера -
+    // Хормана - Попы, без шевеления координат. Деление рёбер - точные
+    // предикаты Intersect.h; пары рёбер больших многоугольников ищет
+    // SegmentSweep, малых - перебор.
+    //
+    // Результат - контуры против часовой стрелки (в осях с y вверх); дыра
+    // разности идёт по часовой. Точки пересечения округляются до целых.
+    // Difference - subject без clip. Буферы живут в потоке между вызовами.
+    void polygonBoolean(const Vertex* subject, size_t subjectCount, const Vertex* clip, size_t clipCount,
+        BooleanOp op, std::vector<Contour>& result);
+
+    // Отсечение многоугольником произвольной формы - пересечение с ним
+    inline void clipPolygon(const Contour& subject, const Contour& area, std::vector<Contour>& result) {
+        polygonBoolean(subject.data(), subject.size(), area.data(), area.size(), BooleanOp::Intersection, result);
+    }
+
+    // Пара многоугольников для пакетной обработки
+    struct BooleanTask {
+        const Contour* subject;
+        const Contour* clip;
+        BooleanOp op;
+        std::vector<Contour> result;
+    };
+
+    // Пары пакета обрабатываются параллельно на всех участниках пула
+    void polygonBooleanBatch(ThreadPool& pool, std::vector<BooleanTask>& tasks);
+
+    // Контур многоугольника, треугольника или параллелограмма;
+    // false - фигура не многоугольник
+    bool polygonContour(const Shape& shape, Contour& contour);
+
+    // op между каждой фигурой-многоугольником из shapes и tool, пакетом
+    // на пуле. replaced - фигуры, которые операция изменила, pieces - новые
+    // фигуры вместо них того же цвета (фигуру, отсечённую целиком, ничто
+    // не заменяет). Фигуры не меняются: замену выполняет вызывающий,
+    // обычно EditJournal::replace.
+    void booleanWithTool(ThreadPool& pool, const std::vector<Shape*>& shapes, const Shape& tool, BooleanOp op,
+        std::vector<Shape*>& replaced, std::vector<Shape*>& pieces);
+
+    // Объединяет с tool многоугольники из shapes, которые с ним сливаются
+    // в один контур. Если хоть один слился, replaced - они и сам tool,
+    // pieces - один многоугольник цвета tool.
+    void mergePolygons(const std::vector<Shape*>& shapes, const Shape& tool,
+        std::vector<Shape*>& replaced, std::vector<Shape*>& pieces);
+
+}
@@ -0,0 +1,372 @@
+﻿#include "RegionQuery.h"
+
+#include "HitTest.h"
+#include "Intersect.h"
+#include "ShapeKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace MyShapes {
+
+    namespace {
+        // Кандидатов на одну задачу пула: меньше - накладные расходы заметнее проверок
+        const size_t ChunkSize = 512;
+
+        // c лежит на прямой ab; попадает ли она в габарит отрезка
+        bool withinBox(const Vertex& a, const Vertex& b, const Vertex& c) {
+            return c.x >= std::min(a.x, b.x) && c.x <= std::max(a.x, b.x) &&
+                c.y >= std::min(a.y, b.y) && c.y <= std::max(a.y, b.y);
+        }
+
+        // Пересечение или касание отрезков, в том числе на одной прямой; точно
+        bool segmentsIntersect(const Vertex& p1, const Vertex& p2, const Vertex& q1, const Vertex& q2) {
+            int d1 = orientation(q1, q2, p1);
+            int d2 = orientation(q1, q2, p2);
+            int d3 = orientation(p1, p2, q1);
+            int d4 = orientation(p1, p2, q2);
+            if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+                return true;
+            }
+            return (d1 == 0 && withinBox(q1, q2, p1)) || (d2 == 0 && withinBox(q1, q2, p2)) ||
+                (d3 == 0 && withinBox(p1, p2, q1)) || (d4 == 0 && withinBox(p1, p2, q2));
+        }
+
+        Rect segmentBox(const Vertex& a, const Vertex& b) {
+            Rect r(a.x, a.y, a.x, a.y);
+            r.include(b.x, b.y);
+            return r;
+        }
+
+        // Вписанная ломаная дуги окружности: от 8 до 64 отрезков на полный круг,
+        // примерно по отрезку на 2 пикселя радиуса
+        void appendArc(std::vector<Vertex>& contour, int cx, int cy, int radius, double from, double span) {
+            double perCircle = std::min(64.0, std::max(8.0, radius / 2.0));
+            int segments = std::max(1, (int)std::ceil(perCircle * span / (2 * M_PI)));
+            for (int i = 0; i <= segments; ++i) {
+                double angle = from + span * i / segments;
+                contour.push_back(Vertex{ (int32_t)lrint(cx + radius * cos(angle)), (int32_t)lrint(cy + radius * sin(angle)) });
+            }
+        }
+
+        // Контур фигуры как набор ломаных (counts - вершин в каждой);
+        // замкнутые контуры повторяют первую вершину в конце
+        void buildContour(const Shape& shape, std::vector<Vertex>& contour, std::vector<uint32_t>& counts) {
+            contour.clear();
+            counts.clear();
+            size_t loopStart = 0;
+            auto endLoop = [&]() {
+                counts.push_back((uint32_t)(contour.size() - loopStart));
+                loopStart = contour.size();
+            };
+
+            switch (shape.kind()) {
+            case ShapeKind::Circle:
+            {
+                const Circle& circle = static_cast<const Circle&>(shape);
+                appendArc(contour, circle.getCenter().x, circle.getCenter().y, circle.getRadius(), 0, 2 * M_PI);
+                endLoop();
+                break;
+            }
+            case ShapeKind::Arc:
+            {
+                const Arc& arc = static_cast<const Arc&>(shape);
+                double from = fmod(fmod(arc.startAngle, 2 * M_PI) + 2 * M_PI, 2 * M_PI);
+                double to = fmod(fmod(arc.endAngle, 2 * M_PI) + 2 * M_PI, 2 * M_PI);
+                if (to < from) to += 2 * M_PI;  // Дуга пересекает 0 радиан
+                double span = to > from ? to - from : 2 * M_PI;  // Совпавшие концы - полный круг
+                appendArc(contour, arc.center.x, arc.center.y, arc.radius, from, span);
+                endLoop();
+                break;
+            }
+            case ShapeKind::Ring:
+            {
+                const Ring& ring = static_cast<const Ring&>(shape);
+                for (const Circle* circle : { &ring.getOuterCircle(), &ring.getInnerCircle() }) {
+                    appendArc(contour, circle->getCenter().x, circle->getCenter().y, circle->getRadius(), 0, 2 * M_PI);
+                    endLoop();
+                }
+                break;
+            }
+            default:
+            {
+                // Точка, отрезок и ломаные - по опорным точкам
+                shape.writeAnchors(contour);
+                bool closed = shape.kind() == ShapeKind::Polygon || shape.kind() == ShapeKind::Triangle ||
+                    shape.kind() == ShapeKind::Parallelogram;
+                if (closed && !contour.empty()) {
+                    contour.push_back(contour.front());
+                }
+                endLoop();
+                break;
+            }
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------- EdgeGrid
+
+    void RegionQuery::EdgeGrid::build(const std::vector<Vertex>& region, const Rect& area) {
+        outline = region.data();
+        edgeCount = region.size();
+        bounds = area;
+
+        // Около 16 ячеек на ребро: большая часть ячеек пуста, и луч в contains
+        // быстро доходит до ячейки с известной чётностью
+        int side = std::max(1, (int)std::sqrt(edgeCount * 16.0));
+        columns = std::min(side, std::max(1, bounds.width()));
+        rows = std::min(side, std::max(1, bounds.height()));
+        cellWidth = std::max(1, (bounds.width() + columns - 1) / columns);
+        cellHeight = std::max(1, (bounds.height() + rows - 1) / rows);
+
+        // Два прохода: сколько рёбер в каждой ячейке, затем раскладка
+        cellStart.assign((size_t)columns * rows + 1, 0);
+        for (int pass = 0; pass < 2; ++pass) {
+            std::vector<uint32_t> fill;
+            if (pass == 1) {
+                for (size_t c = 1; c < cellStart.size(); ++c) cellStart[c] += cellStart[c - 1];
+                cellEdges.resize(cellStart.back());
+                fill.assign(cellStart.begin(), cellStart.end() - 1);
+            }
+            for (size_t e = 0; e < edgeCount; ++e) {
+                int column0, row0, column1, row1;
+                if (!cellRange(segmentBox(outline[e], outline[(e + 1) % edgeCount]), column0, row0, column1, row1)) continue;
+                for (int row = row0; row <= row1; ++row) {
+                    for (int column = column0; column <= column1; ++column) {
+                        size_t cell = (size_t)row * columns + column;
+                        if (pass == 0) ++cellStart[cell + 1];
+                        else cellEdges[fill[cell]++] = (uint32_t)e;
+                    }
+                }
+            }
+        }
+
+        // Ячейка без рёбер целиком по одну сторону границы: достаточно её
+        // левого верхнего угла. Углы одного ряда лежат на одной прямой, и
+        // чётность для всех считается одним проходом: ребро, пересекающее
+        // прямую ряда, меняет чётность углов левее точки пересечения
+        // (правило crossesRay, как у insidePolygon). Всего O(E + ячеек).
+        cellInside.assign((size_t)columns * rows, 0);
+        size_t stride = (size_t)columns + 1;
+        flips.assign((size_t)rows * stride, 0);
+        for (size_t e = 0; e < edgeCount; ++e) {
+            const Vertex& a = outline[e];
+            const Vertex& b = outline[(e + 1) % edgeCount];
+            if (a.y == b.y) continue;
+
+            // Ряды, чья прямая y удовлетворяет (a.y > y) != (b.y > y): y из [low, high)
+            int low = std::min(a.y, b.y), high = std::max(a.y, b.y);
+            int row0 = std::max(0, (low - bounds.top + cellHeight - 1) / cellHeight);
+            int row1 = std::min(rows - 1, (high - bounds.top + cellHeight - 1) / cellHeight - 1);
+            for (int row = row0; row <= row1; ++row) {
+                int y = bounds.top + row * cellHeight;
+                double x = a.x + ((double)b.x - a.x) * ((double)y - a.y) / ((double)b.y - a.y);
+                int k = (int)std::ceil((x - bounds.left) / cellWidth);
+                k = std::max(0, std::min(columns, k));
+
+                // k - число углов ряда левее пересечения; точная поправка округления
+                while (k > 0 && !crossesRay(a.x, a.y, b.x, b.y, bounds.left + (k - 1) * cellWidth, y)) --k;
+                while (k < columns && crossesRay(a.x, a.y, b.x, b.y, bounds.left + k * cellWidth, y)) ++k;
+                flips[row * stride + k] ^= 1;
+            }
+        }
+        for (int row = 0; row < rows; ++row) {
+            uint8_t inside = 0;
+            for (int column = columns - 1; column >= 0; --column) {
+                inside ^= flips[row * stride + column + 1];
+                size_t cell = (size_t)row * columns + column;
+                if (cellStart[cell] == cellStart[cell + 1]) cellInside[cell] = inside;
+            }
+        }
+    }
+
+    int RegionQuery::EdgeGrid::firstColumn(uint32_t edge) const {
+        const Vertex& a = outline[edge];
+        const Vertex& b = outline[(edge + 1) % edgeCount];
+        return (std::max(std::min(a.x, b.x), bounds.left) - bounds.left) / cellWidth;
+    }
+
+    bool RegionQuery::EdgeGrid::cellRange(const Rect& box, int& column0, int& row0, int& column1, int& row1) const {
+        if (!box.intersects(bounds)) return false;
+        column0 = (std::max(box.left, bounds.left) - bounds.left) / cellWidth;
+        row0 = (std::max(box.top, bounds.top) - bounds.top) / cellHeight;
+        column1 = std::min(columns - 1, (std::min(box.right, bounds.right) - bounds.left) / cellWidth);
+        row1 = std::min(rows - 1, (std::min(box.bottom, bounds.bottom) - bounds.top) / cellHeight);
+        return true;
+    }
+
+    template <typename Callback>
+    bool RegionQuery::EdgeGrid::forEdges(const Rect& box, Callback&& callback) const {
+        int column0, row0, column1, row1;
+        if (!cellRange(box, column0, row0, column1, row1)) return false;
+        for (int row = row0; row <= row1; ++row) {
+            for (int column = column0; column <= column1; ++column) {
+                size_t cell = (size_t)row * columns + column;
+                for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+                    if (callback(cellEdges[i])) return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool RegionQuery::EdgeGrid::crosses(const Vertex& a, const Vertex& b) const {
+        return forEdges(segmentBox(a, b), [&](uint32_t e) {
+            return segmentsIntersect(a, b, outline[e], outline[(e + 1) % edgeCount]);
+        });
+    }
+
+    bool RegionQuery::EdgeGrid::anyNear(const Rect& box) const {
+        return forEdges(box, [&](uint32_t e) {
+            return segmentBox(outline[e], outline[(e + 1) % edgeCount]).intersects(box);
+        });
+    }
+
+    bool RegionQuery::EdgeGrid::contains(int x, int y) const {
+        if (!bounds.contains(x, y)) return false;
+        int column0 = (x - bounds.left) / cellWidth;
+        size_t rowStart = (size_t)((y - bounds.top) / cellHeight) * columns;
+
+        // Луч вправо до пустой ячейки, дальше чётность известна заранее.
+        // Ребро, лежащее в нескольких ячейках ряда, считается в первой из них.
+        bool inside = false;
+        for (int column = column0; column < columns; ++column) {
+            size_t cell = rowStart + column;
+            if (cellStart[cell] == cellStart[cell + 1]) {
+                return inside != (cellInside[cell] != 0);
+            }
+            for (uint32_t i = cellStart[cell]; i < cellStart[cell + 1]; ++i) {
+                uint32_t e = cellEdges[i];
+                if (std::max(firstColumn(e), column0) != column) continue;
+                const Vertex& a = outline[e];
+                const Vertex& b = outline[(e + 1) % edgeCount];
+                if (crossesRay(a.x, a.y, b.x, b.y, x, y)) inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    // ---------------------------------------------------------------- RegionQuery
+
+    void RegionQuery::selectRect(const Scene& scene, const Rect& area, RegionRule rule,
+        std::vector<Shape*>& result, KindMask visible) {
+        outline.assign({ Vertex{ area.left, area.top }, Vertex{ area.right, area.top },
+            Vertex{ area.right, area.bottom }, Vertex{ area.left, area.bottom } });
+        bounds = area;
+        isRect = true;
+        run(scene, rule, result, visible);
+    }
+
+    void RegionQuery::selectLasso(const Scene& scene, const std::vector<Vertex>& lasso, RegionRule rule,
+        std::vector<Shape*>& result, KindMask visible) {
+        outline = lasso;
+        bounds = Rect();
+        for (const Vertex& v : outline) {
+            bounds.include(v.x, v.y);
+        }
+        isRect = false;
+        if (outline.size() < 3) {
+            result.clear();  // Лассо без площади ничего не выделяет
+            return;
+        }
+        run(scene, rule, result, visible);
+    }
+
+    bool RegionQuery::containsBox(const Rect& box) const {
+        if (isRect) return bounds.contains(box);
+
+        // Все углы внутри лассо, и ни одно его ребро не заходит в габарит
+        const Vertex corners[] = { Vertex{ box.left, box.top }, Vertex{ box.right, box.top },
+            Vertex{ box.right, box.bottom }, Vertex{ box.left, box.bottom } };
+        for (const Vertex& corner : corners) {
+            if (!grid.contains(corner.x, corner.y)) return false;
+        }
+        return !grid.anyNear(box);
+    }
+
+    void RegionQuery::run(const Scene& scene, RegionRule rule, std::vector<Shape*>& result, KindMask visible) {
+        result.clear();
+        candidates.clear();
+        if (bounds.isEmpty()) return;
+        grid.build(outline, bounds);
+
+        // Обход индекса последовательный, всё остальное - в пуле
+        scene.query(bounds, [&](Shape* shape) {
+            candidates.push_back(shape);
+        }, visible);
+
+        accepted.assign(candidates.size(), 0);
+        auto testChunk = [&](int chunk) {
+            size_t end = std::min(candidates.size(), (chunk + 1) * ChunkSize);
+            for (size_t i = chunk * ChunkSize; i < end; ++i) {
+                Rect box = candidates[i]->bounds();
+                if (!box.intersects(bounds)) continue;  // Задет только расширенный габарит
+                if (containsBox(box)) {
+                    accepted[i] = 1;
+                }
+                else if (!(isRect && rule == RegionRule::Inside)) {
+                    // Габарит прямоугольной рамки точен: не поместившаяся в неё фигура
+                    // не лежит в ней целиком, точная проверка не нужна
+                    accepted[i] = testShape(candidates[i], rule);
+                }
+            }
+        };
+        int chunks = (int)((candidates.size() + ChunkSize - 1) / ChunkSize);
+        if (pool && chunks > 1) {
+            pool->parallelFor(chunks, testChunk);
+        }
+        else {
+            for (int chunk = 0; chunk < chunks; ++chunk) testChunk(chunk);
+        }
+
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (accepted[i]) result.push_back(candidates[i]);
+        }
+    }
+
+    bool RegionQuery::testShape(Shape* shape, RegionRule rule) const {
+        static thread_local std::vector<Vertex> contour;
+        static thread_local std::vector<uint32_t> counts;
+        static thread_local std::vector<uint8_t> inside;
+        buildContour(*shape, contour, counts);
+        if (contour.empty()) return false;
+
+        inside.resize(contour.size());
+        if (isRect) {
+            for (size_t i = 0; i < contour.size(); ++i) {
+                inside[i] = bounds.contains(contour[i].x, contour[i].y);
+            }
+        }
+        else {
+            for (size_t i = 0; i < contour.size(); ++i) {
+                inside[i] = grid.contains(contour[i].x, contour[i].y);
+            }
+        }
+
+        bool anyInside = false, allInside = true;
+        for (uint8_t flag : inside) {
+            anyInside = anyInside || flag;
+            allInside = allInside && flag;
+        }
+        if (rule == RegionRule::Touching && anyInside) return true;
+        if (rule == RegionRule::Inside && !allInside) return false;
+
+        // Контур пересекает границу области: у вогнутого лассо так бывает,
+        // даже когда все вершины контура внутри
+        bool crosses = false;
+        const Vertex* loop = contour.data();
+        for (uint32_t n : counts) {
+            for (uint32_t k = 0; k + 1 < n && !crosses; ++k) {
+                crosses = grid.crosses(loop[k], loop[k + 1]);
+            }
+            loop += n;
+        }
+        if (rule == RegionRule::Inside) return !crosses;
+        if (crosses) return true;
+
+        // Ни одной общей точки контуров: область может лежать внутри заливки фигуры
+        return shape->isClicked(outline[0].x, outline[0].y);
+    }
+
+}
@@ -0,0 +1,96 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Geometry.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Shapes.h"
+
+namespace MyShapes {
+
+    class ThreadPool;
+
+    // Когда фигура считается попавшей в область выделения
+    enum class RegionRule {
+        Inside,    // Лежит в области целиком
+        Touching   // Хотя бы частично в области
+    };
+
+    // Выделение рамкой и лассо. Кандидаты отбираются пространственным индексом
+    // сцены по габариту области. Фигуры, чей габарит целиком внутри области,
+    // принимаются сразу; остальные проверяются точно по контуру: контур
+    // окружностей и дуг - вписанная ломаная. Кандидаты проверяются
+    // параллельно в пуле (или в вызывающем потоке, если пула нет), рёбра
+    // области разложены по сетке, поэтому ребро контура сравнивается только
+    // с рёбрами области поблизости. Буферы переиспользуются между вызовами.
+    class RegionQuery {
+    public:
+        explicit RegionQuery(ThreadPool* pool = nullptr) : pool(pool) {}
+
+        // Фигуры видов из visible в прямоугольнике area, в произвольном порядке
+        void selectRect(const Scene& scene, const Rect& area, RegionRule rule,
+            std::vector<Shape*>& result, KindMask visible = AllKinds);
+
+        // То же для замкнутой ломаной lasso (замыкающее ребро подразумевается)
+        void selectLasso(const Scene& scene, const std::vector<Vertex>& lasso, RegionRule rule,
+            std::vector<Shape*>& result, KindMask visible = AllKinds);
+
+        // Рёбра области, разложенные по ячейкам равномерной сетки
+        class EdgeGrid {
+        public:
+            void build(const std::vector<Vertex>& outline, const Rect& bounds);
+
+            // Пересекает ли отрезок (a, b) хотя бы одно ребро области
+            bool crosses(const Vertex& a, const Vertex& b) const;
+
+            // Есть ли рёбра, чей габарит пересекает box
+            bool anyNear(const Rect& box) const;
+
+            // Точка внутри области; то же правило, что у insidePolygon,
+            // но луч проверяется только до ближайшей пустой ячейки справа
+            bool contains(int x, int y) const;
+
+        private:
+            const Vertex* outline = nullptr;
+            size_t edgeCount = 0;
+            Rect bounds;
+            int columns = 0, rows = 0;
+            int cellWidth = 1, cellHeight = 1;
+            std::vector<uint32_t> cellStart;  // Начало списка ячейки в cellEdges
+            std::vector<uint32_t> cellEdges;  // Номера рёбер, ячейка за ячейкой
+            std::vector<uint8_t> cellInside;  // Для ячеек без рёбер - лежат ли они внутри
+            std::vector<uint8_t> flips;       // Смены чётности по рядам при заполнении cellInside
+
+            // Ячейки, накрывающие box: [column0, column1] x [row0, row1]
+            bool cellRange(const Rect& box, int& column0, int& row0, int& column1, int& row1) const;
+
+            int firstColumn(uint32_t edge) const;
+
+            template <typename Callback>
+            bool forEdges(const Rect& box, Callback&& callback) const;
+        };
+
+    private:
+        ThreadPool* pool;
+
+        // Текущая область
+        std::vector<Vertex> outline;
+        Rect bounds;
+        bool isRect = false;
+        EdgeGrid grid;
+
+        std::vector<Shape*> candidates;  // Все фигуры, найденные индексом
+        std::vector<uint8_t> accepted;
+
+        void run(const Scene& scene, RegionRule rule, std::vector<Shape*>& result, KindMask visible);
+
+        // Точная проверка одной фигуры; вызывается из разных потоков
+        bool testShape(Shape* shape, RegionRule rule) const;
+
+        // Лежит ли весь габарит внутри области
+        bool containsBox(const Rect& box) const;
+    };
+
+}
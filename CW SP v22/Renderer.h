@@ -0,0 +1,86 @@
+﻿#pragma once
+
+#include <cstdint>
+
+namespace MyShapes {
+
+    // Цвет в формате 0x00BBGGRR (совпадает с раскладкой COLORREF)
+    typedef uint32_t Color;
+
+    inline Color makeColor(int r, int g, int b) {
+        return (Color)((r & 0xFF) | ((g & 0xFF) << 8) | ((b & 0xFF) << 16));
+    }
+
+    inline int colorRed(Color c) { return c & 0xFF; }
+    inline int colorGreen(Color c) { return (c >> 8) & 0xFF; }
+    inline int colorBlue(Color c) { return (c >> 16) & 0xFF; }
+
+    enum class PenStyle {
+        Solid,
+        Dash,
+        Dot
+    };
+
+    // Параметры пера. Одинаковые перья рендерер выбирает повторно без затрат.
+    struct Pen {
+        Color color;
+        int width;
+        PenStyle style;
+
+        Pen(Color color, int width = 1, PenStyle style = PenStyle::Solid)
+            : color(color), width(width), style(style) {}
+
+        bool operator==(const Pen& other) const {
+            return color == other.color && width == other.width && style == other.style;
+        }
+
+        bool operator!=(const Pen& other) const {
+            return !(*this == other);
+        }
+    };
+
+    // Вершина ломаной; раскладка совпадает с POINT
+    struct Vertex {
+        int32_t x, y;
+    };
+
+    // Интерфейс вывода графики. Фигуры рисуют себя только через него,
+    // поэтому библиотека фигур не зависит от WinAPI.
+    // Семантика методов повторяет соответствующие функции GDI.
+    class Renderer {
+    public:
+        // Устанавливает текущее перо. Подряд идущие фигуры одного стиля
+        // вызывают setPen с тем же пером, реализации должны пропускать такой вызов.
+        virtual void setPen(const Pen& pen) = 0;
+
+        // Сплошное перо толщиной 1 пиксель
+        void setPen(Color color) { setPen(Pen(color)); }
+
+        virtual void pixel(int x, int y, Color color) = 0;
+
+        // Отрезок без последней точки, как у пары MoveToEx/LineTo
+        virtual void line(int x1, int y1, int x2, int y2) = 0;
+
+        // Несколько ломаных текущим пером: counts[i] вершин i-й ломаной лежат
+        // в vertices подряд. Последняя точка каждой ломаной не рисуется, как у LineTo.
+        // По умолчанию разбивается на отрезки.
+        virtual void polyPolyline(const Vertex* vertices, const uint32_t* counts, int polylineCount) {
+            for (int i = 0; i < polylineCount; ++i) {
+                for (uint32_t k = 1; k < counts[i]; ++k) {
+                    line(vertices[k - 1].x, vertices[k - 1].y, vertices[k].x, vertices[k].y);
+                }
+                vertices += counts[i];
+            }
+        }
+
+        // Эллипс, вписанный в прямоугольник; внутренность заливается фоном
+        virtual void ellipse(int left, int top, int right, int bottom) = 0;
+
+        // Дуга эллипса против часовой стрелки от луча (xStart, yStart) до луча (xEnd, yEnd)
+        virtual void arc(int left, int top, int right, int bottom,
+            int xStart, int yStart, int xEnd, int yEnd) = 0;
+
+        virtual ~Renderer() {}
+    };
+
+}
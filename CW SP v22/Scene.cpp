@@ -0,0 +1,338 @@
+﻿#include "Scene.h"
+
+#include <algorithm>
+
+namespace MyShapes {
+
+    Scene::~Scene() {
+        clear();
+    }
+
+    void Scene::add(Shape* shape) {
+        addEntry(shape, false);
+    }
+
+    void Scene::addEntry(Shape* shape, bool inArena) {
+        orders.push_back(nextOrder);
+        link(shape, inArena, nextOrder++);
+        shapes.push_back(shape);
+    }
+
+    void Scene::link(Shape* shape, bool inArena, uint64_t order) {
+        Entry& entry = entries[shape];
+        entry.shape = shape;
+        entry.inArena = inArena;
+        if (!inArena) ++heapShapes;
+        if (precise) shape->setPrecise(true);
+        entry.kind = shape->kind();
+        entry.drawn = shape->bounds();
+        entry.proxy = bulk ? index.insertDeferred(entry.drawn, &entry, kindBit(entry.kind)) :
+            index.insert(entry.drawn, &entry, kindBit(entry.kind));
+        entry.order = order;
+
+        std::vector<Shape*>& bucket = buckets[(int)entry.kind];
+        entry.slot = bucket.size();
+        bucket.push_back(shape);
+        addDamage(entry.drawn);
+    }
+
+    void Scene::beginBulkInsert(size_t expectedCount) {
+        bulk = true;
+        if (expectedCount > 0) {
+            entries.reserve(entries.size() + expectedCount);
+            shapes.reserve(shapes.size() + expectedCount);
+            orders.reserve(orders.size() + expectedCount);
+        }
+    }
+
+    void Scene::endBulkInsert() {
+        bulk = false;
+        if (index.pendingCount() > 0) {
+            index.rebuild();
+        }
+    }
+
+    void Scene::remove(Shape* shape) {
+        if (entries.find(shape) == entries.end()) return;
+
+        Detached detached = unlink(shape);
+        shapes[slotOf(detached.order)] = nullptr;
+        ++holes;
+        if (holes > shapes.size() / 2) compact();  // Память дыр не больше памяти фигур
+        destroy(detached);
+    }
+
+    size_t Scene::slotOf(uint64_t order) const {
+        return std::lower_bound(orders.begin(), orders.end(), order) - orders.begin();
+    }
+
+    void Scene::compact() const {
+        if (holes == 0) return;
+        size_t kept = 0;
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            if (!shapes[i]) continue;
+            shapes[kept] = shapes[i];
+            orders[kept] = orders[i];
+            ++kept;
+        }
+        shapes.resize(kept);
+        orders.resize(kept);
+        holes = 0;
+    }
+
+    Scene::Detached Scene::unlink(Shape* shape) {
+        auto found = entries.find(shape);
+        const Entry& entry = found->second;
+        addDamage(entry.drawn);
+        index.remove(entry.proxy);
+
+        // Порядок внутри корзины не важен: переносим последнюю фигуру на место удалённой
+        std::vector<Shape*>& bucket = buckets[(int)entry.kind];
+        Shape* last = bucket.back();
+        bucket[entry.slot] = last;
+        entries[last].slot = entry.slot;
+        bucket.pop_back();
+
+        Detached detached = { shape, entry.order, entry.inArena };
+        if (!entry.inArena) --heapShapes;
+        entries.erase(found);
+        return detached;
+    }
+
+    void Scene::detach(const std::vector<Shape*>& toDetach, std::vector<Detached>& result) {
+        result.clear();
+        result.reserve(toDetach.size());
+        for (Shape* shape : toDetach) {
+            if (entries.find(shape) != entries.end()) {
+                result.push_back(unlink(shape));
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const Detached& a, const Detached& b) {
+            return a.order < b.order;
+        });
+
+        // Места находятся по order и остаются дырами, как в remove: их order
+        // сохраняется, и restore вернёт фигуры на те же места
+        for (const Detached& d : result) {
+            shapes[slotOf(d.order)] = nullptr;
+        }
+        holes += result.size();
+        if (holes > shapes.size() / 2) compact();
+    }
+
+    void Scene::restore(const std::vector<Detached>& detached) {
+        if (detached.empty()) return;
+
+        std::vector<Detached> sorted;
+        for (const Detached& d : detached) {
+            // Режим точности мог смениться, пока фигура была снята
+            if (!precise) d.shape->setPrecise(false);
+            link(d.shape, d.inArena, d.order);
+
+            // Дыра фигуры ещё не убрана compact: фигура встаёт в неё
+            size_t at = slotOf(d.order);
+            if (at < shapes.size() && orders[at] == d.order && shapes[at] == nullptr) {
+                shapes[at] = d.shape;
+                --holes;
+            }
+            else {
+                sorted.push_back(d);
+            }
+        }
+        if (sorted.empty()) return;
+
+        compact();
+        std::sort(sorted.begin(), sorted.end(), [](const Detached& a, const Detached& b) {
+            return a.order < b.order;
+        });
+
+        // shapes упорядочены по order: несколько фигур встают на место
+        // двоичным поиском, много - одним слиянием
+        if (sorted.size() <= 8) {
+            for (const Detached& d : sorted) {
+                size_t at = slotOf(d.order);
+                shapes.insert(shapes.begin() + at, d.shape);
+                orders.insert(orders.begin() + at, d.order);
+            }
+            return;
+        }
+
+        std::vector<Shape*> merged;
+        std::vector<uint64_t> mergedOrders;
+        merged.reserve(shapes.size() + sorted.size());
+        mergedOrders.reserve(shapes.size() + sorted.size());
+        size_t j = 0;
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            while (j < sorted.size() && sorted[j].order < orders[i]) {
+                merged.push_back(sorted[j].shape);
+                mergedOrders.push_back(sorted[j++].order);
+            }
+            merged.push_back(shapes[i]);
+            mergedOrders.push_back(orders[i]);
+        }
+        for (; j < sorted.size(); ++j) {
+            merged.push_back(sorted[j].shape);
+            mergedOrders.push_back(sorted[j].order);
+        }
+        shapes.swap(merged);
+        orders.swap(mergedOrders);
+    }
+
+    void Scene::destroy(const Detached& detached) {
+        if (detached.inArena) {
+            arena.destroy(detached.shape);
+        }
+        else {
+            delete detached.shape;
+        }
+    }
+
+    void Scene::update(Shape* shape) {
+        auto found = entries.find(shape);
+        if (found == entries.end()) return;
+
+        Entry& entry = found->second;
+        Rect bounds = shape->bounds();
+
+        // Стираем фигуру на старом месте и рисуем на новом
+        addDamage(entry.drawn);
+        addDamage(bounds);
+        entry.drawn = bounds;
+
+        index.update(entry.proxy, bounds);
+    }
+
+    void Scene::setPrecise(bool on) {
+        compact();
+        precise = on;
+        for (Shape* shape : shapes) {
+            shape->setPrecise(on);
+        }
+    }
+
+    void Scene::clear() {
+        compact();
+
+        // Деструкторы фигур арены не вызываются: исходные копии режима
+        // точности лежат в куче и освобождаются заранее
+        if (precise) {
+            for (Shape* shape : shapes) {
+                shape->setPrecise(false);
+            }
+        }
+
+        // Снимки общих вершин ломаных лежат в куче: отдаём их до арены
+        for (ShapeKind kind : { ShapeKind::Polyline, ShapeKind::Polygon, ShapeKind::Triangle, ShapeKind::Parallelogram }) {
+            for (Shape* shape : buckets[(int)kind]) {
+                static_cast<Polyline*>(shape)->releaseSnapshot();
+            }
+        }
+
+        // По одной удаляются только фигуры из кучи, фигуры арены уходят вместе с ней
+        if (heapShapes > 0) {
+            for (Shape* shape : shapes) {
+                if (!entries[shape].inArena) delete shape;
+            }
+            heapShapes = 0;
+        }
+        shapes.clear();
+        orders.clear();
+
+        // Таблица entries лежит в арене: освобождаем её целиком до самой арены
+        {
+            std::pmr::unordered_map<const Shape*, Entry> empty(arena.getResource());
+            entries.swap(empty);
+        }
+        arena.release();
+        for (std::vector<Shape*>& bucket : buckets) {
+            bucket.clear();
+        }
+        index.clear();
+        damage.clear();
+    }
+
+    void Scene::collect(const Rect& area, std::vector<Shape*>& result, KindMask visible) const {
+        result.clear();
+
+        // Область накрывает всю сцену (перерисовка окна целиком): индекс ничего
+        // не отсечёт, а shapes уже лежат в порядке отрисовки - сортировать не нужно
+        if (area.contains(index.getBounds())) {
+            // Дыры пропускаются, а не убираются: отмена удаления вернёт фигуры в них
+            result.reserve(size());
+            for (Shape* shape : shapes) {
+                if (shape && (visible & kindBit(shape->kind()))) {
+                    result.push_back(shape);
+                }
+            }
+            return;
+        }
+
+        std::vector<std::pair<uint64_t, Shape*>> found;
+        queryEntries(area, visible, [&](const Entry& entry) {
+            // drawn совпадает с текущим габаритом: update вызывается после каждой правки
+            if (entry.drawn.intersects(area)) {
+                found.push_back(std::make_pair(entry.order, entry.shape));
+            }
+        });
+
+        std::sort(found.begin(), found.end());
+
+        result.reserve(found.size());
+        for (const auto& item : found) {
+            result.push_back(item.second);
+        }
+    }
+
+    void Scene::addDamage(const Rect& area) {
+        if (area.isEmpty()) return;
+
+        // Пересекающиеся прямоугольники сливаем, пока слияние что-то даёт
+        Rect merged = area;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t i = 0; i < damage.size(); ++i) {
+                if (damage[i].intersects(merged)) {
+                    merged.unite(damage[i]);
+                    damage[i] = damage.back();
+                    damage.pop_back();
+                    changed = true;
+                    break;
+                }
+            }
+        }
+
+        if (damage.size() >= MaxDamageRects) {
+            for (const Rect& r : damage) merged.unite(r);
+            damage.clear();
+        }
+        damage.push_back(merged);
+    }
+
+    std::vector<Rect> Scene::takeDamage() {
+        std::vector<Rect> result;
+        result.swap(damage);
+        return result;
+    }
+
+    Shape* Scene::pick(int x, int y, KindMask visible) const {
+        Shape* best = nullptr;
+        uint64_t bestOrder = 0;
+
+        Rect area(x - PickTolerance, y - PickTolerance, x + PickTolerance, y + PickTolerance);
+        queryEntries(area, visible, [&](const Entry& entry) {
+            Shape* shape = entry.shape;
+            uint64_t order = entry.order;
+
+            // Точную проверку делаем только для фигур выше уже найденной
+            if ((best == nullptr || order > bestOrder) &&
+                shape->bounds().inflated(PickTolerance).contains(x, y) &&
+                shape->isClicked(x, y)) {
+                best = shape;
+                bestOrder = order;
+            }
+        });
+        return best;
+    }
+
+}
@@ -0,0 +1,171 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ShapeArena.h"
+#include "Shapes.h"
+#include "SpatialIndex.h"
+
+namespace MyShapes {
+
+    // Документ редактора: владеет фигурами, хранит порядок отрисовки
+    // и поддерживает пространственный индекс по их габаритам.
+    // Фигуры также разложены по корзинам по виду (ShapeKind); листья индекса
+    // помечены битом вида, поэтому поддеревья из одних скрытых видов
+    // пропускаются целиком, без проверки каждой фигуры.
+    // Фигуры, созданные через create, живут в арене документа: clear и
+    // деструктор освобождают их разом, не обходя по одной.
+    class Scene {
+    public:
+        // Допуск на клик, как у Line::isClicked и Polyline::isClicked
+        static const int PickTolerance = 5;
+
+        Scene() {}
+        ~Scene();
+
+        Scene(const Scene&) = delete;
+        Scene& operator=(const Scene&) = delete;
+
+        // Добавляет фигуру поверх остальных, сцена становится её владельцем
+        void add(Shape* shape);
+
+        // Создаёт фигуру в арене сцены и добавляет её поверх остальных
+        template <typename T, typename... Args>
+        T* create(Args&&... args) {
+            T* shape = arena.template create<T>(std::forward<Args>(args)...);
+            addEntry(shape, true);
+            return shape;
+        }
+
+        // Пакетное добавление: между beginBulkInsert и endBulkInsert фигуры
+        // не вставляются в индекс по одной, а попадают в него одной
+        // перестройкой в конце (SpatialIndex::rebuild). До endBulkInsert
+        // pick, query и collect новых фигур не видят. expectedCount, если
+        // известно, резервирует таблицу фигур сразу под весь пакет.
+        void beginBulkInsert(size_t expectedCount = 0);
+        void endBulkInsert();
+
+        // Удаляет фигуру из сцены и освобождает её
+        void remove(Shape* shape);
+
+        // Фигура, снятая со сцены без освобождения: помнит своё место в
+        // порядке отрисовки и то, кто её освобождает
+        struct Detached {
+            Shape* shape;
+            uint64_t order;
+            bool inArena;
+        };
+
+        // Снимает фигуры со сцены, не освобождая их; result получает их в
+        // порядке отрисовки. Пока фигура снята, ею владеет вызывающий: вернуть
+        // её можно через restore, освободить - через destroy. Фигуры арены
+        // должны быть возвращены или освобождены до clear.
+        void detach(const std::vector<Shape*>& shapes, std::vector<Detached>& result);
+        void restore(const std::vector<Detached>& detached);
+        void destroy(const Detached& detached);
+
+        // Должен вызываться после любого изменения геометрии фигуры
+        // (move, rotate, mirror, trim)
+        void update(Shape* shape);
+
+        void clear();
+
+        // Режим точности для всех фигур сцены, в том числе добавленных позже
+        // (CachedBoundsShape::setPrecise). При выключении фигуры сохраняют
+        // текущую геометрию. По умолчанию выключен: каждая фигура в нём
+        // держит копию исходной геометрии в куче, преобразуется по одной
+        // мимо пакетного пути BatchTransform, а clear обходит все фигуры.
+        void setPrecise(bool on);
+        bool isPrecise() const { return precise; }
+
+        // Самая верхняя фигура видов из visible под точкой или nullptr
+        Shape* pick(int x, int y, KindMask visible = AllKinds) const;
+
+        // Вызывает callback(Shape*) для фигур видов из visible,
+        // чей габарит может пересекать area
+        template <typename Callback>
+        void query(const Rect& area, Callback&& callback, KindMask visible = AllKinds) const {
+            queryEntries(area, visible, [&](const Entry& entry) {
+                callback(entry.shape);
+            });
+        }
+
+        // Фигуры видов из visible, чей габарит пересекает area, в порядке отрисовки
+        void collect(const Rect& area, std::vector<Shape*>& result, KindMask visible = AllKinds) const;
+
+        // Повреждённая область: объединение старых и новых габаритов фигур,
+        // изменённых через add, remove и update. Окно перерисовывает только её.
+        void addDamage(const Rect& area);
+        void addDamage(const Shape* shape) { addDamage(shape->bounds()); }
+
+        // Возвращает накопленные прямоугольники и очищает список
+        std::vector<Rect> takeDamage();
+
+        // Фигуры в порядке отрисовки (последняя - самая верхняя)
+        const std::vector<Shape*>& getShapes() const {
+            compact();
+            return shapes;
+        }
+        size_t size() const { return shapes.size() - holes; }
+        // Фигуры из кучи (add): clear удаляет их по одной, без них - только арену
+        size_t heapCount() const { return heapShapes; }
+
+        // Фигуры одного вида в произвольном порядке
+        const std::vector<Shape*>& getShapes(ShapeKind kind) const { return buckets[(int)kind]; }
+
+        const SpatialIndex& getIndex() const { return index; }
+
+    private:
+        struct Entry {
+            Shape* shape;
+            int proxy;       // Лист в пространственном индексе
+            uint64_t order;  // Чем больше, тем выше фигура
+            Rect drawn;      // Габарит на момент последней отрисовки
+            ShapeKind kind;  // Корзина, в которой лежит фигура
+            size_t slot;     // Позиция в корзине своего вида
+            bool inArena;    // Создана через create: освобождает арена
+        };
+
+        void addEntry(Shape* shape, bool inArena);
+        // Заводит запись и лист индекса; в shapes фигуру кладёт вызывающий
+        void link(Shape* shape, bool inArena, uint64_t order);
+        Detached unlink(Shape* shape);
+        // Место фигуры с данным order в shapes: двоичный поиск по orders
+        size_t slotOf(uint64_t order) const;
+        // Убирает из shapes дыры, оставленные remove и detach
+        void compact() const;
+
+        // Листья индексов хранят указатель на Entry: узлы unordered_map не перемещаются
+        template <typename Callback>
+        void queryEntries(const Rect& area, KindMask visible, Callback&& callback) const {
+            index.query(area, [&](int proxy) {
+                callback(*static_cast<const Entry*>(index.getUserData(proxy)));
+                return true;
+            }, visible);
+        }
+
+        // Больше прямоугольников не храним: сливаем их в один
+        static const size_t MaxDamageRects = 16;
+
+        // Арена объявлена первой: узлы entries живут в ней и должны уйти раньше
+        ShapeArena arena;
+        // Порядок отрисовки и order каждой позиции (по возрастанию). remove и
+        // detach оставляют в shapes дыру (nullptr) за O(log n), restore
+        // заполняет её обратно. Дыры убираются одним проходом, когда их больше
+        // половины или shapes отдаются наружу (getShapes).
+        mutable std::vector<Shape*> shapes;
+        mutable std::vector<uint64_t> orders;
+        mutable size_t holes = 0;
+        std::pmr::unordered_map<const Shape*, Entry> entries{ arena.getResource() };
+        size_t heapShapes = 0;  // Добавлены через add и удаляются по одной
+        std::vector<Shape*> buckets[ShapeKindCount];
+        SpatialIndex index;
+        uint64_t nextOrder = 0;
+        std::vector<Rect> damage;
+        bool precise = false;
+        bool bulk = false;
+    };
+
+}
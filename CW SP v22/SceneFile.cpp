@@ -0,0 +1,369 @@
+﻿#include "SceneFile.h"
+
+#include "Scene.h"
+#include "SceneStore.h"
+#include "ShapeKernels.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace MyShapes {
+
+    using namespace SceneFormat;
+
+    namespace {
+        const size_t SectionAlignment = 8;
+
+        size_t alignUp(size_t offset) {
+            return (offset + SectionAlignment - 1) & ~(SectionAlignment - 1);
+        }
+
+        // Столбцы, без которых строку вида не прочитать
+        uint32_t requiredColumns(ShapeKind kind) {
+            auto bit = [](Column column) { return 1u << column; };
+            uint32_t mask = bit(ColumnColor);
+            switch (kind) {
+            case ShapeKind::Line:
+                return mask | bit(ColumnX) | bit(ColumnY) | bit(ColumnX2) | bit(ColumnY2);
+            case ShapeKind::Circle:
+                return mask | bit(ColumnX) | bit(ColumnY) | bit(ColumnRadius);
+            case ShapeKind::Arc:
+                return mask | bit(ColumnX) | bit(ColumnY) | bit(ColumnRadius) | bit(ColumnStartAngle) | bit(ColumnEndAngle);
+            case ShapeKind::Ring:
+                return mask | bit(ColumnX) | bit(ColumnY) | bit(ColumnRadius) | bit(ColumnInnerRadius);
+            default:
+                return mask | bit(ColumnFirst) | bit(ColumnVertexCount);
+            }
+        }
+    }
+
+    // ---------------------------------------------------------------- SceneFileWriter
+
+    void SceneFileWriter::addSection(uint32_t id, const void* data, size_t elementSize, size_t count) {
+        sections.push_back(Pending{ id, data, elementSize, count });
+    }
+
+    bool SceneFileWriter::write(const char* path, uint64_t shapeCount, uint64_t vertexCount) const {
+        Header header;
+        memcpy(header.magic, Magic, sizeof(header.magic));
+        header.version = Version;
+        header.byteOrder = ByteOrder;
+        header.sectionCount = (uint32_t)sections.size();
+        header.shapeCount = shapeCount;
+        header.vertexCount = vertexCount;
+
+        // Оглавление целиком известно заранее: смещения считаются до записи данных
+        std::vector<Section> table;
+        size_t offset = alignUp(sizeof(Header) + sections.size() * sizeof(Section));
+        for (const Pending& pending : sections) {
+            table.push_back(Section{ pending.id, (uint32_t)pending.elementSize, offset, pending.count });
+            offset = alignUp(offset + pending.elementSize * pending.count);
+        }
+
+        FILE* file = fopen(path, "wb");
+        if (!file) return false;
+
+        static const char padding[SectionAlignment] = {};
+        size_t written = 0;
+        auto put = [&](const void* bytes, size_t size) {
+            if (size != 0 && fwrite(bytes, 1, size, file) != size) return false;
+            written += size;
+            return true;
+        };
+        auto pad = [&]() {
+            return put(padding, alignUp(written) - written);
+        };
+
+        bool ok = put(&header, sizeof(header)) && put(table.data(), table.size() * sizeof(Section)) && pad();
+        for (size_t i = 0; ok && i < sections.size(); ++i) {
+            ok = put(sections[i].data, sections[i].elementSize * sections[i].count) && pad();
+        }
+        ok = fclose(file) == 0 && ok;
+        if (!ok) remove(path);  // Недописанный документ хуже отсутствующего
+        return ok;
+    }
+
+    // ---------------------------------------------------------------- SceneFile
+
+    bool SceneFile::open(const char* path) {
+        close();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && (uint64_t)size.QuadPart >= sizeof(Header) &&
+            (uint64_t)size.QuadPart <= SIZE_MAX) {
+            // Отображение держит файл само, дескрипторы больше не нужны
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                length = (size_t)size.QuadPart;
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && (uint64_t)info.st_size >= sizeof(Header)) {
+            void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED) {
+                data = static_cast<const unsigned char*>(view);
+                length = (size_t)info.st_size;
+            }
+        }
+        ::close(fd);
+#endif
+
+        if (!data) {
+            length = 0;
+            return false;
+        }
+        if (!readSections() || !validate()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void SceneFile::close() {
+        if (data) {
+#ifdef _WIN32
+            UnmapViewOfFile(data);
+#else
+            munmap(const_cast<unsigned char*>(data), length);
+#endif
+        }
+        data = nullptr;
+        length = 0;
+        for (Columns& columns : tables) columns = Columns();
+        order = nullptr;
+        orderBounds = nullptr;
+        vertices = nullptr;
+        shapeCount = 0;
+        vertexTotal = 0;
+    }
+
+    bool SceneFile::readSections() {
+        Header header;
+        memcpy(&header, data, sizeof(header));
+        if (memcmp(header.magic, Magic, sizeof(header.magic)) != 0) return false;
+        if (header.byteOrder != ByteOrder || header.version == 0 || header.version > Version) return false;
+        if (header.sectionCount > (length - sizeof(Header)) / sizeof(Section)) return false;
+        if (header.shapeCount > SIZE_MAX || header.vertexCount > UINT32_MAX) return false;
+        shapeCount = (size_t)header.shapeCount;
+        vertexTotal = (size_t)header.vertexCount;
+
+        uint32_t present[ShapeKindCount] = {};
+        const Section* table = reinterpret_cast<const Section*>(data + sizeof(Header));
+        for (uint32_t i = 0; i < header.sectionCount; ++i) {
+            Section section;
+            memcpy(&section, table + i, sizeof(section));
+            if (section.elementSize == 0 || section.offset % SectionAlignment != 0 || section.offset > length ||
+                section.count > (length - section.offset) / section.elementSize) {
+                return false;
+            }
+            const void* at = data + section.offset;
+
+            if (section.id < (uint32_t)ShapeKindCount * ColumnsPerKind) {
+                int kind = section.id / ColumnsPerKind;
+                Column column = (Column)(section.id % ColumnsPerKind);
+                bool angle = column == ColumnStartAngle || column == ColumnEndAngle;
+                if (section.elementSize != (angle ? sizeof(double) : sizeof(int32_t))) return false;
+
+                // Все столбцы вида - одной длины
+                Columns& t = tables[kind];
+                if (present[kind] != 0 && t.rows != section.count) return false;
+                t.rows = (size_t)section.count;
+                present[kind] |= 1u << column;
+
+                const int32_t* ints = static_cast<const int32_t*>(at);
+                const uint32_t* words = static_cast<const uint32_t*>(at);
+                switch (column) {
+                case ColumnColor: t.color = words; break;
+                case ColumnX: t.x = ints; break;
+                case ColumnY: t.y = ints; break;
+                case ColumnX2: t.x2 = ints; break;
+                case ColumnY2: t.y2 = ints; break;
+                case ColumnRadius: t.radius = ints; break;
+                case ColumnInnerRadius: t.innerRadius = ints; break;
+                case ColumnStartAngle: t.startAngle = static_cast<const double*>(at); break;
+                case ColumnEndAngle: t.endAngle = static_cast<const double*>(at); break;
+                case ColumnFirst: t.first = words; break;
+                case ColumnVertexCount: t.count = words; break;
+                default: break;
+                }
+            }
+            else if (section.id == SectionOrder) {
+                if (section.elementSize != sizeof(uint32_t) || section.count != shapeCount) return false;
+                order = static_cast<const uint32_t*>(at);
+            }
+            else if (section.id == SectionBounds) {
+                if (section.elementSize != sizeof(Rect) || section.count != shapeCount) return false;
+                orderBounds = static_cast<const Rect*>(at);
+            }
+            else if (section.id == SectionVertices) {
+                if (section.elementSize != sizeof(Vertex) || section.count != vertexTotal) return false;
+                vertices = static_cast<const Vertex*>(at);
+            }
+            // Незнакомые разделы - от более поздней версии, пропускаем
+        }
+
+        for (int kind = 0; kind < ShapeKindCount; ++kind) {
+            if (tables[kind].rows == 0) continue;
+            if (kind == (int)ShapeKind::Point) return false;
+            uint32_t required = requiredColumns((ShapeKind)kind);
+            if ((present[kind] & required) != required) return false;
+        }
+        return (shapeCount == 0 || (order && orderBounds)) && (vertexTotal == 0 || vertices);
+    }
+
+    // Все ссылки ведут внутрь файла: дальше draw и loadInto их не проверяют
+    bool SceneFile::validate() const {
+        for (size_t i = 0; i < shapeCount; ++i) {
+            uint32_t kind = order[i] >> OrderRowBits;
+            uint32_t row = order[i] & ((1u << OrderRowBits) - 1);
+            if (kind >= (uint32_t)ShapeKindCount || row >= tables[kind].rows) return false;
+        }
+        for (int kind = (int)ShapeKind::Polyline; kind < ShapeKindCount; ++kind) {
+            const Columns& t = tables[kind];
+            for (size_t row = 0; row < t.rows; ++row) {
+                if (t.first[row] > vertexTotal || t.count[row] > vertexTotal - t.first[row]) return false;
+                if (kind == (int)ShapeKind::Triangle && t.count[row] != 3) return false;
+                if (kind == (int)ShapeKind::Parallelogram && t.count[row] != 4) return false;
+            }
+        }
+        return true;
+    }
+
+    void SceneFile::drawRow(Renderer& renderer, ShapeKind kind, size_t row) const {
+        const Columns& t = tables[(int)kind];
+        renderer.setPen(t.color[row]);
+
+        // Те же вызовы Renderer, что в SceneStore::drawRow
+        switch (kind) {
+        case ShapeKind::Line:
+            renderer.line(t.x[row], t.y[row], t.x2[row], t.y2[row]);
+            break;
+        case ShapeKind::Circle:
+        {
+            int cx = t.x[row], cy = t.y[row], r = t.radius[row];
+            renderer.ellipse(cx - r, cy - r, cx + r, cy + r);
+            break;
+        }
+        case ShapeKind::Arc:
+        {
+            int cx = t.x[row], cy = t.y[row], r = t.radius[row];
+            int xStart, yStart, xEnd, yEnd;
+            arcEndPoints(cx, cy, r, t.startAngle[row], t.endAngle[row], xStart, yStart, xEnd, yEnd);
+            renderer.arc(cx - r, cy - r, cx + r, cy + r, xEnd, yEnd, xStart, yStart);
+            break;
+        }
+        case ShapeKind::Ring:
+        {
+            int cx = t.x[row], cy = t.y[row], outer = t.radius[row], inner = t.innerRadius[row];
+            renderer.ellipse(cx - outer, cy - outer, cx + outer, cy + outer);
+            renderer.ellipse(cx - inner, cy - inner, cx + inner, cy + inner);
+            break;
+        }
+        default:
+        {
+            uint32_t count = t.count[row];
+            if (count == 0) break;
+
+            const Vertex* v = vertices + t.first[row];
+            renderer.polyPolyline(v, &count, 1);
+            if (kind != ShapeKind::Polyline) {
+                renderer.line(v[count - 1].x, v[count - 1].y, v[0].x, v[0].y); // Замыкающая сторона
+            }
+            break;
+        }
+        }
+    }
+
+    void SceneFile::draw(Renderer& renderer) const {
+        draw(renderer, Rect(INT_MIN, INT_MIN, INT_MAX, INT_MAX));
+    }
+
+    void SceneFile::draw(Renderer& renderer, const Rect& area, KindMask visible) const {
+        for (size_t i = 0; i < shapeCount; ++i) {
+            if (!orderBounds[i].intersects(area)) continue;
+            ShapeKind kind = getKind(i);
+            if (!(visible & kindBit(kind))) continue;
+            drawRow(renderer, kind, order[i] & ((1u << OrderRowBits) - 1));
+        }
+    }
+
+    void SceneFile::loadInto(Scene& scene) const {
+        std::vector<Point> points;
+        scene.beginBulkInsert(shapeCount);
+        for (size_t i = 0; i < shapeCount; ++i) {
+            ShapeKind kind = getKind(i);
+            const Columns& t = tables[(int)kind];
+            size_t row = order[i] & ((1u << OrderRowBits) - 1);
+
+            if (kind >= ShapeKind::Polyline) {
+                points.clear();
+                for (uint32_t k = 0; k < t.count[row]; ++k) {
+                    const Vertex& v = vertices[t.first[row] + k];
+                    points.push_back(Point(v.x, v.y));
+                }
+            }
+
+            Shape* shape = nullptr;
+            switch (kind) {
+            case ShapeKind::Line:
+                shape = scene.create<Line>(Point(t.x[row], t.y[row]), Point(t.x2[row], t.y2[row]));
+                break;
+            case ShapeKind::Circle:
+                shape = scene.create<Circle>(Point(t.x[row], t.y[row]), t.radius[row]);
+                break;
+            case ShapeKind::Arc:
+                shape = scene.create<Arc>(Point(t.x[row], t.y[row]), t.radius[row], t.startAngle[row], t.endAngle[row]);
+                break;
+            case ShapeKind::Ring:
+                shape = scene.create<Ring>(Point(t.x[row], t.y[row]), t.radius[row], t.innerRadius[row]);
+                break;
+            case ShapeKind::Polyline:
+                shape = scene.create<Polyline>(points);
+                break;
+            case ShapeKind::Polygon:
+                shape = scene.create<Polygon>(points);
+                break;
+            case ShapeKind::Triangle:
+                shape = scene.create<Triangle>(points[0], points[1], points[2]);
+                break;
+            default:
+                shape = scene.create<Parallelogram>(points);
+                break;
+            }
+            shape->setColor(t.color[row]);
+        }
+        scene.endBulkInsert();
+    }
+
+    bool SceneFile::save(const char* path, const std::vector<Shape*>& shapes) {
+        SceneStore store;
+        for (const Shape* shape : shapes) {
+            store.add(*shape);
+        }
+        return store.save(path);
+    }
+
+}
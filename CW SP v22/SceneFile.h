@@ -0,0 +1,155 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Geometry.h"
+#include "Renderer.h"
+#include "Shapes.h"
+
+namespace MyShapes {
+
+    class Scene;
+
+    // Двоичный документ редактора (.msh). Раскладка повторяет SceneStore:
+    // каждый столбец таблицы вида - отдельный раздел файла, вершины всех
+    // ломаных - общий пул, порядок отрисовки - два раздела (ссылка и габарит).
+    //
+    //   Header
+    //   Section[sectionCount]   - оглавление
+    //   данные разделов, каждый выровнен на 8 байт
+    //
+    // Числа записываются в порядке байтов машины; byteOrder позволяет
+    // отличить файл с другой машины. Читатель пропускает разделы с
+    // незнакомым id, поэтому новые столбцы не ломают старые версии.
+    namespace SceneFormat {
+        const char Magic[4] = { 'M', 'S', 'H', 'F' };
+        const uint32_t Version = 1;
+        const uint32_t ByteOrder = 0x01020304;
+
+        // Столбцы таблицы вида; id раздела - вид * ColumnsPerKind + столбец
+        enum Column : uint32_t {
+            ColumnColor,        // Color
+            ColumnX,            // int32_t, далее так же
+            ColumnY,
+            ColumnX2,
+            ColumnY2,
+            ColumnRadius,
+            ColumnInnerRadius,
+            ColumnStartAngle,   // double
+            ColumnEndAngle,     // double
+            ColumnFirst,        // uint32_t, первая вершина в пуле
+            ColumnVertexCount,  // uint32_t
+            ColumnsPerKind
+        };
+
+        enum SharedSection : uint32_t {
+            SectionOrder = 0x10000,  // uint32_t: (вид << OrderRowBits) | строка
+            SectionBounds,           // Rect на каждую фигуру в порядке отрисовки
+            SectionVertices          // Vertex
+        };
+
+        const int OrderRowBits = 28;
+
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint32_t byteOrder;
+            uint32_t sectionCount;
+            uint64_t shapeCount;
+            uint64_t vertexCount;
+        };
+
+        struct Section {
+            uint32_t id;
+            uint32_t elementSize;
+            uint64_t offset;  // От начала файла
+            uint64_t count;
+        };
+    }
+
+    // Собирает разделы из чужой памяти и пишет их одним проходом,
+    // без промежуточной копии
+    class SceneFileWriter {
+    public:
+        void addSection(uint32_t id, const void* data, size_t elementSize, size_t count);
+        bool write(const char* path, uint64_t shapeCount, uint64_t vertexCount) const;
+
+    private:
+        struct Pending {
+            uint32_t id;
+            const void* data;
+            size_t elementSize;
+            size_t count;
+        };
+        std::vector<Pending> sections;
+    };
+
+    // Документ, открытый только для чтения через отображение файла в память.
+    // Столбцы и пул вершин используются на месте: open проверяет оглавление
+    // и ссылки, но не разбирает фигуры, draw рисует прямо из отображения.
+    // Фигуры-объекты для правки создаёт loadInto.
+    class SceneFile {
+    public:
+        SceneFile() {}
+        ~SceneFile() { close(); }
+
+        SceneFile(const SceneFile&) = delete;
+        SceneFile& operator=(const SceneFile&) = delete;
+
+        // false, если файл не открывается, не является документом,
+        // записан более новой версией или повреждён
+        bool open(const char* path);
+        void close();
+        bool isOpen() const { return data != nullptr; }
+
+        size_t size() const { return shapeCount; }
+        size_t vertexCount() const { return vertexTotal; }
+        ShapeKind getKind(size_t i) const { return (ShapeKind)(order[i] >> SceneFormat::OrderRowBits); }
+        const Rect& bounds(size_t i) const { return orderBounds[i]; }
+
+        // Рисует фигуры в порядке отрисовки; с area - только задевающие её
+        // и только видов из visible
+        void draw(Renderer& renderer) const;
+        void draw(Renderer& renderer, const Rect& area, KindMask visible = AllKinds) const;
+
+        // Создаёт фигуры документа в арене сцены поверх уже имеющихся
+        void loadInto(Scene& scene) const;
+
+        // Записывает фигуры в порядке отрисовки. Point в документ не входит.
+        static bool save(const char* path, const std::vector<Shape*>& shapes);
+
+    private:
+        // Столбцы одного вида внутри отображения; отсутствующие - nullptr
+        struct Columns {
+            size_t rows = 0;
+            const Color* color = nullptr;
+            const int32_t* x = nullptr;
+            const int32_t* y = nullptr;
+            const int32_t* x2 = nullptr;
+            const int32_t* y2 = nullptr;
+            const int32_t* radius = nullptr;
+            const int32_t* innerRadius = nullptr;
+            const double* startAngle = nullptr;
+            const double* endAngle = nullptr;
+            const uint32_t* first = nullptr;
+            const uint32_t* count = nullptr;
+        };
+
+        const unsigned char* data = nullptr;
+        size_t length = 0;
+
+        Columns tables[ShapeKindCount];
+        const uint32_t* order = nullptr;
+        const Rect* orderBounds = nullptr;
+        const Vertex* vertices = nullptr;
+        size_t shapeCount = 0;
+        size_t vertexTotal = 0;
+
+        bool readSections();
+        bool validate() const;
+        void drawRow(Renderer& renderer, ShapeKind kind, size_t row) const;
+    };
+
+}
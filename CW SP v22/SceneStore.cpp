@@ -0,0 +1,466 @@
+﻿#include "SceneStore.h"
+
+#include "HitTest.h"
+#include "SceneFile.h"
+#include "ShapeKernels.h"
+
+namespace MyShapes {
+
+    namespace {
+        // Все непустые столбцы таблицы, чтобы добавлять и уплотнять строки одним циклом
+        template <typename Table, typename Visit>
+        void forEachColumn(Table& t, Visit&& visit) {
+            visit(t.slot); visit(t.color);
+            visit(t.x); visit(t.y); visit(t.x2); visit(t.y2);
+            visit(t.radius); visit(t.innerRadius);
+            visit(t.startAngle); visit(t.endAngle);
+            visit(t.first); visit(t.count);
+        }
+    }
+
+    const SceneStore::Slot* SceneStore::find(ShapeHandle handle) const {
+        if (handle.index >= slots.size()) return nullptr;
+        const Slot& slot = slots[handle.index];
+        if (!slot.alive || slot.generation != handle.generation) return nullptr;
+        return &slot;
+    }
+
+    bool SceneStore::contains(ShapeHandle handle) const {
+        return find(handle) != nullptr;
+    }
+
+    ShapeHandle SceneStore::add(const Shape& shape) {
+        ShapeKind kind = shape.kind();
+        if (kind == ShapeKind::Point) return ShapeHandle();
+
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            index = (uint32_t)slots.size();
+            slots.push_back(Slot{ 0, 0, 0, kind, false });
+        }
+
+        Table& table = tables[(int)kind];
+        size_t row = table.rows();
+
+        // Новая строка во всех столбцах вида; чужие столбцы остаются пустыми
+        table.slot.push_back(index);
+        table.color.push_back(0);
+        switch (kind) {
+        case ShapeKind::Line:
+            table.x.push_back(0); table.y.push_back(0); table.x2.push_back(0); table.y2.push_back(0);
+            break;
+        case ShapeKind::Circle:
+            table.x.push_back(0); table.y.push_back(0); table.radius.push_back(0);
+            break;
+        case ShapeKind::Arc:
+            table.x.push_back(0); table.y.push_back(0); table.radius.push_back(0);
+            table.startAngle.push_back(0); table.endAngle.push_back(0);
+            break;
+        case ShapeKind::Ring:
+            table.x.push_back(0); table.y.push_back(0);
+            table.radius.push_back(0); table.innerRadius.push_back(0);
+            break;
+        default:
+            table.first.push_back(0); table.count.push_back(0);
+            break;
+        }
+        writeRow(table, kind, row, shape, false);
+
+        Slot& slot = slots[index];
+        slot.kind = kind;
+        slot.row = (uint32_t)row;
+        slot.position = (uint32_t)orderRow.size();
+        slot.alive = true;
+        orderBounds.push_back(shape.bounds());
+        orderRow.push_back(((uint32_t)kind << RowBits) | (uint32_t)row);
+        ++liveCount;
+        return ShapeHandle(index, slot.generation);
+    }
+
+    void SceneStore::writeRow(Table& t, ShapeKind kind, size_t row, const Shape& shape, bool reuseVertices) {
+        t.color[row] = shape.getColor();
+
+        switch (kind) {
+        case ShapeKind::Line:
+        {
+            const Line& line = static_cast<const Line&>(shape);
+            t.x[row] = line.getStart().x;
+            t.y[row] = line.getStart().y;
+            t.x2[row] = line.getEnd().x;
+            t.y2[row] = line.getEnd().y;
+            break;
+        }
+        case ShapeKind::Circle:
+        {
+            const Circle& circle = static_cast<const Circle&>(shape);
+            t.x[row] = circle.getCenter().x;
+            t.y[row] = circle.getCenter().y;
+            t.radius[row] = circle.getRadius();
+            break;
+        }
+        case ShapeKind::Arc:
+        {
+            const Arc& arc = static_cast<const Arc&>(shape);
+            t.x[row] = arc.center.x;
+            t.y[row] = arc.center.y;
+            t.radius[row] = arc.radius;
+            t.startAngle[row] = arc.startAngle;
+            t.endAngle[row] = arc.endAngle;
+            break;
+        }
+        case ShapeKind::Ring:
+        {
+            const Ring& ring = static_cast<const Ring&>(shape);
+            t.x[row] = ring.getOuterCircle().getCenter().x;
+            t.y[row] = ring.getOuterCircle().getCenter().y;
+            t.radius[row] = ring.getOuterCircle().getRadius();
+            t.innerRadius[row] = ring.getInnerCircle().getRadius();
+            break;
+        }
+        default:
+        {
+            // Ломаная в любом из четырёх видов; экземпляр отдаёт вершины из общих
+            const Polyline& polyline = static_cast<const Polyline&>(shape);
+            size_t count = polyline.vertexCount();
+
+            // Не больше прежнего - пишем на старое место, иначе в конец пула
+            if (!reuseVertices || count > t.count[row]) {
+                t.first[row] = (uint32_t)vertices.size();
+                vertices.resize(vertices.size() + count);
+            }
+            t.count[row] = (uint32_t)count;
+            polyline.copyVertices(vertices.data() + t.first[row]);
+            break;
+        }
+        }
+    }
+
+    bool SceneStore::replace(ShapeHandle handle, const Shape& shape) {
+        const Slot* slot = find(handle);
+        if (!slot || slot->kind != shape.kind()) return false;
+
+        writeRow(tables[(int)slot->kind], slot->kind, slot->row, shape, true);
+        orderBounds[slot->position] = shape.bounds();
+        return true;
+    }
+
+    void SceneStore::remove(ShapeHandle handle) {
+        if (!contains(handle)) return;
+
+        Slot& slot = slots[handle.index];
+        tables[(int)slot.kind].slot[slot.row] = Dead;
+        orderRow[slot.position] = Dead;
+        slot.alive = false;
+        ++slot.generation;
+        freeSlots.push_back(handle.index);
+        --liveCount;
+        ++deadCount;
+
+        if (deadCount > liveCount && deadCount > 1024) {
+            compact();
+        }
+    }
+
+    void SceneStore::clear() {
+        for (Table& table : tables) {
+            forEachColumn(table, [](auto& column) { column.clear(); });
+        }
+        vertices.clear();
+        orderBounds.clear();
+        orderRow.clear();
+
+        // Дескрипторы, выданные до очистки, остаются недействительными
+        freeSlots.clear();
+        for (uint32_t i = 0; i < slots.size(); ++i) {
+            if (slots[i].alive) {
+                slots[i].alive = false;
+                ++slots[i].generation;
+            }
+            freeSlots.push_back((uint32_t)slots.size() - 1 - i);
+        }
+        liveCount = 0;
+        deadCount = 0;
+    }
+
+    void SceneStore::compact() {
+        std::vector<Vertex> packed;
+        packed.reserve(vertices.size());
+        std::vector<uint32_t> newRow[ShapeKindCount];  // Старая строка -> новая
+
+        for (int kind = 0; kind < ShapeKindCount; ++kind) {
+            Table& table = tables[kind];
+
+            std::vector<size_t> keep;
+            keep.reserve(table.rows());
+            newRow[kind].assign(table.rows(), Dead);
+            for (size_t row = 0; row < table.rows(); ++row) {
+                if (table.slot[row] != Dead) {
+                    newRow[kind][row] = (uint32_t)keep.size();
+                    keep.push_back(row);
+                }
+            }
+
+            forEachColumn(table, [&](auto& column) {
+                if (column.empty()) return;
+                for (size_t w = 0; w < keep.size(); ++w) {
+                    column[w] = column[keep[w]];
+                }
+                column.resize(keep.size());
+            });
+
+            for (size_t row = 0; row < table.rows(); ++row) {
+                slots[table.slot[row]].row = (uint32_t)row;
+            }
+
+            // Вершины живых фигур переносим подряд, в порядке строк
+            if (isPolyKind((ShapeKind)kind)) {
+                for (size_t row = 0; row < table.rows(); ++row) {
+                    uint32_t first = (uint32_t)packed.size();
+                    packed.insert(packed.end(), vertices.begin() + table.first[row],
+                        vertices.begin() + table.first[row] + table.count[row]);
+                    table.first[row] = first;
+                }
+            }
+        }
+
+        vertices.swap(packed);
+
+        size_t written = 0;
+        for (size_t i = 0; i < orderRow.size(); ++i) {
+            if (orderRow[i] == Dead) continue;
+
+            uint32_t kind = orderRow[i] >> RowBits;
+            uint32_t row = newRow[kind][orderRow[i] & RowMask];
+            slots[tables[kind].slot[row]].position = (uint32_t)written;
+            orderBounds[written] = orderBounds[i];
+            orderRow[written] = (kind << RowBits) | row;
+            ++written;
+        }
+        orderBounds.resize(written);
+        orderRow.resize(written);
+        deadCount = 0;
+    }
+
+    bool SceneStore::save(const char* path) {
+        static_assert(RowBits == SceneFormat::OrderRowBits, "draw order layout must match the file");
+        if (deadCount > 0) compact();
+
+        SceneFileWriter writer;
+        for (int kind = 0; kind < ShapeKindCount; ++kind) {
+            const Table& t = tables[kind];
+            uint32_t base = kind * SceneFormat::ColumnsPerKind;
+            auto column = [&](SceneFormat::Column id, const auto& values) {
+                if (!values.empty()) writer.addSection(base + id, values.data(), sizeof(values[0]), values.size());
+            };
+            column(SceneFormat::ColumnColor, t.color);
+            column(SceneFormat::ColumnX, t.x);
+            column(SceneFormat::ColumnY, t.y);
+            column(SceneFormat::ColumnX2, t.x2);
+            column(SceneFormat::ColumnY2, t.y2);
+            column(SceneFormat::ColumnRadius, t.radius);
+            column(SceneFormat::ColumnInnerRadius, t.innerRadius);
+            column(SceneFormat::ColumnStartAngle, t.startAngle);
+            column(SceneFormat::ColumnEndAngle, t.endAngle);
+            column(SceneFormat::ColumnFirst, t.first);
+            column(SceneFormat::ColumnVertexCount, t.count);
+        }
+        writer.addSection(SceneFormat::SectionOrder, orderRow.data(), sizeof(uint32_t), orderRow.size());
+        writer.addSection(SceneFormat::SectionBounds, orderBounds.data(), sizeof(Rect), orderBounds.size());
+        writer.addSection(SceneFormat::SectionVertices, vertices.data(), sizeof(Vertex), vertices.size());
+        return writer.write(path, orderRow.size(), vertices.size());
+    }
+
+    Rect SceneStore::bounds(ShapeHandle handle) const {
+        const Slot* slot = find(handle);
+        if (!slot) return Rect();
+
+        return orderBounds[slot->position];
+    }
+
+    Color SceneStore::getColor(ShapeHandle handle) const {
+        const Slot* slot = find(handle);
+        return slot ? tables[(int)slot->kind].color[slot->row] : 0;
+    }
+
+    void SceneStore::setColor(ShapeHandle handle, Color color) {
+        const Slot* slot = find(handle);
+        if (slot) tables[(int)slot->kind].color[slot->row] = color;
+    }
+
+    void SceneStore::move(ShapeHandle handle, int dx, int dy) {
+        const Slot* slot = find(handle);
+        if (!slot) return;
+
+        moveRow(tables[(int)slot->kind], slot->kind, slot->row, dx, dy);
+
+        // Сдвиг не меняет формы, габарит сдвигается вместе с фигурой
+        Rect& b = orderBounds[slot->position];
+        b = Rect(b.left + dx, b.top + dy, b.right + dx, b.bottom + dy);
+    }
+
+    void SceneStore::moveRow(Table& t, ShapeKind kind, size_t row, int dx, int dy) {
+        if (isPolyKind(kind)) {
+            Vertex* v = vertices.data() + t.first[row];
+            for (uint32_t i = 0; i < t.count[row]; ++i) {
+                v[i].x += dx;
+                v[i].y += dy;
+            }
+            return;
+        }
+
+        t.x[row] += dx;
+        t.y[row] += dy;
+        if (kind == ShapeKind::Line) {
+            t.x2[row] += dx;
+            t.y2[row] += dy;
+        }
+    }
+
+    Shape* SceneStore::createShape(ShapeHandle handle) const {
+        const Slot* slot = find(handle);
+        if (!slot) return nullptr;
+
+        const Table& t = tables[(int)slot->kind];
+        size_t row = slot->row;
+
+        std::vector<Point> points;
+        if (isPolyKind(slot->kind)) {
+            points.reserve(t.count[row]);
+            for (uint32_t i = 0; i < t.count[row]; ++i) {
+                const Vertex& v = vertices[t.first[row] + i];
+                points.push_back(Point(v.x, v.y));
+            }
+        }
+
+        Shape* shape = nullptr;
+        switch (slot->kind) {
+        case ShapeKind::Line:
+            shape = new Line(Point(t.x[row], t.y[row]), Point(t.x2[row], t.y2[row]));
+            break;
+        case ShapeKind::Circle:
+            shape = new Circle(Point(t.x[row], t.y[row]), t.radius[row]);
+            break;
+        case ShapeKind::Arc:
+            shape = new Arc(Point(t.x[row], t.y[row]), t.radius[row], t.startAngle[row], t.endAngle[row]);
+            break;
+        case ShapeKind::Ring:
+            shape = new Ring(Point(t.x[row], t.y[row]), t.radius[row], t.innerRadius[row]);
+            break;
+        case ShapeKind::Polyline:
+            shape = new Polyline(points);
+            break;
+        case ShapeKind::Polygon:
+            shape = new Polygon(points);
+            break;
+        case ShapeKind::Triangle:
+            shape = new Triangle(points[0], points[1], points[2]);
+            break;
+        case ShapeKind::Parallelogram:
+            shape = new Parallelogram(points);
+            break;
+        default:
+            return nullptr;
+        }
+        shape->setColor(t.color[row]);
+        return shape;
+    }
+
+    void SceneStore::drawRow(Renderer& renderer, ShapeKind kind, size_t row) const {
+        const Table& t = tables[(int)kind];
+        renderer.setPen(t.color[row]);
+
+        // Те же вызовы Renderer, что в draw соответствующих классов фигур
+        switch (kind) {
+        case ShapeKind::Line:
+            renderer.line(t.x[row], t.y[row], t.x2[row], t.y2[row]);
+            break;
+        case ShapeKind::Circle:
+        {
+            int cx = t.x[row], cy = t.y[row], r = t.radius[row];
+            renderer.ellipse(cx - r, cy - r, cx + r, cy + r);
+            break;
+        }
+        case ShapeKind::Arc:
+        {
+            int cx = t.x[row], cy = t.y[row], r = t.radius[row];
+            int xStart, yStart, xEnd, yEnd;
+            arcEndPoints(cx, cy, r, t.startAngle[row], t.endAngle[row], xStart, yStart, xEnd, yEnd);
+            renderer.arc(cx - r, cy - r, cx + r, cy + r, xEnd, yEnd, xStart, yStart);
+            break;
+        }
+        case ShapeKind::Ring:
+        {
+            int cx = t.x[row], cy = t.y[row], outer = t.radius[row], inner = t.innerRadius[row];
+            renderer.ellipse(cx - outer, cy - outer, cx + outer, cy + outer);
+            renderer.ellipse(cx - inner, cy - inner, cx + inner, cy + inner);
+            break;
+        }
+        default:
+        {
+            uint32_t count = t.count[row];
+            if (count == 0) break;
+
+            const Vertex* v = vertices.data() + t.first[row];
+            renderer.polyPolyline(v, &count, 1);
+            if (kind != ShapeKind::Polyline) {
+                renderer.line(v[count - 1].x, v[count - 1].y, v[0].x, v[0].y); // Замыкающая сторона
+            }
+            break;
+        }
+        }
+    }
+
+    void SceneStore::draw(Renderer& renderer) const {
+        draw(renderer, Rect(INT_MIN, INT_MIN, INT_MAX, INT_MAX));
+    }
+
+    void SceneStore::draw(Renderer& renderer, const Rect& area) const {
+        for (size_t i = 0; i < orderRow.size(); ++i) {
+            if (orderRow[i] == Dead || !orderBounds[i].intersects(area)) continue;
+            drawRow(renderer, (ShapeKind)(orderRow[i] >> RowBits), orderRow[i] & RowMask);
+        }
+    }
+
+    bool SceneStore::hitRow(ShapeKind kind, size_t row, int x, int y) const {
+        const Table& t = tables[(int)kind];
+        switch (kind) {
+        case ShapeKind::Line:
+            return nearSegment(t.x[row], t.y[row], t.x2[row], t.y2[row], x, y);
+        case ShapeKind::Circle:
+            return insideCircle(t.x[row], t.y[row], t.radius[row], x, y);
+        case ShapeKind::Arc:
+            return nearArc(t.x[row], t.y[row], t.radius[row], t.startAngle[row], t.endAngle[row], x, y);
+        case ShapeKind::Ring:
+            return insideRing(t.x[row], t.y[row], t.radius[row], t.innerRadius[row], x, y);
+        case ShapeKind::Polyline:
+            // Вершины уже лежат подряд: векторные ядра работают прямо по пулу
+            return nearPolyline(vertices.data() + t.first[row], t.count[row], x, y);
+        default:
+            return insidePolygon(vertices.data() + t.first[row], t.count[row], x, y);
+        }
+    }
+
+    ShapeHandle SceneStore::pick(int x, int y) const {
+        // С конца порядка: первое попадание - самая верхняя фигура
+        for (size_t i = orderRow.size(); i-- > 0;) {
+            if (orderRow[i] == Dead) continue;
+
+            const Rect& b = orderBounds[i];
+            if (x < b.left - ClickTolerance || x > b.right + ClickTolerance ||
+                y < b.top - ClickTolerance || y > b.bottom + ClickTolerance) continue;
+
+            ShapeKind kind = (ShapeKind)(orderRow[i] >> RowBits);
+            size_t row = orderRow[i] & RowMask;
+            if (hitRow(kind, row, x, y)) {
+                uint32_t index = tables[(int)kind].slot[row];
+                return ShapeHandle(index, slots[index].generation);
+            }
+        }
+        return ShapeHandle();
+    }
+
+}
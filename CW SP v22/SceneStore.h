@@ -0,0 +1,143 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Geometry.h"
+#include "Renderer.h"
+#include "Shapes.h"
+
+namespace MyShapes {
+
+    // Устойчивая ссылка на фигуру в SceneStore. В отличие от указателя или номера
+    // строки не меняется при удалении соседей и уплотнении; после удаления
+    // фигуры её дескриптор перестаёт быть действительным (растёт generation).
+    struct ShapeHandle {
+        uint32_t index;
+        uint32_t generation;
+
+        ShapeHandle() : index(UINT32_MAX), generation(0) {}
+        ShapeHandle(uint32_t index, uint32_t generation) : index(index), generation(generation) {}
+
+        bool isNull() const { return index == UINT32_MAX; }
+
+        bool operator==(const ShapeHandle& other) const {
+            return index == other.index && generation == other.generation;
+        }
+
+        bool operator!=(const ShapeHandle& other) const {
+            return !(*this == other);
+        }
+    };
+
+    // Хранилище сцены "структурой массивов": у каждого вида фигур своя таблица,
+    // каждое поле - отдельный непрерывный столбец. Вершины всех ломаных и
+    // многоугольников лежат в одном общем пуле, строка хранит только диапазон.
+    // Обход при отрисовке и выборе кликом идёт подряд по памяти, без вызова
+    // виртуальных функций и перехода по указателю на каждую фигуру.
+    //
+    // Порядок отрисовки - отдельная таблица из двух столбцов: габарит и
+    // ссылка (вид, строка). Отсечение и выбор кликом просматривают только её,
+    // к таблицам видов обращаются лишь за фигурами, прошедшими отсечение.
+    // Удаление помечает строки; compact() убирает помеченные строки и мусор
+    // в пуле вершин, сохраняя порядок.
+    class SceneStore {
+    public:
+        SceneStore() {}
+
+        // Копирует геометрию и цвет фигуры. Point в сцену не входит:
+        // для неё возвращается пустой дескриптор.
+        ShapeHandle add(const Shape& shape);
+
+        // Заменяет геометрию и цвет фигуры того же вида, сохраняя дескриптор
+        // и место в порядке отрисовки. Возвращает false, если вид другой.
+        bool replace(ShapeHandle handle, const Shape& shape);
+
+        void remove(ShapeHandle handle);
+        void clear();
+
+        bool contains(ShapeHandle handle) const;
+        size_t size() const { return liveCount; }
+
+        ShapeKind getKind(ShapeHandle handle) const { return slots[handle.index].kind; }
+        Rect bounds(ShapeHandle handle) const;
+        Color getColor(ShapeHandle handle) const;
+        void setColor(ShapeHandle handle, Color color);
+        void move(ShapeHandle handle, int dx, int dy);
+
+        // Новая фигура-объект с той же геометрией и цветом: для правки
+        // методами классов фигур с последующим replace
+        Shape* createShape(ShapeHandle handle) const;
+
+        // Рисует фигуры в порядке добавления; с area - только задевающие её
+        void draw(Renderer& renderer) const;
+        void draw(Renderer& renderer, const Rect& area) const;
+
+        // Самая верхняя фигура под точкой или пустой дескриптор
+        ShapeHandle pick(int x, int y) const;
+
+        // Удаляет помеченные строки и неиспользуемые вершины.
+        // Вызывается сам, когда удалённых строк становится больше живых.
+        void compact();
+
+        // Записывает документ в формате SceneFile: столбцы таблиц как есть.
+        // Удалённые строки сначала уплотняются.
+        bool save(const char* path);
+
+        size_t vertexPoolSize() const { return vertices.size(); }
+
+    private:
+        static constexpr uint32_t Dead = UINT32_MAX;
+        static constexpr int RowBits = 28;
+        static constexpr uint32_t RowMask = (1u << RowBits) - 1;
+
+        // Строка таблицы. Вид использует только свои столбцы:
+        //   Line                        x, y - начало; x2, y2 - конец
+        //   Circle                      x, y - центр; radius
+        //   Arc                         x, y, radius; startAngle, endAngle
+        //   Ring                        x, y, radius - внешний; innerRadius
+        //   Polyline, Polygon,
+        //   Triangle, Parallelogram     first, count - вершины в пуле
+        struct Table {
+            std::vector<uint32_t> slot;    // Dead - строка удалена
+            std::vector<Color> color;
+
+            std::vector<int32_t> x, y, x2, y2;
+            std::vector<int32_t> radius, innerRadius;
+            std::vector<double> startAngle, endAngle;
+            std::vector<uint32_t> first, count;
+
+            size_t rows() const { return slot.size(); }
+        };
+
+        struct Slot {
+            uint32_t generation;
+            uint32_t row;
+            uint32_t position;  // Место в порядке отрисовки
+            ShapeKind kind;
+            bool alive;
+        };
+
+        Table tables[ShapeKindCount];
+        std::vector<Vertex> vertices;  // Общий пул: x, y рядом, уходит в polyPolyline без копирования
+        // Порядок отрисовки: габарит и (вид << RowBits) | строка либо Dead
+        std::vector<Rect> orderBounds;
+        std::vector<uint32_t> orderRow;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        size_t liveCount = 0;
+        size_t deadCount = 0;
+
+        static bool isPolyKind(ShapeKind kind) { return kind >= ShapeKind::Polyline; }
+
+        const Slot* find(ShapeHandle handle) const;
+
+        // Записывает геометрию фигуры в строку row (строка уже существует)
+        void writeRow(Table& table, ShapeKind kind, size_t row, const Shape& shape, bool reuseVertices);
+        void moveRow(Table& table, ShapeKind kind, size_t row, int dx, int dy);
+
+        void drawRow(Renderer& renderer, ShapeKind kind, size_t row) const;
+        bool hitRow(ShapeKind kind, size_t row, int x, int y) const;
+    };
+
+}
@@ -0,0 +1,360 @@
+﻿#include "SegmentSweep.h"
+
+#include "Intersect.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace MyShapes {
+
+    namespace {
+
+        bool isClosed(ShapeKind kind) {
+            return kind == ShapeKind::Polygon || kind == ShapeKind::Triangle || kind == ShapeKind::Parallelogram;
+        }
+
+        uint64_t pairKey(uint32_t a, uint32_t b) {
+            return a < b ? (uint64_t)a << 32 | b : (uint64_t)b << 32 | a;
+        }
+
+        // Отрезок ab задевает дугу: одна из общих точек с окружностью лежит
+        // в угловом промежутке от startAngle до endAngle (концы включаются)
+        bool crossesArc(const Arc& arc, const Vertex& a, const Vertex& b) {
+            double t[2];
+            int count = circleCrossings(a, b, arc.center.x, arc.center.y, arc.radius, t);
+
+            // Угловая длина дуги, как в Arc::trim; совпавшие концы - вся окружность
+            const double twoPi = 2 * M_PI, epsilon = 1e-9;
+            double span = std::fmod(arc.endAngle - arc.startAngle, twoPi);
+            if (span < 0) span += twoPi;
+            if (span == 0) return count > 0;
+            for (int i = 0; i < count; ++i) {
+                double x = a.x + t[i] * ((double)b.x - a.x);
+                double y = a.y + t[i] * ((double)b.y - a.y);
+                double along = std::fmod(std::atan2(y - arc.center.y, x - arc.center.x) - arc.startAngle, twoPi);
+                if (along < 0) along += twoPi;
+                if (along <= span + epsilon || along >= twoPi - epsilon) return true;
+            }
+            return false;
+        }
+
+    }
+
+    SegmentSweep::SegmentSweep() : status(Order{ this }) {}
+
+    bool SegmentSweep::Order::operator()(uint32_t a, uint32_t b) const {
+        if (a == b) return false;
+        // set сравнивает вставляемый отрезок с уже стоящими в порядке
+        if (a == sweep->inserting) return sweep->sideAtPoint(a, b) < 0;
+        if (b == sweep->inserting) return sweep->sideAtPoint(b, a) > 0;
+        return a < b;
+    }
+
+    void SegmentSweep::clear() {
+        segments.clear();
+    }
+
+    void SegmentSweep::addSegment(const Vertex& a, const Vertex& b, uint32_t owner, uint32_t edge) {
+        if (a.x == b.x && a.y == b.y) return;  // Вырожденное ребро ни с чем не пересекается
+        bool ordered = a.x < b.x || (a.x == b.x && a.y < b.y);
+        segments.push_back(Segment{ ordered ? a : b, ordered ? b : a, owner, edge });
+    }
+
+    void SegmentSweep::addShape(const Shape& shape, uint32_t owner) {
+        ShapeKind kind = shape.kind();
+        bool closed = isClosed(kind);
+        if (kind != ShapeKind::Line && kind != ShapeKind::Polyline && !closed) return;
+
+        anchors.clear();
+        shape.writeAnchors(anchors);
+        for (size_t i = 0; i + 1 < anchors.size(); ++i) {
+            addSegment(anchors[i], anchors[i + 1], owner, (uint32_t)i);
+        }
+        if (closed && anchors.size() > 2) {
+            addSegment(anchors.back(), anchors.front(), owner, (uint32_t)(anchors.size() - 1));
+        }
+    }
+
+    // Допуск для дробной точки пересечения: её координаты округлены
+    double SegmentSweep::tolerance() const {
+        return 1e-9 * (std::fabs(pointX) + std::fabs(pointY) + 1);
+    }
+
+    // Положение текущей точки относительно отрезка: -1 - ниже, 1 - выше,
+    // 0 - на нём (для дробной точки - в пределах допуска)
+    int SegmentSweep::pointSide(const Segment& s) const {
+        if (s.left.x == s.right.x) {
+            // Вертикальный отрезок занимает на заметающей прямой весь свой диапазон
+            return pointY < s.left.y ? -1 : (pointY > s.right.y ? 1 : 0);
+        }
+        if (pointExact) {
+            return orientation(s.left, s.right, Vertex{ (int32_t)pointX, (int32_t)pointY });
+        }
+        double y = s.left.y + (pointX - s.left.x) * ((double)s.right.y - s.left.y) / ((double)s.right.x - s.left.x);
+        double d = tolerance();
+        return pointY < y - d ? -1 : (pointY > y + d ? 1 : 0);
+    }
+
+    // Сторона отрезка key, проходящего через текущую точку, относительно other
+    // сразу после этой точки: -1 - ниже, 1 - выше
+    int SegmentSweep::sideAtPoint(uint32_t key, uint32_t other) const {
+        const Segment& k = segments[key];
+        const Segment& e = segments[other];
+        int side = pointSide(e);
+        if (side != 0) return side;
+
+        // Точка на other: выше тот, чьё направление повёрнуто против часовой
+        side = crossSign((double)e.right.x - e.left.x, (double)e.right.y - e.left.y,
+            (double)k.right.x - k.left.x, (double)k.right.y - k.left.y);
+        if (side != 0) return side;
+        return key < other ? -1 : 1;  // Наложение на одной прямой
+    }
+
+    bool SegmentSweep::containsPoint(uint32_t segment) const {
+        const Segment& s = segments[segment];
+        if (s.left.x != s.right.x) {
+            double d = pointExact ? 0 : tolerance();
+            if (pointX < s.left.x - d || pointX > s.right.x + d) return false;
+        }
+        else if (std::fabs(pointX - s.left.x) > (pointExact ? 0 : tolerance())) {
+            return false;
+        }
+        return pointSide(s) == 0;
+    }
+
+    // Отрезки через точку стоят в порядке подряд: от segment вниз и вверх
+    void SegmentSweep::collectThrough(uint32_t segment) {
+        Status::iterator at = positions[segment];
+        through.push_back(segment);
+        for (Status::iterator it = at; it != status.begin();) {
+            --it;
+            if (!containsPoint(*it)) break;
+            through.push_back(*it);
+        }
+        for (Status::iterator it = std::next(at); it != status.end() && containsPoint(*it); ++it) {
+            through.push_back(*it);
+        }
+    }
+
+    void SegmentSweep::insert(uint32_t segment) {
+        inserting = segment;
+        positions[segment] = status.insert(segment).first;
+        active[segment] = 1;
+        touched.push_back(segment);
+    }
+
+    void SegmentSweep::erase(uint32_t segment) {
+        // Соседи становятся соседями друг другу
+        Status::iterator at = positions[segment];
+        if (at != status.begin()) touched.push_back(*std::prev(at));
+        Status::iterator next = std::next(at);
+        if (next != status.end()) touched.push_back(*next);
+        status.erase(at);
+        active[segment] = 0;
+    }
+
+    void SegmentSweep::checkPair(uint32_t a, uint32_t b, std::vector<SweepCrossing>& crossings) {
+        const Segment& sa = segments[a];
+        const Segment& sb = segments[b];
+        double t;
+        if (!segmentCrossing(sa.left, sa.right, sb.left, sb.right, t)) return;
+        // Соседями пара становится не раз; помнятся только пересекающиеся
+        if (!tested.insert(pairKey(a, b)).second) return;
+
+        // Общая точка - конец отрезка, если конец лежит на прямой другого
+        bool endA = orientation(sb.left, sb.right, sa.left) == 0 || orientation(sb.left, sb.right, sa.right) == 0;
+        bool endB = orientation(sa.left, sa.right, sb.left) == 0 || orientation(sa.left, sa.right, sb.right) == 0;
+        double x = sa.left.x + t * ((double)sa.right.x - sa.left.x);
+        double y = sa.left.y + t * ((double)sa.right.y - sa.left.y);
+
+        if (!(endA && endB && sa.owner == sb.owner)) {
+            crossings.push_back(SweepCrossing{ sa.owner, sa.edge, sb.owner, sb.edge,
+                Vertex{ (int32_t)std::lrint(x), (int32_t)std::lrint(y) } });
+        }
+        if (endA || endB) return;  // Порядок поменяют события концов
+
+        // Внутренние точки обоих: отрезки меняются местами. Событие не раньше текущего.
+        if (x < pointX || (x == pointX && y < pointY)) {
+            x = pointX;
+            y = pointY;
+        }
+        events.push(Event{ x, y, EventKind::Cross, a, b });
+    }
+
+    void SegmentSweep::checkNeighbours(uint32_t segment, std::vector<SweepCrossing>& crossings) {
+        Status::iterator at = positions[segment];
+        if (at != status.begin()) checkPair(*std::prev(at), segment, crossings);
+        Status::iterator next = std::next(at);
+        if (next != status.end()) checkPair(segment, *next, crossings);
+    }
+
+    // Частый случай: пересекаются два соседа, и больше через точку никто не
+    // идёт. Они меняются местами; false - случай не тот.
+    bool SegmentSweep::swapNeighbours(uint32_t a, uint32_t b) {
+        Status::iterator lower = positions[a], upper = positions[b];
+        if (std::next(upper) == lower) std::swap(lower, upper);
+        else if (std::next(lower) != upper) return false;
+        if (lower != status.begin() && containsPoint(*std::prev(lower))) return false;
+        if (std::next(upper) != status.end() && containsPoint(*std::next(upper))) return false;
+
+        uint32_t below = *lower, above = *upper;
+        erase(below);
+        erase(above);
+        insert(above);
+        insert(below);
+        return true;
+    }
+
+    // Все отрезки через точку стоят в порядке подряд. Каждая их пара
+    // сообщается, кончающиеся выходят, остальные встают заново в порядке
+    // сразу после точки: в целой точке он определяется точно, в дробной -
+    // по направлениям отрезков, прошедших в пределах допуска.
+    void SegmentSweep::processPoint(std::vector<SweepCrossing>& crossings) {
+        through.clear();
+        for (const Event& event : group) {
+            if (event.kind == EventKind::Start) continue;
+            if (active[event.a]) collectThrough(event.a);
+            if (active[event.b]) collectThrough(event.b);
+        }
+        for (const Event& event : group) {
+            if (event.kind == EventKind::Start) insert(event.a);
+        }
+        for (const Event& event : group) {
+            if (event.kind == EventKind::Start) collectThrough(event.a);
+        }
+        std::sort(through.begin(), through.end());
+        through.erase(std::unique(through.begin(), through.end()), through.end());
+
+        // Одинокое начало или конец: порядок уже верен
+        if (through.size() == 1) {
+            const Vertex& right = segments[through[0]].right;
+            if (right.x == pointX && right.y == pointY) erase(through[0]);
+            return;
+        }
+
+        for (size_t i = 0; i < through.size(); ++i) {
+            for (size_t j = i + 1; j < through.size(); ++j) {
+                checkPair(through[i], through[j], crossings);
+            }
+        }
+        for (uint32_t segment : through) {
+            erase(segment);
+        }
+        for (uint32_t segment : through) {
+            const Vertex& right = segments[segment].right;
+            if (right.x != pointX || right.y != pointY) insert(segment);
+        }
+    }
+
+    bool SegmentSweep::hasEvent() const {
+        return nextEndpoint < endpoints.size() || !events.empty();
+    }
+
+    const SegmentSweep::Event& SegmentSweep::peekEvent() const {
+        if (events.empty()) return endpoints[nextEndpoint];
+        if (nextEndpoint == endpoints.size()) return events.top();
+        return events.top() > endpoints[nextEndpoint] ? endpoints[nextEndpoint] : events.top();
+    }
+
+    void SegmentSweep::popEvent() {
+        if (events.empty() || (nextEndpoint < endpoints.size() && events.top() > endpoints[nextEndpoint])) ++nextEndpoint;
+        else events.pop();
+    }
+
+    void SegmentSweep::run(std::vector<SweepCrossing>& crossings) {
+        crossings.clear();
+        status.clear();
+        tested.clear();
+        tested.reserve(segments.size());
+        positions.assign(segments.size(), status.end());
+        active.assign(segments.size(), 0);
+
+        // Концы известны заранее: их хватает отсортировать, в куче - только пересечения
+        endpoints.clear();
+        nextEndpoint = 0;
+        for (uint32_t i = 0; i < (uint32_t)segments.size(); ++i) {
+            const Segment& s = segments[i];
+            endpoints.push_back(Event{ (double)s.left.x, (double)s.left.y, EventKind::Start, i, i });
+            endpoints.push_back(Event{ (double)s.right.x, (double)s.right.y, EventKind::End, i, i });
+        }
+        std::sort(endpoints.begin(), endpoints.end(), [](const Event& a, const Event& b) { return b > a; });
+
+        while (hasEvent()) {
+            // События одной точки: концы, пересечения, начала. Дробные точки
+            // пересечений, совпадающие в пределах допуска, - одна точка.
+            group.clear();
+            Event first = peekEvent();
+            popEvent();
+            group.push_back(first);
+            pointX = first.x;
+            pointY = first.y;
+            pointExact = pointX == std::floor(pointX) && pointY == std::floor(pointY);
+            if (pointExact) {
+                while (hasEvent() && peekEvent().x == pointX && peekEvent().y == pointY) {
+                    group.push_back(peekEvent());
+                    popEvent();
+                }
+            }
+            else {
+                double d = tolerance();
+                deferred.clear();
+                while (!events.empty() && events.top().x <= pointX + d) {
+                    const Event& next = events.top();
+                    (std::fabs(next.y - pointY) <= d ? group : deferred).push_back(next);
+                    events.pop();
+                }
+                for (const Event& event : deferred) {
+                    events.push(event);
+                }
+            }
+
+            touched.clear();
+            bool swapped = false;
+            if (group.size() == 1 && first.kind == EventKind::Cross) {
+                if (!active[first.a] || !active[first.b]) continue;
+                swapped = swapNeighbours(first.a, first.b);
+            }
+            if (!swapped) {
+                processPoint(crossings);
+            }
+            for (uint32_t segment : touched) {
+                if (active[segment]) checkNeighbours(segment, crossings);
+            }
+        }
+    }
+
+    void crossedShapes(const std::vector<Shape*>& shapes,
+        const Point& start, const Point& end, std::vector<Shape*>& crossed) {
+        crossed.clear();
+
+        Vertex a{ start.x, start.y }, b{ end.x, end.y };
+        static thread_local std::vector<Vertex> anchors;
+        static thread_local std::vector<SegmentCrossing> found;
+        for (Shape* shape : shapes) {
+            ShapeKind kind = shape->kind();
+            const Circle* circle = nullptr;
+            if (kind == ShapeKind::Circle) circle = static_cast<const Circle*>(shape);
+            else if (kind == ShapeKind::Ring) circle = &static_cast<const Ring*>(shape)->getOuterCircle();
+
+            bool hit = false;
+            if (circle) {
+                double t[2];
+                hit = circleCrossings(a, b, circle->getCenter().x, circle->getCenter().y, circle->getRadius(), t) > 0;
+            }
+            else if (kind == ShapeKind::Arc) {
+                hit = crossesArc(*static_cast<const Arc*>(shape), a, b);
+            }
+            else if (kind == ShapeKind::Line || kind == ShapeKind::Polyline || isClosed(kind)) {
+                // Рёбра - как у SegmentSweep::addShape, с замыкающим у многоугольников
+                anchors.clear();
+                shape->writeAnchors(anchors);
+                if (isClosed(kind) && anchors.size() > 2) anchors.push_back(anchors.front());
+                polylineCrossings(anchors.data(), anchors.size(), a, b, found);
+                hit = !found.empty();
+            }
+            if (hit) crossed.push_back(shape);
+        }
+    }
+
+}
@@ -0,0 +1,123 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+#include "Shapes.h"
+
+namespace MyShapes {
+
+    // Общая точка двух отрезков, добавленных в SegmentSweep
+    struct SweepCrossing {
+        uint32_t firstOwner, firstEdge;
+        uint32_t secondOwner, secondEdge;
+        Vertex point;  // Округлена до целых
+    };
+
+    // Все попарные пересечения множества отрезков заметанием прямой
+    // (Бентли - Оттман) за O((n + k) log n), k - число пересечений. Отрезок
+    // знает владельца (обычно номер фигуры) и номер ребра в нём.
+    //
+    // Проверки пар и порядок отрезков в целых точках (концах) - точные
+    // предикаты Intersect.h; точки пересечений - double, и отрезки через
+    // одну такую точку упорядочиваются по направлениям. Несколько отрезков
+    // через одну точку и касания концом обрабатываются: все пары через точку
+    // сообщаются при её обработке. Коллинеарные наложения, как и у
+    // segmentCrossing, пересечением не считаются. Рёбра одного владельца,
+    // которые сходятся в общей вершине, не сообщаются.
+    //
+    // Отрезки, очередь событий и служебные массивы живут между запусками.
+    class SegmentSweep {
+    public:
+        SegmentSweep();
+
+        SegmentSweep(const SegmentSweep&) = delete;
+        SegmentSweep& operator=(const SegmentSweep&) = delete;
+
+        void clear();
+        void addSegment(const Vertex& a, const Vertex& b, uint32_t owner, uint32_t edge);
+
+        // Рёбра линии, ломаной или многоугольника (с замыкающим ребром);
+        // остальные виды фигур отрезков не дают
+        void addShape(const Shape& shape, uint32_t owner);
+
+        size_t size() const { return segments.size(); }
+
+        void run(std::vector<SweepCrossing>& crossings);
+
+    private:
+        struct Segment {
+            Vertex left, right;  // left раньше right: по x, затем по y
+            uint32_t owner, edge;
+        };
+
+        // Какой отрезок ниже сразу после точки вставки
+        struct Order {
+            const SegmentSweep* sweep;
+            bool operator()(uint32_t a, uint32_t b) const;
+        };
+
+        enum class EventKind : uint8_t { End, Cross, Start };
+
+        struct Event {
+            double x, y;
+            EventKind kind;
+            uint32_t a, b;
+
+            bool operator>(const Event& other) const {
+                if (x != other.x) return x > other.x;
+                if (y != other.y) return y > other.y;
+                return kind > other.kind;
+            }
+        };
+
+        typedef std::set<uint32_t, Order> Status;
+
+        std::vector<Segment> segments;
+        std::vector<Vertex> anchors;
+        std::vector<Event> endpoints;  // Начала и концы, по порядку заметания
+        size_t nextEndpoint = 0;
+        std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;  // Пересечения
+        Status status;
+        std::vector<Status::iterator> positions;
+        std::vector<uint8_t> active;
+        std::unordered_set<uint64_t> tested;  // Уже найденные пересекающиеся пары
+        std::vector<uint32_t> touched;  // Отрезки, у которых в этой точке сменились соседи
+        std::vector<uint32_t> through;  // Отрезки через текущую целую точку
+        std::vector<Event> group, deferred;
+
+        // Текущая точка событий; вставляемый отрезок inserting проходит через неё
+        double pointX = 0, pointY = 0;
+        bool pointExact = false;
+        uint32_t inserting = 0;
+
+        double tolerance() const;
+        int pointSide(const Segment& s) const;
+        int sideAtPoint(uint32_t key, uint32_t other) const;
+        bool containsPoint(uint32_t segment) const;
+        void collectThrough(uint32_t segment);
+        void processPoint(std::vector<SweepCrossing>& crossings);
+        void insert(uint32_t segment);
+        void erase(uint32_t segment);
+        void checkPair(uint32_t a, uint32_t b, std::vector<SweepCrossing>& crossings);
+        void checkNeighbours(uint32_t segment, std::vector<SweepCrossing>& crossings);
+        bool swapNeighbours(uint32_t a, uint32_t b);
+        bool hasEvent() const;
+        const Event& peekEvent() const;
+        void popEvent();
+    };
+
+    // Фигуры из shapes, которые задевает отрезок start - end. Одному отрезку
+    // заметание не нужно: каждая фигура проверяется с ним напрямую, без
+    // пересечений фигур между собой. Рёбра - polylineCrossings; круги и кольца -
+    // общие точки с (внешней) окружностью, дуги - те из них, что лежат в её
+    // угловом промежутке. Заметание остаётся для запросов всех пар.
+    void crossedShapes(const std::vector<Shape*>& shapes,
+        const Point& start, const Point& end, std::vector<Shape*>& crossed);
+
+}
@@ -0,0 +1,60 @@
+﻿#include "Selection.h"
+
+namespace MyShapes {
+
+    bool Selection::add(Shape* shape) {
+        if (!shape || contains(shape)) return false;
+
+        positions[shape] = shapes.size();
+        shapes.push_back(shape);
+        return true;
+    }
+
+    bool Selection::remove(Shape* shape) {
+        auto found = positions.find(shape);
+        if (found == positions.end()) return false;
+
+        // Сохраняем порядок выделения: сдвигаем хвост и его индексы
+        size_t index = found->second;
+        positions.erase(found);
+        shapes.erase(shapes.begin() + index);
+        for (size_t i = index; i < shapes.size(); ++i) {
+            positions[shapes[i]] = i;
+        }
+        return true;
+    }
+
+    void Selection::toggle(Shape* shape) {
+        if (!remove(shape)) {
+            add(shape);
+        }
+    }
+
+    void Selection::clear() {
+        shapes.clear();
+        positions.clear();
+    }
+
+    Rect Selection::bounds() const {
+        Rect r;
+        for (const Shape* shape : shapes) {
+            r.unite(shape->bounds());
+        }
+        return r;
+    }
+
+    void Selection::pivot(double& x, double& y) const {
+        x = y = 0;
+        if (shapes.empty()) return;
+
+        for (const Shape* shape : shapes) {
+            double shapeX, shapeY;
+            shape->pivot(shapeX, shapeY);
+            x += shapeX;
+            y += shapeY;
+        }
+        x /= shapes.size();
+        y /= shapes.size();
+    }
+
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "Geometry.h"
+#include "Shapes.h"
+
+namespace MyShapes {
+
+    // Набор выделенных фигур. Фигурами не владеет: их владелец - Scene.
+    // Порядок - порядок выделения; последняя выделенная фигура - основная
+    // (к ней применяются операции над одной фигурой, например обрезка).
+    class Selection {
+    public:
+        bool contains(const Shape* shape) const { return positions.count(shape) != 0; }
+
+        // Возвращают false, если состав не изменился
+        bool add(Shape* shape);
+        bool remove(Shape* shape);
+
+        // Добавляет невыделенную фигуру или снимает выделение с выделенной
+        void toggle(Shape* shape);
+
+        void clear();
+
+        // Снимает выделение с фигур, для которых predicate(shape) истинно
+        template <typename Predicate>
+        void removeIf(Predicate&& predicate) {
+            size_t kept = 0;
+            for (Shape* shape : shapes) {
+                if (predicate(shape)) {
+                    positions.erase(shape);
+                    continue;
+                }
+                positions[shape] = kept;
+                shapes[kept++] = shape;
+            }
+            shapes.resize(kept);
+        }
+
+        bool empty() const { return shapes.empty(); }
+        size_t size() const { return shapes.size(); }
+
+        const std::vector<Shape*>& getShapes() const { return shapes; }
+        Shape* primary() const { return shapes.empty() ? nullptr : shapes.back(); }
+
+        // Объединение габаритов выделенных фигур
+        Rect bounds() const;
+
+        // Среднее центров фигур (Shape::pivot). При повороте вокруг него
+        // оно остаётся на месте, поэтому повторные повороты группы
+        // не уводят её в сторону, как центр габарита
+        void pivot(double& x, double& y) const;
+
+    private:
+        std::vector<Shape*> shapes;
+        std::unordered_map<const Shape*, size_t> positions;  // Индекс в shapes
+    };
+
+}
@@ -0,0 +1,94 @@
+﻿#include "ShapeArena.h"
+
+namespace MyShapes {
+
+    ShapeArena::ShapeArena(size_t blockSize) : blockSize(blockSize) {}
+
+    ShapeArena::~ShapeArena() {
+        release();
+    }
+
+    void* ShapeArena::carve(size_t bytes) {
+        if ((size_t)(limit - cursor) < bytes) {
+            // Большой запрос получает свой блок, текущий блок продолжает нарезаться
+            if (bytes > blockSize / 4) {
+                char* own = newBlock(bytes);
+                blocks.push_back(own);
+                reserved += bytes;
+                return own;
+            }
+
+            cursor = newBlock(blockSize);
+            limit = cursor + blockSize;
+            blocks.push_back(cursor);
+            reserved += blockSize;
+        }
+
+        void* p = cursor;
+        cursor += bytes;
+        return p;
+    }
+
+    void* ShapeArena::do_allocate(size_t bytes, size_t alignment) {
+        if (alignment > Granularity) {
+            throw std::bad_alloc();
+        }
+
+        size_t rounded = (bytes + Granularity - 1) / Granularity * Granularity;
+        if (rounded == 0) rounded = Granularity;
+
+        size_t cls = rounded / Granularity - 1;
+        if (cls < ClassCount && freeLists[cls]) {
+            FreeChunk* chunk = freeLists[cls];
+            freeLists[cls] = chunk->next;
+            return chunk;
+        }
+        return carve(rounded);
+    }
+
+    // Выравнивание уже проверено в do_allocate: куски всех классов выровнены одинаково
+    void ShapeArena::do_deallocate(void* p, size_t bytes, [[maybe_unused]] size_t alignment) {
+        size_t rounded = (bytes + Granularity - 1) / Granularity * Granularity;
+        if (rounded == 0) rounded = Granularity;
+
+        // Крупные куски остаются в блоке до release
+        size_t cls = rounded / Granularity - 1;
+        if (cls < ClassCount) {
+            FreeChunk* chunk = static_cast<FreeChunk*>(p);
+            chunk->next = freeLists[cls];
+            freeLists[cls] = chunk;
+        }
+    }
+
+    void ShapeArena::destroy(Shape* shape) {
+        if (!shape) return;
+
+        // Начало самого производного объекта: там, куда его поставил create
+        void* object = dynamic_cast<void*>(shape);
+        shape->~Shape();
+
+        Header* header = static_cast<Header*>(object) - 1;
+        deallocate(header, sizeof(Header) + header->size, alignof(Header));
+        --liveShapes;
+    }
+
+    char* ShapeArena::newBlock(size_t bytes) {
+        // Выравнивание задаётся явно: обычный operator new гарантирует
+        // только __STDCPP_DEFAULT_NEW_ALIGNMENT__, а это 8 байт в Win32
+        return static_cast<char*>(::operator new(bytes, std::align_val_t{ Granularity }));
+    }
+
+    void ShapeArena::release() {
+        for (char* block : blocks) {
+            ::operator delete(block, std::align_val_t{ Granularity });
+        }
+        blocks.clear();
+        cursor = limit = nullptr;
+        for (FreeChunk*& list : freeLists) {
+            list = nullptr;
+        }
+        liveShapes = 0;
+        reserved = 0;
+    }
+
+}
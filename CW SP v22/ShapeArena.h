@@ -0,0 +1,100 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Shapes.h"
+
+namespace MyShapes {
+
+    // Память одного документа для фигур и вершин их ломаных.
+    // Память нарезается из крупных блоков; мелкие запросы округляются до
+    // классов по 16 байт, и освобождённый кусок уходит в список своего класса,
+    // так что удалённую фигуру или массив вершин занимают следующие.
+    // release() возвращает блоки разом, не обходя фигуры и не вызывая
+    // деструкторов. Память фигуры и её вершин лежит в арене, но то, что
+    // фигура держит в куче (исходная копия режима точности, общие вершины
+    // копий ломаной), владелец арены освобождает до release - так делает
+    // Scene::clear.
+    // Вершины ломаных получают арену как std::pmr::memory_resource.
+    // Арена не потокобезопасна, как и документ, которому она принадлежит.
+    class ShapeArena : public std::pmr::memory_resource {
+    public:
+        explicit ShapeArena(size_t blockSize = 1024 * 1024);
+        ~ShapeArena();
+
+        ShapeArena(const ShapeArena&) = delete;
+        ShapeArena& operator=(const ShapeArena&) = delete;
+
+        // Создаёт фигуру в арене. Ломаные и многоугольники получают
+        // арену последним аргументом конструктора - для своих вершин.
+        template <typename T, typename... Args>
+        T* create(Args&&... args) {
+            static_assert(std::is_base_of<Shape, T>::value, "ShapeArena holds shapes only");
+            static_assert(alignof(T) <= alignof(Header), "shape alignment exceeds the arena header");
+
+            Header* header = static_cast<Header*>(allocate(sizeof(Header) + sizeof(T), alignof(Header)));
+            header->size = sizeof(T);
+            ++liveShapes;
+
+            if constexpr (std::is_base_of<Polyline, T>::value) {
+                return new (header + 1) T(std::forward<Args>(args)..., this);
+            }
+            else {
+                return new (header + 1) T(std::forward<Args>(args)...);
+            }
+        }
+
+        // Уничтожает фигуру, созданную create; её память займут следующие
+        void destroy(Shape* shape);
+
+        // Освобождает все фигуры и вершины без вызова деструкторов.
+        // Указатели на фигуры арены после этого недействительны.
+        void release();
+
+        // Для контейнеров, живущих вместе с документом
+        std::pmr::memory_resource* getResource() { return this; }
+
+        // Сколько фигур сейчас создано в арене
+        size_t size() const { return liveShapes; }
+
+        // Сколько памяти взято у системы
+        size_t reservedBytes() const { return reserved; }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    private:
+        static const size_t Granularity = 16;
+        static const size_t ClassCount = 32;  // Классы до 512 байт, крупнее - без переиспользования
+
+        // Размер объекта перед ним самим: destroy получает Shape* без точного типа
+        struct alignas(Granularity) Header {
+            size_t size;
+        };
+
+        struct FreeChunk {
+            FreeChunk* next;
+        };
+
+        void* carve(size_t bytes);
+        static char* newBlock(size_t bytes);  // Блок, выровненный на Granularity
+
+        size_t blockSize;
+        std::vector<char*> blocks;
+        char* cursor = nullptr;
+        char* limit = nullptr;
+        FreeChunk* freeLists[ClassCount] = {};
+        size_t liveShapes = 0;
+        size_t reserved = 0;
+    };
+
+}
@@ -0,0 +1,139 @@
+﻿#pragma once
+
+#include <cmath>
+#include <cstdlib>
+
+#include "Geometry.h"
+
+#ifndef M_PI
+#define M_PI 3.1415926535
+#endif
+
+namespace MyShapes {
+
+    // Геометрия фигур над простыми числами. Ими пользуются и классы фигур,
+    // и хранилище SceneStore, поэтому обе формы сцены рисуются и выбираются
+    // кликом одинаково.
+
+    // Допустимое расстояние клика от контура, пиксели
+    const int ClickTolerance = 5;
+
+    // Клик ближе ClickTolerance к отрезку (x1, y1) - (x2, y2) - именно к отрезку,
+    // а не к прямой через него. Без корня и деления: сравниваются квадраты.
+    // Произведения целых координат (до 2^20 по модулю) в double точны, поэтому
+    // векторные ядра (HitTest.h) дают тот же ответ теми же операциями.
+    inline bool nearSegment(int x1, int y1, int x2, int y2, int x, int y) {
+        double dx = (double)x2 - x1, dy = (double)y2 - y1;
+        double px = (double)x - x1, py = (double)y - y1;
+        double dot = px * dx + py * dy;          // Проекция точки на отрезок, умноженная на длину
+        double lengthSq = dx * dx + dy * dy;
+        const double toleranceSq = (double)ClickTolerance * ClickTolerance;
+
+        if (dot <= 0) {
+            return px * px + py * py < toleranceSq;  // Ближе всего начало
+        }
+        if (dot >= lengthSq) {
+            double ex = px - dx, ey = py - dy;
+            return ex * ex + ey * ey < toleranceSq;  // Ближе всего конец
+        }
+
+        // Расстояние до прямой: |cross| / длина
+        double cross = px * dy - py * dx;
+        return cross * cross < toleranceSq * lengthSq;
+    }
+
+    // Пересекает ли луч из (x, y) вправо ребро многоугольника (xi, yi) - (xj, yj).
+    // Нечётное число пересечений - точка внутри.
+    inline bool crossesRay(int xi, int yi, int xj, int yj, int x, int y) {
+        if ((yi > y) == (yj > y)) return false;
+
+        // x < xi + (xj - xi) * (y - yi) / (yj - yi), умноженное на (yj - yi):
+        // точно и без деления, знак множителя меняет сравнение
+        double lhs = ((double)x - xi) * ((double)yj - yi);
+        double rhs = ((double)xj - xi) * ((double)y - yi);
+        return yj > yi ? lhs < rhs : lhs > rhs;
+    }
+
+    inline bool insideCircle(int cx, int cy, int radius, int x, int y) {
+        int dx = x - cx;
+        int dy = y - cy;
+        return dx * dx + dy * dy <= radius * radius;
+    }
+
+    // Внутри внешнего круга и снаружи внутреннего
+    inline bool insideRing(int cx, int cy, int outerRadius, int innerRadius, int x, int y) {
+        return insideCircle(cx, cy, outerRadius, x, y) && !insideCircle(cx, cy, innerRadius, x, y);
+    }
+
+    // Клик в полосе ClickTolerance вокруг дуги от startAngle до endAngle (радианы)
+    inline bool nearArc(int cx, int cy, int radius, double startAngle, double endAngle, int x, int y) {
+        int dx = x - cx;
+        int dy = y - cy;
+
+        // Проверяем, находится ли точка рядом с окружностью дуги
+        double distance = sqrt((double)dx * dx + (double)dy * dy);
+        if (std::abs(distance - radius) >= ClickTolerance) {
+            return false; // Точка далеко от окружности
+        }
+
+        // Приводим углы к диапазону от 0 до 2*PI для удобства
+        double normalizedStartAngle = fmod(startAngle + 2 * M_PI, 2 * M_PI);
+        double normalizedEndAngle = fmod(endAngle + 2 * M_PI, 2 * M_PI);
+        double normalizedAngle = fmod(atan2(dy, dx) + 2 * M_PI, 2 * M_PI);
+
+        // Проверяем, находится ли угол между startAngle и endAngle
+        if (normalizedStartAngle < normalizedEndAngle) {
+            return normalizedAngle >= normalizedStartAngle && normalizedAngle <= normalizedEndAngle;
+        }
+        // Дуга пересекает 0 радиан (например, от 350° до 10°)
+        return normalizedAngle >= normalizedStartAngle || normalizedAngle <= normalizedEndAngle;
+    }
+
+    // Концы дуги в целых координатах - те, что уходят в Renderer::arc
+    inline void arcEndPoints(int cx, int cy, int radius, double startAngle, double endAngle,
+        int& xStart, int& yStart, int& xEnd, int& yEnd) {
+        xStart = cx + radius * cos(startAngle);
+        yStart = cy + radius * sin(startAngle);
+        xEnd = cx + radius * cos(endAngle);
+        yEnd = cy + radius * sin(endAngle);
+    }
+
+    // Точный габарит дуги: концы и те крайние точки окружности
+    // (0, 90, 180, 270 градусов), которые попадают в её угловой диапазон.
+    // Если концы совпали, рисуется вся окружность, и габарит - её.
+    inline Rect arcBounds(int cx, int cy, int radius, double startAngle, double endAngle) {
+        // Совпавшие концы GDI (и SoftwareRenderer) понимают как полный эллипс
+        int xStart, yStart, xEnd, yEnd;
+        arcEndPoints(cx, cy, radius, startAngle, endAngle, xStart, yStart, xEnd, yEnd);
+        if (xStart == xEnd && yStart == yEnd) {
+            return Rect(cx - radius, cy - radius, cx + radius, cy + radius);
+        }
+
+        double from = fmod(fmod(startAngle, 2 * M_PI) + 2 * M_PI, 2 * M_PI);
+        double to = fmod(fmod(endAngle, 2 * M_PI) + 2 * M_PI, 2 * M_PI);
+        if (to < from) {
+            to += 2 * M_PI; // Дуга пересекает 0 радиан
+        }
+
+        Rect r;
+        auto includeAngle = [&](double angle) {
+            double px = cx + radius * cos(angle);
+            double py = cy + radius * sin(angle);
+            r.include((int)floor(px), (int)floor(py));
+            r.include((int)ceil(px), (int)ceil(py));
+        };
+
+        includeAngle(from);
+        includeAngle(to);
+
+        // Крайние точки окружности по осям, попавшие внутрь дуги
+        for (int k = 0; k < 8; ++k) {
+            double extreme = k * M_PI / 2;
+            if (extreme > from && extreme < to) {
+                includeAngle(extreme);
+            }
+        }
+        return r;
+    }
+
+}
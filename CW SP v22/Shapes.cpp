@@ -0,0 +1,796 @@
+﻿#include "Shapes.h"
+
+#include "HitTest.h"
+#include "Intersect.h"
+#include "ShapeKernels.h"
+#include "Transform.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace MyShapes {
+
+    void Point::rotateAround(const Point& center, double angle) {
+        double rad = angle * M_PI / 180.0; // Переводим угол в радианы
+        double cosAngle = cos(rad);
+        double sinAngle = sin(rad);
+
+        // Смещаем точку к началу координат
+        double dx = x - center.x;
+        double dy = y - center.y;
+
+        // Поворачиваем и возвращаем точку обратно
+        x = (int)lrint(center.x + (dx * cosAngle - dy * sinAngle));
+        y = (int)lrint(center.y + (dx * sinAngle + dy * cosAngle));
+    }
+
+    // ---------------------------------------------------------------- Shape
+
+    void Shape::transform(const Affine& m) {
+        std::vector<Vertex> anchors;
+        writeAnchors(anchors);
+        transformVertices(m, anchors.data(), anchors.size());
+        readAnchors(anchors.data(), m);
+    }
+
+    // ---------------------------------------------------------------- CachedBoundsShape
+
+    void CachedBoundsShape::setPrecise(bool on) {
+        if (!on) {
+            placement.reset();
+            return;
+        }
+        if (placement) return;
+
+        placement.reset(new Placement{ std::unique_ptr<Shape>(copy()), Affine::identity() });
+    }
+
+    void CachedBoundsShape::bake() {
+        static thread_local std::vector<Vertex> anchors;
+        anchors.clear();
+        placement->original->writeAnchors(anchors);
+        transformVertices(placement->matrix, anchors.data(), anchors.size());
+
+        // Параметры и точки берутся у исходной фигуры, поэтому матрица
+        // применяется целиком, а не к результату прошлого округления
+        baking = true;
+        restoreParameters(*placement->original);
+        readAnchors(anchors.data(), placement->matrix);
+        baking = false;
+    }
+
+    void CachedBoundsShape::transform(const Affine& m) {
+        if (!placement) {
+            Shape::transform(m);
+            return;
+        }
+        placement->matrix = m * placement->matrix;
+        bake();
+    }
+
+    void CachedBoundsShape::pivot(double& x, double& y) const {
+        if (!placement) {
+            computePivot(x, y);
+            return;
+        }
+        double originalX, originalY;
+        placement->original->pivot(originalX, originalY);
+        placement->matrix.apply(originalX, originalY, x, y);
+    }
+
+    bool lineSegmentIntersection(const Point& p1, const Point& p2, const Point& q1, const Point& q2, Point& intersection) {
+        // Точные предикаты (Intersect.h): без переполнения и целочисленного деления
+        Vertex a{ p1.x, p1.y }, b{ p2.x, p2.y };
+        double t;
+        if (!segmentCrossing(a, b, Vertex{ q1.x, q1.y }, Vertex{ q2.x, q2.y }, t)) {
+            return false; // Общей точки нет, или отрезки на одной прямой
+        }
+        intersection.x = (int)lrint(a.x + t * ((double)b.x - a.x));
+        intersection.y = (int)lrint(a.y + t * ((double)b.y - a.y));
+        return true;
+    }
+
+    // ---------------------------------------------------------------- Line
+
+    void Line::trim(const Point& trimStart, const Point& trimEnd) {
+        Point crossing;
+        if (!lineSegmentIntersection(start, end, trimStart, trimEnd, crossing)) return;
+        if (crossing.x == start.x && crossing.y == start.y) return;  // От линии ничего бы не осталось
+        end.x = crossing.x;
+        end.y = crossing.y;
+        markDirty();
+    }
+
+    void Line::draw(Renderer& renderer) {
+        renderer.setPen(color); // Перо выбранного цвета
+        renderer.line(start.x, start.y, end.x, end.y);
+    }
+
+    bool Line::isClicked(int x, int y) {
+        // Простая проверка на попадание в линию (с учётом некоторой погрешности)
+        return nearSegment(start.x, start.y, end.x, end.y, x, y);
+    }
+
+    Rect Line::computeBounds() const {
+        Rect r(start.x, start.y, start.x, start.y);
+        r.include(end.x, end.y);
+        return r;
+    }
+
+    void Line::rotate(double angle) {
+        // Поворачиваем обе точки вокруг середины линии
+        double centerX, centerY;
+        pivot(centerX, centerY);
+        transform(Affine::rotation(centerX, centerY, angle));
+    }
+
+    // ---------------------------------------------------------------- Circle
+
+    void Circle::draw(Renderer& renderer) {
+        renderer.setPen(color); // Перо выбранного цвета
+        renderer.ellipse(center.x - radius, center.y - radius, center.x + radius, center.y + radius);
+    }
+
+    bool Circle::isClicked(int x, int y) {
+        return insideCircle(center.x, center.y, radius, x, y);
+    }
+
+    Rect Circle::computeBounds() const {
+        return Rect(center.x - radius, center.y - radius, center.x + radius, center.y + radius);
+    }
+
+    namespace {
+        const double TwoPi = 2 * M_PI;
+
+        // Общая точка отрезка обрезки в самом начале дуги ничего бы от неё не оставила
+        const double AngleEpsilon = 1e-9;
+
+        // Угол, приведённый к [0, 2π)
+        double normalizedAngle(double angle) {
+            angle = fmod(angle, TwoPi);
+            return angle < 0 ? angle + TwoPi : angle;
+        }
+
+        // Меньше нуля - точка слева от отрезка ab, если смотреть на экране
+        // (ось y вниз) из a в b; обрезка оставляет замкнутые фигуры с этой стороны
+        double sideOf(const Point& a, const Point& b, double x, double y) {
+            return ((double)b.x - a.x) * (y - a.y) - ((double)b.y - a.y) * (x - a.x);
+        }
+
+        Point pointOn(const Point& a, const Point& b, double t) {
+            return Point((int)lrint(a.x + t * ((double)b.x - a.x)), (int)lrint(a.y + t * ((double)b.y - a.y)));
+        }
+
+        // Отрезок обрезки, проходящий окружность насквозь
+        struct Chord {
+            double t[2];      // Положения общих точек на отрезке, по возрастанию
+            double from, to;  // Дуга от from к to по возрастанию угла - слева от отрезка
+        };
+
+        bool chordOf(const Point& center, int radius, const Point& a, const Point& b, Chord& chord) {
+            if (radius <= 0) return false;
+            if (circleCrossings(Vertex{ a.x, a.y }, Vertex{ b.x, b.y }, center.x, center.y, radius, chord.t) != 2) {
+                return false;
+            }
+            double angles[2];
+            for (int i = 0; i < 2; ++i) {
+                double x = a.x + chord.t[i] * ((double)b.x - a.x);
+                double y = a.y + chord.t[i] * ((double)b.y - a.y);
+                angles[i] = atan2(y - center.y, x - center.x);
+            }
+            // Сторону дуги от первой точки ко второй решает её середина
+            double middle = angles[0] + normalizedAngle(angles[1] - angles[0]) / 2;
+            bool left = sideOf(a, b, center.x + radius * cos(middle), center.y + radius * sin(middle)) < 0;
+            chord.from = normalizedAngle(angles[left ? 0 : 1]);
+            chord.to = normalizedAngle(angles[left ? 1 : 0]);
+            return true;
+        }
+    }
+
+    bool Circle::trimPieces(const Point& trimStart, const Point& trimEnd, std::vector<Shape*>& pieces) const {
+        Chord chord;
+        if (!chordOf(center, radius, trimStart, trimEnd, chord)) return false;
+        Shape* arc = new Arc(center, radius, chord.from, chord.to);
+        arc->setColor(color);
+        pieces.push_back(arc);
+        return true;
+    }
+
+    namespace {
+        // Радиус после подобия: масштаб - корень из модуля определителя,
+        // у движений (сдвиг, поворот, отражение) он равен 1
+        int scaledRadius(int radius, const Affine& m) {
+            double scale = sqrt(fabs(m.determinant()));
+            if (fabs(scale - 1.0) <= 1e-9) return radius;
+            return (int)lrint(radius * scale);
+        }
+    }
+
+    const Vertex* Circle::readAnchors(const Vertex* anchors, const Affine& m) {
+        anchors = center.readAnchors(anchors, m);
+        radius = scaledRadius(radius, m);
+        markDirty();
+        return anchors;
+    }
+
+    // ---------------------------------------------------------------- Arc
+
+    Arc::Arc(Point center, Point startPoint, Point endPoint)
+        : center(center) {
+        radius = sqrt(pow(startPoint.x - center.x, 2) + pow(startPoint.y - center.y, 2));
+        startAngle = atan2(startPoint.y - center.y, startPoint.x - center.x);
+        endAngle = atan2(endPoint.y - center.y, endPoint.x - center.x);
+    }
+
+    void Arc::draw(Renderer& renderer) {
+        renderer.setPen(color); // Перо выбранного цвета
+
+        // Преобразуем углы в координаты точек на окружности
+        int xStart, yStart, xEnd, yEnd;
+        arcEndPoints(center.x, center.y, radius, startAngle, endAngle, xStart, yStart, xEnd, yEnd);
+
+        // Дуга идёт от startAngle к endAngle по возрастанию угла, то есть на экране
+        // (ось y вниз) по часовой стрелке. Renderer::arc рисует против часовой,
+        // поэтому концы передаются в обратном порядке.
+        renderer.arc(center.x - radius, center.y - radius, center.x + radius, center.y + radius,
+            xEnd, yEnd, xStart, yStart);
+    }
+
+    void Arc::rotate(double angle) {
+        if (isPrecise()) {
+            transform(Affine::rotation(center.x, center.y, angle));
+            return;
+        }
+
+        // angle задан в градусах, как у остальных фигур, а углы дуги - в радианах
+        double rad = angle * M_PI / 180.0;
+        startAngle += rad;
+        endAngle += rad;
+
+        // Приводим углы к диапазону от 0 до 2π для корректного отображения
+        startAngle = fmod(startAngle + 2 * M_PI, 2 * M_PI);
+        endAngle = fmod(endAngle + 2 * M_PI, 2 * M_PI);
+        markDirty();
+    }
+
+    void Arc::mirror(bool vertical) {
+        if (vertical) {
+            startAngle = -startAngle;
+            endAngle = -endAngle;
+        }
+        else {
+            startAngle = M_PI - startAngle;
+            endAngle = M_PI - endAngle;
+        }
+        markDirty();
+    }
+
+    const Vertex* Arc::readAnchors(const Vertex* anchors, const Affine& m) {
+        anchors = center.readAnchors(anchors, m);
+
+        // Направление на конец дуги преобразуется линейной частью матрицы
+        auto mapAngle = [&](double angle) {
+            double dx = cos(angle), dy = sin(angle);
+            return atan2(m.c * dx + m.d * dy, m.a * dx + m.b * dy);
+        };
+        double newStart = mapAngle(startAngle);
+        double newEnd = mapAngle(endAngle);
+        if (m.determinant() < 0) {
+            std::swap(newStart, newEnd);
+        }
+        startAngle = newStart;
+        endAngle = newEnd;
+        radius = scaledRadius(radius, m);
+        markDirty();
+        return anchors;
+    }
+
+    bool Arc::isClicked(int x, int y) {
+        // Полоса ClickTolerance вокруг дуги, как у отрезков
+        return nearArc(center.x, center.y, radius, startAngle, endAngle, x, y);
+    }
+
+    Rect Arc::computeBounds() const {
+        return arcBounds(center.x, center.y, radius, startAngle, endAngle);
+    }
+
+    void Arc::trim(const Point& trimStart, const Point& trimEnd) {
+        double t[2];
+        int count = circleCrossings(Vertex{ trimStart.x, trimStart.y }, Vertex{ trimEnd.x, trimEnd.y },
+            center.x, center.y, radius, t);
+
+        // Угловая длина дуги; совпавшие концы - вся окружность
+        double span = normalizedAngle(endAngle - startAngle);
+        if (span == 0) span = TwoPi;
+        double nearest = span;
+        for (int i = 0; i < count; ++i) {
+            double x = trimStart.x + t[i] * ((double)trimEnd.x - trimStart.x);
+            double y = trimStart.y + t[i] * ((double)trimEnd.y - trimStart.y);
+            double along = normalizedAngle(atan2(y - center.y, x - center.x) - startAngle);
+            if (along > AngleEpsilon && along < nearest) nearest = along;
+        }
+        if (nearest == span) return;  // Отрезок не задел дугу или задел её конец
+        endAngle = normalizedAngle(startAngle + nearest);
+        markDirty();
+    }
+
+    // ---------------------------------------------------------------- Ring
+
+    bool Ring::isClicked(int x, int y) {
+        // Внутри внешнего круга и снаружи внутреннего
+        return insideRing(outerCircle.getCenter().x, outerCircle.getCenter().y,
+            outerCircle.getRadius(), innerCircle.getRadius(), x, y);
+    }
+
+    bool Ring::trimPieces(const Point& trimStart, const Point& trimEnd, std::vector<Shape*>& pieces) const {
+        int outer = std::max(outerCircle.getRadius(), innerCircle.getRadius());
+        int inner = std::min(outerCircle.getRadius(), innerCircle.getRadius());
+        Chord outerChord;
+        if (!chordOf(center, outer, trimStart, trimEnd, outerChord)) return false;
+
+        auto keep = [&](Shape* piece) {
+            piece->setColor(color);
+            pieces.push_back(piece);
+        };
+        keep(new Arc(center, outer, outerChord.from, outerChord.to));
+        Point outerFirst = pointOn(trimStart, trimEnd, outerChord.t[0]);
+        Point outerLast = pointOn(trimStart, trimEnd, outerChord.t[1]);
+
+        // Хорда внутреннего круга лежит внутри хорды внешнего
+        Chord innerChord;
+        if (chordOf(center, inner, trimStart, trimEnd, innerChord)) {
+            // Разрез проходит через отверстие: край разреза - два отрезка между кругами
+            keep(new Arc(center, inner, innerChord.from, innerChord.to));
+            keep(new Line(outerFirst, pointOn(trimStart, trimEnd, innerChord.t[0])));
+            keep(new Line(pointOn(trimStart, trimEnd, innerChord.t[1]), outerLast));
+        }
+        else {
+            keep(new Line(outerFirst, outerLast));
+            // Отверстие целиком по одну сторону разреза
+            if (inner > 0 && sideOf(trimStart, trimEnd, center.x, center.y) < 0) {
+                keep(new Circle(center, inner));
+            }
+        }
+        return true;
+    }
+
+    // ---------------------------------------------------------------- Polyline
+
+    namespace {
+        // Выпуклая оболочка (монотонная цепь Эндрю) без точек на рёбрах
+        std::vector<Vertex> convexHull(std::vector<Vertex> v) {
+            std::sort(v.begin(), v.end(), [](const Vertex& a, const Vertex& b) {
+                return a.x < b.x || (a.x == b.x && a.y < b.y);
+            });
+            v.erase(std::unique(v.begin(), v.end(), [](const Vertex& a, const Vertex& b) {
+                return a.x == b.x && a.y == b.y;
+            }), v.end());
+            if (v.size() < 3) return v;
+
+            auto cross = [](const Vertex& o, const Vertex& a, const Vertex& b) {
+                return (int64_t)(a.x - o.x) * (b.y - o.y) - (int64_t)(a.y - o.y) * (b.x - o.x);
+            };
+            std::vector<Vertex> hull(2 * v.size());
+            size_t k = 0;
+            for (size_t i = 0; i < v.size(); ++i) {
+                while (k >= 2 && cross(hull[k - 2], hull[k - 1], v[i]) <= 0) --k;
+                hull[k++] = v[i];
+            }
+            for (size_t i = v.size() - 1, lower = k + 1; i > 0; --i) {
+                while (k >= lower && cross(hull[k - 2], hull[k - 1], v[i - 1]) <= 0) --k;
+                hull[k++] = v[i - 1];
+            }
+            hull.resize(k - 1);
+            return hull;
+        }
+
+        // Вершины экземпляра во временном буфере потока
+        const std::vector<Vertex>& instanceVertices(const Polyline& polyline) {
+            static thread_local std::vector<Vertex> vertices;
+            vertices.resize(polyline.vertexCount());
+            polyline.copyVertices(vertices.data());
+            return vertices;
+        }
+    }
+
+    const std::vector<Vertex>& SharedVertices::getHull() const {
+        std::call_once(hullBuilt, [this] { hull = convexHull(vertices); });
+        return hull;
+    }
+
+    std::shared_ptr<const SharedVertices> Polyline::sharedVertices() const {
+        if (shared) return shared;
+        if (!snapshot) {
+            std::shared_ptr<SharedVertices> vertices = std::make_shared<SharedVertices>();
+            vertices->vertices.reserve(points.size());
+            vertices->sumX = vertices->sumY = 0;
+            for (const Point& p : points) {
+                vertices->vertices.push_back(Vertex{ p.x, p.y });
+                vertices->sumX += p.x;
+                vertices->sumY += p.y;
+            }
+            snapshot = vertices;
+        }
+        return snapshot;
+    }
+
+    void Polyline::place(const Affine& m) {
+        matrix = m;
+        if (shifted()) {
+            std::vector<Vertex>().swap(placed);
+            return;
+        }
+        placed = shared->vertices;
+        transformVertices(matrix, placed.data(), placed.size());
+    }
+
+    void Polyline::copyVertices(Vertex* out) const {
+        if (shared) {
+            if (!shifted()) {
+                std::copy(placed.begin(), placed.end(), out);
+                return;
+            }
+            int dx = (int)matrix.tx, dy = (int)matrix.ty;
+            for (const Vertex& v : shared->vertices) {
+                *out++ = Vertex{ v.x + dx, v.y + dy };
+            }
+            return;
+        }
+        for (const Point& p : points) {
+            *out++ = Vertex{ p.x, p.y };
+        }
+    }
+
+    void Polyline::unshare() {
+        if (!shared) return;
+
+        const std::vector<Vertex>& vertices = instanceVertices(*this);
+        points.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            points[i].x = vertices[i].x;
+            points[i].y = vertices[i].y;
+        }
+        shared.reset();
+        matrix = Affine::identity();
+        std::vector<Vertex>().swap(placed);
+        sumValid = false;
+    }
+
+    void Polyline::transform(const Affine& m) {
+        if (!shared) {
+            CachedBoundsShape::transform(m);
+            return;
+        }
+        place(m * matrix);
+        markDirty();
+    }
+
+    const Vertex* Polyline::readAnchors(const Vertex* anchors, const Affine& m) {
+        if (shared) {
+            Affine candidate = m * matrix;
+            size_t n = shared->vertices.size();
+            if (isShift(candidate)) {
+                // Образы при целом сдвиге целые без округления: сравнивается
+                // только матрица, точки совпадают с ней заведомо
+                place(candidate);
+                markDirty();
+                return anchors + n;
+            }
+
+            // Иначе округление половин может разойтись с записанными точками.
+            // Сверяются вершины, которые экземпляру всё равно нужны для рисования.
+            static thread_local std::vector<Vertex> expected;
+            expected = shared->vertices;
+            transformVertices(candidate, expected.data(), n);
+            bool same = std::equal(expected.begin(), expected.end(), anchors, [](const Vertex& a, const Vertex& b) {
+                return a.x == b.x && a.y == b.y;
+            });
+            if (same) {
+                matrix = candidate;
+                placed.swap(expected);
+                markDirty();
+                return anchors + n;
+            }
+            unshare();
+        }
+
+        for (Point& p : points) {
+            p.x = anchors->x;
+            p.y = anchors->y;
+            ++anchors;
+        }
+        markDirty();
+        return anchors;
+    }
+
+    void Polyline::drawOutline(Renderer& renderer, bool closed) const {
+        renderer.setPen(color); // Перо выбранного цвета
+
+        if (shared) {
+            // Экземпляр рисуется из общих вершин со сдвигом или из placed:
+            // при рисовании ничего не пересчитывается
+            bool shift = shifted();
+            const std::vector<Vertex>& v = shift ? shared->vertices : placed;
+            int dx = shift ? (int)matrix.tx : 0, dy = shift ? (int)matrix.ty : 0;
+            for (size_t i = 0; i + 1 < v.size(); ++i) {
+                renderer.line(v[i].x + dx, v[i].y + dy, v[i + 1].x + dx, v[i + 1].y + dy);
+            }
+            if (closed && !v.empty()) {
+                renderer.line(v.back().x + dx, v.back().y + dy, v[0].x + dx, v[0].y + dy);
+            }
+            return;
+        }
+
+        for (size_t i = 0; i + 1 < points.size(); ++i) {
+            renderer.line(points[i].x, points[i].y, points[i + 1].x, points[i + 1].y);
+        }
+        if (closed && !points.empty()) {
+            renderer.line(points.back().x, points.back().y, points[0].x, points[0].y);
+        }
+    }
+
+    void Polyline::draw(Renderer& renderer) {
+        drawOutline(renderer, false);
+    }
+
+    Point Polyline::centroid() const {
+        double x, y;
+        computePivot(x, y);
+        return Point((int)x, (int)y);
+    }
+
+    void Polyline::computePivot(double& x, double& y) const {
+        if (shared) {
+            // Среднее общих вершин, переведённое матрицей
+            size_t n = shared->vertices.size();
+            if (n == 0) {
+                x = y = 0;
+                return;
+            }
+            matrix.apply(shared->sumX / n, shared->sumY / n, x, y);
+            return;
+        }
+        if (points.empty()) {
+            x = y = 0;
+            return;
+        }
+        if (!sumValid) {
+            sumX = 0;
+            sumY = 0;
+            for (const Point& p : points) {
+                sumX += p.x;
+                sumY += p.y;
+            }
+            sumValid = true;
+        }
+        x = sumX / points.size();
+        y = sumY / points.size();
+    }
+
+    void Polyline::rotatePointsAround(double centerX, double centerY, double angle) {
+        double rad = angle * M_PI / 180.0; // Переводим угол в радианы
+        double cosAngle = cos(rad);
+        double sinAngle = sin(rad);
+
+        double newSumX = 0, newSumY = 0;
+        for (Point& p : points) {
+            double dx = p.x - centerX;
+            double dy = p.y - centerY;
+
+            // То же, что Point::rotateAround, но синус и косинус считаются один раз
+            p.x = (int)lrint(centerX + (dx * cosAngle - dy * sinAngle));
+            p.y = (int)lrint(centerY + (dx * sinAngle + dy * cosAngle));
+
+            newSumX += p.x;
+            newSumY += p.y;
+        }
+
+        markDirty();
+        sumX = newSumX;
+        sumY = newSumY;
+        sumValid = true;
+    }
+
+    void Polyline::rotate(double angle) {
+        if (vertexCount() == 0) return;
+
+        // Центр не округляется: у треугольника и параллелограмма это
+        // тоже среднее вершин
+        double centerX, centerY;
+        pivot(centerX, centerY);
+        if (isPrecise() || shared) {
+            transform(Affine::rotation(centerX, centerY, angle));
+            return;
+        }
+
+        // Поворачиваем каждую точку вокруг центра
+        rotatePointsAround(centerX, centerY, angle);
+    }
+
+    void Polyline::mirror(bool vertical) {
+        if (vertexCount() == 0) return;
+
+        // Находим центр ломаной как среднее всех точек
+        Point center = centroid();
+        if (shared) {
+            // Отражение относительно целого центра переносит вершины точно
+            transform(Affine::mirror(center.x, center.y, vertical));
+            return;
+        }
+
+        // Зеркально отражаем каждую точку относительно центра
+        for (Point& p : points) {
+            if (vertical) {
+                p.x = center.x - (p.x - center.x);
+            }
+            else {
+                p.y = center.y - (p.y - center.y);
+            }
+        }
+
+        // Сумма координат отражается так же, как каждая точка
+        double n = (double)points.size();
+        double newSumX = vertical ? 2.0 * center.x * n - sumX : sumX;
+        double newSumY = vertical ? sumY : 2.0 * center.y * n - sumY;
+        markDirty();
+        sumX = newSumX;
+        sumY = newSumY;
+        sumValid = true;
+    }
+
+    namespace {
+        // Вершины фигуры подряд, как их ждут ядра HitTest.h. Буфер у каждого потока свой
+        const std::vector<Vertex>& packedVertices(const Shape& shape) {
+            static thread_local std::vector<Vertex> packed;
+            packed.clear();
+            shape.writeAnchors(packed);
+            return packed;
+        }
+    }
+
+    bool Polyline::isClicked(int x, int y) {
+        // Габарит кэширован: далёкие клики отсекаются без обхода вершин
+        if (!bounds().inflated(ClickTolerance).contains(x, y)) return false;
+
+        const std::vector<Vertex>& packed = packedVertices(*this);
+        return nearPolyline(packed.data(), packed.size(), x, y);
+    }
+
+    Rect Polyline::computeBounds() const {
+        Rect r;
+        if (shared) {
+            if (!shifted()) {
+                for (const Vertex& v : placed) {
+                    r.include(v.x, v.y);
+                }
+                return r;
+            }
+            // Габарит сдвинутого экземпляра - габарит оболочки общих вершин со сдвигом
+            int dx = (int)matrix.tx, dy = (int)matrix.ty;
+            for (const Vertex& v : shared->getHull()) {
+                r.include(v.x + dx, v.y + dy);
+            }
+            return r;
+        }
+        for (const Point& p : points) {
+            r.include(p.x, p.y);
+        }
+        return r;
+    }
+
+    void Polyline::trim(const Point& trimStart, const Point& trimEnd) {
+        // Вершины экземпляра читаются из общих; свои он получит, только если обрезка случится
+        const std::vector<Vertex>& vertices = packedVertices(*this);
+        std::vector<SegmentCrossing> crossings;
+        polylineCrossings(vertices.data(), vertices.size(),
+            Vertex{ trimStart.x, trimStart.y }, Vertex{ trimEnd.x, trimEnd.y }, crossings);
+
+        // Остаётся участок до первой общей точки с линией обрезки;
+        // точка в самом начале ломаной от неё ничего бы не оставила
+        for (const SegmentCrossing& crossing : crossings) {
+            const Vertex& first = vertices[0];
+            if (crossing.point.x == first.x && crossing.point.y == first.y) continue;
+
+            std::vector<Point> trimmedPoints;
+            trimmedPoints.reserve(crossing.segment + 2);
+            for (size_t i = 0; i <= crossing.segment; ++i) {
+                trimmedPoints.push_back(Point(vertices[i].x, vertices[i].y));
+            }
+            const Vertex& last = vertices[crossing.segment];
+            if (crossing.point.x != last.x || crossing.point.y != last.y) {
+                trimmedPoints.push_back(Point(crossing.point.x, crossing.point.y));
+            }
+
+            shared.reset();
+            matrix = Affine::identity();
+            std::vector<Vertex>().swap(placed);
+            points.assign(trimmedPoints.begin(), trimmedPoints.end());
+            markDirty();
+            return;
+        }
+    }
+
+    // ---------------------------------------------------------------- Polygon
+
+    void Polygon::draw(Renderer& renderer) {
+        drawOutline(renderer, true);
+    }
+
+    bool Polygon::isClicked(int x, int y) {
+        if (!bounds().contains(x, y)) return false;
+
+        // Правило чётности: луч вправо пересекает контур нечётное число раз
+        const std::vector<Vertex>& packed = packedVertices(*this);
+        return insidePolygon(packed.data(), packed.size(), x, y);
+    }
+
+    // ---------------------------------------------------------------- Triangle
+
+    bool Triangle::trimPieces(const Point& trimStart, const Point& trimEnd, std::vector<Shape*>& pieces) const {
+        std::vector<Vertex> v;
+        writeAnchors(v);
+        Vertex a{ trimStart.x, trimStart.y }, b{ trimEnd.x, trimEnd.y };
+        if (v.size() != 3 || (a.x == b.x && a.y == b.y)) return false;
+
+        // Прямая разреза делит вершины, и отрезок покрывает всю хорду: оба
+        // её конца - пересечения рёбер с отрезком или вершины на отрезке
+        int sides[3];
+        bool left = false, right = false;
+        for (int i = 0; i < 3; ++i) {
+            sides[i] = orientation(a, b, v[i]);
+            left |= sides[i] < 0;
+            right |= sides[i] > 0;
+        }
+        if (!left || !right) return false;
+        for (int i = 0; i < 3; ++i) {
+            double t;
+            if (sides[i] * sides[(i + 1) % 3] < 0 && !segmentCrossing(v[i], v[(i + 1) % 3], a, b, t)) return false;
+            if (sides[i] == 0 && !segmentCrossing(v[(i + 2) % 3], v[i], a, b, t)) return false;
+        }
+
+        // Отсечение полуплоскостью (Сазерленд - Ходжман): вершины слева и на
+        // прямой остаются, на рёбрах, где сторона сменилась, встают точки разреза
+        std::vector<Point> kept;
+        for (int i = 0; i < 3; ++i) {
+            const Vertex& p = v[i];
+            const Vertex& q = v[(i + 1) % 3];
+            if (sides[i] <= 0) kept.push_back(Point(p.x, p.y));
+            if (sides[i] * sides[(i + 1) % 3] < 0) {
+                double sp = sideOf(trimStart, trimEnd, p.x, p.y), sq = sideOf(trimStart, trimEnd, q.x, q.y);
+                double t = std::min(std::max(sp / (sp - sq), 0.0), 1.0);  // Знаки точные, значения - нет
+                Point cut = pointOn(Point(p.x, p.y), Point(q.x, q.y), t);
+                if (kept.empty() || kept.back().x != cut.x || kept.back().y != cut.y) kept.push_back(cut);
+            }
+        }
+        if (kept.size() > 1 && kept.back().x == kept.front().x && kept.back().y == kept.front().y) kept.pop_back();
+        if (kept.size() < 3) return false;  // Разрез у самой вершины: после округления не осталось площади
+
+        Shape* piece = kept.size() == 3 ? static_cast<Shape*>(new Triangle(kept[0], kept[1], kept[2])) : new Polygon(kept);
+        piece->setColor(color);
+        pieces.push_back(piece);
+        return true;
+    }
+
+    // ---------------------------------------------------------------- Parallelogram
+
+    Parallelogram::Parallelogram(Point p1, Point p2, double angle, std::pmr::memory_resource* resource)
+        : Polygon({ p1, p2 }, resource) {
+        // Вычисляем третью и четвертую точку на основе угла
+        double dx = p2.x - p1.x;
+        double dy = p2.y - p1.y;
+
+        // Длина стороны
+        double length = sqrt(dx * dx + dy * dy);
+
+        // Угол наклона (в радианах)
+        double rad = angle * M_PI / 180.0;
+
+        // Вычисляем третью точку, используя угол наклона
+        Point p3(p1.x + length * cos(rad), p1.y + length * sin(rad));
+        Point p4(p2.x + length * cos(rad), p2.y + length * sin(rad));
+
+        points.push_back(p4);
+        points.push_back(p3);
+    }
+
+}
@@ -0,0 +1,748 @@
+﻿#pragma once
+
+#include <vector>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <cmath>
+
+#include "Affine.h"
+#include "Geometry.h"
+#include "Renderer.h"
+
+#ifndef M_PI
+#define M_PI 3.1415926535
+#endif
+
+namespace MyShapes {
+
+    class Point;
+
+    // Точный тип фигуры. В отличие от dynamic_cast не учитывает наследование:
+    // треугольник имеет вид Triangle, а не Polyline.
+    enum class ShapeKind {
+        Point,
+        Line,
+        Circle,
+        Arc,
+        Ring,
+        Polyline,
+        Polygon,
+        Triangle,
+        Parallelogram,
+        Count
+    };
+
+    const int ShapeKindCount = (int)ShapeKind::Count;
+
+    // Набор видов фигур в виде битовой маски
+    typedef unsigned KindMask;
+
+    inline KindMask kindBit(ShapeKind kind) {
+        return 1u << (int)kind;
+    }
+
+    const KindMask AllKinds = (1u << ShapeKindCount) - 1;
+
+    // Определим интерфейс для всех фигур
+    class Shape {
+    protected:
+        Color color = 0;
+    public:
+
+        virtual void setColor(Color newColor) {
+            color = newColor;
+        }
+
+        Color getColor() const { return color; }
+
+        // Вид фигуры; у каждого класса есть и статическая константа Kind
+        virtual ShapeKind kind() const = 0;
+
+        virtual void draw(Renderer& renderer) = 0;
+        virtual void move(int dx, int dy) = 0;
+        virtual Shape* copy() const = 0;
+        virtual void rotate(double angle) = 0;
+        virtual void mirror(bool vertical) = 0;
+        virtual void trim(const MyShapes::Point& start, const MyShapes::Point& end) = 0;
+
+        // Обрезка, после которой фигура становится фигурами других видов:
+        // круг - дугой, кольцо и треугольник - обрезанным контуром. true -
+        // фигура заменяется новыми фигурами pieces её цвета; false - отрезок
+        // её не разрезает, и обрезка (если есть) выполняется на месте, trim.
+        virtual bool trimPieces(const Point& start, const Point& end, std::vector<Shape*>& pieces) const {
+            return false;
+        }
+
+        // Добавляем виртуальный метод isClicked
+        virtual bool isClicked(int x, int y) = 0;
+
+        // Габаритный прямоугольник фигуры (без учёта допуска на клик)
+        virtual Rect bounds() const = 0;
+
+        // Пакетное преобразование (BatchTransform, Transform.h): фигура дописывает
+        // свои опорные точки в общий массив, одна матрица преобразует его целиком,
+        // затем фигура забирает точки обратно и пересчитывает остальное (углы
+        // дуги, габарит). readAnchors возвращает начало точек следующей фигуры.
+        virtual void writeAnchors(std::vector<Vertex>& anchors) const = 0;
+        virtual const Vertex* readAnchors(const Vertex* anchors, const Affine& m) = 0;
+
+        // Преобразует одну фигуру матрицей m через её опорные точки
+        virtual void transform(const Affine& m);
+
+        // Центр поворота и отражения: середина отрезка, центр круга,
+        // среднее вершин ломаной. Не округляется до целых.
+        virtual void pivot(double& x, double& y) const = 0;
+
+        // Режим точности (см. CachedBoundsShape); точка его не поддерживает
+        virtual void setPrecise(bool on) {}
+        virtual bool isPrecise() const { return false; }
+
+        // Экземпляр общей геометрии (см. Polyline::copy): преобразуется
+        // своей матрицей, как фигура в режиме точности
+        virtual bool isInstance() const { return false; }
+
+        virtual ~Shape() {}  // Виртуальный деструктор для безопасного удаления производных классов
+    };
+
+    // Точка
+    class Point : public Shape {
+    public:
+        static constexpr ShapeKind Kind = ShapeKind::Point;
+        ShapeKind kind() const override { return Kind; }
+
+    public:
+        int x, y;
+
+        Point() : x(0), y(0) {}  // Конструктор по умолчанию
+
+        Point(int x, int y) : x(x), y(y) {}
+
+        void draw(Renderer& renderer) override {
+            renderer.pixel(x, y, color);
+        }
+
+        void move(int dx, int dy) override {
+            x += dx;
+            y += dy;
+        }
+
+        Shape* copy() const override {
+            return new Point(x, y);
+        }
+
+        void rotate(double angle) override {
+            // Поворот точки не имеет смысла
+        }
+
+        void mirror(bool vertical) override {
+            if (vertical) {
+                x = -x;
+            }
+            else {
+                y = -y;
+            }
+        }
+
+        bool isClicked(int x, int y) override {
+            return this->x == x && this->y == y; // Простая проверка
+        }
+
+        Rect bounds() const override {
+            return Rect(x, y, x, y);
+        }
+
+        void writeAnchors(std::vector<Vertex>& anchors) const override {
+            anchors.push_back(Vertex{ x, y });
+        }
+
+        const Vertex* readAnchors(const Vertex* anchors, const Affine& m) override {
+            x = anchors->x;
+            y = anchors->y;
+            return anchors + 1;
+        }
+
+        void pivot(double& x, double& y) const override {
+            x = this->x;
+            y = this->y;
+        }
+
+        // Результат округляется до ближайшего целого
+        void rotateAround(const Point& center, double angle);
+
+        void trim(const Point& trimStart, const Point& trimEnd) override {
+            // Точку нельзя обрезать
+        }
+    };
+
+    // Фигура с кэшированным габаритом. Габарит считается лениво при первом
+    // обращении и хранится до тех пор, пока мутатор не вызовет markDirty().
+    //
+    // Режим точности (setPrecise): фигура хранит копию исходной геометрии
+    // и накопленную матрицу. transform только умножает матрицы, а целые
+    // координаты каждый раз получаются из исходных одним округлением,
+    // поэтому ошибка не копится: 36 поворотов на 10 градусов возвращают
+    // фигуру точно на место. Остальные мутаторы (move, mirror, trim) меняют
+    // целую геометрию напрямую, и она становится новой исходной.
+    class CachedBoundsShape : public Shape {
+    private:
+        mutable Rect cachedBounds;
+        mutable bool boundsDirty = true;
+
+        struct Placement {
+            std::unique_ptr<Shape> original;  // Того же класса, без режима точности
+            Affine matrix;                    // Из исходной геометрии в текущую
+        };
+        std::unique_ptr<Placement> placement;
+        bool baking = false;  // Идёт пересчёт из исходной геометрии
+
+        // Переводит исходную геометрию накопленной матрицей в целые координаты
+        void bake();
+
+    protected:
+        virtual Rect computeBounds() const = 0;
+        virtual void computePivot(double& x, double& y) const = 0;
+
+    public:
+        CachedBoundsShape() {}
+
+        // Копия получает текущую геометрию без режима точности
+        CachedBoundsShape(const CachedBoundsShape& other)
+            : Shape(other), cachedBounds(other.cachedBounds), boundsDirty(other.boundsDirty) {}
+
+        CachedBoundsShape& operator=(const CachedBoundsShape& other) {
+            Shape::operator=(other);
+            cachedBounds = other.cachedBounds;
+            boundsDirty = other.boundsDirty;
+            placement.reset();
+            return *this;
+        }
+
+        // Берёт у исходной фигуры того же класса то, что не выражается
+        // опорными точками: радиусы, углы дуги, число вершин
+        virtual void restoreParameters(const Shape& original) {}
+
+        void transform(const Affine& m) override;
+
+        // В режиме точности центр исходной фигуры переводится матрицей,
+        // поэтому он не смещается от округления вершин
+        void pivot(double& x, double& y) const override;
+
+        void setPrecise(bool on) override;
+        bool isPrecise() const override { return placement != nullptr; }
+
+        Rect bounds() const override {
+            if (boundsDirty) {
+                cachedBounds = computeBounds();
+                boundsDirty = false;
+            }
+            return cachedBounds;
+        }
+
+        // Помечает габарит устаревшим. Вызывается всеми мутаторами; при прямом
+        // изменении открытых полей фигуры вызывающий код делает это сам.
+        virtual void markDirty() {
+            boundsDirty = true;
+            if (placement && !baking) {
+                // Изменение в обход transform: текущая геометрия становится исходной
+                setPrecise(false);
+                setPrecise(true);
+            }
+        }
+    };
+
+    bool lineSegmentIntersection(const Point& p1, const Point& p2, const Point& q1, const Point& q2, Point& intersection);
+
+    // Линия (отрезок)
+    class Line : public CachedBoundsShape {
+    public:
+        static constexpr ShapeKind Kind = ShapeKind::Line;
+        ShapeKind kind() const override { return Kind; }
+
+    protected:
+        Point start, end;
+    public:
+        Line(Point start, Point end) : start(start), end(end) {}
+
+        const Point& getStart() const { return start; }
+        const Point& getEnd() const { return end; }
+
+        void draw(Renderer& renderer) override;
+        bool isClicked(int x, int y) override;
+
+        void move(int dx, int dy) override {
+            start.move(dx, dy);
+            end.move(dx, dy);
+            markDirty();
+        }
+
+        Shape* copy() const override {
+            return new Line(start, end);
+        }
+
+        void rotate(double angle) override;
+
+        void mirror(bool vertical) override {
+
+        }
+
+        // Как у ломаной: остаётся участок от начала до пересечения с линией обрезки
+        void trim(const Point& trimStart, const Point& trimEnd) override;
+
+        void writeAnchors(std::vector<Vertex>& anchors) const override {
+            start.writeAnchors(anchors);
+            end.writeAnchors(anchors);
+        }
+
+        const Vertex* readAnchors(const Vertex* anchors, const Affine& m) override {
+            anchors = start.readAnchors(anchors, m);
+            anchors = end.readAnchors(anchors, m);
+            markDirty();
+            return anchors;
+        }
+
+    protected:
+        Rect computeBounds() const override;
+
+        void computePivot(double& x, double& y) const override {
+            x = (start.x + end.x) / 2.0;
+            y = (start.y + end.y) / 2.0;
+        }
+    };
+
+    // Круг
+    class Circle : public CachedBoundsShape {
+    public:
+        static constexpr ShapeKind Kind = ShapeKind::Circle;
+        ShapeKind kind() const override { return Kind; }
+
+    protected:
+        Point center;
+        int radius;
+
+    public:
+        Circle(Point center, int radius) : center(center), radius(radius) {}
+
+        // Методы доступа
+        Point getCenter() const { return center; }
+        int getRadius() const { return radius; }
+
+        void draw(Renderer& renderer) override;
+        bool isClicked(int x, int y) override;
+
+        void move(int dx, int dy) override {
+            center.move(dx, dy);
+            markDirty();
+        }
+
+        Shape* copy() const override {
+            return new Circle(center, radius);
+        }
+
+        void rotate(double angle) override {
+            // Поворот круга не имеет смысла
+        }
+
+        void mirror(bool vertical) override {
+
+        }
+
+        // Круг на месте не обрезается: отрезок, проходящий его насквозь,
+        // заменяет его дугой по левую сторону от отрезка (trimPieces)
+        void trim(const Point& trimStart, const Point& trimEnd) override {}
+        bool trimPieces(const Point& trimStart, const Point& trimEnd, std::vector<Shape*>& pieces) const override;
+
+        void writeAnchors(std::vector<Vertex>& anchors) const override {
+            center.writeAnchors(anchors);
+        }
+
+        // Радиус меняется только при масштабировании
+        const Vertex* readAnchors(const Vertex* anchors, const Affine& m) override;
+
+        void restoreParameters(const Shape& original) override {
+            radius = static_cast<const Circle&>(original).radius;
+        }
+
+    protected:
+        Rect computeBounds() const override;
+
+        void computePivot(double& x, double& y) const override {
+            center.pivot(x, y);
+        }
+    };
+
+    class Arc : public CachedBoundsShape {
+    public:
+        static constexpr ShapeKind Kind = ShapeKind::Arc;
+        ShapeKind kind() const override { return Kind; }
+
+    public:
+        Point center;
+        int radius;
+        double startAngle, endAngle;  // Углы в радианах
+
+        // Конструктор с центром, радиусом и углами
+        Arc(Point center, int radius, double startAngle, double endAngle)
+            : center(center), radius(radius), startAngle(startAngle), endAngle(endAngle) {}
+
+        // Конструктор с центром и двумя конечными точками
+        Arc(Point center, Point startPoint, Point endPoint);
+
+        // Метод для рисования дуги
+        void draw(Renderer& renderer) override;
+
+        void move(int dx, int dy) override {
+            center.move(dx, dy);
+            markDirty();
+        }
+
+        Shape* copy() const override {
+            return new Arc(center, radius, startAngle, endAngle);
+        }
+
+        void rotate(double angle) override;
+        void mirror(bool vertical) override;
+
+        // Проверка клика на дуге
+        bool isClicked(int x, int y) override;
+
+        // Как у ломаной: остаётся часть от начального угла до первой общей
+        // точки с отрезком обрезки
+        void trim(const Point& trimStart, const Point& trimEnd) override;
+
+        void writeAnchors(std::vector<Vertex>& anchors) const override {
+            center.writeAnchors(anchors);
+        }
+
+        // Углы поворачиваются вместе с плоскостью; отражение меняет
+        // направление обхода, поэтому концы дуги меняются местами
+        const Vertex* readAnchors(const Vertex* anchors, const Affine& m) override;
+
+        void restoreParameters(const Shape& original) override {
+            const Arc& arc = static_cast<const Arc&>(original);
+            radius = arc.radius;
+            startAngle = arc.startAngle;
+            endAngle = arc.endAngle;
+        }
+
+    protected:
+        void computePivot(double& x, double& y) const override {
+            center.pivot(x, y);
+        }
+
+        // Точный габарит: концы дуги и те крайние точки окружности
+        // (0, 90, 180, 270 градусов), которые попадают в её угловой диапазон.
+        // Если концы совпали, рисуется вся окружность, и габарит - её.
+        Rect computeBounds() const override;
+    };
+
+    class Ring : public CachedBoundsShape {
+    public:
+        static constexpr ShapeKind Kind = ShapeKind::Ring;
+        ShapeKind kind() const override { return Kind; }
+
+    private:
+        Point center; // Добавляем поле для центра
+        Circle outerCircle; // Внешний круг
+        Circle innerCircle; // Внутренний круг
+
+    public:
+        Ring(Point center, int outerRadius, int innerRadius)
+            : center(center), // Инициализируем центр
+            outerCircle(center, outerRadius),
+            innerCircle(center, innerRadius) {}
+
+        const Circle& getOuterCircle() const { return outerCircle; }
+        const Circle& getInnerCircle() const { return innerCircle; }
+
+        void setColor(Color newColor) override {
+            Shape::setColor(newColor);
+            outerCircle.setColor(newColor);
+            innerCircle.setColor(newColor);
+        }
+
+        void draw(Renderer& renderer) override {
+            outerCircle.draw(renderer);
+            innerCircle.draw(renderer);
+        }
+
+        void move(int dx, int dy) override {
+            center.move(dx, dy);
+            outerCircle.move(dx, dy);
+            innerCircle.move(dx, dy);
+            markDirty();
+        }
+
+        Shape* copy() const override {
+            return new Ring(center, outerCircle.getRadius(), innerCircle.getRadius());
+        }
+
+        void rotate(double angle) override {
+            // Кольцо не имеет смысла вращать
+        }
+
+        void mirror(bool vertical) override {
+            outerCircle.mirror(vertical);
+            innerCircle.mirror(vertical);
+        }
+
+        bool isClicked(int x, int y) override;
+
+        // Отрезок, проходящий внешний круг насквозь, заменяет кольцо его
+        // частью слева от отрезка: дугами кругов и отрезками по линии разреза
+        void trim(const Point& trimStart, const Point& trimEnd) override {}
+        bool trimPieces(const Point& trimStart, const Point& trimEnd, std::vector<Shape*>& pieces) const override;
+
+        void writeAnchors(std::vector<Vertex>& anchors) const override {
+            center.writeAnchors(anchors);
+            outerCircle.writeAnchors(anchors);
+            innerCircle.writeAnchors(anchors);
+        }
+
+        const Vertex* readAnchors(const Vertex* anchors, const Affine& m) override {
+            anchors = center.readAnchors(anchors, m);
+            anchors = outerCircle.readAnchors(anchors, m);
+            anchors = innerCircle.readAnchors(anchors, m);
+            markDirty();
+            return anchors;
+        }
+
+        void restoreParameters(const Shape& original) override {
+            const Ring& ring = static_cast<const Ring&>(original);
+            outerCircle.restoreParameters(ring.outerCircle);
+            innerCircle.restoreParameters(ring.innerCircle);
+        }
+
+    protected:
+        void computePivot(double& x, double& y) const override {
+            center.pivot(x, y);
+        }
+
+        // Внутренний радиус может быть задан больше внешнего
+        Rect computeBounds() const override {
+            return unionOf(outerCircle.bounds(), innerCircle.bounds());
+        }
+    };
+
+    // Вершины, общие для копий ломаной. Не меняются после создания:
+    // копии только читают их, каждая через свою матрицу.
+    struct SharedVertices {
+        std::vector<Vertex> vertices;
+        double sumX, sumY;  // Сумма координат: центр копии без обхода вершин
+
+        // Выпуклая оболочка: габарит копии считается по ней. Строится при
+        // первом обращении (исходным копиям режима точности она не нужна),
+        // один раз, даже если копии спрашивают габарит из разных потоков.
+        const std::vector<Vertex>& getHull() const;
+
+    private:
+        mutable std::vector<Vertex> hull;
+        mutable std::once_flag hullBuilt;
+    };
+
+    class Polyline : public CachedBoundsShape {
+    public:
+        static constexpr ShapeKind Kind = ShapeKind::Polyline;
+        ShapeKind kind() const override { return Kind; }
+
+    private:
+        // Экземпляр: вершины - shared, переведённые matrix с округлением;
+        // свои points пусты. Изменение, которое не выражается матрицей
+        // (обрезка, правка вершин), сначала даёт копии свои вершины (unshare).
+        std::shared_ptr<const SharedVertices> shared;
+        Affine matrix = Affine::identity();
+
+        // Вершины экземпляра с матрицей сложнее целого сдвига: пересчитываются
+        // при смене матрицы, а не при каждом рисовании. Экземпляр, сдвинутый
+        // на целое (вставка, move), рисуется прямо из shared со сдвигом.
+        std::vector<Vertex> placed;
+
+        // Общие вершины для копий, снятые с points; сбрасываются markDirty
+        mutable std::shared_ptr<const SharedVertices> snapshot;
+
+        // Сумма координат вершин для центра поворота и отражения.
+        // Поддерживается мутаторами по ходу их основного цикла,
+        // поэтому отдельный проход по вершинам не нужен.
+        mutable double sumX = 0, sumY = 0;
+        mutable bool sumValid = false;
+
+    protected:
+        // Центр как среднее всех точек
+        Point centroid() const;
+        void computePivot(double& x, double& y) const override;
+
+        // Экземпляр общих вершин other в его же положении
+        Polyline(const Polyline& other, std::shared_ptr<const SharedVertices> vertices)
+            : CachedBoundsShape(other), shared(std::move(vertices)),
+            matrix(other.shared ? other.matrix : Affine::identity()), placed(other.placed) {}
+
+        // Матрица - перенос на целое: образы вершин целые без округления
+        static bool isShift(const Affine& m) {
+            return m.a == 1 && m.b == 0 && m.c == 0 && m.d == 1 &&
+                m.tx == std::floor(m.tx) && m.ty == std::floor(m.ty);
+        }
+        bool shifted() const { return isShift(matrix); }
+
+        // Новая матрица экземпляра: пересчёт placed, если она не целый сдвиг
+        void place(const Affine& m);
+
+        std::shared_ptr<const SharedVertices> sharedVertices() const;
+
+        // Отрезки между вершинами; closed добавляет замыкающий
+        void drawOutline(Renderer& renderer, bool closed) const;
+
+    public:
+        // Память вершин - у ресурса фигуры: куча или арена документа (ShapeArena).
+        // Копия фигуры всегда получает память из кучи. У экземпляра пусты:
+        // вершины читаются через writeAnchors или copyVertices.
+        std::pmr::vector<Point> points;
+
+        Polyline(const std::vector<Point>& points,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : points(points.begin(), points.end(), resource) {}
+
+        void draw(Renderer& renderer) override;
+
+        bool isInstance() const override { return shared != nullptr; }
+        size_t vertexCount() const { return shared ? shared->vertices.size() : points.size(); }
+
+        // Текущие вершины подряд в out (vertexCount() штук)
+        void copyVertices(Vertex* out) const;
+
+        // Копирование при записи: экземпляр получает свои вершины
+        void unshare();
+
+        void move(int dx, int dy) override {
+            if (shared) {
+                // Сдвиг на целое переносит округлённые вершины точно
+                place(Affine::translation(dx, dy) * matrix);
+                markDirty();
+                return;
+            }
+            for (Point& p : points) {
+                p.x += dx;
+                p.y += dy;
+            }
+            markDirty();
+            if (sumValid) {
+                // Сдвиг всех точек меняет сумму на n*d
+                sumX += (double)dx * points.size();
+                sumY += (double)dy * points.size();
+            }
+        }
+
+        void markDirty() override {
+            // Сначала сумма и общие вершины: в режиме точности базовый
+            // markDirty копирует фигуру
+            sumValid = false;
+            snapshot.reset();
+            CachedBoundsShape::markDirty();
+        }
+
+        // Отдаёт снимок общих вершин. Арена освобождает фигуры без
+        // деструкторов, поэтому Scene::clear вызывает это до ShapeArena::release.
+        void releaseSnapshot() const { snapshot.reset(); }
+
+        // Копия - экземпляр: вершины общие с этой фигурой, своя только
+        // матрица. Тысяча копий ломаной стоит тысячу матриц и один массив.
+        Shape* copy() const override {
+            return new Polyline(*this, sharedVertices());
+        }
+
+        // Экземпляр уже копит матрицу и округляет вершины один раз
+        void setPrecise(bool on) override {
+            if (on && shared) return;
+            CachedBoundsShape::setPrecise(on);
+        }
+
+        void transform(const Affine& m) override;
+        void rotate(double angle) override;
+        void mirror(bool vertical) override;
+        bool isClicked(int x, int y) override;
+        void trim(const Point& trimStart, const Point& trimEnd) override;
+
+        void writeAnchors(std::vector<Vertex>& anchors) const override {
+            size_t at = anchors.size();
+            anchors.resize(at + vertexCount());
+            copyVertices(anchors.data() + at);
+        }
+
+        // Экземпляр остаётся экземпляром, если точки совпали с его
+        // матрицей, умноженной на m; иначе получает свои вершины
+        const Vertex* readAnchors(const Vertex* anchors, const Affine& m) override;
+
+        void restoreParameters(const Shape& original) override {
+            points.resize(static_cast<const Polyline&>(original).vertexCount());
+        }
+
+    protected:
+        Rect computeBounds() const override;
+
+        // Поворот всех точек вокруг центра с пересчётом суммы координат
+        void rotatePointsAround(double centerX, double centerY, double angle);
+    };
+
+    class Polygon : public Polyline {
+    public:
+        static constexpr ShapeKind Kind = ShapeKind::Polygon;
+        ShapeKind kind() const override { return Kind; }
+
+    public:
+        Polygon(const std::vector<Point>& points,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : Polyline(points, resource) {}
+
+        void draw(Renderer& renderer) override;
+
+    protected:
+        Polygon(const Polygon& other, std::shared_ptr<const SharedVertices> vertices)
+            : Polyline(other, std::move(vertices)) {}
+
+    public:
+        Shape* copy() const override {
+            return new Polygon(*this, sharedVertices());
+        }
+
+        bool isClicked(int x, int y) override;
+    };
+
+    class Triangle : public Polygon {
+    public:
+        static constexpr ShapeKind Kind = ShapeKind::Triangle;
+        ShapeKind kind() const override { return Kind; }
+
+    public:
+        Triangle(Point p1, Point p2, Point p3,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : Polygon({ p1, p2, p3 }, resource) {}
+
+        Shape* copy() const override {
+            return new Triangle(points[0], points[1], points[2]);
+        }
+
+        // Отрезок, проходящий треугольник насквозь, оставляет его часть слева
+        // от себя: треугольник или четырёхугольник (Polygon)
+        void trim(const Point& trimStart, const Point& trimEnd) override {}
+        bool trimPieces(const Point& trimStart, const Point& trimEnd, std::vector<Shape*>& pieces) const override;
+    };
+
+    class Parallelogram : public Polygon {
+    public:
+        static constexpr ShapeKind Kind = ShapeKind::Parallelogram;
+        ShapeKind kind() const override { return Kind; }
+
+    public:
+        Parallelogram(Point p1, Point p2, double angle,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        // Из готовых четырёх вершин (при загрузке и копировании из хранилища)
+        explicit Parallelogram(const std::vector<Point>& points,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : Polygon(points, resource) {}
+
+        Shape* copy() const override {
+            return new Parallelogram(*this);
+        }
+    };
+
+}
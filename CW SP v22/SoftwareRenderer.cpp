@@ -0,0 +1,193 @@
+﻿#include "SoftwareRenderer.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace MyShapes {
+
+    namespace {
+        // Деление с округлением вверх; знаменатель положителен, числитель любой
+        long long ceilDiv(long long a, long long b) {
+            return a >= 0 ? (a + b - 1) / b : -(-a / b);
+        }
+    }
+
+    SoftwareRenderer::SoftwareRenderer(Framebuffer& target, Color background)
+        : target(target), background(background), penColor(0), clip(target.getBounds()) {}
+
+    void SoftwareRenderer::setClip(const Rect& area) {
+        clip = intersectionOf(area, target.getBounds());
+    }
+
+    void SoftwareRenderer::setPen(const Pen& pen) {
+        penColor = pen.color;
+    }
+
+    void SoftwareRenderer::pixel(int x, int y, Color color) {
+        plot(x, y, color);
+    }
+
+    void SoftwareRenderer::span(int y, int x0, int x1, Color color) {
+        if (y < clip.top || y > clip.bottom) return;
+        if (x0 < clip.left) x0 = clip.left;
+        if (x1 > clip.right) x1 = clip.right;
+        if (x0 <= x1) target.fillSpan(y, x0, x1, color);
+    }
+
+    void SoftwareRenderer::line(int x1, int y1, int x2, int y2) {
+        // Отрезок целиком вне области отсечения не трогаем
+        if (std::max(x1, x2) < clip.left || std::min(x1, x2) > clip.right ||
+            std::max(y1, y2) < clip.top || std::min(y1, y2) > clip.bottom) {
+            return;
+        }
+
+        // Брезенхэм без последней точки, как LineTo. Точка k лежит на главной
+        // оси в start + step * k, на второй - в start + step * j(k), где
+        // j(k) = floor((2 * minor * k + major) / (2 * major)). Обе монотонны,
+        // поэтому точки внутри clip - один промежуток k: отсечение находит его
+        // целочисленно (как Лианг - Барски по параметру k) и начинает обход с
+        // первой точки внутри с тем же err, что дал бы полный обход.
+        long long dx = std::abs((long long)x2 - x1), ady = std::abs((long long)y2 - y1);
+        int sx = x1 < x2 ? 1 : -1, sy = y1 < y2 ? 1 : -1;
+        bool xMajor = dx >= ady;
+        long long major = xMajor ? dx : ady, minor = xMajor ? ady : dx;
+        long long majorStart = xMajor ? x1 : y1, minorStart = xMajor ? y1 : x1;
+        int majorStep = xMajor ? sx : sy, minorStep = xMajor ? sy : sx;
+        long long majorLow = xMajor ? clip.left : clip.top, majorHigh = xMajor ? clip.right : clip.bottom;
+        long long minorLow = xMajor ? clip.top : clip.left, minorHigh = xMajor ? clip.bottom : clip.right;
+
+        long long first = std::max(0LL, majorStep > 0 ? majorLow - majorStart : majorStart - majorHigh);
+        long long last = std::min(major - 1, majorStep > 0 ? majorHigh - majorStart : majorStart - majorLow);
+        long long low = minorStep > 0 ? minorLow - minorStart : minorStart - minorHigh;
+        long long high = minorStep > 0 ? minorHigh - minorStart : minorStart - minorLow;
+        if (minor == 0) {
+            if (low > 0 || high < 0) return;
+        }
+        else {
+            first = std::max(first, ceilDiv((2 * low - 1) * major, 2 * minor));
+            last = std::min(last, ceilDiv((2 * high + 1) * major, 2 * minor) - 1);
+        }
+        if (first > last) return;
+
+        long long j = (2 * minor * first + major) / (2 * major);
+        int x = (int)(x1 + (long long)sx * (xMajor ? first : j));
+        int y = (int)(y1 + (long long)sy * (xMajor ? j : first));
+        long long err = xMajor ? dx * (1 + j) - ady * (1 + first) : dx * (1 + first) - ady * (1 + j);
+        for (long long k = first; k <= last; ++k) {
+            target.set(x, y, penColor);
+            long long e2 = 2 * err;
+            if (e2 >= -ady) { err -= ady; x += sx; }
+            if (e2 <= dx) { err += dx; y += sy; }
+        }
+    }
+
+    void SoftwareRenderer::polyPolyline(const Vertex* vertices, const uint32_t* counts, int polylineCount) {
+        for (int i = 0; i < polylineCount; ++i) {
+            for (uint32_t k = 1; k < counts[i]; ++k) {
+                line(vertices[k - 1].x, vertices[k - 1].y, vertices[k].x, vertices[k].y);
+            }
+            vertices += counts[i];
+        }
+    }
+
+    template <typename Visit>
+    void SoftwareRenderer::traceQuadrant(int rx, int ry, Visit&& visit) {
+        if (ry == 0) {
+            for (int x = 0; x <= rx; ++x) visit(x, 0);
+            return;
+        }
+
+        // Решающие величины умножены на 4, чтобы обойтись без дробей
+        long long rx2 = (long long)rx * rx, ry2 = (long long)ry * ry;
+        long long x = 0, y = ry;
+        long long px = 0, py = 2 * rx2 * y;
+
+        // Участок, где наклон меньше 1: шаг по x
+        long long d = 4 * ry2 - 4 * rx2 * ry + rx2;
+        while (px < py) {
+            visit((int)x, (int)y);
+            ++x;
+            px += 2 * ry2;
+            if (d < 0) {
+                d += 4 * (px + ry2);
+            }
+            else {
+                --y;
+                py -= 2 * rx2;
+                d += 4 * (px - py + ry2);
+            }
+        }
+
+        // Участок, где наклон больше 1: шаг по y
+        d = ry2 * (2 * x + 1) * (2 * x + 1) + 4 * rx2 * (y - 1) * (y - 1) - 4 * rx2 * ry2;
+        while (y >= 0) {
+            visit((int)x, (int)y);
+            --y;
+            py -= 2 * rx2;
+            if (d > 0) {
+                d += 4 * (rx2 - py);
+            }
+            else {
+                ++x;
+                px += 2 * ry2;
+                d += 4 * (px - py + rx2);
+            }
+        }
+    }
+
+    void SoftwareRenderer::ellipse(int left, int top, int right, int bottom) {
+        int cx = (left + right) / 2, cy = (top + bottom) / 2;
+        int rx = (right - left) / 2, ry = (bottom - top) / 2;
+        if (rx < 0 || ry < 0) return;
+        if (cx + rx < clip.left || cx - rx > clip.right || cy + ry < clip.top || cy - ry > clip.bottom) return;
+
+        // inner[dy] - ближайшая к оси точка контура в строке dy: внутри неё заливка фоном
+        std::vector<int>& inner = innerX;
+        inner.assign(ry + 1, -1);
+        traceQuadrant(rx, ry, [&](int dx, int dy) {
+            if (inner[dy] < 0) inner[dy] = dx;
+            plot(cx + dx, cy + dy, penColor);
+            plot(cx - dx, cy + dy, penColor);
+            plot(cx + dx, cy - dy, penColor);
+            plot(cx - dx, cy - dy, penColor);
+        });
+
+        for (int dy = 0; dy <= ry; ++dy) {
+            if (inner[dy] > 0) {
+                span(cy + dy, cx - inner[dy] + 1, cx + inner[dy] - 1, background);
+                if (dy > 0) span(cy - dy, cx - inner[dy] + 1, cx + inner[dy] - 1, background);
+            }
+        }
+    }
+
+    void SoftwareRenderer::arc(int left, int top, int right, int bottom,
+        int xStart, int yStart, int xEnd, int yEnd) {
+        int cx = (left + right) / 2, cy = (top + bottom) / 2;
+        int rx = (right - left) / 2, ry = (bottom - top) / 2;
+        if (rx < 0 || ry < 0) return;
+        if (cx + rx < clip.left || cx - rx > clip.right || cy + ry < clip.top || cy - ry > clip.bottom) return;
+
+        // Лучи от центра в координатах с осью y вверх: "против часовой" как на экране
+        long long sx = xStart - cx, sy = cy - yStart;
+        long long ex = xEnd - cx, ey = cy - yEnd;
+        long long turn = sx * ey - sy * ex;
+        bool full = turn == 0 && sx * ex + sy * ey >= 0; // Лучи совпадают - весь эллипс
+
+        auto inside = [&](long long vx, long long vy) {
+            if (full) return true;
+            long long fromStart = sx * vy - sy * vx;  // > 0: v левее луча начала
+            long long toEnd = vx * ey - vy * ex;      // > 0: луч конца левее v
+            if (turn > 0) return fromStart >= 0 && toEnd >= 0;
+            // Дуга больше половины: точка не должна лежать строго в дополнении
+            return !(fromStart < 0 && toEnd < 0);
+        };
+
+        traceQuadrant(rx, ry, [&](int dx, int dy) {
+            if (inside(dx, -dy)) plot(cx + dx, cy + dy, penColor);
+            if (inside(-dx, -dy)) plot(cx - dx, cy + dy, penColor);
+            if (inside(dx, dy)) plot(cx + dx, cy - dy, penColor);
+            if (inside(-dx, dy)) plot(cx - dx, cy - dy, penColor);
+        });
+    }
+
+}
@@ -0,0 +1,54 @@
+﻿#pragma once
+
+#include <vector>
+
+#include "Framebuffer.h"
+#include "Renderer.h"
+
+namespace MyShapes {
+
+    // Переносимый растеризатор в Framebuffer: тот же интерфейс, что у GdiRenderer,
+    // но без WinAPI, поэтому сцену можно рисовать на сервере и в замерах.
+    // Отрезки - алгоритм Брезенхэма, эллипсы и дуги - алгоритм средней точки,
+    // заливка - строками через Framebuffer::fillSpan. Вся арифметика целочисленная,
+    // результат не зависит от платформы и компилятора.
+    // Отличия от GDI: эллипс занимает прямоугольник включительно, как Shape::bounds
+    // (GDI не доходит на пиксель до right и bottom); толщина и стиль пера не
+    // поддерживаются, всё рисуется сплошным пером в 1 пиксель.
+    class SoftwareRenderer : public Renderer {
+    public:
+        explicit SoftwareRenderer(Framebuffer& target, Color background = makeColor(255, 255, 255));
+
+        // Рисовать только внутри area (в пределах изображения)
+        void setClip(const Rect& area);
+        const Rect& getClip() const { return clip; }
+
+        using Renderer::setPen;
+        void setPen(const Pen& pen) override;
+        void pixel(int x, int y, Color color) override;
+        void line(int x1, int y1, int x2, int y2) override;
+        void polyPolyline(const Vertex* vertices, const uint32_t* counts, int polylineCount) override;
+        void ellipse(int left, int top, int right, int bottom) override;
+        void arc(int left, int top, int right, int bottom,
+            int xStart, int yStart, int xEnd, int yEnd) override;
+
+    private:
+        Framebuffer& target;
+        Color background;
+        Color penColor;
+        Rect clip;
+        std::vector<int> innerX;  // Рабочий массив ellipse, чтобы не выделять память на каждый вызов
+
+        void plot(int x, int y, Color color) {
+            if (clip.contains(x, y)) target.set(x, y, color);
+        }
+
+        void span(int y, int x0, int x1, Color color);
+
+        // Обходит четверть эллипса алгоритмом средней точки и вызывает
+        // visit(dx, dy) для каждой точки контура с dx, dy >= 0
+        template <typename Visit>
+        static void traceQuadrant(int rx, int ry, Visit&& visit);
+    };
+
+}
@@ -0,0 +1,386 @@
+﻿#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace MyShapes {
+
+    namespace {
+        // Полупериметр как оценка "стоимости" узла при выборе места вставки
+        long long perimeter(const Rect& r) {
+            return (long long)(r.right - r.left) + (long long)(r.bottom - r.top);
+        }
+
+        // Младшие 16 бит через один: x и y затем чередуются в коде Мортона
+        uint32_t spreadBits(uint32_t v) {
+            v &= 0xFFFF;
+            v = (v | (v << 8)) & 0x00FF00FF;
+            v = (v | (v << 4)) & 0x0F0F0F0F;
+            v = (v | (v << 2)) & 0x33333333;
+            v = (v | (v << 1)) & 0x55555555;
+            return v;
+        }
+    }
+
+    SpatialIndex::SpatialIndex(int fatMargin)
+        : root(NullNode), freeList(NullNode), leafCount(0), fatMargin(fatMargin) {}
+
+    int SpatialIndex::allocateNode() {
+        if (freeList == NullNode) {
+            Node node;
+            node.parent = NullNode;
+            nodes.push_back(node);
+            freeList = (int)nodes.size() - 1;
+        }
+
+        int id = freeList;
+        freeList = nodes[id].parent;
+
+        Node& node = nodes[id];
+        node.bounds = Rect();
+        node.userData = nullptr;
+        node.mask = 0;
+        node.parent = NullNode;
+        node.child1 = NullNode;
+        node.child2 = NullNode;
+        node.height = 0;
+        return id;
+    }
+
+    void SpatialIndex::freeNode(int id) {
+        nodes[id].parent = freeList;
+        nodes[id].height = -1;
+        freeList = id;
+    }
+
+    int SpatialIndex::insert(const Rect& bounds, void* userData, unsigned mask) {
+        int leaf = allocateNode();
+        nodes[leaf].bounds = bounds.inflated(fatMargin);
+        nodes[leaf].userData = userData;
+        nodes[leaf].mask = mask;
+        insertLeaf(leaf);
+        ++leafCount;
+        return leaf;
+    }
+
+    int SpatialIndex::insertDeferred(const Rect& bounds, void* userData, unsigned mask) {
+        int leaf = allocateNode();
+        nodes[leaf].bounds = bounds.inflated(fatMargin);
+        nodes[leaf].userData = userData;
+        nodes[leaf].mask = mask;
+        nodes[leaf].parent = PendingParent;
+        ++leafCount;
+        ++pending;
+        return leaf;
+    }
+
+    void SpatialIndex::rebuild() {
+        // Внутренние узлы освобождаются, листы остаются на своих местах
+        std::vector<BuildItem> leaves;
+        leaves.reserve(leafCount);
+        Rect centers;
+        for (int id = 0; id < (int)nodes.size(); ++id) {
+            if (nodes[id].height == 0) {
+                const Rect& b = nodes[id].bounds;
+                centers.include((int)(((long long)b.left + b.right) / 2), (int)(((long long)b.top + b.bottom) / 2));
+                leaves.push_back(BuildItem{ 0, id });
+            }
+            else if (nodes[id].height > 0) {
+                freeNode(id);
+            }
+        }
+        pending = 0;
+        if (leaves.empty()) {
+            root = NullNode;
+            return;
+        }
+
+        // Центры квантуются в 16 бит по каждой оси внутри их общего габарита
+        double scaleX = 65535.0 / std::max(1LL, (long long)centers.right - centers.left);
+        double scaleY = 65535.0 / std::max(1LL, (long long)centers.bottom - centers.top);
+        for (BuildItem& item : leaves) {
+            const Rect& b = nodes[item.leaf].bounds;
+            double x = ((long long)b.left + b.right) / 2 - (long long)centers.left;
+            double y = ((long long)b.top + b.bottom) / 2 - (long long)centers.top;
+            item.code = spreadBits((uint32_t)(x * scaleX)) | (spreadBits((uint32_t)(y * scaleY)) << 1);
+        }
+        std::sort(leaves.begin(), leaves.end(),
+            [](const BuildItem& a, const BuildItem& b) { return a.code < b.code; });
+
+        nodes.reserve(2 * leaves.size());
+        root = buildRange(leaves.data(), leaves.size());
+        nodes[root].parent = NullNode;
+    }
+
+    int SpatialIndex::buildRange(BuildItem* items, size_t count) {
+        if (count == 1) return items[0].leaf;
+
+        size_t half = count / 2;
+        int child1 = buildRange(items, half);
+        int child2 = buildRange(items + half, count - half);
+
+        // allocateNode может перевыделить nodes: ссылки берутся после него
+        int id = allocateNode();
+        Node& node = nodes[id];
+        node.child1 = child1;
+        node.child2 = child2;
+        node.bounds = unionOf(nodes[child1].bounds, nodes[child2].bounds);
+        node.mask = nodes[child1].mask | nodes[child2].mask;
+        node.height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[child1].parent = id;
+        nodes[child2].parent = id;
+        return id;
+    }
+
+    void SpatialIndex::remove(int proxy) {
+        assert(nodes[proxy].isLeaf());
+        if (nodes[proxy].parent == PendingParent) --pending;  // В дереве его нет
+        else removeLeaf(proxy);
+        freeNode(proxy);
+        --leafCount;
+    }
+
+    bool SpatialIndex::update(int proxy, const Rect& bounds) {
+        assert(nodes[proxy].isLeaf());
+        if (nodes[proxy].bounds.contains(bounds)) {
+            return false; // Фигура осталась внутри расширенного прямоугольника
+        }
+        if (nodes[proxy].parent == PendingParent) {
+            nodes[proxy].bounds = bounds.inflated(fatMargin);  // Место в дереве определит rebuild
+            return true;
+        }
+
+        removeLeaf(proxy);
+        nodes[proxy].bounds = bounds.inflated(fatMargin);
+        insertLeaf(proxy);
+        return true;
+    }
+
+    void SpatialIndex::clear() {
+        nodes.clear();
+        root = NullNode;
+        freeList = NullNode;
+        leafCount = 0;
+        pending = 0;
+    }
+
+    void SpatialIndex::insertLeaf(int leaf) {
+        if (root == NullNode) {
+            root = leaf;
+            nodes[root].parent = NullNode;
+            return;
+        }
+
+        // Спускаемся к соседу, добавление к которому увеличит дерево меньше всего
+        Rect leafBounds = nodes[leaf].bounds;
+        int index = root;
+        while (!nodes[index].isLeaf()) {
+            int child1 = nodes[index].child1;
+            int child2 = nodes[index].child2;
+
+            long long area = perimeter(nodes[index].bounds);
+            long long combinedArea = perimeter(unionOf(nodes[index].bounds, leafBounds));
+
+            // Стоимость создания нового родителя для этого узла и листа
+            long long cost = 2 * combinedArea;
+
+            // Минимальная стоимость спуска ниже
+            long long inheritanceCost = 2 * (combinedArea - area);
+
+            auto descendCost = [&](int child) {
+                long long childCost = perimeter(unionOf(leafBounds, nodes[child].bounds));
+                if (!nodes[child].isLeaf()) {
+                    childCost -= perimeter(nodes[child].bounds);
+                }
+                return childCost + inheritanceCost;
+            };
+
+            long long cost1 = descendCost(child1);
+            long long cost2 = descendCost(child2);
+
+            if (cost < cost1 && cost < cost2) break;
+
+            index = cost1 < cost2 ? child1 : child2;
+        }
+
+        int sibling = index;
+
+        // Новый родитель для соседа и листа
+        int oldParent = nodes[sibling].parent;
+        int newParent = allocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].bounds = unionOf(leafBounds, nodes[sibling].bounds);
+        nodes[newParent].mask = nodes[leaf].mask | nodes[sibling].mask;
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        if (oldParent != NullNode) {
+            if (nodes[oldParent].child1 == sibling) nodes[oldParent].child1 = newParent;
+            else nodes[oldParent].child2 = newParent;
+        }
+        else {
+            root = newParent;
+        }
+
+        // Поднимаемся к корню, пересчитывая габариты и балансируя
+        index = nodes[leaf].parent;
+        while (index != NullNode) {
+            index = balance(index);
+
+            int child1 = nodes[index].child1;
+            int child2 = nodes[index].child2;
+            nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+            nodes[index].bounds = unionOf(nodes[child1].bounds, nodes[child2].bounds);
+            nodes[index].mask = nodes[child1].mask | nodes[child2].mask;
+
+            index = nodes[index].parent;
+        }
+    }
+
+    void SpatialIndex::removeLeaf(int leaf) {
+        if (leaf == root) {
+            root = NullNode;
+            return;
+        }
+
+        int parent = nodes[leaf].parent;
+        int grandParent = nodes[parent].parent;
+        int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        if (grandParent != NullNode) {
+            // Соседа подвешиваем к деду, родителя удаляем
+            if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+            else nodes[grandParent].child2 = sibling;
+            nodes[sibling].parent = grandParent;
+            freeNode(parent);
+
+            int index = grandParent;
+            while (index != NullNode) {
+                index = balance(index);
+
+                int child1 = nodes[index].child1;
+                int child2 = nodes[index].child2;
+                nodes[index].bounds = unionOf(nodes[child1].bounds, nodes[child2].bounds);
+                nodes[index].mask = nodes[child1].mask | nodes[child2].mask;
+                nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+
+                index = nodes[index].parent;
+            }
+        }
+        else {
+            root = sibling;
+            nodes[sibling].parent = NullNode;
+            freeNode(parent);
+        }
+    }
+
+    // Поворот поддерева с корнем a, если его ветви отличаются по высоте больше чем на 1.
+    // Возвращает новый корень поддерева.
+    int SpatialIndex::balance(int iA) {
+        Node* A = &nodes[iA];
+        if (A->isLeaf() || A->height < 2) {
+            return iA;
+        }
+
+        int iB = A->child1;
+        int iC = A->child2;
+        Node* B = &nodes[iB];
+        Node* C = &nodes[iC];
+
+        int heightDelta = C->height - B->height;
+
+        // Поднимаем C
+        if (heightDelta > 1) {
+            int iF = C->child1;
+            int iG = C->child2;
+            Node* F = &nodes[iF];
+            Node* G = &nodes[iG];
+
+            C->child1 = iA;
+            C->parent = A->parent;
+            A->parent = iC;
+
+            if (C->parent != NullNode) {
+                if (nodes[C->parent].child1 == iA) nodes[C->parent].child1 = iC;
+                else nodes[C->parent].child2 = iC;
+            }
+            else {
+                root = iC;
+            }
+
+            if (F->height > G->height) {
+                C->child2 = iF;
+                A->child2 = iG;
+                G->parent = iA;
+                A->bounds = unionOf(B->bounds, G->bounds);
+                C->bounds = unionOf(A->bounds, F->bounds);
+                A->mask = B->mask | G->mask;
+                C->mask = A->mask | F->mask;
+                A->height = 1 + std::max(B->height, G->height);
+                C->height = 1 + std::max(A->height, F->height);
+            }
+            else {
+                C->child2 = iG;
+                A->child2 = iF;
+                F->parent = iA;
+                A->bounds = unionOf(B->bounds, F->bounds);
+                C->bounds = unionOf(A->bounds, G->bounds);
+                A->mask = B->mask | F->mask;
+                C->mask = A->mask | G->mask;
+                A->height = 1 + std::max(B->height, F->height);
+                C->height = 1 + std::max(A->height, G->height);
+            }
+            return iC;
+        }
+
+        // Поднимаем B
+        if (heightDelta < -1) {
+            int iD = B->child1;
+            int iE = B->child2;
+            Node* D = &nodes[iD];
+            Node* E = &nodes[iE];
+
+            B->child1 = iA;
+            B->parent = A->parent;
+            A->parent = iB;
+
+            if (B->parent != NullNode) {
+                if (nodes[B->parent].child1 == iA) nodes[B->parent].child1 = iB;
+                else nodes[B->parent].child2 = iB;
+            }
+            else {
+                root = iB;
+            }
+
+            if (D->height > E->height) {
+                B->child2 = iD;
+                A->child1 = iE;
+                E->parent = iA;
+                A->bounds = unionOf(C->bounds, E->bounds);
+                B->bounds = unionOf(A->bounds, D->bounds);
+                A->mask = C->mask | E->mask;
+                B->mask = A->mask | D->mask;
+                A->height = 1 + std::max(C->height, E->height);
+                B->height = 1 + std::max(A->height, D->height);
+            }
+            else {
+                B->child2 = iE;
+                A->child1 = iD;
+                D->parent = iA;
+                A->bounds = unionOf(C->bounds, D->bounds);
+                B->bounds = unionOf(A->bounds, E->bounds);
+                A->mask = C->mask | D->mask;
+                B->mask = A->mask | E->mask;
+                A->height = 1 + std::max(C->height, D->height);
+                B->height = 1 + std::max(A->height, E->height);
+            }
+            return iB;
+        }
+
+        return iA;
+    }
+
+}
@@ -0,0 +1,130 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Geometry.h"
+
+namespace MyShapes {
+
+    // Динамическое дерево габаритных прямоугольников (разновидность R-дерева
+    // с бинарными узлами). Листья хранят "расширенные" прямоугольники с запасом
+    // fatMargin, поэтому небольшие перемещения фигуры не перестраивают дерево.
+    // Дерево балансируется поворотами, высота остаётся O(log n).
+    // Каждый лист помечен битовой маской (например, видом фигуры), узел хранит
+    // объединение масок поддерева: запрос с маской пропускает чужие поддеревья.
+    class SpatialIndex {
+    public:
+        static const int NullNode = -1;
+
+        explicit SpatialIndex(int fatMargin = 8);
+
+        // Добавляет прямоугольник, возвращает идентификатор листа
+        int insert(const Rect& bounds, void* userData, unsigned mask = ~0u);
+
+        // Добавляет лист, не вставляя его в дерево: запросы его не видят до
+        // rebuild. Для пакетной загрузки, где вставка по одному листу дороже
+        // одной перестройки в конце.
+        int insertDeferred(const Rect& bounds, void* userData, unsigned mask = ~0u);
+
+        // Строит дерево заново из всех листов, в том числе отложенных: листы
+        // упорядочиваются по кривой Мортона (Z-порядок) центров, затем
+        // диапазон делится пополам до отдельных листов. Соседи по кривой
+        // близки на плоскости, поэтому поддеревья компактны, а высота -
+        // ровно log2 n. Идентификаторы листов не меняются. После множества
+        // обновлений возвращает дереву качество свежей постройки.
+        void rebuild();
+
+        void remove(int proxy);
+
+        // Сообщает новый габарит. Возвращает true, если лист пришлось переставить
+        bool update(int proxy, const Rect& bounds);
+
+        void clear();
+
+        void* getUserData(int proxy) const { return nodes[proxy].userData; }
+        const Rect& getFatBounds(int proxy) const { return nodes[proxy].bounds; }
+
+        int size() const { return leafCount; }
+        int height() const { return root == NullNode ? 0 : nodes[root].height; }
+
+        // Листы, добавленные insertDeferred и ещё не попавшие в дерево
+        int pendingCount() const { return pending; }
+
+        // Габарит всех листов с запасом; пустой, если дерево пусто
+        Rect getBounds() const { return root == NullNode ? Rect() : nodes[root].bounds; }
+
+        // Вызывает callback(proxy) для каждого листа, чей расширенный габарит
+        // пересекает area, а маска - mask. Если callback вернёт false, обход прекращается.
+        template <typename Callback>
+        void query(const Rect& area, Callback&& callback, unsigned mask = ~0u) const {
+            if (root == NullNode) return;
+
+            int stack[StackSize];
+            std::vector<int> overflow;
+            int top = 0;
+            stack[top++] = root;
+
+            while (top > 0 || !overflow.empty()) {
+                int id;
+                if (!overflow.empty()) {
+                    id = overflow.back();
+                    overflow.pop_back();
+                }
+                else {
+                    id = stack[--top];
+                }
+
+                const Node& node = nodes[id];
+                if (!(node.mask & mask) || !node.bounds.intersects(area)) continue;
+
+                if (node.isLeaf()) {
+                    if (!callback(id)) return;
+                }
+                else {
+                    for (int child : { node.child1, node.child2 }) {
+                        if (top < StackSize) stack[top++] = child;
+                        else overflow.push_back(child);
+                    }
+                }
+            }
+        }
+
+    private:
+        static const int StackSize = 128;
+        static const int PendingParent = -2;  // parent отложенного листа
+
+        struct Node {
+            Rect bounds;
+            void* userData;
+            unsigned mask;  // У внутреннего узла - объединение масок детей
+            int parent;   // Для свободных узлов - следующий в списке свободных
+            int child1;
+            int child2;
+            int height;   // 0 у листа, -1 у свободного узла
+
+            bool isLeaf() const { return child1 == NullNode; }
+        };
+
+        std::vector<Node> nodes;
+        int root;
+        int freeList;
+        int leafCount;
+        int fatMargin;
+        int pending = 0;
+
+        int allocateNode();
+        void freeNode(int id);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        int balance(int a);
+        // Лист с кодом Мортона его центра: сортируется компактный массив,
+        // а не узлы дерева
+        struct BuildItem {
+            uint32_t code;
+            int leaf;
+        };
+        int buildRange(BuildItem* items, size_t count);
+    };
+
+}
@@ -0,0 +1,108 @@
+﻿#include "ThreadPool.h"
+
+namespace MyShapes {
+
+    ThreadPool::ThreadPool(int threadCount) {
+        if (threadCount <= 0) {
+            threadCount = (int)std::thread::hardware_concurrency();
+            if (threadCount <= 0) threadCount = 1;
+        }
+
+        for (int i = 0; i < threadCount; ++i) {
+            queues.push_back(std::unique_ptr<Queue>(new Queue()));
+        }
+        for (int i = 1; i < threadCount; ++i) {
+            workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::parallelFor(int count, const std::function<void(int)>& job) {
+        if (count <= 0) return;
+
+        // Соседние индексы попадают к одному участнику: плитки рядом в памяти
+        int participants = size();
+        for (int q = 0; q < participants; ++q) {
+            int begin = (int)((long long)count * q / participants);
+            int end = (int)((long long)count * (q + 1) / participants);
+            std::lock_guard<std::mutex> lock(queues[q]->mutex);
+            for (int i = begin; i < end; ++i) {
+                queues[q]->items.push_back(i);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &job;
+            busy = (int)workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+
+        runTasks(0);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return busy == 0; });
+        task = nullptr;
+    }
+
+    void ThreadPool::workerLoop(int id) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+
+            runTasks(id);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--busy == 0) {
+                done.notify_one();
+            }
+        }
+    }
+
+    void ThreadPool::runTasks(int id) {
+        int item;
+        while (popOwn(id, item) || steal(id, item)) {
+            (*task)(item);
+        }
+    }
+
+    bool ThreadPool::popOwn(int id, int& item) {
+        Queue& queue = *queues[id];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.items.empty()) return false;
+        item = queue.items.front();
+        queue.items.pop_front();
+        return true;
+    }
+
+    bool ThreadPool::steal(int id, int& item) {
+        // Чужую очередь забираем с конца, чтобы не мешать её владельцу
+        for (int k = 1; k < size(); ++k) {
+            Queue& queue = *queues[(id + k) % size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.items.empty()) {
+                item = queue.items.back();
+                queue.items.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+}
@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MyShapes {
+
+    // Пул потоков с перехватом работы. parallelFor раздаёт индексы
+    // непрерывными кусками по очередям участников; закончив свою очередь,
+    // участник забирает работу с другого конца чужой очереди.
+    // Вызывающий поток тоже участвует, поэтому пул из одного потока
+    // выполняет всё последовательно без переключений.
+    class ThreadPool {
+    public:
+        // threadCount - число участников вместе с вызывающим потоком;
+        // 0 - по числу аппаратных потоков
+        explicit ThreadPool(int threadCount = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        int size() const { return (int)queues.size(); }
+
+        // Вызывает task(i) для каждого i из [0, count) и ждёт завершения всех.
+        // Вызовы для разных i могут идти параллельно.
+        void parallelFor(int count, const std::function<void(int)>& task);
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<int> items;
+        };
+
+        std::vector<std::thread> workers;
+        std::vector<std::unique_ptr<Queue>> queues;  // 0 - вызывающий поток
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const std::function<void(int)>* task = nullptr;
+        uint64_t generation = 0;  // Номер текущего parallelFor
+        int busy = 0;             // Рабочие потоки, ещё не закончившие его
+        bool stopping = false;
+
+        void workerLoop(int id);
+        void runTasks(int id);
+        bool popOwn(int id, int& item);
+        bool steal(int id, int& item);
+    };
+
+}
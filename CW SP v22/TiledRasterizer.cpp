@@ -0,0 +1,58 @@
+﻿#include "TiledRasterizer.h"
+
+#include "SoftwareRenderer.h"
+
+namespace MyShapes {
+
+    TiledRasterizer::TiledRasterizer(int tileSize)
+        : tileSize(tileSize) {}
+
+    void TiledRasterizer::render(const std::vector<Shape*>& shapes, Framebuffer& target,
+        ThreadPool* pool, Color background) {
+        int columns = (target.getWidth() + tileSize - 1) / tileSize;
+        int rows = (target.getHeight() + tileSize - 1) / tileSize;
+
+        // Массивы плиток переиспользуются между кадрами
+        bins.resize((size_t)columns * rows);
+        for (std::vector<int>& bin : bins) {
+            bin.clear();
+        }
+
+        binnedCount = 0;
+        Rect frame = target.getBounds();
+        for (size_t i = 0; i < shapes.size(); ++i) {
+            Rect area = intersectionOf(shapes[i]->bounds().inflated(BoundsMargin), frame);
+            if (area.isEmpty()) continue;
+
+            for (int ty = area.top / tileSize; ty <= area.bottom / tileSize; ++ty) {
+                for (int tx = area.left / tileSize; tx <= area.right / tileSize; ++tx) {
+                    bins[(size_t)ty * columns + tx].push_back((int)i);
+                    ++binnedCount;
+                }
+            }
+        }
+
+        auto renderTile = [&](int tile) {
+            const std::vector<int>& bin = bins[tile];
+            if (bin.empty()) return;
+
+            int tx = tile % columns, ty = tile / columns;
+            SoftwareRenderer renderer(target, background);
+            renderer.setClip(Rect(tx * tileSize, ty * tileSize,
+                (tx + 1) * tileSize - 1, (ty + 1) * tileSize - 1));
+            for (int index : bin) {
+                shapes[index]->draw(renderer);
+            }
+        };
+
+        if (pool) {
+            pool->parallelFor((int)bins.size(), renderTile);
+        }
+        else {
+            for (int tile = 0; tile < (int)bins.size(); ++tile) {
+                renderTile(tile);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,43 @@
+﻿#pragma once
+
+#include <vector>
+
+#include "Framebuffer.h"
+#include "Shapes.h"
+#include "ThreadPool.h"
+
+namespace MyShapes {
+
+    // Многопоточная растеризация сцены в Framebuffer. Изображение делится
+    // на квадратные плитки, фигуры раскладываются по плиткам, которые задевает
+    // их габарит, с сохранением порядка отрисовки. Каждая плитка рисуется
+    // SoftwareRenderer с отсечением по своей границе, поэтому пиксель получает
+    // ту же последовательность примитивов, что и при обычном проходе:
+    // результат совпадает с однопоточным до пикселя.
+    class TiledRasterizer {
+    public:
+        // Плитка 128x128: фигура редко попадает больше чем в 2 плитки,
+        // а плиток в кадре хватает на равномерную загрузку потоков
+        explicit TiledRasterizer(int tileSize = 128);
+
+        // shapes - в порядке отрисовки. pool = nullptr - в вызывающем потоке.
+        // Раскладка читает bounds(), поэтому кэш габаритов заполняется до
+        // параллельной части; draw фигур из разных плиток вызывается одновременно.
+        void render(const std::vector<Shape*>& shapes, Framebuffer& target,
+            ThreadPool* pool = nullptr, Color background = makeColor(255, 255, 255));
+
+        int getTileSize() const { return tileSize; }
+
+        // Сколько раз фигуры попали в плитки на последнем render (с повторами)
+        long long getBinnedCount() const { return binnedCount; }
+
+    private:
+        // Запас к габариту на округление концов дуги
+        static const int BoundsMargin = 1;
+
+        int tileSize;
+        std::vector<std::vector<int>> bins;  // Индексы фигур по плиткам, построчно
+        long long binnedCount = 0;
+    };
+
+}
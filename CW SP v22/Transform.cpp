@@ -0,0 +1,116 @@
+﻿#include "Transform.h"
+
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MYSHAPES_AFFINE_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MYSHAPES_AFFINE_SSE2
+#endif
+
+namespace MyShapes {
+
+    Affine Affine::rotation(double centerX, double centerY, double degrees) {
+        double rad = degrees * M_PI / 180.0;
+        double cosAngle = cos(rad);
+        double sinAngle = sin(rad);
+
+        // Перенос центра в начало координат, поворот, перенос обратно
+        Affine m{ cosAngle, -sinAngle, sinAngle, cosAngle, 0, 0 };
+        m.tx = centerX - (m.a * centerX + m.b * centerY);
+        m.ty = centerY - (m.c * centerX + m.d * centerY);
+        return m;
+    }
+
+    Affine Affine::mirror(double centerX, double centerY, bool vertical) {
+        if (vertical) {
+            return Affine{ -1, 0, 0, 1, 2 * centerX, 0 };
+        }
+        return Affine{ 1, 0, 0, -1, 0, 2 * centerY };
+    }
+
+    Affine Affine::operator*(const Affine& other) const {
+        return Affine{
+            a * other.a + b * other.c,
+            a * other.b + b * other.d,
+            c * other.a + d * other.c,
+            c * other.b + d * other.d,
+            a * other.tx + b * other.ty + tx,
+            c * other.tx + d * other.ty + ty
+        };
+    }
+
+    Affine Affine::inverse() const {
+        double det = determinant();
+        Affine m{ d / det, -b / det, -c / det, a / det, 0, 0 };
+        m.tx = -(m.a * tx + m.b * ty);
+        m.ty = -(m.c * tx + m.d * ty);
+        return m;
+    }
+
+    void transformVertices(const Affine& m, Vertex* vertices, size_t count) {
+        static_assert(sizeof(Vertex) == 2 * sizeof(int32_t), "Vertex must be a packed x, y pair");
+
+        size_t i = 0;
+
+        // Вершина (x, y) даёт x * (a, c) + y * (b, d) + (tx, ty); округление
+        // cvtpd_epi32 - к ближайшему, как у lrint в хвосте
+#if defined(MYSHAPES_AFFINE_AVX)
+        __m256d col0 = _mm256_setr_pd(m.a, m.c, m.a, m.c);
+        __m256d col1 = _mm256_setr_pd(m.b, m.d, m.b, m.d);
+        __m256d shift = _mm256_setr_pd(m.tx, m.ty, m.tx, m.ty);
+        for (; i + 2 <= count; i += 2) {
+            __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vertices + i));
+            __m256d v = _mm256_cvtepi32_pd(packed);      // x0 y0 x1 y1
+            __m256d xs = _mm256_unpacklo_pd(v, v);        // x0 x0 x1 x1
+            __m256d ys = _mm256_unpackhi_pd(v, v);        // y0 y0 y1 y1
+            __m256d r = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(xs, col0), _mm256_mul_pd(ys, col1)), shift);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(vertices + i), _mm256_cvtpd_epi32(r));
+        }
+#elif defined(MYSHAPES_AFFINE_SSE2)
+        __m128d col0 = _mm_setr_pd(m.a, m.c);
+        __m128d col1 = _mm_setr_pd(m.b, m.d);
+        __m128d shift = _mm_setr_pd(m.tx, m.ty);
+        for (; i < count; ++i) {
+            __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(vertices + i));
+            __m128d v = _mm_cvtepi32_pd(packed);          // x y
+            __m128d xs = _mm_unpacklo_pd(v, v);
+            __m128d ys = _mm_unpackhi_pd(v, v);
+            __m128d r = _mm_add_pd(_mm_add_pd(_mm_mul_pd(xs, col0), _mm_mul_pd(ys, col1)), shift);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(vertices + i), _mm_cvtpd_epi32(r));
+        }
+#endif
+        for (; i < count; ++i) {
+            double x, y;
+            m.apply(vertices[i].x, vertices[i].y, x, y);
+            vertices[i].x = (int32_t)lrint(x);
+            vertices[i].y = (int32_t)lrint(y);
+        }
+    }
+
+    void BatchTransform::apply(const std::vector<Shape*>& shapes, const Affine& m) {
+        // Фигуры в режиме точности и экземпляры копят матрицу сами
+        auto byMatrix = [](const Shape* shape) { return shape->isPrecise() || shape->isInstance(); };
+
+        anchors.clear();
+        for (const Shape* shape : shapes) {
+            if (!byMatrix(shape)) shape->writeAnchors(anchors);
+        }
+
+        transformVertices(m, anchors.data(), anchors.size());
+
+        const Vertex* next = anchors.data();
+        for (Shape* shape : shapes) {
+            if (byMatrix(shape)) {
+                // Точки пересчитываются из исходных или общих
+                shape->transform(m);
+            }
+            else {
+                next = shape->readAnchors(next, m);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,32 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Affine.h"
+#include "Renderer.h"
+#include "Shapes.h"
+
+namespace MyShapes {
+
+    // Преобразует вершины на месте с округлением до ближайшего целого.
+    // Матрица считается один раз; цикл идёт по две вершины за шаг (AVX)
+    // или по одной (SSE2) без обращений к sin/cos.
+    void transformVertices(const Affine& m, Vertex* vertices, size_t count);
+
+    // Применяет одну матрицу ко всем опорным точкам набора фигур за один проход:
+    // точки собираются в плотный массив, преобразуются transformVertices
+    // и раскладываются обратно. Буфер переиспользуется между вызовами.
+    // Фигуры в режиме точности и экземпляры общей геометрии преобразуются
+    // своим transform.
+    class BatchTransform {
+    public:
+        void apply(const std::vector<Shape*>& shapes, const Affine& m);
+
+        size_t getVertexCount() const { return anchors.size(); }
+
+    private:
+        std::vector<Vertex> anchors;
+    };
+
+}
@@ -0,0 +1,692 @@
+﻿#include "VectorExport.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+
+namespace MyShapes {
+
+    namespace {
+        const int64_t Powers10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000 };
+
+        // Пары цифр 00..99: целое печатается по два знака за деление
+        const char DigitPairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        int digitCount(uint64_t v) {
+            int digits = 1;
+            for (; v >= 10000; v /= 10000) digits += 4;
+            return digits + (v >= 10) + (v >= 100) + (v >= 1000);
+        }
+
+        // Знаков после запятой: координаты дуг и кривых - до тысячных, углы - до миллионных
+        const int CoordinateDecimals = 3;
+        const int AngleDecimals = 6;
+        const int ColorDecimals = 3;
+
+        // Дуга как в RegionQuery: от начала по возрастанию угла, совпавшие концы - полный круг
+        void arcSpan(const Arc& arc, double& from, double& span) {
+            from = fmod(fmod(arc.startAngle, 2 * M_PI) + 2 * M_PI, 2 * M_PI);
+            double to = fmod(fmod(arc.endAngle, 2 * M_PI) + 2 * M_PI, 2 * M_PI);
+            if (to < from) to += 2 * M_PI;
+            span = to > from ? to - from : 2 * M_PI;
+        }
+
+        bool isPolygonKind(ShapeKind kind) {
+            return kind == ShapeKind::Polygon || kind == ShapeKind::Triangle || kind == ShapeKind::Parallelogram;
+        }
+
+        // Стандартная палитра ACI. 1-9 - именованные цвета; 10-249 - 24 тона
+        // через 15 градусов по пять яркостей, нечётный номер - тот же тон
+        // вполовину насыщенности; 250-255 - серые.
+        struct AciPalette {
+            Color colors[256] = {};
+
+            AciPalette() {
+                const Color named[] = { 0, makeColor(255, 0, 0), makeColor(255, 255, 0), makeColor(0, 255, 0),
+                    makeColor(0, 255, 255), makeColor(0, 0, 255), makeColor(255, 0, 255), 0,
+                    makeColor(128, 128, 128), makeColor(192, 192, 192) };
+                std::copy(std::begin(named), std::end(named), colors);
+
+                const double levels[] = { 255, 165, 127, 76, 38 };
+                for (int i = 10; i < 250; ++i) {
+                    double hue = (i - 10) / 10 * 15 / 60.0;
+                    int sector = (int)hue;
+                    double f = hue - sector;
+                    double v = levels[i % 10 / 2];
+                    double s = i % 2 ? 0.5 : 1.0;
+                    int p = (int)(v * (1 - s)), q = (int)(v * (1 - s * f)), t = (int)(v * (1 - s * (1 - f)));
+                    int top = (int)v;
+                    switch (sector) {
+                    case 0: colors[i] = makeColor(top, t, p); break;
+                    case 1: colors[i] = makeColor(q, top, p); break;
+                    case 2: colors[i] = makeColor(p, top, t); break;
+                    case 3: colors[i] = makeColor(p, q, top); break;
+                    case 4: colors[i] = makeColor(t, p, top); break;
+                    default: colors[i] = makeColor(top, p, q); break;
+                    }
+                }
+
+                const int greys[] = { 51, 91, 132, 173, 214, 255 };
+                for (int i = 0; i < 6; ++i) colors[250 + i] = makeColor(greys[i], greys[i], greys[i]);
+            }
+        };
+
+        const AciPalette& aciPalette() {
+            static const AciPalette palette;
+            return palette;
+        }
+    }
+
+    Color aciColor(int index) {
+        return index >= 1 && index <= 255 ? aciPalette().colors[index] : 0;
+    }
+
+    int nearestAci(Color color) {
+        const AciPalette& palette = aciPalette();
+        int best = 7;
+        int bestDistance = INT_MAX;
+        for (int i = 1; i < 256; ++i) {
+            int dr = colorRed(color) - colorRed(palette.colors[i]);
+            int dg = colorGreen(color) - colorGreen(palette.colors[i]);
+            int db = colorBlue(color) - colorBlue(palette.colors[i]);
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance) {
+                best = i;
+                bestDistance = distance;
+                if (distance == 0) break;
+            }
+        }
+        return best;
+    }
+
+    // ---------------------------------------------------------------- OutputBuffer
+
+    OutputBuffer::OutputBuffer(size_t capacity) : data(std::max<size_t>(capacity, 64)) {
+        cursor = data.data();
+        limit = cursor + data.size();
+    }
+
+    void OutputBuffer::open(FILE* target) {
+        file = target;
+        cursor = data.data();
+        written = 0;
+        failed = false;
+    }
+
+    bool OutputBuffer::finish() {
+        flush();
+        if (file && fflush(file) != 0) failed = true;
+        file = nullptr;
+        return !failed;
+    }
+
+    void OutputBuffer::flush() {
+        size_t used = cursor - data.data();
+        if (used == 0) return;
+        if (file && fwrite(data.data(), 1, used, file) != used) failed = true;
+        written += used;
+        cursor = data.data();
+    }
+
+    void OutputBuffer::write(const char* text, size_t length) {
+        if (length > (size_t)(limit - cursor)) {
+            flush();
+            if (length >= data.size()) {
+                // Длинный кусок пишется напрямую, минуя буфер
+                if (file && fwrite(text, 1, length, file) != length) failed = true;
+                written += length;
+                return;
+            }
+        }
+        memcpy(cursor, text, length);
+        cursor += length;
+    }
+
+    void OutputBuffer::longInteger(int64_t value) {
+        char* p = reserve(21);
+        uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+        if (value < 0) *p++ = '-';
+
+        // Запись через локальный указатель: cursor обновляется один раз в конце
+        char* end = p + digitCount(magnitude);
+        char* q = end;
+        while (magnitude >= 100) {
+            int pair = (int)(magnitude % 100) * 2;
+            magnitude /= 100;
+            *--q = DigitPairs[pair + 1];
+            *--q = DigitPairs[pair];
+        }
+        if (magnitude >= 10) {
+            *--q = DigitPairs[magnitude * 2 + 1];
+            *--q = DigitPairs[magnitude * 2];
+        }
+        else {
+            *--q = (char)('0' + magnitude);
+        }
+        cursor = end;
+    }
+
+    void OutputBuffer::number(double value, int decimals) {
+        decimals = std::min(std::max(decimals, 0), 8);
+        double scaled = value * Powers10[decimals];
+        if (!(fabs(scaled) < 9e15)) {
+            // Вне точного диапазона int64 (и NaN): редкий случай, без ручного формата
+            char* p = reserve(32);
+            int length = snprintf(p, 32, "%.17g", std::isfinite(value) ? value : 0.0);
+            cursor = p + std::max(0, std::min(length, 31));
+            return;
+        }
+
+        int64_t rounded = llround(scaled);
+        if (rounded < 0) {
+            put('-');
+            rounded = -rounded;
+        }
+        int64_t whole = rounded / Powers10[decimals];
+        int64_t fraction = rounded % Powers10[decimals];
+        integer(whole);
+        if (fraction == 0) return;
+
+        while (fraction % 10 == 0) {
+            fraction /= 10;
+            --decimals;
+        }
+        char* p = reserve(decimals + 1);
+        *p++ = '.';
+        for (int i = decimals - 1; i >= 0; --i) {
+            p[i] = (char)('0' + fraction % 10);
+            fraction /= 10;
+        }
+        cursor = p + decimals;
+    }
+
+    // ---------------------------------------------------------------- VectorExporter
+
+    VectorExporter::VectorExporter(size_t bufferSize) : out(bufferSize) {}
+
+    bool VectorExporter::exportFile(const char* path, const std::vector<Shape*>& shapes) {
+        size_t length = strlen(path);
+        auto hasExtension = [&](const char* extension) {
+            if (length < 4 || path[length - 4] != '.') return false;
+            for (int i = 0; i < 3; ++i) {
+                if ((path[length - 3 + i] | 0x20) != extension[i]) return false;
+            }
+            return true;
+        };
+        ExportFormat format = hasExtension("dxf") ? ExportFormat::Dxf :
+            hasExtension("pdf") ? ExportFormat::Pdf : ExportFormat::Svg;
+        return exportFile(path, format, shapes);
+    }
+
+    bool VectorExporter::exportFile(const char* path, ExportFormat format, const std::vector<Shape*>& shapes) {
+        FILE* file = fopen(path, "wb");
+        if (!file) return false;
+        bool ok = exportStream(file, format, shapes);
+        if (fclose(file) != 0) ok = false;
+        return ok;
+    }
+
+    bool VectorExporter::exportStream(FILE* file, ExportFormat format, const std::vector<Shape*>& shapes) {
+        // Габарит по кэшированным габаритам фигур, без обхода геометрии
+        extents = Rect();
+        for (const Shape* shape : shapes) extents = unionOf(extents, shape->bounds());
+        if (extents.isEmpty()) extents = Rect(0, 0, 0, 0);
+
+        out.open(file);
+        switch (format) {
+        case ExportFormat::Svg: writeSvg(shapes); break;
+        case ExportFormat::Dxf: writeDxf(shapes); break;
+        case ExportFormat::Pdf: writePdf(shapes); break;
+        }
+        written = out.position();
+        return out.finish();
+    }
+
+    // ---------------------------------------------------------------- SVG
+
+    void VectorExporter::svgColor(Color color, bool fill) {
+        static const char hex[] = "0123456789abcdef";
+        out.write(fill ? " fill=\"#" : " stroke=\"#");
+        int channels[3] = { colorRed(color), colorGreen(color), colorBlue(color) };
+        for (int c : channels) {
+            out.put(hex[c >> 4]);
+            out.put(hex[c & 15]);
+        }
+        out.put('"');
+    }
+
+    const std::vector<Vertex>& VectorExporter::verticesOf(const Polyline& polyline) {
+        vertices.clear();
+        polyline.writeAnchors(vertices);
+        return vertices;
+    }
+
+    void VectorExporter::svgPoints(const Polyline& polyline) {
+        out.write(" points=\"");
+        const std::vector<Vertex>& v = verticesOf(polyline);
+        for (size_t k = 0; k < v.size(); ++k) {
+            if (k > 0) out.put(' ');
+            out.integer(v[k].x);
+            out.put(',');
+            out.integer(v[k].y);
+        }
+        out.put('"');
+    }
+
+    void VectorExporter::svgCircle(const Point& center, int radius, Color color) {
+        out.write("<circle cx=\"");
+        out.integer(center.x);
+        out.write("\" cy=\"");
+        out.integer(center.y);
+        out.write("\" r=\"");
+        out.integer(radius);
+        out.put('"');
+        svgColor(color);
+        out.write("/>\n");
+    }
+
+    void VectorExporter::writeSvg(const std::vector<Shape*>& shapes) {
+        int64_t width = (int64_t)extents.right - extents.left + 1;
+        int64_t height = (int64_t)extents.bottom - extents.top + 1;
+        out.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"");
+        out.integer(extents.left);
+        out.put(' ');
+        out.integer(extents.top);
+        out.put(' ');
+        out.integer(width);
+        out.put(' ');
+        out.integer(height);
+        out.write("\" width=\"");
+        out.integer(width);
+        out.write("\" height=\"");
+        out.integer(height);
+        out.write("\">\n<g fill=\"none\" stroke-linecap=\"round\" stroke-linejoin=\"round\">\n");
+
+        for (const Shape* shape : shapes) {
+            Color color = shape->getColor();
+            ShapeKind kind = shape->kind();
+            switch (kind) {
+            case ShapeKind::Point:
+            {
+                const Point& point = static_cast<const Point&>(*shape);
+                out.write("<rect x=\"");
+                out.integer(point.x);
+                out.write("\" y=\"");
+                out.integer(point.y);
+                out.write("\" width=\"1\" height=\"1\"");
+                svgColor(color, true);
+                out.write("/>\n");
+                break;
+            }
+            case ShapeKind::Line:
+            {
+                const Line& line = static_cast<const Line&>(*shape);
+                out.write("<line x1=\"");
+                out.integer(line.getStart().x);
+                out.write("\" y1=\"");
+                out.integer(line.getStart().y);
+                out.write("\" x2=\"");
+                out.integer(line.getEnd().x);
+                out.write("\" y2=\"");
+                out.integer(line.getEnd().y);
+                out.put('"');
+                svgColor(color);
+                out.write("/>\n");
+                break;
+            }
+            case ShapeKind::Circle:
+            {
+                const Circle& circle = static_cast<const Circle&>(*shape);
+                svgCircle(circle.getCenter(), circle.getRadius(), color);
+                break;
+            }
+            case ShapeKind::Arc:
+            {
+                const Arc& arc = static_cast<const Arc&>(*shape);
+                double from, span;
+                arcSpan(arc, from, span);
+                if (span >= 2 * M_PI) {
+                    // Команда A не рисует полный круг: концы совпадают
+                    svgCircle(arc.center, arc.radius, color);
+                    break;
+                }
+                // sweep = 1 - по возрастанию угла при оси y вниз, как у Arc
+                double r = arc.radius;
+                out.write("<path d=\"M");
+                out.number(arc.center.x + r * cos(from), CoordinateDecimals);
+                out.put(',');
+                out.number(arc.center.y + r * sin(from), CoordinateDecimals);
+                out.write("A");
+                out.integer(arc.radius);
+                out.put(',');
+                out.integer(arc.radius);
+                out.write(span > M_PI ? " 0 1 1 " : " 0 0 1 ");
+                out.number(arc.center.x + r * cos(from + span), CoordinateDecimals);
+                out.put(',');
+                out.number(arc.center.y + r * sin(from + span), CoordinateDecimals);
+                out.put('"');
+                svgColor(color);
+                out.write("/>\n");
+                break;
+            }
+            case ShapeKind::Ring:
+            {
+                const Ring& ring = static_cast<const Ring&>(*shape);
+                svgCircle(ring.getOuterCircle().getCenter(), ring.getOuterCircle().getRadius(), color);
+                svgCircle(ring.getInnerCircle().getCenter(), ring.getInnerCircle().getRadius(), color);
+                break;
+            }
+            default:
+            {
+                const Polyline& polyline = static_cast<const Polyline&>(*shape);
+                out.write(isPolygonKind(kind) ? "<polygon" : "<polyline");
+                svgPoints(polyline);
+                svgColor(color);
+                out.write("/>\n");
+                break;
+            }
+            }
+        }
+        out.write("</g>\n</svg>\n");
+    }
+
+    // ---------------------------------------------------------------- DXF
+
+    void VectorExporter::dxfGroup(int code, const char* value) {
+        out.integer(code);
+        out.put('\n');
+        out.write(value);
+        out.put('\n');
+    }
+
+    void VectorExporter::dxfGroup(int code, int64_t value) {
+        out.integer(code);
+        out.put('\n');
+        out.integer(value);
+        out.put('\n');
+    }
+
+    void VectorExporter::dxfGroup(int code, double value) {
+        out.integer(code);
+        out.put('\n');
+        out.number(value, AngleDecimals);
+        out.put('\n');
+    }
+
+    void VectorExporter::dxfEntity(const char* name, Color color) {
+        dxfGroup(0, name);
+        dxfGroup(8, "0");
+        // Группы 420 (истинный цвет) в R12 нет: пишется ближайший номер ACI.
+        // Подряд идущие фигуры обычно одного цвета - поиск по палитре запоминается
+        if (color != lastColor) {
+            lastColor = color;
+            lastAci = nearestAci(color);
+        }
+        dxfGroup(62, (int64_t)lastAci);
+    }
+
+    void VectorExporter::writeDxf(const std::vector<Shape*>& shapes) {
+        // Отражённый по y габарит совпадает с исходным
+        dxfGroup(0, "SECTION");
+        dxfGroup(2, "HEADER");
+        dxfGroup(9, "$ACADVER");
+        dxfGroup(1, "AC1009");
+        dxfGroup(9, "$EXTMIN");
+        dxfGroup(10, (int64_t)extents.left);
+        dxfGroup(20, (int64_t)extents.top);
+        dxfGroup(9, "$EXTMAX");
+        dxfGroup(10, (int64_t)extents.right);
+        dxfGroup(20, (int64_t)extents.bottom);
+        dxfGroup(0, "ENDSEC");
+        dxfGroup(0, "SECTION");
+        dxfGroup(2, "ENTITIES");
+
+        for (const Shape* shape : shapes) {
+            Color color = shape->getColor();
+            ShapeKind kind = shape->kind();
+            switch (kind) {
+            case ShapeKind::Point:
+            {
+                const Point& point = static_cast<const Point&>(*shape);
+                dxfEntity("POINT", color);
+                dxfGroup(10, (int64_t)point.x);
+                dxfGroup(20, dxfY(point.y));
+                break;
+            }
+            case ShapeKind::Line:
+            {
+                const Line& line = static_cast<const Line&>(*shape);
+                dxfEntity("LINE", color);
+                dxfGroup(10, (int64_t)line.getStart().x);
+                dxfGroup(20, dxfY(line.getStart().y));
+                dxfGroup(11, (int64_t)line.getEnd().x);
+                dxfGroup(21, dxfY(line.getEnd().y));
+                break;
+            }
+            case ShapeKind::Circle:
+            case ShapeKind::Ring:
+            {
+                const Circle* circles[2] = { nullptr, nullptr };
+                if (kind == ShapeKind::Circle) {
+                    circles[0] = static_cast<const Circle*>(shape);
+                }
+                else {
+                    circles[0] = &static_cast<const Ring*>(shape)->getOuterCircle();
+                    circles[1] = &static_cast<const Ring*>(shape)->getInnerCircle();
+                }
+                for (const Circle* circle : circles) {
+                    if (!circle) continue;
+                    dxfEntity("CIRCLE", color);
+                    dxfGroup(10, (int64_t)circle->getCenter().x);
+                    dxfGroup(20, dxfY(circle->getCenter().y));
+                    dxfGroup(40, (int64_t)circle->getRadius());
+                }
+                break;
+            }
+            case ShapeKind::Arc:
+            {
+                // Отражение меняет направление обхода: [from, from + span] переходит
+                // в [-(from + span), -from], углы DXF - в градусах против часовой
+                const Arc& arc = static_cast<const Arc&>(*shape);
+                double from, span;
+                arcSpan(arc, from, span);
+                double start = fmod(2 * M_PI - fmod(from + span, 2 * M_PI), 2 * M_PI) * 180 / M_PI;
+                dxfEntity("ARC", color);
+                dxfGroup(10, (int64_t)arc.center.x);
+                dxfGroup(20, dxfY(arc.center.y));
+                dxfGroup(40, (int64_t)arc.radius);
+                dxfGroup(50, start);
+                dxfGroup(51, start + span * 180 / M_PI);
+                break;
+            }
+            default:
+            {
+                const Polyline& polyline = static_cast<const Polyline&>(*shape);
+                dxfEntity("POLYLINE", color);
+                dxfGroup(66, (int64_t)1);
+                dxfGroup(10, (int64_t)0);
+                dxfGroup(20, (int64_t)0);
+                dxfGroup(70, (int64_t)(isPolygonKind(kind) ? 1 : 0));
+                for (const Vertex& p : verticesOf(polyline)) {
+                    dxfGroup(0, "VERTEX");
+                    dxfGroup(8, "0");
+                    dxfGroup(10, (int64_t)p.x);
+                    dxfGroup(20, dxfY(p.y));
+                }
+                dxfGroup(0, "SEQEND");
+                dxfGroup(8, "0");
+                break;
+            }
+            }
+        }
+        dxfGroup(0, "ENDSEC");
+        dxfGroup(0, "EOF");
+    }
+
+    // ---------------------------------------------------------------- PDF
+
+    void VectorExporter::pdfPoint(double x, double y) {
+        out.number(x, CoordinateDecimals);
+        out.put(' ');
+        out.number(y, CoordinateDecimals);
+        out.put(' ');
+    }
+
+    // Дуга кривыми Безье по четверти окружности и меньше; перо уже в начальной точке
+    void VectorExporter::pdfArc(double cx, double cy, double r, double from, double span) {
+        int segments = std::max(1, (int)ceil(span / (M_PI / 2) - 1e-9));
+        double step = span / segments;
+        double k = 4.0 / 3.0 * tan(step / 4) * r;
+        double a = from;
+        for (int i = 0; i < segments; ++i, a += step) {
+            double b = a + step;
+            double c0 = cos(a), s0 = sin(a), c1 = cos(b), s1 = sin(b);
+            pdfPoint(cx + r * c0 - k * s0, cy + r * s0 + k * c0);
+            pdfPoint(cx + r * c1 + k * s1, cy + r * s1 - k * c1);
+            pdfPoint(cx + r * c1, cy + r * s1);
+            out.write("c\n");
+        }
+    }
+
+    void VectorExporter::writePdf(const std::vector<Shape*>& shapes) {
+        // Страница с полем в 1 пункт под перо; cm переводит координаты редактора
+        // (ось y вниз) в координаты страницы, так что фигуры пишутся как есть
+        int64_t width = (int64_t)extents.right - extents.left + 3;
+        int64_t height = (int64_t)extents.bottom - extents.top + 3;
+        uint64_t offsets[6] = {};
+
+        out.write("%PDF-1.4\n");
+        offsets[1] = out.position();
+        out.write("1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+        offsets[2] = out.position();
+        out.write("2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
+        offsets[3] = out.position();
+        out.write("3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 ");
+        out.integer(width);
+        out.put(' ');
+        out.integer(height);
+        out.write("] /Contents 4 0 R >>\nendobj\n");
+
+        // Длина потока заранее не известна: она - отдельный объект после него
+        offsets[4] = out.position();
+        out.write("4 0 obj\n<< /Length 5 0 R >>\nstream\n");
+        uint64_t streamStart = out.position();
+
+        out.write("1 0 0 -1 ");
+        out.integer(1 - (int64_t)extents.left);
+        out.put(' ');
+        out.integer((int64_t)extents.bottom + 1);
+        out.write(" cm\n1 w 1 J 1 j\n");
+
+        Color stroke = 0, fill = 0;
+        bool haveStroke = false, haveFill = false;
+        auto setColor = [&](Color color, bool filled) {
+            Color& current = filled ? fill : stroke;
+            bool& have = filled ? haveFill : haveStroke;
+            if (have && current == color) return;
+            current = color;
+            have = true;
+            out.number(colorRed(color) / 255.0, ColorDecimals);
+            out.put(' ');
+            out.number(colorGreen(color) / 255.0, ColorDecimals);
+            out.put(' ');
+            out.number(colorBlue(color) / 255.0, ColorDecimals);
+            out.write(filled ? " rg\n" : " RG\n");
+        };
+        auto moveTo = [&](double x, double y) {
+            pdfPoint(x, y);
+            out.write("m\n");
+        };
+        auto circle = [&](const Circle& c) {
+            double r = c.getRadius();
+            moveTo(c.getCenter().x + r, c.getCenter().y);
+            pdfArc(c.getCenter().x, c.getCenter().y, r, 0, 2 * M_PI);
+            out.write("h S\n");
+        };
+
+        for (const Shape* shape : shapes) {
+            ShapeKind kind = shape->kind();
+            setColor(shape->getColor(), kind == ShapeKind::Point);
+            switch (kind) {
+            case ShapeKind::Point:
+            {
+                const Point& point = static_cast<const Point&>(*shape);
+                out.integer(point.x);
+                out.put(' ');
+                out.integer(point.y);
+                out.write(" 1 1 re f\n");
+                break;
+            }
+            case ShapeKind::Line:
+            {
+                const Line& line = static_cast<const Line&>(*shape);
+                moveTo(line.getStart().x, line.getStart().y);
+                out.integer(line.getEnd().x);
+                out.put(' ');
+                out.integer(line.getEnd().y);
+                out.write(" l S\n");
+                break;
+            }
+            case ShapeKind::Circle:
+                circle(static_cast<const Circle&>(*shape));
+                break;
+            case ShapeKind::Arc:
+            {
+                const Arc& arc = static_cast<const Arc&>(*shape);
+                double from, span;
+                arcSpan(arc, from, span);
+                moveTo(arc.center.x + arc.radius * cos(from), arc.center.y + arc.radius * sin(from));
+                pdfArc(arc.center.x, arc.center.y, arc.radius, from, span);
+                out.write("S\n");
+                break;
+            }
+            case ShapeKind::Ring:
+            {
+                const Ring& ring = static_cast<const Ring&>(*shape);
+                circle(ring.getOuterCircle());
+                circle(ring.getInnerCircle());
+                break;
+            }
+            default:
+            {
+                const Polyline& polyline = static_cast<const Polyline&>(*shape);
+                const std::vector<Vertex>& v = verticesOf(polyline);
+                if (v.empty()) break;
+                for (size_t k = 0; k < v.size(); ++k) {
+                    out.integer(v[k].x);
+                    out.put(' ');
+                    out.integer(v[k].y);
+                    out.write(k == 0 ? " m\n" : " l\n");
+                }
+                out.write(isPolygonKind(kind) ? "s\n" : "S\n");
+                break;
+            }
+            }
+        }
+
+        uint64_t streamLength = out.position() - streamStart;
+        out.write("endstream\nendobj\n");
+        offsets[5] = out.position();
+        out.write("5 0 obj\n");
+        out.integer((int64_t)streamLength);
+        out.write("\nendobj\n");
+
+        // Таблица ссылок: записи ровно по 20 байт
+        uint64_t xref = out.position();
+        out.write("xref\n0 6\n0000000000 65535 f \n");
+        for (int i = 1; i <= 5; ++i) {
+            char entry[21];
+            snprintf(entry, sizeof(entry), "%010llu 00000 n \n", (unsigned long long)offsets[i]);
+            out.write(entry, 20);
+        }
+        out.write("trailer\n<< /Size 6 /Root 1 0 R >>\nstartxref\n");
+        out.integer((int64_t)xref);
+        out.write("\n%%EOF\n");
+    }
+
+}
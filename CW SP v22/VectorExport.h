@@ -0,0 +1,134 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Geometry.h"
+#include "Shapes.h"
+
+namespace MyShapes {
+
+    // Буфер вывода: текст и числа форматируются прямо в него, на диск он
+    // уходит целыми блоками. Без iostream и без промежуточных строк;
+    // числа не зависят от локали.
+    class OutputBuffer {
+    public:
+        explicit OutputBuffer(size_t capacity = 1 << 20);
+
+        // Начинает запись в файл; finish сбрасывает остаток и сообщает, была ли ошибка
+        void open(FILE* file);
+        bool finish();
+
+        void write(const char* text, size_t length);
+        void write(const char* text) { write(text, strlen(text)); }  // Длина литерала известна при сборке
+        void put(char c) {
+            if (cursor == limit) flush();
+            *cursor++ = c;
+        }
+
+        // Координаты почти всегда укладываются в пять знаков: им - короткий путь без вызова
+        void integer(int64_t value) {
+            if ((uint64_t)value < 100000 && limit - cursor >= 5) {
+                int v = (int)value;
+                char* p = cursor + (v >= 10) + (v >= 100) + (v >= 1000) + (v >= 10000) + 1;
+                cursor = p;
+                do {
+                    *--p = (char)('0' + v % 10);
+                    v /= 10;
+                } while (v > 0);
+                return;
+            }
+            longInteger(value);
+        }
+        // Фиксированная точка с decimals знаками, хвостовые нули отбрасываются
+        void number(double value, int decimals);
+
+        // Байт от начала записи, включая ещё не сброшенные
+        uint64_t position() const { return written + (cursor - data.data()); }
+
+    private:
+        FILE* file = nullptr;
+        std::vector<char> data;
+        char* cursor;  // Следующий свободный байт data
+        char* limit;   // Конец data
+        uint64_t written = 0;
+        bool failed = false;
+
+        void flush();
+        void longInteger(int64_t value);
+        char* reserve(size_t length) {
+            if ((size_t)(limit - cursor) < length) flush();
+            return cursor;
+        }
+    };
+
+    enum class ExportFormat {
+        Svg,
+        Dxf,
+        Pdf
+    };
+
+    // Палитра AutoCAD Color Index: цвет номера 1-255 и ближайший к цвету номер.
+    // Номер 7 (белый на тёмном фоне, чёрный на светлом) считается чёрным.
+    Color aciColor(int index);
+    int nearestAci(Color color);
+
+    // Потоковый экспорт сцены. Фигуры обходятся один раз в порядке
+    // отрисовки и сразу пишутся в OutputBuffer; перед ними считается только
+    // общий габарит по готовым габаритам фигур - он нужен в заголовке.
+    // Каждый вид переходит в свой примитив формата:
+    //
+    //   SVG: line, circle, path с командой A для дуги, polyline, polygon;
+    //        кольцо - две окружности, точка - квадрат 1x1.
+    //   DXF: LINE, CIRCLE, ARC, POLYLINE (R12), POINT. Ось y DXF смотрит
+    //        вверх: чертёж отражается внутри габарита, который пишется
+    //        в $EXTMIN/$EXTMAX (так его отражает обратно VectorImporter).
+    //        Цвет - ближайший номер ACI, группой 62: истинного цвета в R12 нет.
+    //   PDF: одна страница размером с габарит, один несжатый поток
+    //        содержимого. Окружности и дуги - кривые Безье не больше
+    //        четверти окружности: других кривых в PDF нет.
+    class VectorExporter {
+    public:
+        explicit VectorExporter(size_t bufferSize = 1 << 20);
+
+        // Формат по расширению: .dxf, .pdf, остальное - SVG
+        bool exportFile(const char* path, const std::vector<Shape*>& shapes);
+        bool exportFile(const char* path, ExportFormat format, const std::vector<Shape*>& shapes);
+
+        bool exportStream(FILE* file, ExportFormat format, const std::vector<Shape*>& shapes);
+
+        // Размер последнего записанного файла
+        uint64_t bytesWritten() const { return written; }
+
+    private:
+        OutputBuffer out;
+        Rect extents;
+        uint64_t written = 0;
+        std::vector<Vertex> vertices;  // Вершины текущей ломаной (у экземпляра - пересчитанные)
+        Color lastColor = 0;           // Последний цвет DXF и его номер ACI
+        int lastAci = 7;
+
+        const std::vector<Vertex>& verticesOf(const Polyline& polyline);
+
+        void writeSvg(const std::vector<Shape*>& shapes);
+        void writeDxf(const std::vector<Shape*>& shapes);
+        void writePdf(const std::vector<Shape*>& shapes);
+
+        void svgColor(Color color, bool fill = false);
+        void svgPoints(const Polyline& polyline);
+        void svgCircle(const Point& center, int radius, Color color);
+
+        void dxfGroup(int code, const char* value);
+        void dxfGroup(int code, int64_t value);
+        void dxfGroup(int code, double value);
+        void dxfEntity(const char* name, Color color);
+        int64_t dxfY(int y) const { return (int64_t)extents.top + extents.bottom - y; }
+
+        void pdfPoint(double x, double y);
+        void pdfArc(double cx, double cy, double r, double from, double span);
+    };
+
+}
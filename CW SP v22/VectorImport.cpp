@@ -0,0 +1,1013 @@
+﻿#include "VectorImport.h"
+
+#include "Scene.h"
+#include "ThreadPool.h"
+#include "VectorExport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+
+namespace MyShapes {
+
+    namespace {
+        typedef VectorImporter::Item Item;
+        typedef VectorImporter::Piece Piece;
+
+        // Служебные элементы идут в Item::type после видов фигур
+        enum Marker : uint8_t {
+            MarkerEnterIgnored = 100,  // Начало пропускаемого блока (defs, секция DXF кроме ENTITIES)
+            MarkerLeaveIgnored,        // Конец блока SVG
+            MarkerResetIgnored,        // Конец секции DXF: секции не вкладываются
+            MarkerMinY,                // $EXTMIN / $EXTMAX DXF, значение в startAngle
+            MarkerMaxY,
+            MarkerUnsupported          // Элемент, который не во что перевести
+        };
+
+        bool isSpace(char c) {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        bool isDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        int32_t toInt(double v) {
+            return (int32_t)lrint(v);
+        }
+
+        // Число SVG или DXF: знак, цифры, дробная часть, порядок.
+        // Без strtod: не зависит от локали и не ищет конец строки.
+        bool parseNumber(const char*& p, const char* end, double& value) {
+            static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+            const char* s = p;
+            bool negative = false;
+            if (s < end && (*s == '+' || *s == '-')) negative = *s++ == '-';
+
+            double mantissa = 0;
+            int digits = 0, exponent = 0;
+            for (; s < end && isDigit(*s); ++s, ++digits) mantissa = mantissa * 10 + (*s - '0');
+            if (s < end && *s == '.') {
+                for (++s; s < end && isDigit(*s); ++s, ++digits, --exponent) mantissa = mantissa * 10 + (*s - '0');
+            }
+            if (digits == 0) return false;
+
+            if (s < end && (*s == 'e' || *s == 'E')) {
+                const char* e = s + 1;
+                bool negativeExponent = false;
+                if (e < end && (*e == '+' || *e == '-')) negativeExponent = *e++ == '-';
+                if (e < end && isDigit(*e)) {
+                    int power = 0;
+                    for (; e < end && isDigit(*e); ++e) power = std::min(power * 10 + (*e - '0'), 1000);
+                    exponent += negativeExponent ? -power : power;
+                    s = e;
+                }
+            }
+
+            if (exponent < 0) mantissa = -exponent <= 22 ? mantissa / powers[-exponent] : mantissa * pow(10.0, exponent);
+            else if (exponent > 0) mantissa = exponent <= 22 ? mantissa * powers[exponent] : mantissa * pow(10.0, exponent);
+            value = negative ? -mantissa : mantissa;
+            p = s;
+            return true;
+        }
+
+        double parseNumber(std::string_view text, double fallback = 0) {
+            const char* p = text.data();
+            const char* end = p + text.size();
+            while (p < end && isSpace(*p)) ++p;
+            double value;
+            return parseNumber(p, end, value) ? value : fallback;
+        }
+
+        Item& addItem(Piece& piece, uint8_t type, Color color = 0) {
+            piece.items.push_back(Item());
+            Item& item = piece.items.back();
+            memset(&item, 0, sizeof(item));
+            item.type = type;
+            item.color = color;
+            return item;
+        }
+
+        void addMarker(Piece& piece, Marker marker, double value = 0) {
+            addItem(piece, marker).startAngle = value;
+        }
+
+        // Вершины с first до конца пула - ломаная или многоугольник; вырожденные отбрасываются
+        void addPoly(Piece& piece, uint32_t first, bool closed, Color color) {
+            uint32_t count = (uint32_t)piece.vertices.size() - first;
+            if (closed && count >= 3) {
+                Item& item = addItem(piece, (uint8_t)ShapeKind::Polygon, color);
+                item.first = first;
+                item.count = count;
+            }
+            else if (count >= 2) {
+                Item& item = addItem(piece, (uint8_t)ShapeKind::Polyline, color);
+                item.first = first;
+                item.count = count;
+            }
+            else {
+                piece.vertices.resize(first);
+                addMarker(piece, MarkerUnsupported);
+            }
+        }
+
+        // ---------------------------------------------------------------- SVG
+
+        // Атрибуты одного тега, без копирования значений
+        struct Attributes {
+            static const int Max = 24;
+            std::string_view names[Max], values[Max];
+            int count = 0;
+
+            void parse(const char* p, const char* end) {
+                count = 0;
+                while (p < end && count < Max) {
+                    while (p < end && (isSpace(*p) || *p == '/')) ++p;
+                    const char* name = p;
+                    while (p < end && *p != '=' && !isSpace(*p) && *p != '/') ++p;
+                    std::string_view n(name, p - name);
+                    while (p < end && isSpace(*p)) ++p;
+                    if (p >= end || *p != '=') {
+                        if (p == name) ++p;  // Мусор без имени
+                        continue;
+                    }
+                    ++p;
+                    while (p < end && isSpace(*p)) ++p;
+                    if (p >= end || (*p != '"' && *p != '\'')) continue;
+                    char quote = *p++;
+                    const char* value = p;
+                    while (p < end && *p != quote) ++p;
+                    names[count] = n;
+                    values[count] = std::string_view(value, p - value);
+                    ++count;
+                    ++p;
+                }
+            }
+
+            bool find(std::string_view name, std::string_view& value) const {
+                for (int i = 0; i < count; ++i) {
+                    if (names[i] == name) {
+                        value = values[i];
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            double number(std::string_view name) const {
+                std::string_view value;
+                return find(name, value) ? parseNumber(value) : 0;
+            }
+        };
+
+        int hexDigit(char c) {
+            if (isDigit(c)) return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // stroke="#rrggbb" или "#rgb", в том числе внутри style; иначе чёрный
+        Color strokeColor(const Attributes& attributes) {
+            std::string_view value;
+            if (!attributes.find("stroke", value)) {
+                std::string_view style;
+                if (!attributes.find("style", style)) return 0;
+                size_t at = style.find("stroke:");
+                if (at == std::string_view::npos) return 0;
+                value = style.substr(at + 7);
+                value = value.substr(0, value.find(';'));
+            }
+            while (!value.empty() && isSpace(value.front())) value.remove_prefix(1);
+            if (value.empty() || value[0] != '#') return 0;
+
+            int digits[6];
+            size_t n = 0;
+            for (size_t i = 1; i < value.size() && n < 6 && hexDigit(value[i]) >= 0; ++i) digits[n++] = hexDigit(value[i]);
+            if (n == 6) return makeColor(digits[0] * 16 + digits[1], digits[2] * 16 + digits[3], digits[4] * 16 + digits[5]);
+            if (n == 3) return makeColor(digits[0] * 17, digits[1] * 17, digits[2] * 17);
+            return 0;
+        }
+
+        // Разделители между числами списка: пробелы и запятые
+        void skipSeparators(const char*& p, const char* end) {
+            while (p < end && (isSpace(*p) || *p == ',')) ++p;
+        }
+
+        void parsePoints(std::string_view text, Piece& piece) {
+            const char* p = text.data();
+            const char* end = p + text.size();
+            double x, y;
+            while (true) {
+                skipSeparators(p, end);
+                if (!parseNumber(p, end, x)) break;
+                skipSeparators(p, end);
+                if (!parseNumber(p, end, y)) break;
+                piece.vertices.push_back(Vertex{ toInt(x), toInt(y) });
+            }
+        }
+
+        // Путь SVG: отрезки копятся в текущую ломаную, дуга окружности её
+        // прерывает и становится отдельной фигурой
+        class PathParser {
+        public:
+            PathParser(Piece& piece, Color color) : piece(piece), color(color) {}
+
+            void parse(std::string_view d) {
+                const char* p = d.data();
+                const char* end = p + d.size();
+                char command = 0;
+                runStart = (uint32_t)piece.vertices.size();
+
+                while (true) {
+                    skipSeparators(p, end);
+                    if (p >= end) break;
+                    if ((*p >= 'A' && *p <= 'Z') || (*p >= 'a' && *p <= 'z')) {
+                        command = *p++;
+                        if (command == 'Z' || command == 'z') {
+                            close();
+                            continue;
+                        }
+                    }
+                    else if (command == 0) {
+                        break;
+                    }
+                    if (!step(command, p, end)) break;
+                    // Повтор M без буквы - это уже L
+                    if (command == 'M') command = 'L';
+                    else if (command == 'm') command = 'l';
+                }
+                flush(false);
+            }
+
+        private:
+            static const int CurveSegments = 8;
+
+            Piece& piece;
+            Color color;
+            uint32_t runStart = 0;
+            bool subpathHasArc = false;
+            double curX = 0, curY = 0, startX = 0, startY = 0;
+            double controlX = 0, controlY = 0;  // Вторая опорная точка последней кривой, для S и T
+            char lastCommand = 0;
+
+            bool numbers(const char*& p, const char* end, double* out, int count) {
+                for (int i = 0; i < count; ++i) {
+                    skipSeparators(p, end);
+                    if (!parseNumber(p, end, out[i])) return false;
+                }
+                return true;
+            }
+
+            // Флаги дуги могут идти без разделителей: "0 01 1"
+            bool flag(const char*& p, const char* end, bool& out) {
+                skipSeparators(p, end);
+                if (p >= end || (*p != '0' && *p != '1')) return false;
+                out = *p++ == '1';
+                return true;
+            }
+
+            void point(double x, double y) {
+                piece.vertices.push_back(Vertex{ toInt(x), toInt(y) });
+            }
+
+            void begin() {
+                runStart = (uint32_t)piece.vertices.size();
+                point(curX, curY);
+            }
+
+            // Закрывает текущую ломаную; после неё пул вершин заканчивается на runStart
+            void flush(bool closed) {
+                uint32_t count = (uint32_t)piece.vertices.size() - runStart;
+                if (count < 2) {
+                    piece.vertices.resize(runStart);
+                    return;
+                }
+                if (closed) {
+                    const Vertex& a = piece.vertices[runStart];
+                    const Vertex& b = piece.vertices.back();
+                    if (a.x == b.x && a.y == b.y) piece.vertices.pop_back();  // Многоугольник замкнут и так
+                }
+                addPoly(piece, runStart, closed, color);
+                runStart = (uint32_t)piece.vertices.size();
+            }
+
+            void close() {
+                if (subpathHasArc) {
+                    point(startX, startY);
+                    flush(false);
+                }
+                else {
+                    flush(true);
+                }
+                curX = startX;
+                curY = startY;
+                subpathHasArc = false;
+                lastCommand = 'Z';
+                begin();
+            }
+
+            void cubic(double x1, double y1, double x2, double y2, double x, double y) {
+                for (int i = 1; i <= CurveSegments; ++i) {
+                    double t = (double)i / CurveSegments, u = 1 - t;
+                    point(u * u * u * curX + 3 * u * u * t * x1 + 3 * u * t * t * x2 + t * t * t * x,
+                        u * u * u * curY + 3 * u * u * t * y1 + 3 * u * t * t * y2 + t * t * t * y);
+                }
+                controlX = x2;
+                controlY = y2;
+            }
+
+            void quadratic(double x1, double y1, double x, double y) {
+                for (int i = 1; i <= CurveSegments; ++i) {
+                    double t = (double)i / CurveSegments, u = 1 - t;
+                    point(u * u * curX + 2 * u * t * x1 + t * t * x, u * u * curY + 2 * u * t * y1 + t * t * y);
+                }
+                controlX = x1;
+                controlY = y1;
+            }
+
+            // Дуга окружности по концам (SVG 1.1, приложение F.6.5).
+            // Эллиптическая дуга заменяется отрезком.
+            void arc(double rx, double ry, bool largeArc, bool sweep, double x, double y) {
+                rx = fabs(rx);
+                ry = fabs(ry);
+                double halfX = (curX - x) / 2, halfY = (curY - y) / 2;
+                double distanceSq = halfX * halfX + halfY * halfY;
+                if (distanceSq == 0) return;  // Концы совпали: дуги нет
+                if (rx == 0 || fabs(rx - ry) > 1e-9 * std::max(rx, ry)) {
+                    addMarker(piece, MarkerUnsupported);
+                    point(x, y);
+                    return;
+                }
+
+                double r = std::max(rx, sqrt(distanceSq));  // Слишком малый радиус растягивается
+                double coefficient = sqrt(std::max(0.0, (r * r - distanceSq) / distanceSq));
+                if (largeArc == sweep) coefficient = -coefficient;
+                double cx = coefficient * halfY + (curX + x) / 2;
+                double cy = -coefficient * halfX + (curY + y) / 2;
+
+                double from = atan2(curY - cy, curX - cx);
+                double span = atan2(y - cy, x - cx) - from;
+                if (sweep && span < 0) span += 2 * M_PI;
+                if (!sweep && span > 0) span -= 2 * M_PI;
+
+                flush(false);
+                // Arc идёт по возрастанию угла: при sweep = 0 концы меняются местами
+                Item& item = addItem(piece, (uint8_t)ShapeKind::Arc, color);
+                item.x = toInt(cx);
+                item.y = toInt(cy);
+                item.radius = toInt(r);
+                item.startAngle = sweep ? from : from + span;
+                item.endAngle = sweep ? from + span : from;
+                subpathHasArc = true;
+
+                curX = x;
+                curY = y;
+                begin();
+            }
+
+            bool step(char command, const char*& p, const char* end) {
+                bool relative = command >= 'a';
+                double baseX = relative ? curX : 0, baseY = relative ? curY : 0;
+                double v[7];
+                char upper = relative ? (char)(command - 32) : command;
+                bool smooth = (upper == 'S' && (lastCommand == 'C' || lastCommand == 'S')) ||
+                    (upper == 'T' && (lastCommand == 'Q' || lastCommand == 'T'));
+                double reflectedX = smooth ? 2 * curX - controlX : curX;
+                double reflectedY = smooth ? 2 * curY - controlY : curY;
+
+                switch (upper) {
+                case 'M':
+                    if (!numbers(p, end, v, 2)) return false;
+                    flush(false);
+                    curX = startX = baseX + v[0];
+                    curY = startY = baseY + v[1];
+                    subpathHasArc = false;
+                    begin();
+                    break;
+                case 'L':
+                    if (!numbers(p, end, v, 2)) return false;
+                    curX = baseX + v[0];
+                    curY = baseY + v[1];
+                    point(curX, curY);
+                    break;
+                case 'H':
+                    if (!numbers(p, end, v, 1)) return false;
+                    curX = baseX + v[0];
+                    point(curX, curY);
+                    break;
+                case 'V':
+                    if (!numbers(p, end, v, 1)) return false;
+                    curY = baseY + v[0];
+                    point(curX, curY);
+                    break;
+                case 'C':
+                    if (!numbers(p, end, v, 6)) return false;
+                    cubic(baseX + v[0], baseY + v[1], baseX + v[2], baseY + v[3], baseX + v[4], baseY + v[5]);
+                    curX = baseX + v[4];
+                    curY = baseY + v[5];
+                    break;
+                case 'S':
+                    if (!numbers(p, end, v, 4)) return false;
+                    cubic(reflectedX, reflectedY, baseX + v[0], baseY + v[1], baseX + v[2], baseY + v[3]);
+                    curX = baseX + v[2];
+                    curY = baseY + v[3];
+                    break;
+                case 'Q':
+                    if (!numbers(p, end, v, 4)) return false;
+                    quadratic(baseX + v[0], baseY + v[1], baseX + v[2], baseY + v[3]);
+                    curX = baseX + v[2];
+                    curY = baseY + v[3];
+                    break;
+                case 'T':
+                    if (!numbers(p, end, v, 2)) return false;
+                    quadratic(reflectedX, reflectedY, baseX + v[0], baseY + v[1]);
+                    curX = baseX + v[0];
+                    curY = baseY + v[1];
+                    break;
+                case 'A':
+                {
+                    bool largeArc, sweep;
+                    if (!numbers(p, end, v, 3) || !flag(p, end, largeArc) || !flag(p, end, sweep) ||
+                        !numbers(p, end, v + 3, 2)) {
+                        return false;
+                    }
+                    arc(v[0], v[1], largeArc, sweep, baseX + v[3], baseY + v[4]);
+                    curX = baseX + v[3];
+                    curY = baseY + v[4];
+                    break;
+                }
+                default:
+                    return false;  // Незнакомая команда: остаток пути не разобрать
+                }
+                lastCommand = upper;
+                return true;
+            }
+        };
+
+        // Содержимое этих элементов само не рисуется
+        bool isIgnoredElement(std::string_view name) {
+            return name == "defs" || name == "symbol" || name == "clipPath" || name == "mask" ||
+                name == "pattern" || name == "marker";
+        }
+
+        void parseSvgElement(std::string_view name, const Attributes& attributes, Piece& piece) {
+            Color color = strokeColor(attributes);
+            if (name == "line") {
+                Item& item = addItem(piece, (uint8_t)ShapeKind::Line, color);
+                item.x = toInt(attributes.number("x1"));
+                item.y = toInt(attributes.number("y1"));
+                item.x2 = toInt(attributes.number("x2"));
+                item.y2 = toInt(attributes.number("y2"));
+            }
+            else if (name == "circle" || name == "ellipse") {
+                double rx = name == "circle" ? attributes.number("r") : attributes.number("rx");
+                double ry = name == "circle" ? rx : attributes.number("ry");
+                if (rx <= 0 || fabs(rx - ry) > 1e-9 * rx) {
+                    addMarker(piece, MarkerUnsupported);
+                    return;
+                }
+                Item& item = addItem(piece, (uint8_t)ShapeKind::Circle, color);
+                item.x = toInt(attributes.number("cx"));
+                item.y = toInt(attributes.number("cy"));
+                item.radius = toInt(rx);
+            }
+            else if (name == "rect") {
+                double x = attributes.number("x"), y = attributes.number("y");
+                double w = attributes.number("width"), h = attributes.number("height");
+                uint32_t first = (uint32_t)piece.vertices.size();
+                piece.vertices.push_back(Vertex{ toInt(x), toInt(y) });
+                piece.vertices.push_back(Vertex{ toInt(x + w), toInt(y) });
+                piece.vertices.push_back(Vertex{ toInt(x + w), toInt(y + h) });
+                piece.vertices.push_back(Vertex{ toInt(x), toInt(y + h) });
+                addPoly(piece, first, true, color);
+            }
+            else if (name == "polyline" || name == "polygon") {
+                std::string_view points;
+                uint32_t first = (uint32_t)piece.vertices.size();
+                if (attributes.find("points", points)) parsePoints(points, piece);
+                addPoly(piece, first, name == "polygon", color);
+            }
+            else if (name == "path") {
+                std::string_view d;
+                if (attributes.find("d", d)) PathParser(piece, color).parse(d);
+            }
+        }
+
+        const char* findText(const char* p, const char* end, const char* text) {
+            size_t n = strlen(text);
+            for (; p + n <= end; ++p) {
+                p = static_cast<const char*>(memchr(p, text[0], end - p));
+                if (!p || p + n > end) return nullptr;
+                if (memcmp(p, text, n) == 0) return p;
+            }
+            return nullptr;
+        }
+
+        void parseSvgPiece(const char* p, const char* end, Piece& piece) {
+            Attributes attributes;
+            while (p < end) {
+                p = static_cast<const char*>(memchr(p, '<', end - p));
+                if (!p) break;
+
+                if (end - p >= 4 && memcmp(p, "<!--", 4) == 0) {
+                    const char* close = findText(p + 4, end, "-->");
+                    if (!close) break;
+                    p = close + 3;
+                    continue;
+                }
+                if (end - p >= 9 && memcmp(p, "<![CDATA[", 9) == 0) {
+                    const char* close = findText(p + 9, end, "]]>");
+                    if (!close) break;
+                    p = close + 3;
+                    continue;
+                }
+                const char* close = static_cast<const char*>(memchr(p, '>', end - p));
+                if (!close) break;
+
+                const char* q = p + 1;
+                p = close + 1;
+                if (*q == '?' || *q == '!') continue;  // Пролог, DOCTYPE
+
+                bool closing = *q == '/';
+                if (closing) ++q;
+                const char* nameBegin = q;
+                while (q < close && !isSpace(*q) && *q != '/') ++q;
+                std::string_view name(nameBegin, q - nameBegin);
+                size_t prefix = name.find(':');
+                if (prefix != std::string_view::npos) name.remove_prefix(prefix + 1);  // svg:line
+
+                bool selfClosing = close[-1] == '/';
+                if (isIgnoredElement(name)) {
+                    if (closing) addMarker(piece, MarkerLeaveIgnored);
+                    else if (!selfClosing) addMarker(piece, MarkerEnterIgnored);
+                    continue;
+                }
+                if (closing) continue;
+
+                attributes.parse(q, close);
+                parseSvgElement(name, attributes, piece);
+            }
+        }
+
+        // Комментарий или CDATA: '<' внутри них тега не начинает
+        struct OpaqueSpan {
+            const char* begin;  // '<' начала
+            const char* end;    // За закрывающим '>'; конец порции, если он не дочитан
+        };
+
+        // Комментарии и CDATA порции по порядку. Ищутся по '!', который вне
+        // них почти не встречается, а не по каждому '<'
+        void findOpaqueSpans(const char* begin, const char* end, std::vector<OpaqueSpan>& spans) {
+            spans.clear();
+            const char* p = begin;
+            while (p < end) {
+                const char* bang = static_cast<const char*>(memchr(p, '!', end - p));
+                if (!bang) break;
+                p = bang + 1;
+                if (bang == begin || bang[-1] != '<') continue;
+
+                const char* terminator;
+                if (end - p >= 2 && memcmp(p, "--", 2) == 0) terminator = "-->";
+                else if (end - p >= 7 && memcmp(p, "[CDATA[", 7) == 0) terminator = "]]>";
+                else continue;  // DOCTYPE - обычный тег
+                const char* close = findText(p, end, terminator);
+                p = close ? close + 3 : end;
+                spans.push_back({ bang - 1, p });
+            }
+        }
+
+        // Участок, внутри которого лежит at (его собственный '<' не в счёт), или nullptr
+        const OpaqueSpan* enclosingSpan(const std::vector<OpaqueSpan>& spans, const char* at) {
+            auto next = std::upper_bound(spans.begin(), spans.end(), at,
+                [](const char* p, const OpaqueSpan& span) { return p < span.begin; });
+            if (next == spans.begin()) return nullptr;
+            const OpaqueSpan& span = next[-1];
+            return at > span.begin && at < span.end ? &span : nullptr;
+        }
+
+        // Граница частей SVG - начало тега вне комментария и CDATA
+        const char* nextSvgBoundary(const char* from, const char* end, const std::vector<OpaqueSpan>& spans) {
+            const char* p = from;
+            while ((p = static_cast<const char*>(memchr(p, '<', end - p))) != nullptr) {
+                const OpaqueSpan* span = enclosingSpan(spans, p);
+                if (!span) return p;
+                p = span->end;
+            }
+            return end;
+        }
+
+        // Недочитанный комментарий целиком уходит в хвост порции
+        const char* lastSvgBoundary(const char* begin, const char* end, const std::vector<OpaqueSpan>& spans) {
+            for (const char* p = end; p > begin; --p) {
+                if (p[-1] == '<') {
+                    const OpaqueSpan* span = enclosingSpan(spans, p - 1);
+                    return span ? span->begin : p - 1;
+                }
+            }
+            return begin;
+        }
+
+        // ---------------------------------------------------------------- DXF
+
+        std::string_view trim(const char* begin, const char* end) {
+            while (begin < end && isSpace(*begin)) ++begin;
+            while (end > begin && isSpace(end[-1])) --end;
+            return std::string_view(begin, end - begin);
+        }
+
+        // Строка [line, конец строки); false, если строка не закончена до end
+        bool readLine(const char*& p, const char* end, std::string_view& line) {
+            const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (!newline) return false;
+            line = trim(p, newline);
+            p = newline + 1;
+            return true;
+        }
+
+        // Пара "0 / ИМЯ", с которой начинается сущность DXF. VERTEX и SEQEND
+        // продолжают POLYLINE и границей не считаются.
+        bool isDxfEntityStart(const char* p, const char* end) {
+            std::string_view code, name;
+            if (!readLine(p, end, code) || code != "0" || !readLine(p, end, name) || name.empty()) return false;
+            if (!((name[0] >= 'A' && name[0] <= 'Z') || (name[0] >= 'a' && name[0] <= 'z'))) return false;
+            return name != "VERTEX" && name != "SEQEND";
+        }
+
+        const char* nextDxfBoundary(const char* begin, const char* from, const char* end) {
+            const char* p = from;
+            if (p > begin && p[-1] != '\n') {
+                const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+                if (!newline) return end;
+                p = newline + 1;
+            }
+            while (p < end) {
+                if (isDxfEntityStart(p, end)) return p;
+                const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+                if (!newline) return end;
+                p = newline + 1;
+            }
+            return end;
+        }
+
+        const char* lastDxfBoundary(const char* begin, const char* end) {
+            const char* line = end;
+            while (line > begin) {
+                const char* p = line - 1;
+                while (p > begin && p[-1] != '\n') --p;
+                line = p;
+                if (isDxfEntityStart(line, end)) return line;
+            }
+            return begin;
+        }
+
+        enum class DxfEntity { None, Section, Line, Circle, Arc, LwPolyline, Polyline, Vertex, Other };
+
+        void parseDxfPiece(const char* p, const char* end, Piece& piece) {
+            DxfEntity entity = DxfEntity::None;
+            Color color = 0;
+            double x = 0, y = 0, x2 = 0, y2 = 0, radius = 0, startAngle = 0, endAngle = 0;
+            int flags = 0;
+            uint32_t first = 0;
+            std::string_view headerVariable;
+
+            // Открытый POLYLINE старого вида: его вершины - отдельные сущности VERTEX
+            bool polylineOpen = false;
+            Color polylineColor = 0;
+            int polylineFlags = 0;
+            uint32_t polylineFirst = 0;
+
+            auto finish = [&]() {
+                switch (entity) {
+                case DxfEntity::Line:
+                {
+                    Item& item = addItem(piece, (uint8_t)ShapeKind::Line, color);
+                    item.x = toInt(x);
+                    item.y = toInt(y);
+                    item.x2 = toInt(x2);
+                    item.y2 = toInt(y2);
+                    break;
+                }
+                case DxfEntity::Circle:
+                case DxfEntity::Arc:
+                {
+                    if (radius <= 0) {
+                        addMarker(piece, MarkerUnsupported);
+                        break;
+                    }
+                    bool isArc = entity == DxfEntity::Arc;
+                    Item& item = addItem(piece, (uint8_t)(isArc ? ShapeKind::Arc : ShapeKind::Circle), color);
+                    item.x = toInt(x);
+                    item.y = toInt(y);
+                    item.radius = toInt(radius);
+                    item.startAngle = startAngle * M_PI / 180;
+                    item.endAngle = endAngle * M_PI / 180;
+                    break;
+                }
+                case DxfEntity::LwPolyline:
+                    addPoly(piece, first, (flags & 1) != 0, color);
+                    break;
+                case DxfEntity::Other:
+                    addMarker(piece, MarkerUnsupported);
+                    break;
+                default:
+                    break;
+                }
+                entity = DxfEntity::None;
+            };
+            auto finishPolyline = [&]() {
+                if (!polylineOpen) return;
+                addPoly(piece, polylineFirst, (polylineFlags & 1) != 0, polylineColor);
+                polylineOpen = false;
+            };
+
+            std::string_view codeText, value;
+            while (readLine(p, end, codeText) && readLine(p, end, value)) {
+                double code = parseNumber(codeText, -1);
+
+                if (code == 0) {
+                    if (entity == DxfEntity::Polyline) {
+                        // Заголовок POLYLINE закончился, дальше его вершины
+                        polylineOpen = true;
+                        polylineColor = color;
+                        polylineFlags = flags;
+                        polylineFirst = (uint32_t)piece.vertices.size();
+                        entity = DxfEntity::None;
+                    }
+                    if (value == "VERTEX" && polylineOpen) {
+                        entity = DxfEntity::Vertex;
+                        continue;
+                    }
+                    if (value == "SEQEND") {
+                        entity = DxfEntity::None;
+                        finishPolyline();
+                        continue;
+                    }
+                    finish();
+                    finishPolyline();
+
+                    color = 0;
+                    x = y = x2 = y2 = radius = startAngle = endAngle = 0;
+                    flags = 0;
+                    first = (uint32_t)piece.vertices.size();
+                    if (value == "SECTION") entity = DxfEntity::Section;
+                    else if (value == "ENDSEC") addMarker(piece, MarkerResetIgnored);
+                    else if (value == "LINE") entity = DxfEntity::Line;
+                    else if (value == "CIRCLE") entity = DxfEntity::Circle;
+                    else if (value == "ARC") entity = DxfEntity::Arc;
+                    else if (value == "LWPOLYLINE") entity = DxfEntity::LwPolyline;
+                    else if (value == "POLYLINE") entity = DxfEntity::Polyline;
+                    else if (value != "EOF") entity = DxfEntity::Other;
+                    continue;
+                }
+
+                switch (entity) {
+                case DxfEntity::Section:
+                    if (code == 2 && value != "ENTITIES" && headerVariable.empty()) {
+                        addMarker(piece, MarkerEnterIgnored);
+                        headerVariable = "-";  // Имя секции прочитано
+                    }
+                    else if (code == 9) {
+                        headerVariable = value;
+                    }
+                    else if (code == 20 && headerVariable == "$EXTMIN") {
+                        addMarker(piece, MarkerMinY, parseNumber(value));
+                    }
+                    else if (code == 20 && headerVariable == "$EXTMAX") {
+                        addMarker(piece, MarkerMaxY, parseNumber(value));
+                    }
+                    break;
+                case DxfEntity::LwPolyline:
+                case DxfEntity::Vertex:
+                    if (code == 10) piece.vertices.push_back(Vertex{ toInt(parseNumber(value)), 0 });
+                    else if (code == 20 && piece.vertices.size() > first) piece.vertices.back().y = toInt(parseNumber(value));
+                    else if (code == 70 && entity == DxfEntity::LwPolyline) flags = (int)parseNumber(value);
+                    else if (code == 62 && entity == DxfEntity::LwPolyline) color = aciColor((int)parseNumber(value));
+                    else if (code == 420 && entity == DxfEntity::LwPolyline) {
+                        uint32_t rgb = (uint32_t)parseNumber(value);
+                        color = makeColor((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+                    }
+                    break;
+                case DxfEntity::None:
+                case DxfEntity::Other:
+                    break;
+                default:
+                {
+                    double number = parseNumber(value);
+                    switch ((int)code) {
+                    case 10: x = number; break;
+                    case 20: y = number; break;
+                    case 11: x2 = number; break;
+                    case 21: y2 = number; break;
+                    case 40: radius = number; break;
+                    case 50: startAngle = number; break;
+                    case 51: endAngle = number; break;
+                    case 70: flags = (int)number; break;
+                    case 62: color = aciColor((int)number); break;
+                    case 420:
+                    {
+                        uint32_t rgb = (uint32_t)number;
+                        color = makeColor((rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+                        break;
+                    }
+                    }
+                    break;
+                }
+                }
+            }
+            if (entity == DxfEntity::Polyline) entity = DxfEntity::None;
+            finish();
+            finishPolyline();
+        }
+
+        const char* nextBoundary(VectorFormat format, const char* begin, const char* from, const char* end,
+            const std::vector<OpaqueSpan>& spans) {
+            return format == VectorFormat::Svg ? nextSvgBoundary(from, end, spans) : nextDxfBoundary(begin, from, end);
+        }
+
+        const char* lastBoundary(VectorFormat format, const char* begin, const char* end,
+            const std::vector<OpaqueSpan>& spans) {
+            return format == VectorFormat::Svg ? lastSvgBoundary(begin, end, spans) : lastDxfBoundary(begin, end);
+        }
+
+        // Сколько байт осталось в файле; 0, если поток не перематывается (канал)
+        uint64_t remainingBytes(FILE* file) {
+            long position = ftell(file);
+            if (position < 0 || fseek(file, 0, SEEK_END) != 0) return 0;
+            long size = ftell(file);
+            fseek(file, position, SEEK_SET);
+            return size > position ? (uint64_t)(size - position) : 0;
+        }
+
+        void parsePiece(VectorFormat format, const char* begin, const char* end, Piece& piece) {
+            piece.items.clear();
+            piece.vertices.clear();
+            if (format == VectorFormat::Svg) parseSvgPiece(begin, end, piece);
+            else parseDxfPiece(begin, end, piece);
+        }
+    }
+
+    VectorImporter::VectorImporter(ThreadPool* pool, size_t pieceSize)
+        : pool(pool), pieceSize(std::max<size_t>(pieceSize, 4096)) {}
+
+    ImportResult VectorImporter::importFile(const char* path, Scene& scene) {
+        size_t length = strlen(path);
+        bool dxf = length >= 4 && (path[length - 4] == '.') &&
+            (path[length - 3] | 0x20) == 'd' && (path[length - 2] | 0x20) == 'x' && (path[length - 1] | 0x20) == 'f';
+        return importFile(path, dxf ? VectorFormat::Dxf : VectorFormat::Svg, scene);
+    }
+
+    ImportResult VectorImporter::importFile(const char* path, VectorFormat format, Scene& scene) {
+        FILE* file = fopen(path, "rb");
+        if (!file) return ImportResult();
+        ImportResult result = importStream(file, format, scene);
+        fclose(file);
+        return result;
+    }
+
+    ImportResult VectorImporter::importStream(FILE* file, VectorFormat format, Scene& scene) {
+        ImportResult result;
+        int pieceCount = pool ? std::max(1, pool->size()) * 2 : 1;
+        pieces.resize(pieceCount);
+        if (buffer.size() < pieceSize * pieceCount) buffer.resize(pieceSize * pieceCount);
+
+        std::vector<const char*> bounds(pieceCount + 1);
+        std::vector<OpaqueSpan> spans;  // Только для SVG
+        MergeState state;
+        size_t filled = 0;  // Перенесённый из прошлой порции хвост в начале буфера
+        bool eof = false;
+        bool bulkStarted = false;
+        uint64_t total = remainingBytes(file);
+
+        while (true) {
+            if (!eof) {
+                size_t wanted = buffer.size() - filled;
+                size_t got = fread(buffer.data() + filled, 1, wanted, file);
+                filled += got;
+                result.bytes += got;
+                eof = got < wanted;
+                if (ferror(file)) break;
+            }
+
+            // Хвост после последней границы ждёт следующей порции
+            const char* begin = buffer.data();
+            const char* end = begin + filled;
+            if (format == VectorFormat::Svg) findOpaqueSpans(begin, end, spans);
+            const char* cut = eof ? end : lastBoundary(format, begin, end, spans);
+            if (cut == begin && !eof) {
+                buffer.resize(buffer.size() * 2);  // Элемент длиннее порции
+                continue;
+            }
+
+            bounds[0] = begin;
+            for (int i = 1; i < pieceCount; ++i) {
+                const char* target = begin + (cut - begin) * i / pieceCount;
+                bounds[i] = std::max(bounds[i - 1], nextBoundary(format, begin, target, cut, spans));
+            }
+            bounds[pieceCount] = cut;
+
+            auto parse = [&](int i) { parsePiece(format, bounds[i], bounds[i + 1], pieces[i]); };
+            if (pool && pieceCount > 1) {
+                pool->parallelFor(pieceCount, parse);
+            }
+            else {
+                for (int i = 0; i < pieceCount; ++i) parse(i);
+            }
+
+            if (!bulkStarted) {
+                // Число фигур всего файла - по плотности первой порции
+                size_t items = 0;
+                for (const Piece& piece : pieces) items += piece.items.size();
+                scene.beginBulkInsert(total > 0 ? (size_t)(items * (double)total / (cut - begin)) : 0);
+                bulkStarted = true;
+            }
+            for (const Piece& piece : pieces) {
+                merge(piece, format, state, scene, result);
+            }
+
+            size_t rest = end - cut;
+            memmove(buffer.data(), cut, rest);
+            filled = rest;
+            if (eof) {
+                result.ok = true;
+                break;
+            }
+        }
+        if (bulkStarted) scene.endBulkInsert();
+        return result;
+    }
+
+    void VectorImporter::merge(const Piece& piece, VectorFormat format, MergeState& state, Scene& scene, ImportResult& result) {
+        // Ось y DXF смотрит вверх: отражаем внутри габарита чертежа
+        bool flip = format == VectorFormat::Dxf && state.haveMinY && state.haveMaxY;
+        int32_t flipSum = flip ? toInt(state.minY + state.maxY) : 0;
+        auto mapY = [&](int32_t y) { return flip ? flipSum - y : y; };
+
+        for (const Item& item : piece.items) {
+            switch (item.type) {
+            case MarkerEnterIgnored:
+                ++state.ignoredDepth;
+                continue;
+            case MarkerLeaveIgnored:
+                state.ignoredDepth = std::max(0, state.ignoredDepth - 1);
+                continue;
+            case MarkerResetIgnored:
+                state.ignoredDepth = 0;
+                continue;
+            case MarkerMinY:
+            case MarkerMaxY:
+                if (item.type == MarkerMinY) {
+                    state.minY = item.startAngle;
+                    state.haveMinY = true;
+                }
+                else {
+                    state.maxY = item.startAngle;
+                    state.haveMaxY = true;
+                }
+                flip = format == VectorFormat::Dxf && state.haveMinY && state.haveMaxY;
+                flipSum = flip ? toInt(state.minY + state.maxY) : 0;
+                continue;
+            default:
+                break;
+            }
+            if (state.ignoredDepth > 0) continue;
+            if (item.type == MarkerUnsupported) {
+                ++result.skipped;
+                continue;
+            }
+
+            Shape* shape = nullptr;
+            switch ((ShapeKind)item.type) {
+            case ShapeKind::Line:
+                shape = scene.create<Line>(Point(item.x, mapY(item.y)), Point(item.x2, mapY(item.y2)));
+                break;
+            case ShapeKind::Circle:
+                shape = scene.create<Circle>(Point(item.x, mapY(item.y)), item.radius);
+                break;
+            case ShapeKind::Arc:
+                // Отражение меняет направление обхода: углы меняют знак и местами
+                shape = flip ?
+                    scene.create<Arc>(Point(item.x, mapY(item.y)), item.radius, -item.endAngle, -item.startAngle) :
+                    scene.create<Arc>(Point(item.x, item.y), item.radius, item.startAngle, item.endAngle);
+                break;
+            default:
+            {
+                points.clear();
+                for (uint32_t k = 0; k < item.count; ++k) {
+                    const Vertex& v = piece.vertices[item.first + k];
+                    points.push_back(Point(v.x, mapY(v.y)));
+                }
+                if ((ShapeKind)item.type == ShapeKind::Polygon) shape = scene.create<Polygon>(points);
+                else shape = scene.create<Polyline>(points);
+                break;
+            }
+            }
+            shape->setColor(item.color);
+            ++result.shapes;
+        }
+    }
+
+}
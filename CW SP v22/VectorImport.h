@@ -0,0 +1,88 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Renderer.h"
+#include "Shapes.h"
+
+namespace MyShapes {
+
+    class Scene;
+    class ThreadPool;
+
+    enum class VectorFormat {
+        Svg,
+        Dxf
+    };
+
+    // Итог импорта
+    struct ImportResult {
+        bool ok = false;      // false - файл не открылся или не читается
+        size_t shapes = 0;    // Добавлено фигур
+        size_t skipped = 0;   // Элементов, которые не во что перевести
+        uint64_t bytes = 0;   // Прочитано байт
+    };
+
+    // Потоковый импорт SVG и DXF. Файл читается порциями фиксированного
+    // размера; порция режется по границам элементов (тег SVG, сущность DXF)
+    // на части, которые разбираются параллельно в пуле. Разобранные фигуры
+    // добавляются в сцену по порядку файла одним пакетом: индекс сцены
+    // строится один раз в конце (Scene::beginBulkInsert). Память импорта
+    // ограничена размером порции; растёт она только под элемент, который
+    // сам в порцию не влезает.
+    //
+    // SVG: line, circle, ellipse с равными радиусами, rect, polyline,
+    // polygon и path. В path отрезки дают Polyline или Polygon (если контур
+    // замкнут Z), дуги окружностей - Arc, кривые Безье заменяются ломаной.
+    // Атрибут transform не учитывается; содержимое defs, symbol,
+    // clipPath, mask и pattern пропускается. Цвет берётся из stroke.
+    // DXF: LINE, CIRCLE, ARC, LWPOLYLINE и POLYLINE из секции ENTITIES,
+    // цвет - из групп 62 и 420. Ось y DXF направлена вверх: если в заголовке
+    // есть $EXTMIN и $EXTMAX, чертёж отражается внутри своего габарита,
+    // иначе координаты берутся как есть.
+    class VectorImporter {
+    public:
+        explicit VectorImporter(ThreadPool* pool = nullptr, size_t pieceSize = 1 << 20);
+
+        // Формат по расширению: .dxf - DXF, остальное - SVG
+        ImportResult importFile(const char* path, Scene& scene);
+        ImportResult importFile(const char* path, VectorFormat format, Scene& scene);
+
+        ImportResult importStream(FILE* file, VectorFormat format, Scene& scene);
+
+        // Разобранный элемент: фигура или служебная отметка
+        struct Item {
+            uint8_t type;    // ShapeKind либо Marker
+            Color color;
+            int32_t x, y, x2, y2, radius;
+            double startAngle, endAngle;
+            uint32_t first, count;  // Вершины ломаной в Piece::vertices
+        };
+
+        // Результат разбора одной части порции
+        struct Piece {
+            std::vector<Item> items;
+            std::vector<Vertex> vertices;
+        };
+
+    private:
+        ThreadPool* pool;
+        size_t pieceSize;
+        std::vector<char> buffer;
+        std::vector<Piece> pieces;
+        std::vector<Point> points;
+
+        // Состояние между порциями, которое видно только при добавлении по порядку
+        struct MergeState {
+            int ignoredDepth = 0;
+            bool haveMinY = false, haveMaxY = false;
+            double minY = 0, maxY = 0;
+        };
+
+        void merge(const Piece& piece, VectorFormat format, MergeState& state, Scene& scene, ImportResult& result);
+    };
+
+}
@@ -1,632 +1,29 @@
 ﻿#define _CRT_SECURE_NO_WARNINGS
+#define NOMINMAX
 
 #include <windows.h>
 #include <vector>
+#include <memory>
 #include <cmath>
+#include <algorithm>
 #include <commctrl.h>
+#include <commdlg.h>
 
 #include "resource.h"
-
-#define M_PI 3.1415926535
-
-namespace MyShapes {
-
-    class Point;
-
-    // Определим интерфейс для всех фигур
-    class Shape {
-    protected:
-        COLORREF color;
-    public:
-
-        virtual void setColor(COLORREF newColor) {
-            color = newColor;
-        }
-
-        virtual void draw(HDC hdc) = 0;
-        virtual void move(int dx, int dy) = 0;
-        virtual Shape* copy() const = 0;
-        virtual void rotate(double angle) = 0;
-        virtual void mirror(bool vertical) = 0;
-        virtual void trim(const MyShapes::Point& start, const MyShapes::Point& end) = 0;
-
-        // Добавляем виртуальный метод isClicked
-        virtual bool isClicked(int x, int y) = 0;
-
-        virtual ~Shape() {}  // Виртуальный деструктор для безопасного удаления производных классов
-    };
-
-    // Точка
-    class Point : public Shape {
-    public:
-        int x, y;
-
-        Point() : x(0), y(0) {}  // Конструктор по умолчанию
-
-        Point(int x, int y) : x(x), y(y) {}
-
-        void draw(HDC hdc) override {
-            SetPixel(hdc, x, y, color);
-        }
-
-        void move(int dx, int dy) override {
-            x += dx;
-            y += dy;
-        }
-
-        Shape* copy() const override {
-            return new Point(x, y);
-        }
-
-        void rotate(double angle) override {
-            // Поворот точки не имеет смысла
-        }
-
-        void mirror(bool vertical) override {
-            if (vertical) {
-                x = -x;
-            }
-            else {
-                y = -y;
-            }
-        }
-
-        bool isClicked(int x, int y) override {
-            return this->x == x && this->y == y; // Простая проверка
-        }
-
-        void rotateAround(const Point& center, double angle) {
-            double rad = angle * M_PI / 180.0; // Переводим угол в радианы
-            double cosAngle = cos(rad);
-            double sinAngle = sin(rad);
-
-            // Смещаем точку к началу координат
-            double dx = x - center.x;
-            double dy = y - center.y;
-
-            // Поворачиваем и возвращаем точку обратно
-            x = center.x + (dx * cosAngle - dy * sinAngle);
-            y = center.y + (dx * sinAngle + dy * cosAngle);
-        }
-
-        void trim(const Point& trimStart, const Point& trimEnd) override {
-            // Точку нельзя обрезать
-        }
-    };
-
-    bool isPointInsideTrimArea(const Point& point, const Point& trimStart, const Point& trimEnd) {
-        int left = min(trimStart.x, trimEnd.x);
-        int right = max(trimStart.x, trimEnd.x);
-        int top = min(trimStart.y, trimEnd.y);
-        int bottom = max(trimStart.y, trimEnd.y);
-
-        return (point.x >= left && point.x <= right && point.y >= top && point.y <= bottom);
-    }
-
-    bool lineSegmentIntersection(const Point& p1, const Point& p2, const Point& q1, const Point& q2, Point& intersection) {
-        int A1 = p2.y - p1.y;
-        int B1 = p1.x - p2.x;
-        int C1 = A1 * p1.x + B1 * p1.y;
-
-        int A2 = q2.y - q1.y;
-        int B2 = q1.x - q2.x;
-        int C2 = A2 * q1.x + B2 * q1.y;
-
-        int det = A1 * B2 - A2 * B1;
-
-        if (det == 0) {
-            return false; // Линии параллельны
-        }
-        else {
-            intersection.x = (B2 * C1 - B1 * C2) / det;
-            intersection.y = (A1 * C2 - A2 * C1) / det;
-
-            // Проверка, находится ли точка пересечения на обоих сегментах
-            if (intersection.x >= min(p1.x, p2.x) && intersection.x <= max(p1.x, p2.x) &&
-                intersection.y >= min(p1.y, p2.y) && intersection.y <= max(p1.y, p2.y) &&
-                intersection.x >= min(q1.x, q2.x) && intersection.x <= max(q1.x, q2.x) &&
-                intersection.y >= min(q1.y, q2.y) && intersection.y <= max(q1.y, q2.y)) {
-                return true;
-            }
-            return false;
-        }
-    }
-
-
-    // Линия (отрезок)
-    class Line : public Shape {
-    protected:
-        Point start, end;
-    public:
-        Line(Point start, Point end) : start(start), end(end) {}
-
-        void draw(HDC hdc) override {
-            HPEN pen = CreatePen(PS_SOLID, 1, color); // Создаем перо выбранного цвета
-            HPEN oldPen = (HPEN)SelectObject(hdc, pen);
-
-            MoveToEx(hdc, start.x, start.y, NULL);
-            LineTo(hdc, end.x, end.y);
-
-            SelectObject(hdc, oldPen); // Восстанавливаем старое перо
-            DeleteObject(pen);          // Удаляем созданное перо
-        }
-
-        bool isClicked(int x, int y) {
-            // Простая проверка на попадание в линию (с учётом некоторой погрешности)
-            int tolerance = 5;
-            int dx = end.x - start.x;
-            int dy = end.y - start.y;
-            double distance = std::abs(dy * x - dx * y + end.x * start.y - end.y * start.x) / sqrt(dx * dx + dy * dy);
-            return distance < tolerance;
-        }
-
-        void move(int dx, int dy) override {
-            start.move(dx, dy);
-            end.move(dx, dy);
-        }
-
-        Shape* copy() const override {
-            return new Line(start, end);
-        }
-
-        void rotate(double angle) override {
-            // Находим центр линии
-            Point center((start.x + end.x) / 2, (start.y + end.y) / 2);
-
-            // Поворачиваем обе точки вокруг центра линии
-            start.rotateAround(center, angle);
-            end.rotateAround(center, angle);
-        }
-
-        void mirror(bool vertical) override {
-
-        }
-
-        void trim(const Point& trimStart, const Point& trimEnd) override {
-            start = trimStart;
-            end = trimEnd;
-        }
-    };
-
-    // Круг
-    class Circle : public Shape {
-    protected:
-        Point center;
-        int radius;
-
-    public:
-        Circle(Point center, int radius) : center(center), radius(radius) {}
-
-        // Методы доступа
-        Point getCenter() const { return center; }
-        int getRadius() const { return radius; }
-
-        void draw(HDC hdc) override {
-            HPEN pen = CreatePen(PS_SOLID, 1, color); // Создаем перо выбранного цвета
-            HPEN oldPen = (HPEN)SelectObject(hdc, pen);
-
-            Ellipse(hdc, center.x - radius, center.y - radius, center.x + radius, center.y + radius);
-
-            SelectObject(hdc, oldPen); // Восстанавливаем старое перо
-            DeleteObject(pen);          // Удаляем созданное перо
-        }
-
-        bool isClicked(int x, int y) {
-            int dx = x - center.x;
-            int dy = y - center.y;
-            return (dx * dx + dy * dy <= radius * radius);
-        }
-
-        void move(int dx, int dy) override {
-            center.move(dx, dy);
-        }
-
-        Shape* copy() const override {
-            return new Circle(center, radius);
-        }
-
-        void rotate(double angle) override {
-            // Поворот круга не имеет смысла
-        }
-
-        void mirror(bool vertical) override {
-
-        }
-
-        void trim(const Point& trimStart, const Point& trimEnd) override {
-            // Если линия обрезки проходит через центр круга, мы можем уменьшить радиус
-            double distance = sqrt(pow(trimStart.x - center.x, 2) + pow(trimStart.y - center.y, 2));
-            if (distance < radius) {
-                radius = distance; // Уменьшаем радиус до расстояния до trimStart
-            }
-        }
-    };
-
-    class Arc : public Shape {
-    public:
-        Point center;
-        int radius;
-        double startAngle, endAngle;  // Углы в радианах
-
-        // Конструктор с центром, радиусом и углами
-        Arc(Point center, int radius, double startAngle, double endAngle)
-            : center(center), radius(radius), startAngle(startAngle), endAngle(endAngle) {}
-
-        // Конструктор с центром и двумя конечными точками
-        Arc(Point center, Point startPoint, Point endPoint)
-            : center(center) {
-            radius = sqrt(pow(startPoint.x - center.x, 2) + pow(startPoint.y - center.y, 2));
-            startAngle = atan2(startPoint.y - center.y, startPoint.x - center.x);
-            endAngle = atan2(endPoint.y - center.y, endPoint.x - center.x);
-        }
-
-        // Метод для рисования дуги
-        void draw(HDC hdc) override {
-            HPEN pen = CreatePen(PS_SOLID, 1, color); // Создаем перо выбранного цвета
-            HPEN oldPen = (HPEN)SelectObject(hdc, pen);
-
-            // Преобразуем углы в координаты точек на окружности
-            int xStart = center.x + radius * cos(startAngle);
-            int yStart = center.y + radius * sin(startAngle);
-            int xEnd = center.x + radius * cos(endAngle);
-            int yEnd = center.y + radius * sin(endAngle);
-
-            // Вызов функции Arc из WinAPI для рисования дуги
-            ::Arc(hdc, center.x - radius, center.y - radius, center.x + radius, center.y + radius,
-                xStart, yStart, xEnd, yEnd);
-
-            SelectObject(hdc, oldPen); // Восстанавливаем старое перо
-            DeleteObject(pen);          // Удаляем созданное перо
-        }
-
-        void move(int dx, int dy) override {
-            center.move(dx, dy);
-        }
-
-        Shape* copy() const override {
-            return new Arc(center, radius, startAngle, endAngle);
-        }
-
-        void rotate(double angle) override {
-            startAngle += angle;
-            endAngle += angle;
-
-            // Приводим углы к диапазону от 0 до 2π для корректного отображения
-            startAngle = fmod(startAngle + 2 * M_PI, 2 * M_PI);
-            endAngle = fmod(endAngle + 2 * M_PI, 2 * M_PI);
-        }
-
-        void mirror(bool vertical) override {
-            if (vertical) {
-                startAngle = -startAngle;
-                endAngle = -endAngle;
-            }
-            else {
-                startAngle = M_PI - startAngle;
-                endAngle = M_PI - endAngle;
-            }
-        }
-
-        // Проверка клика на дуге
-        bool isClicked(int x, int y) override {
-            int dx = x - center.x;
-            int dy = y - center.y;
-
-            // Проверяем, находится ли точка в пределах радиуса
-            if (dx * dx + dy * dy <= radius * radius) {
-                // Вычисляем угол точки относительно центра дуги
-                double angle = atan2(dy, dx);
-
-                // Приводим углы к диапазону от 0 до 2*PI для удобства
-                double normalizedStartAngle = fmod(startAngle + 2 * M_PI, 2 * M_PI);
-                double normalizedEndAngle = fmod(endAngle + 2 * M_PI, 2 * M_PI);
-                double normalizedAngle = fmod(angle + 2 * M_PI, 2 * M_PI);
-
-                // Проверяем, находится ли угол между startAngle и endAngle
-                if (normalizedStartAngle < normalizedEndAngle) {
-                    return (normalizedAngle >= normalizedStartAngle && normalizedAngle <= normalizedEndAngle);
-                }
-                else { // Обработка случаев, когда дуга пересекает 0 радиан (например, от 350° до 10°)
-                    return (normalizedAngle >= normalizedStartAngle || normalizedAngle <= normalizedEndAngle);
-                }
-            }
-            return false; // Точка вне радиуса
-        }
-
-        void trim(const Point& trimStart, const Point& trimEnd) override {
-            // Логика обрезания дуги, например, если обрезка проходит через центр
-            // Уменьшаем радиус или изменяем углы
-            double distance = sqrt(pow(trimStart.x - center.x, 2) + pow(trimStart.y - center.y, 2));
-            if (distance < radius) {
-                radius = distance; // Уменьшаем радиус до trimStart
-            }
-        }
-    };
-
-    class Ring : public Shape {
-    private:
-        Point center; // Добавляем поле для центра
-        Circle outerCircle; // Внешний круг
-        Circle innerCircle; // Внутренний круг
-
-    public:
-        Ring(Point center, int outerRadius, int innerRadius)
-            : center(center), // Инициализируем центр
-            outerCircle(center, outerRadius),
-            innerCircle(center, innerRadius) {}
-
-        void setColor(COLORREF newColor) {
-            outerCircle.setColor(newColor);
-            innerCircle.setColor(newColor);
-        }
-
-        void draw(HDC hdc) override {
-            outerCircle.draw(hdc);
-            innerCircle.draw(hdc);
-        }
-
-        void move(int dx, int dy) override {
-            outerCircle.move(dx, dy);
-            innerCircle.move(dx, dy);
-        }
-
-        Shape* copy() const override {
-            return new Ring(center, outerCircle.getRadius(), innerCircle.getRadius());
-        }
-
-        void rotate(double angle) override {
-            // Кольцо не имеет смысла вращать
-        }
-
-        void mirror(bool vertical) override {
-            outerCircle.mirror(vertical);
-            innerCircle.mirror(vertical);
-        }
-
-        bool isClicked(int x, int y) override {
-            int dx = x - outerCircle.getCenter().x;
-            int dy = y - outerCircle.getCenter().y;
-
-            // Проверяем, находится ли точка внутри внешнего круга и снаружи внутреннего
-            bool insideOuter = (dx * dx + dy * dy <= outerCircle.getRadius() * outerCircle.getRadius());
-            bool insideInner = (dx * dx + dy * dy <= innerCircle.getRadius() * innerCircle.getRadius());
-
-            return insideOuter && !insideInner; // Внутри внешнего и снаружи внутреннего
-        }
-
-        void trim(const Point& trimStart, const Point& trimEnd) override {
-            // Если обрезка проходит через внешний или внутренний радиус, корректируем их
-            double distanceStart = sqrt(pow(trimStart.x - center.x, 2) + pow(trimStart.y - center.y, 2));
-            double distanceEnd = sqrt(pow(trimEnd.x - center.x, 2) + pow(trimEnd.y - center.y, 2));
-
-            // Обновляем радиусы, если нужно
-            if (distanceStart < outerCircle.getRadius()) {
-                outerCircle = Circle(center, distanceStart); // Уменьшаем внешний радиус
-            }
-            if (distanceEnd < innerCircle.getRadius()) {
-                innerCircle = Circle(center, distanceEnd); // Уменьшаем внутренний радиус
-            }
-        }
-    };
-
-    class Polyline : public Shape {
-    public:
-        std::vector<Point> points;
-
-        Polyline(const std::vector<Point>& points) : points(points) {}
-
-        void draw(HDC hdc) override {
-            HPEN pen = CreatePen(PS_SOLID, 1, color); // Создаем перо выбранного цвета
-            HPEN oldPen = (HPEN)SelectObject(hdc, pen);
-
-            for (size_t i = 0; i < points.size() - 1; ++i) {
-                MoveToEx(hdc, points[i].x, points[i].y, NULL);
-                LineTo(hdc, points[i + 1].x, points[i + 1].y);
-            }
-
-            SelectObject(hdc, oldPen); // Восстанавливаем старое перо
-            DeleteObject(pen);          // Удаляем созданное перо
-        }
-
-        void move(int dx, int dy) override {
-            for (Point& p : points) {
-                p.move(dx, dy);
-            }
-        }
-
-        Shape* copy() const override {
-            return new Polyline(points);
-        }
-
-        void rotate(double angle) override {
-            if (points.empty()) return;
-
-            // Находим центр как среднее всех точек
-            double centerX = 0, centerY = 0;
-            for (const MyShapes::Point& p : points) {
-                centerX += p.x;
-                centerY += p.y;
-            }
-            centerX /= points.size();
-            centerY /= points.size();
-            MyShapes::Point center(centerX, centerY);
-
-            // Поворачиваем каждую точку вокруг центра
-            for (MyShapes::Point& point : points) {
-                point.rotateAround(center, angle);
-            }
-        }
-
-        void mirror(bool vertical) override {
-            if (points.empty()) return;
-
-            // Находим центр ломаной как среднее всех точек
-            double centerX = 0, centerY = 0;
-            for (const Point& p : points) {
-                centerX += p.x;
-                centerY += p.y;
-            }
-            centerX /= points.size();
-            centerY /= points.size();
-            Point center(centerX, centerY);
-
-            // Зеркально отражаем каждую точку относительно центра
-            for (Point& p : points) {
-                if (vertical) {
-                    p.x = center.x - (p.x - center.x);
-                }
-                else {
-                    p.y = center.y - (p.y - center.y);
-                }
-            }
-        }
-
-        bool isClicked(int x, int y) override {
-            int tolerance = 5; // Допустимое расстояние от линии
-
-            for (size_t i = 0; i < points.size() - 1; ++i) {
-                int dx = points[i + 1].x - points[i].x;
-                int dy = points[i + 1].y - points[i].y;
-
-                // Уравнение линии: Ax + By + C = 0
-                double A = dy;
-                double B = -dx;
-                double C = dx * points[i].y - dy * points[i].x;
-
-                // Расстояние от точки до линии
-                double distance = std::abs(A * x + B * y + C) / std::sqrt(A * A + B * B);
-
-                if (distance < tolerance) {
-                    return true; // Клик на линии
-                }
-            }
-            return false; // Не попал в полилинию
-        }
-
-
-        void trim(const Point& trimStart, const Point& trimEnd) override {
-            std::vector<Point> trimmedPoints;
-            bool trimming = false;
-
-            for (size_t i = 0; i < points.size() - 1; ++i) {
-                Point p1 = points[i];
-                Point p2 = points[i + 1];
-
-                // Проверка на пересечение текущего отрезка с линией обрезки
-                Point intersection;
-                if (lineSegmentIntersection(p1, p2, trimStart, trimEnd, intersection)) {
-                    trimmedPoints.push_back(p1);
-                    trimmedPoints.push_back(intersection);
-                    trimming = true;
-                    break;
-                }
-                else {
-                    trimmedPoints.push_back(p1);
-                }
-            }
-
-            // Если обрезка произошла, обновляем точки полилинии
-            if (trimming) {
-                points = trimmedPoints;
-            }
-        }
-
-    };
-
-    class Polygon : public Polyline {
-    public:
-        Polygon(const std::vector<Point>& points) : Polyline(points) {}
-
-        void draw(HDC hdc) override {
-            HPEN pen = CreatePen(PS_SOLID, 1, color); // Создаем перо выбранного цвета
-            HPEN oldPen = (HPEN)SelectObject(hdc, pen);
-
-            Polyline::draw(hdc);
-            MoveToEx(hdc, points.back().x, points.back().y, NULL);
-            LineTo(hdc, points[0].x, points[0].y);
-
-            SelectObject(hdc, oldPen); // Восстанавливаем старое перо
-            DeleteObject(pen);          // Удаляем созданное перо
-        }
-
-        Shape* copy() const override {
-            return new Polygon(points);
-        }
-
-        bool isClicked(int x, int y) override {
-            bool inside = false;
-
-            for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
-                if (((points[i].y > y) != (points[j].y > y)) &&
-                    (x < (points[j].x - points[i].x) * (y - points[i].y) / (points[j].y - points[i].y) + points[i].x)) {
-                    inside = !inside;
-                }
-            }
-            return inside; // Внутри многоугольника
-        }
-
-
-
-
-    };
-
-    class Triangle : public Polygon {
-    public:
-        Triangle(Point p1, Point p2, Point p3) : Polygon({ p1, p2, p3 }) {}
-
-        void rotate(double angle) override {
-            // Находим центр треугольника как среднее всех точек
-            Point center(
-                (points[0].x + points[1].x + points[2].x) / 3,
-                (points[0].y + points[1].y + points[2].y) / 3
-            );
-
-            // Поворачиваем каждую точку вокруг центра
-            for (Point& point : points) {
-                point.rotateAround(center, angle);
-            }
-        }
-
-        void trim(const Point& trimStart, const Point& trimEnd) override {
-            // Логика обрезки для треугольника
-            // Проверяем пересечения с рёбрами
-        }
-    };
-
-    class Parallelogram : public Polygon {
-    public:
-        Parallelogram(Point p1, Point p2, double angle) : Polygon({ p1, p2 }) {
-            // Вычисляем третью и четвертую точку на основе угла
-            double dx = p2.x - p1.x;
-            double dy = p2.y - p1.y;
-
-            // Длина стороны
-            double length = sqrt(dx * dx + dy * dy);
-
-            // Угол наклона (в радианах)
-            double rad = angle * M_PI / 180.0;
-
-            // Вычисляем третью точку, используя угол наклона
-            Point p3(p1.x + length * cos(rad), p1.y + length * sin(rad));
-            Point p4(p2.x + length * cos(rad), p2.y + length * sin(rad));
-
-            points.push_back(p4);
-            points.push_back(p3);
-        }
-
-        void rotate(double angle) override {
-            Point center(
-                (points[0].x + points[1].x + points[2].x + points[3].x) / 4,
-                (points[0].y + points[1].y + points[2].y + points[3].y) / 4
-            );
-
-            for (Point& point : points) {
-                point.rotateAround(center, angle);
-            }
-        }
-    };
-
-}
+#include "EditJournal.h"
+#include "PolygonBoolean.h"
+#include "Scene.h"
+#include "SceneFile.h"
+#include "SegmentSweep.h"
+#include "Selection.h"
+#include "RegionQuery.h"
+#include "ThreadPool.h"
+#include "Transform.h"
+#include "VectorExport.h"
+#include "VectorImport.h"
+#include "BatchRenderer.h"
+#include "GdiRenderer.h"
+#include "GdiBackBuffer.h"
 
 // Функция для показа диалога и получения количества точек
 int ShowPointDialog(HWND hwnd) {
@@ -703,14 +100,192 @@ void UpdateStatusBar(HWND hWndStatus, int countShapes) {
     SendMessage(hWndStatus, SB_SETTEXT, 1, (LPARAM)statusText);
 }
 
+// Стандартный диалог выбора документа; false, если пользователь передумал
+bool AskDocumentPath(HWND hwnd, char* path, DWORD size, bool save) {
+    OPENFILENAME ofn = { 0 };
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hwnd;
+    ofn.lpstrFilter = "Документ редактора (*.msh)\0*.msh\0Все файлы\0*.*\0";
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = size;
+    ofn.lpstrDefExt = "msh";
+    if (save) {
+        ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
+        return GetSaveFileName(&ofn) != FALSE;
+    }
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+    return GetOpenFileName(&ofn) != FALSE;
+}
+
+// Диалог выбора чертежа для импорта
+bool AskImportPath(HWND hwnd, char* path, DWORD size) {
+    OPENFILENAME ofn = { 0 };
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hwnd;
+    ofn.lpstrFilter = "Чертежи (*.svg;*.dxf)\0*.svg;*.dxf\0SVG (*.svg)\0*.svg\0DXF (*.dxf)\0*.dxf\0";
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = size;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+    return GetOpenFileName(&ofn) != FALSE;
+}
+
+// Диалог сохранения чертежа; формат - по выбранному в диалоге фильтру
+bool AskExportPath(HWND hwnd, char* path, DWORD size, MyShapes::ExportFormat& format) {
+    static const char* extensions[] = { "svg", "dxf", "pdf" };
+    OPENFILENAME ofn = { 0 };
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hwnd;
+    ofn.lpstrFilter = "SVG (*.svg)\0*.svg\0DXF (*.dxf)\0*.dxf\0PDF (*.pdf)\0*.pdf\0";
+    ofn.nFilterIndex = 1;
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = size;
+    ofn.lpstrDefExt = extensions[0];
+    ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
+    if (!GetSaveFileName(&ofn)) return false;
+    format = (MyShapes::ExportFormat)(ofn.nFilterIndex >= 1 && ofn.nFilterIndex <= 3 ? ofn.nFilterIndex - 1 : 0);
+    return true;
+}
+
+// Габарит включительный, RECT - нет; margin пикселей запаса на перо
+RECT ToWindowRect(const MyShapes::Rect& r, int margin) {
+    RECT rc = { r.left - margin, r.top - margin, r.right + 1 + margin, r.bottom + 1 + margin };
+    return rc;
+}
+
+MyShapes::Rect FromWindowRect(const RECT& rc) {
+    return MyShapes::Rect(rc.left, rc.top, rc.right - 1, rc.bottom - 1);
+}
+
+// Перерисовка только тех областей, где фигуры изменились с прошлого кадра.
+// staticLayer = nullptr, если менялась только выделенная фигура: она рисуется
+// поверх статического слоя закадрового буфера и не требует его перерисовки.
+void InvalidateDamage(HWND hwnd, MyShapes::Scene& scene, GdiBackBuffer* staticLayer) {
+    for (const MyShapes::Rect& r : scene.takeDamage()) {
+        RECT rc = ToWindowRect(r, 1);
+        if (staticLayer) {
+            staticLayer->invalidateStatic(rc);
+        }
+        InvalidateRect(hwnd, &rc, FALSE);
+    }
+}
+
+// Выделенная фигура рисуется синим, остальные - чёрным
+void MarkSelected(MyShapes::Scene& scene, MyShapes::Shape* shape, bool selected) {
+    shape->setColor(selected ? RGB(0, 0, 255) : RGB(0, 0, 0));
+    scene.addDamage(shape);
+}
+
+// Одна матрица для всего выделения за один проход; журнал обновляет
+// габариты в сцене и запоминает правку для отмены
+void TransformSelection(MyShapes::EditJournal& journal, const MyShapes::Selection& selection, const MyShapes::Affine& m) {
+    journal.transform(selection.getShapes(), m);
+}
+
+// Центр габарита выделения: относительно него группа отражается
+void SelectionCenter(const MyShapes::Selection& selection, double& x, double& y) {
+    MyShapes::Rect r = selection.bounds();
+    x = (r.left + r.right) / 2.0;
+    y = (r.top + r.bottom) / 2.0;
+}
+
+// Вид фигур, видимость которых переключает пункт меню "Показать"
+MyShapes::ShapeKind ShowCommandKind(int command) {
+    switch (command) {
+    case IDM_SHOW_LINES: return MyShapes::ShapeKind::Line;
+    case IDM_SHOW_CIRCLES: return MyShapes::ShapeKind::Circle;
+    case IDM_SHOW_ARCS: return MyShapes::ShapeKind::Arc;
+    case IDM_SHOW_RINGS: return MyShapes::ShapeKind::Ring;
+    case IDM_SHOW_POLYLINES: return MyShapes::ShapeKind::Polyline;
+    case IDM_SHOW_POLYGONS: return MyShapes::ShapeKind::Polygon;
+    case IDM_SHOW_TRIANGLES: return MyShapes::ShapeKind::Triangle;
+    default: return MyShapes::ShapeKind::Parallelogram;
+    }
+}
+
+// Размер маркера точки строящейся фигуры
+const int ConstructionMarker = 3;
+
+// Таймер, по которому открытый документ создаёт фигуры после первого кадра
+const UINT_PTR LoadTimer = 1;
+
+// Соседние вершины лассо не ближе (по сумме сдвигов): долгое движение мыши
+// не раздувает контур, а точность выделения от этого не страдает
+const int LassoStep = 4;
+
+// Маркер точки - крестик
+void DrawMarker(MyShapes::Renderer& renderer, const MyShapes::Point& p) {
+    renderer.line(p.x - ConstructionMarker, p.y, p.x + ConstructionMarker + 1, p.y);
+    renderer.line(p.x, p.y - ConstructionMarker, p.x, p.y + ConstructionMarker + 1);
+}
+
+// Точки строящейся фигуры: маркеры и ломаная через них
+void DrawConstruction(MyShapes::Renderer& renderer, const std::vector<MyShapes::Point>& construction) {
+    renderer.setPen(RGB(255, 0, 0));
+    for (size_t i = 0; i < construction.size(); ++i) {
+        const MyShapes::Point& p = construction[i];
+        DrawMarker(renderer, p);
+        if (i > 0) {
+            renderer.line(construction[i - 1].x, construction[i - 1].y, p.x, p.y);
+        }
+    }
+}
+
+// Точки пересечения фигур: только маркеры
+void DrawIntersections(MyShapes::Renderer& renderer, const std::vector<MyShapes::Point>& intersections) {
+    renderer.setPen(RGB(0, 160, 0));
+    for (const MyShapes::Point& p : intersections) {
+        DrawMarker(renderer, p);
+    }
+}
+
+// Рамка (по двум углам) или лассо выделения пунктиром
+void DrawRegion(MyShapes::Renderer& renderer, const std::vector<MyShapes::Vertex>& path, bool lasso) {
+    if (path.size() < 2) return;
+    renderer.setPen(MyShapes::Pen(RGB(0, 0, 255), 1, MyShapes::PenStyle::Dot));
+    if (lasso) {
+        for (size_t i = 1; i < path.size(); ++i) {
+            renderer.line(path[i - 1].x, path[i - 1].y, path[i].x, path[i].y);
+        }
+        renderer.line(path.back().x, path.back().y, path[0].x, path[0].y);
+        return;
+    }
+    const MyShapes::Vertex& a = path[0];
+    const MyShapes::Vertex& b = path[1];
+    renderer.line(a.x, a.y, b.x, a.y);
+    renderer.line(b.x, a.y, b.x, b.y);
+    renderer.line(b.x, b.y, a.x, b.y);
+    renderer.line(a.x, b.y, a.x, a.y);
+}
+
 // Основная логика для окна
 LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     // Глобальные переменные
     static HWND hWndStatus;
     static HMENU hContextMenu;
 
-    static std::vector<MyShapes::Shape*> shapes;
-    static MyShapes::Shape* selectedShape = nullptr;
+    static MyShapes::Scene scene; // Фигуры документа и индекс для выбора кликом
+    static MyShapes::EditJournal journal(scene); // Правки документа для отмены и повтора
+    static MyShapes::SceneFile document; // Открытый документ: рисуется из отображения, пока фигур ещё нет
+    static std::vector<std::unique_ptr<MyShapes::Shape>> clipboard; // Копии для вставки: ломаные делят с ними вершины
+    static int pasteCount = 0; // Каждая следующая вставка сдвигается дальше
+    static GdiBackBuffer backBuffer; // Статический слой невыделенных фигур и кадр
+    static GdiObjectCache gdiObjects; // Перья и кисти, общие для всех перерисовок
+    static MyShapes::Selection selection; // Щелчок выделяет фигуру, Ctrl+щелчок добавляет или снимает
+
+    // Протяжка по пустому месту выделяет рамкой, с Shift - лассо.
+    // Рамка слева направо берёт фигуры целиком внутри, справа налево - задетые.
+    static MyShapes::ThreadPool pool;
+    static MyShapes::RegionQuery regionQuery(&pool);
+    static std::vector<MyShapes::Vertex> dragPath; // Углы рамки или вершины лассо
+    static MyShapes::Rect dragArea;                // Область окна, занятая рамкой
+    static bool dragging = false;
+    static bool dragLasso = false;
+
+    // Пересечения рёбер фигур: для обрезки всего, что задевает отрезок,
+    // и для показа всех пересечений рисунка
+    static MyShapes::SegmentSweep sweep;
+    static std::vector<MyShapes::Point> intersections; // Снимок на момент команды показа
+    static MyShapes::Rect intersectionArea;
 
     static int numPoints = 0;
     static std::vector<MyShapes::Point> points;
@@ -719,6 +294,8 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         MODE_SELECT,
         MODE_TRIM_SELECTED_FIRST_POINT,
         MODE_TRIM_SELECTED_SECOND_POINT,
+        MODE_TRIM_ALL_FIRST_POINT,
+        MODE_TRIM_ALL_SECOND_POINT,
         MODE_ADD_LINE_FIRST_POINT,
         MODE_ADD_LINE_SECOND_POINT,
         MODE_ADD_CIRCLE_FIRST_POINT,
@@ -736,18 +313,45 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     static Mode mode = MODE_SELECT;
 
     static MyShapes::Point startPoint, endPoint;
+
+    // Уже поставленные точки строящейся фигуры и занятая ими область окна
+    static std::vector<MyShapes::Point> construction;
+    static MyShapes::Rect constructionArea;
+    auto addConstructionPoint = [&](const MyShapes::Point& p) {
+        construction.push_back(p);
+        constructionArea.include(p.x, p.y);
+        RECT rc = ToWindowRect(constructionArea, ConstructionMarker + 1);
+        InvalidateRect(hwnd, &rc, FALSE);
+    };
+    auto clearConstruction = [&]() {
+        if (construction.empty()) return;
+        RECT rc = ToWindowRect(constructionArea, ConstructionMarker + 1);
+        InvalidateRect(hwnd, &rc, FALSE);
+        construction.clear();
+        constructionArea = MyShapes::Rect();
+    };
+
+    // Фигуры открытого документа создаются в сцене; дальше он не нужен
+    auto finishOpen = [&]() {
+        if (!document.isOpen()) return;
+        KillTimer(hwnd, LoadTimer);
+        document.loadInto(scene);
+        document.close();
+        scene.takeDamage(); // Кадр уже нарисован из документа, перерисовка не нужна
+        UpdateStatusBar(hWndStatus, (int)scene.size());
+    };
+
     HDC hdc;
     PAINTSTRUCT ps;
 
-    // Флаги отображения для каждой фигуры
-    static bool showLines = true;
-    static bool showCircles = true;
-    static bool showArcs = true;
-    static bool showRings = true;
-    static bool showPolylines = true;
-    static bool showPolygons = true;
-    static bool showTriangles = true;
-    static bool showParallelograms = true;
+    // Видимые виды фигур, по биту на каждый
+    static MyShapes::KindMask visibleKinds = MyShapes::AllKinds;
+
+    // Команды, мышь и клавиатура работают с фигурами сцены: пока документ
+    // только нарисован, сначала создаём их
+    if (document.isOpen() && (msg == WM_COMMAND || msg == WM_LBUTTONDOWN || msg == WM_RBUTTONDOWN || msg == WM_KEYDOWN)) {
+        finishOpen();
+    }
 
     switch (msg) {
     case WM_CREATE:
@@ -775,6 +379,7 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         // Общая обработка для всех фигур, которые требуют диалог ввода точек
         bool shapeRequiresPoints = false;
         Mode newMode;
+        Mode modeBefore = mode;
 
         switch (LOWORD(wParam)) {
         case IDM_ADD_LINE:
@@ -792,21 +397,228 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         case IDM_SELECT_MODE:
             mode = MODE_SELECT;
             break;
+        case IDM_FILE_OPEN:
+        {
+            char path[MAX_PATH] = "";
+            if (!AskDocumentPath(hwnd, path, MAX_PATH, false)) break;
+
+            // Столбцы документа читаются прямо из отображения файла
+            if (!document.open(path)) {
+                MessageBox(hwnd, "Файл не является документом редактора или повреждён", "Открытие", MB_ICONERROR | MB_OK);
+                break;
+            }
+            selection.clear();
+            clearConstruction();
+            mode = MODE_SELECT;
+            journal.clear();
+            scene.clear();
+            scene.takeDamage(); // Перерисовывается всё окно
+
+            // Первый кадр рисуется прямо из отображения. Фигуры создаются по
+            // таймеру: WM_TIMER выбирается из очереди после WM_PAINT. Команда,
+            // клик или клавиша раньше таймера создают их сразу (finishOpen).
+            backBuffer.invalidateStatic();
+            InvalidateRect(hwnd, NULL, FALSE);
+            UpdateStatusBar(hWndStatus, (int)document.size());
+            SetTimer(hwnd, LoadTimer, 0, NULL);
+            break;
+        }
+        case IDM_FILE_SAVE:
+        {
+            char path[MAX_PATH] = "";
+            if (!AskDocumentPath(hwnd, path, MAX_PATH, true)) break;
+
+            // Синий цвет выделения в документ не попадает
+            for (MyShapes::Shape* shape : selection.getShapes()) {
+                MarkSelected(scene, shape, false);
+            }
+            bool saved = MyShapes::SceneFile::save(path, scene.getShapes());
+            for (MyShapes::Shape* shape : selection.getShapes()) {
+                MarkSelected(scene, shape, true);
+            }
+            scene.takeDamage(); // На экране ничего не изменилось
+            if (!saved) {
+                MessageBox(hwnd, "Не удалось записать документ", "Сохранение", MB_ICONERROR | MB_OK);
+            }
+            break;
+        }
+        case IDM_FILE_EXPORT:
+        {
+            char path[MAX_PATH] = "";
+            MyShapes::ExportFormat format;
+            if (!AskExportPath(hwnd, path, MAX_PATH, format)) break;
+
+            // Как при сохранении: цвет выделения в чертёж не попадает
+            for (MyShapes::Shape* shape : selection.getShapes()) {
+                MarkSelected(scene, shape, false);
+            }
+            MyShapes::VectorExporter exporter;
+            bool exported = exporter.exportFile(path, format, scene.getShapes());
+            for (MyShapes::Shape* shape : selection.getShapes()) {
+                MarkSelected(scene, shape, true);
+            }
+            scene.takeDamage(); // На экране ничего не изменилось
+            if (!exported) {
+                MessageBox(hwnd, "Не удалось записать файл", "Экспорт", MB_ICONERROR | MB_OK);
+            }
+            break;
+        }
+        case IDM_FILE_IMPORT:
+        {
+            char path[MAX_PATH] = "";
+            if (!AskImportPath(hwnd, path, MAX_PATH)) break;
+
+            // Фигуры чертежа добавляются поверх текущих; файл разбирается частями в пуле
+            MyShapes::VectorImporter importer(&pool);
+            size_t before = scene.size();
+            MyShapes::ImportResult result = importer.importFile(path, scene);
+            journal.add(std::vector<MyShapes::Shape*>(scene.getShapes().begin() + before, scene.getShapes().end()));
+            if (!result.ok) {
+                MessageBox(hwnd, "Не удалось прочитать файл", "Импорт", MB_ICONERROR | MB_OK);
+            }
+            else if (result.skipped > 0) {
+                char message[128];
+                wsprintf(message, "Добавлено фигур: %u\nПропущено элементов: %u",
+                    (unsigned)result.shapes, (unsigned)result.skipped);
+                MessageBox(hwnd, message, "Импорт", MB_ICONINFORMATION | MB_OK);
+            }
+            scene.takeDamage(); // Перерисовывается всё окно
+            backBuffer.invalidateStatic();
+            InvalidateRect(hwnd, NULL, FALSE);
+            UpdateStatusBar(hWndStatus, (int)scene.size());
+            break;
+        }
+        case IDM_EDIT_UNDO:
+        case IDM_EDIT_REDO:
+        {
+            // Отмена может убрать выделенную фигуру со сцены: выделение снимается
+            for (MyShapes::Shape* shape : selection.getShapes()) {
+                MarkSelected(scene, shape, false);
+            }
+            selection.clear();
+            if (LOWORD(wParam) == IDM_EDIT_UNDO) {
+                journal.undo();
+            }
+            else {
+                journal.redo();
+            }
+            InvalidateDamage(hwnd, scene, &backBuffer);
+            UpdateStatusBar(hWndStatus, (int)scene.size());
+            break;
+        }
+        case IDM_EDIT_COPY:
+            if (!selection.empty()) {
+                clipboard.clear();
+                for (MyShapes::Shape* shape : selection.getShapes()) {
+                    clipboard.emplace_back(shape->copy());
+                    clipboard.back()->setColor(RGB(0, 0, 0));
+                }
+                pasteCount = 0;
+            }
+            break;
+        case IDM_EDIT_PASTE:
+            if (!clipboard.empty()) {
+                // Вставленные копии - экземпляры: вершины ломаных не копируются
+                int offset = 10 * ++pasteCount;
+                for (MyShapes::Shape* shape : selection.getShapes()) {
+                    MarkSelected(scene, shape, false);
+                }
+                selection.clear();
+                std::vector<MyShapes::Shape*> pasted;
+                for (const auto& prototype : clipboard) {
+                    MyShapes::Shape* shape = prototype->copy();
+                    shape->move(offset, offset);
+                    scene.add(shape);
+                    pasted.push_back(shape);
+                    selection.add(shape);
+                    MarkSelected(scene, shape, true);
+                }
+                journal.add(pasted);
+                InvalidateDamage(hwnd, scene, &backBuffer);
+                UpdateStatusBar(hWndStatus, (int)scene.size());
+            }
+            break;
+        case IDM_PRECISION_MODE:
+            // Фигуры копят повороты в матрице и округляются один раз от исходной геометрии
+            scene.setPrecise(!scene.isPrecise());
+            CheckMenuItem(GetMenu(hwnd), IDM_PRECISION_MODE, scene.isPrecise() ? MF_CHECKED : MF_UNCHECKED);
+            break;
         case IDM_TRIM_SELECTED:
-            if (selectedShape) {
+            if (!selection.empty()) {
                 mode = MODE_TRIM_SELECTED_FIRST_POINT;
             }
             break;
-        case IDM_MIRROR_VERTICAL:  // Обработка зеркального отображения
-            if (selectedShape) {
-                selectedShape->mirror(true); // Вертикальное отражение
-                InvalidateRect(hwnd, NULL, TRUE); // Обновляем окно
+        case IDM_TRIM_ALL:
+            mode = MODE_TRIM_ALL_FIRST_POINT;
+            break;
+        case IDM_CLIP_SELECTED:
+        case IDM_SUBTRACT_SELECTED:
+        case IDM_MERGE_SELECTED:
+        {
+            // Инструмент - последняя выделенная фигура, остальные выделенные
+            // отсекаются им, вычитают его или сливаются с ним
+            if (selection.size() < 2) break;
+            MyShapes::Shape* tool = selection.primary();
+            std::vector<MyShapes::Shape*> others;
+            for (MyShapes::Shape* shape : selection.getShapes()) {
+                MarkSelected(scene, shape, false);
+                if (shape != tool) others.push_back(shape);
+            }
+            selection.clear();
+
+            std::vector<MyShapes::Shape*> replaced, pieces;
+            if (LOWORD(wParam) == IDM_MERGE_SELECTED) {
+                MyShapes::mergePolygons(others, *tool, replaced, pieces);
             }
+            else {
+                MyShapes::BooleanOp op = LOWORD(wParam) == IDM_CLIP_SELECTED ?
+                    MyShapes::BooleanOp::Intersection : MyShapes::BooleanOp::Difference;
+                MyShapes::booleanWithTool(pool, others, *tool, op, replaced, pieces);
+            }
+            journal.replace(replaced, pieces); // Одна правка для отмены
+            InvalidateDamage(hwnd, scene, &backBuffer);
+            UpdateStatusBar(hWndStatus, (int)scene.size());
             break;
-        case IDM_MIRROR_HORIZONTAL:  // Обработка зеркального отображения
-            if (selectedShape) {
-                selectedShape->mirror(false); // Вертикальное отражение
-                InvalidateRect(hwnd, NULL, TRUE); // Обновляем окно
+        }
+        case IDM_SHOW_INTERSECTIONS:
+        {
+            if (!intersections.empty()) {
+                // Повторный выбор убирает маркеры
+                RECT rc = ToWindowRect(intersectionArea, ConstructionMarker + 1);
+                InvalidateRect(hwnd, &rc, FALSE);
+                intersections.clear();
+                intersectionArea = MyShapes::Rect();
+                CheckMenuItem(GetMenu(hwnd), IDM_SHOW_INTERSECTIONS, MF_UNCHECKED);
+                break;
+            }
+            sweep.clear();
+            const std::vector<MyShapes::Shape*>& shapes = scene.getShapes();
+            for (size_t i = 0; i < shapes.size(); ++i) {
+                if (visibleKinds & MyShapes::kindBit(shapes[i]->kind())) {
+                    sweep.addShape(*shapes[i], (uint32_t)i);
+                }
+            }
+            std::vector<MyShapes::SweepCrossing> crossings;
+            sweep.run(crossings);
+            for (const MyShapes::SweepCrossing& c : crossings) {
+                intersections.push_back(MyShapes::Point(c.point.x, c.point.y));
+                intersectionArea.include(c.point.x, c.point.y);
+            }
+            if (!intersections.empty()) {
+                RECT rc = ToWindowRect(intersectionArea, ConstructionMarker + 1);
+                InvalidateRect(hwnd, &rc, FALSE);
+                CheckMenuItem(GetMenu(hwnd), IDM_SHOW_INTERSECTIONS, MF_CHECKED);
+            }
+            break;
+        }
+        case IDM_MIRROR_VERTICAL:  // Обработка зеркального отображения
+        case IDM_MIRROR_HORIZONTAL:
+            if (!selection.empty()) {
+                double cx, cy;
+                SelectionCenter(selection, cx, cy);
+                TransformSelection(journal, selection,
+                    MyShapes::Affine::mirror(cx, cy, LOWORD(wParam) == IDM_MIRROR_VERTICAL));
+                InvalidateDamage(hwnd, scene, nullptr); // Обновляем изменившуюся часть окна
             }
             break;
         case IDM_ADD_POLYLINE:
@@ -828,49 +640,34 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             break;
 
         case IDM_SHOW_LINES:
-            showLines = !showLines;
-            CheckMenuItem(GetMenu(hwnd), IDM_SHOW_LINES, showLines ? MF_CHECKED : MF_UNCHECKED);
-            InvalidateRect(hwnd, NULL, TRUE); // Перерисовать окно
-            break;
         case IDM_SHOW_CIRCLES:
-            showCircles = !showCircles;
-            CheckMenuItem(GetMenu(hwnd), IDM_SHOW_CIRCLES, showCircles ? MF_CHECKED : MF_UNCHECKED);
-            InvalidateRect(hwnd, NULL, TRUE);
-            break;
         case IDM_SHOW_ARCS:
-            showArcs = !showArcs;
-            CheckMenuItem(GetMenu(hwnd), IDM_SHOW_ARCS, showArcs ? MF_CHECKED : MF_UNCHECKED);
-            InvalidateRect(hwnd, NULL, TRUE);
-            break;
         case IDM_SHOW_RINGS:
-            showRings = !showRings;
-            CheckMenuItem(GetMenu(hwnd), IDM_SHOW_RINGS, showRings ? MF_CHECKED : MF_UNCHECKED);
-            InvalidateRect(hwnd, NULL, TRUE);
-            break;
         case IDM_SHOW_POLYLINES:
-            showPolylines = !showPolylines;
-            CheckMenuItem(GetMenu(hwnd), IDM_SHOW_POLYLINES, showPolylines ? MF_CHECKED : MF_UNCHECKED);
-            InvalidateRect(hwnd, NULL, TRUE);
-            break;
         case IDM_SHOW_POLYGONS:
-            showPolygons = !showPolygons;
-            CheckMenuItem(GetMenu(hwnd), IDM_SHOW_POLYGONS, showPolygons ? MF_CHECKED : MF_UNCHECKED);
-            InvalidateRect(hwnd, NULL, TRUE);
-            break;
         case IDM_SHOW_TRIANGLES:
-            showTriangles = !showTriangles;
-            CheckMenuItem(GetMenu(hwnd), IDM_SHOW_TRIANGLES, showTriangles ? MF_CHECKED : MF_UNCHECKED);
-            InvalidateRect(hwnd, NULL, TRUE);
-            break;
         case IDM_SHOW_PARALLELOGRAMS:
-            showParallelograms = !showParallelograms;
-            CheckMenuItem(GetMenu(hwnd), IDM_SHOW_PARALLELOGRAMS, showParallelograms ? MF_CHECKED : MF_UNCHECKED);
-            InvalidateRect(hwnd, NULL, TRUE);
+        {
+            MyShapes::KindMask bit = MyShapes::kindBit(ShowCommandKind(LOWORD(wParam)));
+            visibleKinds ^= bit;
+            CheckMenuItem(GetMenu(hwnd), LOWORD(wParam), (visibleKinds & bit) ? MF_CHECKED : MF_UNCHECKED);
+
+            // Скрытые фигуры нельзя оставлять выделенными
+            selection.removeIf([&](MyShapes::Shape* shape) {
+                if (visibleKinds & MyShapes::kindBit(shape->kind())) return false;
+                shape->setColor(RGB(0, 0, 0));
+                return true;
+            });
+            backBuffer.invalidateStatic();
+            InvalidateRect(hwnd, NULL, FALSE); // Перерисовать окно
             break;
+        }
         case IDM_ROTATE_SELECTED:
-            if (selectedShape) {
-                selectedShape->rotate(10); // Вращаем на 15 градусов
-                InvalidateRect(hwnd, NULL, TRUE); // Обновляем окно
+            if (!selection.empty()) {
+                double cx, cy;
+                selection.pivot(cx, cy); // Не смещается при повороте, в отличие от центра габарита
+                TransformSelection(journal, selection, MyShapes::Affine::rotation(cx, cy, 10)); // Вращаем на 10 градусов
+                InvalidateDamage(hwnd, scene, nullptr); // Обновляем изменившуюся часть окна
             }
             break;
         }
@@ -886,7 +683,13 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             }
         }
 
-        UpdateStatusBar(hWndStatus, shapes.size() + 1);
+        // Смена режима прерывает построение начатой фигуры
+        if (mode != modeBefore) {
+            points.clear();
+            clearConstruction();
+        }
+
+        UpdateStatusBar(hWndStatus, scene.size() + 1);
 
         break;
     }
@@ -898,64 +701,113 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
 
         switch (mode) {
         case MODE_SELECT:
+        {
+            // Самая верхняя фигура под курсором через пространственный индекс
+            MyShapes::Shape* hit = scene.pick(xPos, yPos, visibleKinds);
 
-            if (selectedShape != nullptr)
-                selectedShape->setColor(RGB(0, 0, 0));
-
-            selectedShape = nullptr;
-
-            for (MyShapes::Shape* shape : shapes) {
-                if (shape->isClicked(xPos, yPos)) {
-                    selectedShape = shape;
-                    selectedShape->setColor(RGB(0, 0, 255));
-                    InvalidateRect(hwnd, NULL, TRUE);
-                    break;
+            if (!(wParam & MK_CONTROL)) {
+                for (MyShapes::Shape* shape : selection.getShapes()) {
+                    MarkSelected(scene, shape, false);
                 }
+                selection.clear();
+            }
+            if (hit != nullptr) {
+                selection.toggle(hit);
+                MarkSelected(scene, hit, selection.contains(hit));
             }
+            else {
+                dragging = true;
+                dragLasso = (wParam & MK_SHIFT) != 0;
+                dragPath.assign(2, MyShapes::Vertex{ xPos, yPos });
+                dragArea = MyShapes::Rect(xPos, yPos, xPos, yPos);
+                SetCapture(hwnd);
+            }
+            // Фигуры переходят между статическим слоем и слоем выделения
+            InvalidateDamage(hwnd, scene, &backBuffer);
             break;
+        }
 
         case MODE_TRIM_SELECTED_FIRST_POINT:
             startPoint = MyShapes::Point(xPos, yPos);
+            addConstructionPoint(startPoint);
             mode = MODE_TRIM_SELECTED_SECOND_POINT;
             break;
 
         case MODE_TRIM_SELECTED_SECOND_POINT:
+        {
             endPoint = MyShapes::Point(xPos, yPos);
-            if (selectedShape) {
-                selectedShape->trim(startPoint, endPoint);
-                InvalidateRect(hwnd, NULL, TRUE); // Обновляем окно
+            // Обрезка может заменить выделенную фигуру кусками: выделение снимается
+            std::vector<MyShapes::Shape*> trimmed = selection.getShapes();
+            for (MyShapes::Shape* shape : trimmed) {
+                MarkSelected(scene, shape, false);
             }
+            selection.clear();
+            journal.trim(trimmed, startPoint, endPoint);
+            InvalidateDamage(hwnd, scene, &backBuffer); // Фигуры уходят в статический слой
+            UpdateStatusBar(hWndStatus, (int)scene.size());
+            clearConstruction();
             mode = MODE_SELECT;
             break;
+        }
+
+        case MODE_TRIM_ALL_FIRST_POINT:
+            startPoint = MyShapes::Point(xPos, yPos);
+            addConstructionPoint(startPoint);
+            mode = MODE_TRIM_ALL_SECOND_POINT;
+            break;
+
+        case MODE_TRIM_ALL_SECOND_POINT:
+        {
+            endPoint = MyShapes::Point(xPos, yPos);
+            // Кандидаты - из индекса по габариту отрезка, задетые - проверкой каждого с отрезком
+            MyShapes::Rect cut(startPoint.x, startPoint.y, startPoint.x, startPoint.y);
+            cut.include(endPoint.x, endPoint.y);
+            std::vector<MyShapes::Shape*> candidates, crossed;
+            scene.collect(cut, candidates, visibleKinds);
+            MyShapes::crossedShapes(candidates, startPoint, endPoint, crossed);
+            if (!crossed.empty()) {
+                journal.trim(crossed, startPoint, endPoint); // Одна правка для отмены
+                InvalidateDamage(hwnd, scene, nullptr);
+                UpdateStatusBar(hWndStatus, (int)scene.size()); // Круги и кольца могли распасться на куски
+            }
+            clearConstruction();
+            mode = MODE_SELECT;
+            break;
+        }
 
         case MODE_ADD_LINE_FIRST_POINT:
             startPoint = MyShapes::Point(xPos, yPos);
+            addConstructionPoint(startPoint);
             mode = MODE_ADD_LINE_SECOND_POINT;
             break;
 
         case MODE_ADD_LINE_SECOND_POINT:
             endPoint = MyShapes::Point(xPos, yPos);
-            shapes.push_back(new MyShapes::Line(startPoint, endPoint));
+            journal.add(scene.create<MyShapes::Line>(startPoint, endPoint));
             mode = MODE_SELECT;
-            InvalidateRect(hwnd, NULL, TRUE);
+            clearConstruction();
+            InvalidateDamage(hwnd, scene, &backBuffer);
             break;
 
         case MODE_ADD_CIRCLE_FIRST_POINT:
             startPoint = MyShapes::Point(xPos, yPos);
+            addConstructionPoint(startPoint);
             mode = MODE_ADD_CIRCLE_SECOND_POINT;
             break;
 
         case MODE_ADD_CIRCLE_SECOND_POINT:
         {
             int radius = sqrt(pow(xPos - startPoint.x, 2) + pow(yPos - startPoint.y, 2));
-            shapes.push_back(new MyShapes::Circle(startPoint, radius));
+            journal.add(scene.create<MyShapes::Circle>(startPoint, radius));
             mode = MODE_SELECT;
-            InvalidateRect(hwnd, NULL, TRUE);
+            clearConstruction();
+            InvalidateDamage(hwnd, scene, &backBuffer);
             break;
         }
 
         case MODE_ADD_ARC_FIRST_POINT:
             startPoint = MyShapes::Point(xPos, yPos);
+            addConstructionPoint(startPoint);
             mode = MODE_ADD_ARC_SECOND_POINT;
             break;
 
@@ -963,65 +815,76 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         {
             endPoint = MyShapes::Point(xPos, yPos);
             int radiusArc = sqrt(pow(startPoint.x - endPoint.x, 2) + pow(startPoint.y - endPoint.y, 2)); // Расчет радиуса
-            shapes.push_back(new MyShapes::Arc(startPoint, radiusArc, 45 * M_PI / 180, 135 * M_PI / 180)); // Пример углов в радианах
+            journal.add(scene.create<MyShapes::Arc>(startPoint, radiusArc, 45 * M_PI / 180, 135 * M_PI / 180)); // Пример углов в радианах
             mode = MODE_SELECT;
-            InvalidateRect(hwnd, NULL, TRUE);
+            clearConstruction();
+            InvalidateDamage(hwnd, scene, &backBuffer);
             break;
         }
 
         case MODE_ADD_RING_FIRST_POINT:
             startPoint = MyShapes::Point(xPos, yPos);
+            addConstructionPoint(startPoint);
             mode = MODE_ADD_RING_SECOND_POINT;
             break;
 
         case MODE_ADD_RING_SECOND_POINT:
         {
             int outerRadius = sqrt(pow(xPos - startPoint.x, 2) + pow(yPos - startPoint.y, 2));
-            shapes.push_back(new MyShapes::Ring(startPoint, outerRadius, outerRadius / 2)); // Пример кольца
+            journal.add(scene.create<MyShapes::Ring>(startPoint, outerRadius, outerRadius / 2)); // Пример кольца
             mode = MODE_SELECT;
-            InvalidateRect(hwnd, NULL, TRUE);
+            clearConstruction();
+            InvalidateDamage(hwnd, scene, &backBuffer);
             break;
         }
 
         // Polyline
         case MODE_ADD_POLYLINE_FIRST_POINT:
             points.push_back(MyShapes::Point(xPos, yPos));
+            addConstructionPoint(points.back());
             if (points.size() == numPoints) {
-                shapes.push_back(new MyShapes::Polyline(points));
+                journal.add(scene.create<MyShapes::Polyline>(points));
                 points.clear();
                 mode = MODE_SELECT;
-                InvalidateRect(hwnd, NULL, TRUE);
+                clearConstruction();
+                InvalidateDamage(hwnd, scene, &backBuffer);
             }
             break;
             // Polygon
         case MODE_ADD_POLYGON_FIRST_POINT:
             points.push_back(MyShapes::Point(xPos, yPos));
+            addConstructionPoint(points.back());
             if (points.size() == numPoints) {
-                shapes.push_back(new MyShapes::Polygon(points));
+                journal.add(scene.create<MyShapes::Polygon>(points));
                 points.clear();
                 mode = MODE_SELECT;
-                InvalidateRect(hwnd, NULL, TRUE);
+                clearConstruction();
+                InvalidateDamage(hwnd, scene, &backBuffer);
             }
             break;
             // Triangle
         case MODE_ADD_TRIANGLE_FIRST_POINT:
             points.push_back(MyShapes::Point(xPos, yPos));
+            addConstructionPoint(points.back());
             if (points.size() == 3) {
-                shapes.push_back(new MyShapes::Triangle(points[0], points[1], points[2]));
+                journal.add(scene.create<MyShapes::Triangle>(points[0], points[1], points[2]));
                 points.clear();
                 mode = MODE_SELECT;
-                InvalidateRect(hwnd, NULL, TRUE);
+                clearConstruction();
+                InvalidateDamage(hwnd, scene, &backBuffer);
             }
             break;
             // Parallelogram
         case MODE_ADD_PARALLELOGRAM_FIRST_POINT:
             points.push_back(MyShapes::Point(xPos, yPos));
+            addConstructionPoint(points.back());
             if (points.size() == 2) {
                 double angle = ShowAngleDialog(hwnd);
-                shapes.push_back(new MyShapes::Parallelogram(points[0], points[1], angle));
+                journal.add(scene.create<MyShapes::Parallelogram>(points[0], points[1], angle));
                 points.clear();
                 mode = MODE_SELECT;
-                InvalidateRect(hwnd, NULL, TRUE);
+                clearConstruction();
+                InvalidateDamage(hwnd, scene, &backBuffer);
             }
             break;
 
@@ -1030,6 +893,54 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         break;
     }
 
+    case WM_MOUSEMOVE:
+        if (dragging) {
+            // Вне окна при захвате мыши координаты отрицательные
+            MyShapes::Vertex v{ (short)LOWORD(lParam), (short)HIWORD(lParam) };
+            RECT old = ToWindowRect(dragArea, 1);
+            InvalidateRect(hwnd, &old, FALSE);
+
+            if (dragLasso) {
+                const MyShapes::Vertex& last = dragPath.back();
+                if (std::abs(v.x - last.x) + std::abs(v.y - last.y) >= LassoStep) dragPath.push_back(v);
+                dragArea.include(v.x, v.y);
+            }
+            else {
+                dragPath[1] = v;
+                dragArea = MyShapes::Rect(dragPath[0].x, dragPath[0].y, dragPath[0].x, dragPath[0].y);
+                dragArea.include(v.x, v.y);
+            }
+            RECT rc = ToWindowRect(dragArea, 1);
+            InvalidateRect(hwnd, &rc, FALSE);
+        }
+        break;
+
+    case WM_LBUTTONUP:
+        if (dragging) {
+            dragging = false;
+            ReleaseCapture();
+            RECT rc = ToWindowRect(dragArea, 1);
+            InvalidateRect(hwnd, &rc, FALSE);
+
+            static std::vector<MyShapes::Shape*> found;
+            if (dragLasso) {
+                regionQuery.selectLasso(scene, dragPath, MyShapes::RegionRule::Inside, found, visibleKinds);
+            }
+            else {
+                MyShapes::RegionRule rule = dragPath[1].x >= dragPath[0].x ?
+                    MyShapes::RegionRule::Inside : MyShapes::RegionRule::Touching;
+                regionQuery.selectRect(scene, dragArea, rule, found, visibleKinds);
+            }
+            for (MyShapes::Shape* shape : found) {
+                if (selection.add(shape)) {
+                    MarkSelected(scene, shape, true);
+                }
+            }
+            dragPath.clear();
+            InvalidateDamage(hwnd, scene, &backBuffer);
+        }
+        break;
+
     case WM_RBUTTONDOWN: {
         // Получаем координаты клика мыши
         POINT pt;
@@ -1043,55 +954,107 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     }
 
     case WM_KEYDOWN:
-        if (selectedShape) {
+        if (GetKeyState(VK_CONTROL) < 0) {
+            int command = 0;
+            switch (wParam) {
+            case 'Z': command = IDM_EDIT_UNDO; break;
+            case 'Y': command = IDM_EDIT_REDO; break;
+            case 'C': command = IDM_EDIT_COPY; break;
+            case 'V': command = IDM_EDIT_PASTE; break;
+            }
+            if (command != 0) {
+                SendMessage(hwnd, WM_COMMAND, command, 0);
+                break;
+            }
+        }
+        if (!selection.empty()) {
             int moveDistance = 10;
 
             switch (wParam) {
             case VK_LEFT:
-                selectedShape->move(-moveDistance, 0);
+                TransformSelection(journal, selection, MyShapes::Affine::translation(-moveDistance, 0));
                 break;
             case VK_RIGHT:
-                selectedShape->move(moveDistance, 0);
+                TransformSelection(journal, selection, MyShapes::Affine::translation(moveDistance, 0));
                 break;
             case VK_UP:
-                selectedShape->move(0, -moveDistance);
+                TransformSelection(journal, selection, MyShapes::Affine::translation(0, -moveDistance));
                 break;
             case VK_DOWN:
-                selectedShape->move(0, moveDistance);
+                TransformSelection(journal, selection, MyShapes::Affine::translation(0, moveDistance));
                 break;
             case VK_DELETE:
-            {
-                auto it = std::find(shapes.begin(), shapes.end(), selectedShape);
-                if (it != shapes.end()) {
-                    delete* it;               // Удаляем объект из памяти
-                    shapes.erase(it);          // Удаляем указатель из вектора
+                // Фигуры уходят из сцены в журнал и возвращаются отменой
+                // уже без цвета выделения
+                for (MyShapes::Shape* shape : selection.getShapes()) {
+                    MarkSelected(scene, shape, false);
                 }
-                selectedShape = nullptr;       // Сбрасываем указатель
+                journal.remove(selection.getShapes());
+                selection.clear();
                 break;
             }
-
-            }
-            InvalidateRect(hwnd, NULL, TRUE);
+            InvalidateDamage(hwnd, scene, nullptr); // Статический слой выделенные фигуры не затрагивают
         }
         break;
 
+    case WM_ERASEBKGND:
+        return 1; // Фон стирает WM_PAINT, и только в перерисовываемой области
+
     case WM_PAINT:
+    {
         hdc = BeginPaint(hwnd, &ps);
-        for (MyShapes::Shape* shape : shapes) {
-            // Проверяем тип фигуры перед рисованием
-            if ((dynamic_cast<MyShapes::Line*>(shape) && showLines) ||
-                (dynamic_cast<MyShapes::Circle*>(shape) && showCircles) ||
-                (dynamic_cast<MyShapes::Arc*>(shape) && showArcs) ||
-                (dynamic_cast<MyShapes::Ring*>(shape) && showRings) ||
-                (dynamic_cast<MyShapes::Polyline*>(shape) && showPolylines) ||
-                (dynamic_cast<MyShapes::Polygon*>(shape) && showPolygons) ||
-                (dynamic_cast<MyShapes::Triangle*>(shape) && showTriangles) ||
-                (dynamic_cast<MyShapes::Parallelogram*>(shape) && showParallelograms)) {
-                shape->draw(hdc);
+
+        RECT client;
+        GetClientRect(hwnd, &client);
+        backBuffer.ensureSize(hdc, client.right, client.bottom);
+
+        // Статический слой: невыделенные фигуры, только в устаревших областях
+        backBuffer.updateStatic([&](HDC layerDC, const RECT& area) {
+            GdiRenderer gdi(layerDC, gdiObjects); // Восстанавливает перо контекста при выходе из блока
+            MyShapes::BatchRenderer renderer(gdi); // Отрезки фигур уходят пакетами через PolyPolyline
+
+            if (document.isOpen()) {
+                // Фигуры документа ещё не созданы: рисуем из отображения файла
+                document.draw(renderer, FromWindowRect(area).inflated(1), visibleKinds);
+                return;
+            }
+
+            static std::vector<MyShapes::Shape*> visible;
+            // Скрытые виды отсекаются ещё в пространственном индексе
+            scene.collect(FromWindowRect(area).inflated(1), visible, visibleKinds);
+            for (MyShapes::Shape* shape : visible) {
+                if (!selection.contains(shape)) {
+                    shape->draw(renderer);
+                }
+            }
+        });
+
+        // Динамический слой поверх копии статического: выделение и построение
+        HDC frameDC = backBuffer.beginFrame(ps.rcPaint);
+        {
+            GdiRenderer gdi(frameDC, gdiObjects);
+            MyShapes::BatchRenderer renderer(gdi);
+            MyShapes::Rect paintArea = FromWindowRect(ps.rcPaint);
+            for (MyShapes::Shape* shape : selection.getShapes()) {
+                if (shape->bounds().intersects(paintArea)) {
+                    shape->draw(renderer);
+                }
+            }
+            DrawIntersections(renderer, intersections);
+            DrawConstruction(renderer, construction);
+            if (dragging) {
+                DrawRegion(renderer, dragPath, dragLasso);
             }
         }
+        backBuffer.present(hdc, ps.rcPaint);
+
         EndPaint(hwnd, &ps);
         break;
+    }
+
+    case WM_TIMER:
+        if (wParam == LoadTimer) finishOpen();
+        break;
 
     case WM_SIZE:
         // Установка размеров статус-бара при изменении размеров окна
@@ -1099,9 +1062,9 @@ LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         break;
 
     case WM_DESTROY:
-        for (MyShapes::Shape* shape : shapes) {
-            delete shape;
-        }
+        journal.clear();
+        scene.clear();
+        gdiObjects.clear();
         PostQuitMessage(0);
         break;
 
@@ -41,3 +41,17 @@
 #define IDR_CONTEXT_MENU                129
 
 #define IDM_TRIM_SELECTED             32791
+#define IDM_PRECISION_MODE            32792
+#define IDM_FILE_OPEN                 32793
+#define IDM_FILE_SAVE                 32794
+#define IDM_FILE_IMPORT               32795
+#define IDM_FILE_EXPORT               32796
+#define IDM_EDIT_UNDO                 32797
+#define IDM_EDIT_REDO                 32798
+#define IDM_EDIT_COPY                 32799
+#define IDM_EDIT_PASTE                32800
+#define IDM_TRIM_ALL                  32801
+#define IDM_SHOW_INTERSECTIONS        32802
+#define IDM_CLIP_SELECTED             32803
+#define IDM_SUBTRACT_SELECTED         32804
+#define IDM_MERGE_SELECTED            32805
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Минимальный каркас замеров: каждый BENCH_CASE регистрируется сам
+// и запускается из BenchMain.cpp (по имени или все подряд).
+namespace Bench {
+
+    typedef void (*BenchFn)();
+
+    struct Registrar {
+        Registrar(const char* name, BenchFn fn);
+    };
+
+    // Множитель размера задач (--scale=N), по умолчанию 1
+    int scale();
+
+    // Детерминированный генератор, чтобы прогоны были сравнимы
+    class Random {
+        uint64_t state;
+    public:
+        explicit Random(uint64_t seed = 42) : state(seed) {}
+
+        uint32_t next() {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return (uint32_t)state;
+        }
+
+        int range(int lo, int hi) { return lo + (int)(next() % (uint32_t)(hi - lo + 1)); }
+    };
+
+    // Время выполнения fn в миллисекундах
+    template <typename F>
+    double measureMs(F&& fn) {
+        auto begin = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - begin).count();
+    }
+
+    void report(const std::string& name, double ms, long long items);
+
+    // Проверка корректности результата; провал даёт ненулевой код выхода
+    void check(bool condition, const std::string& what);
+
+    // Не даёт компилятору выбросить вычисления
+    void consume(long long value);
+}
+
+#define BENCH_CASE(name) \
+    static void name(); \
+    static Bench::Registrar name##_registrar(#name, name); \
+    static void name()
@@ -0,0 +1,100 @@
+#include "BenchScene.h"
+#include "Scene.h"
+
+using namespace MyShapes;
+
+// Загрузка и закрытие документа из миллиона фигур: каждая фигура и массив
+// её вершин отдельно в куче против арены документа
+BENCH_CASE(arenaLoadTeardown) {
+    const int count = 1000000 * Bench::scale();
+    const int world = 50000;
+
+    std::vector<Shape*> heap;
+    double heapLoadMs = Bench::measureMs([&] {
+        heap = Bench::makeScene(count, world);
+    });
+    Bench::report("load, heap", heapLoadMs, count);
+
+    ShapeArena arena;
+    std::vector<Shape*> pooled;
+    double arenaLoadMs = Bench::measureMs([&] {
+        pooled = Bench::makeScene(count, world, 42, &arena);
+    });
+    Bench::report("load, arena", arenaLoadMs, count);
+
+    Bench::CountingRenderer heapDrawn, arenaDrawn;
+    for (Shape* shape : heap) shape->draw(heapDrawn);
+    for (Shape* shape : pooled) shape->draw(arenaDrawn);
+    Bench::check(heapDrawn.digest == arenaDrawn.digest, "arena shapes match heap shapes");
+
+    double heapFreeMs = Bench::measureMs([&] {
+        Bench::destroyScene(heap);
+    });
+    Bench::report("teardown, heap", heapFreeMs, count);
+
+    double arenaFreeMs = Bench::measureMs([&] {
+        arena.release();
+        pooled.clear();
+    });
+    Bench::report("teardown, arena", arenaFreeMs, count);
+    Bench::check(arena.size() == 0, "arena is empty after release");
+}
+
+// Только выделение памяти: та же последовательность запросов, что при загрузке
+// сцены (объект фигуры и массив вершин), без конструирования фигур
+BENCH_CASE(arenaAllocatorOnly) {
+    const int count = 1000000 * Bench::scale();
+
+    std::vector<size_t> sizes;
+    Bench::generateScene(count, 50000, 42, [&](auto tag, auto&&... args) {
+        typedef typename decltype(tag)::type T;
+        sizes.push_back(sizeof(T));
+        if constexpr (std::is_base_of<Polyline, T>::value) {
+            T probe(args...);
+            sizes.push_back(probe.points.size() * sizeof(Point));
+        }
+    });
+
+    // Арена первой: освобождённые мелкие блоки кучи malloc сливает лениво,
+    // при следующем крупном запросе, и это время досталось бы арене
+    std::vector<void*> blocks(sizes.size());
+    ShapeArena arena;
+    double arenaMs = Bench::measureMs([&] {
+        for (size_t i = 0; i < sizes.size(); ++i) blocks[i] = arena.allocate(sizes[i], alignof(std::max_align_t));
+        arena.release();
+    });
+    Bench::report("arena allocate/release", arenaMs, (long long)sizes.size());
+
+    double heapMs = Bench::measureMs([&] {
+        for (size_t i = 0; i < sizes.size(); ++i) blocks[i] = ::operator new(sizes[i]);
+        for (size_t i = 0; i < sizes.size(); ++i) ::operator delete(blocks[i]);
+    });
+    Bench::report("operator new/delete", heapMs, (long long)sizes.size());
+    Bench::check(arenaMs * 10 < heapMs, "arena allocation is an order of magnitude cheaper");
+}
+
+// То же через документ редактора: Scene::add(new ...) против Scene::create
+BENCH_CASE(arenaSceneLoadClear) {
+    const int count = 1000000 * Bench::scale();
+    const int world = 50000;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        bool useArena = pass == 1;
+        Scene scene;
+
+        double loadMs = Bench::measureMs([&] {
+            Bench::generateScene(count, world, 42, [&](auto tag, auto&&... args) {
+                typedef typename decltype(tag)::type T;
+                if (useArena) scene.create<T>(args...);
+                else scene.add(new T(args...));
+            });
+        });
+        Bench::report(useArena ? "scene load, create" : "scene load, add(new)", loadMs, count);
+
+        double clearMs = Bench::measureMs([&] {
+            scene.clear();
+        });
+        Bench::report(useArena ? "scene clear, arena" : "scene clear, heap", clearMs, count);
+        Bench::check(scene.size() == 0, "scene is empty after clear");
+    }
+}
@@ -0,0 +1,225 @@
+#include "BenchScene.h"
+#include "EditJournal.h"
+#include "Intersect.h"
+#include "PolygonBoolean.h"
+#include "Scene.h"
+#include "ThreadPool.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace MyShapes;
+
+namespace {
+
+    Contour box(int left, int bottom, int right, int top) {
+        return Contour{ { left, bottom }, { right, bottom }, { right, top }, { left, top } };
+    }
+
+    // Звёздный многоугольник: вершины по возрастанию угла, радиус случаен
+    // от (1 - spread) * radius до radius; чем больше spread, тем больше пересечений
+    Contour makeStar(Bench::Random& rnd, int cx, int cy, int radius, int count, double spread = 0.5) {
+        Contour star;
+        for (int k = 0; k < count; ++k) {
+            double angle = 2 * M_PI * (k + rnd.range(0, 800) / 1000.0) / count;
+            double r = radius * (1 - spread * rnd.range(0, 1000) / 1000.0);
+            star.push_back(Vertex{ cx + (int)lrint(r * cos(angle)), cy + (int)lrint(r * sin(angle)) });
+        }
+        return star;
+    }
+
+    // Площадь со знаком: дыры (по часовой) вычитаются
+    double areaOf(const std::vector<Contour>& contours) {
+        double area = 0;
+        for (const Contour& c : contours) {
+            for (size_t i = 0, n = c.size(); i < n; ++i) {
+                area += (double)c[i].x * c[(i + 1) % n].y - (double)c[(i + 1) % n].x * c[i].y;
+            }
+        }
+        return area / 2;
+    }
+
+    double areaOf(const Contour& contour) {
+        return std::fabs(areaOf(std::vector<Contour>{ contour }));
+    }
+
+    bool inside(double x, double y, const std::vector<Contour>& contours) {
+        bool in = false;
+        for (const Contour& c : contours) {
+            if (pointInPolygon(x, y, c.data(), c.size())) in = !in;
+        }
+        return in;
+    }
+
+    std::vector<Contour> run(const Contour& a, const Contour& b, BooleanOp op) {
+        std::vector<Contour> result;
+        polygonBoolean(a.data(), a.size(), b.data(), b.size(), op, result);
+        return result;
+    }
+
+    bool near(double value, double expected, double tolerance) {
+        return std::fabs(value - expected) <= tolerance;
+    }
+
+    // Все три операции над a и b: площади сходятся, случайные точки
+    // (кроме единиц у самой границы из-за округления) попадают куда нужно
+    void checkOperations(const Contour& a, const Contour& b, Bench::Random& rnd, int world, const char* label) {
+        std::vector<Contour> united = run(a, b, BooleanOp::Union);
+        std::vector<Contour> common = run(a, b, BooleanOp::Intersection);
+        std::vector<Contour> rest = run(a, b, BooleanOp::Difference);
+        double areaA = areaOf(a), areaB = areaOf(b);
+        double tolerance = 1e-4 * (areaA + areaB);
+        printf("  %s: %zu / %zu / %zu contours\n", label, united.size(), common.size(), rest.size());
+
+        char message[128];
+        snprintf(message, sizeof(message), "%s: union + intersection = A + B", label);
+        Bench::check(near(areaOf(united) + areaOf(common), areaA + areaB, tolerance), message);
+        snprintf(message, sizeof(message), "%s: difference = A - intersection", label);
+        Bench::check(near(areaOf(rest), areaA - areaOf(common), tolerance), message);
+
+        int wrong = 0;
+        const int samples = 4000;
+        for (int i = 0; i < samples; ++i) {
+            double x = rnd.range(0, world) + 0.37, y = rnd.range(0, world) + 0.61;
+            bool inA = pointInPolygon(x, y, a.data(), a.size());
+            bool inB = pointInPolygon(x, y, b.data(), b.size());
+            if (inside(x, y, united) != (inA || inB)) ++wrong;
+            if (inside(x, y, common) != (inA && inB)) ++wrong;
+            if (inside(x, y, rest) != (inA && !inB)) ++wrong;
+        }
+        snprintf(message, sizeof(message), "%s: sample points classified correctly", label);
+        Bench::check(wrong <= samples / 200, message);
+    }
+
+    bool sameContours(const std::vector<Contour>& a, const std::vector<Contour>& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i].size() != b[i].size()) return false;
+            for (size_t j = 0; j < a[i].size(); ++j) {
+                if (a[i][j].x != b[i][j].x || a[i][j].y != b[i][j].y) return false;
+            }
+        }
+        return true;
+    }
+
+    uint64_t digestOf(const std::vector<Shape*>& shapes) {
+        Bench::CountingRenderer renderer;
+        for (Shape* shape : shapes) shape->draw(renderer);
+        return renderer.digest;
+    }
+
+}
+
+// Объединение, пересечение и разность многоугольников: вырожденные случаи,
+// большие звёзды (пары рёбер ищет заметание), пакет пар на пуле, замена
+// фигур результатом с отменой
+BENCH_CASE(polygonBoolean) {
+    // Перекрытие, общее ребро, вершина на ребре, дыра
+    {
+        Contour a = box(0, 0, 100, 100);
+        Contour b = box(50, 50, 150, 150);
+        Bench::check(areaOf(run(a, b, BooleanOp::Union)) == 17500 && run(a, b, BooleanOp::Union).size() == 1,
+            "overlapping squares unite");
+        Bench::check(areaOf(run(a, b, BooleanOp::Intersection)) == 2500, "overlapping squares intersect");
+        Bench::check(areaOf(run(a, b, BooleanOp::Difference)) == 7500, "overlapping squares subtract");
+
+        std::vector<Contour> united = run(a, box(100, 0, 200, 100), BooleanOp::Union);
+        Bench::check(united.size() == 1 && united[0].size() == 4 && areaOf(united) == 20000,
+            "squares with a shared edge merge into one rectangle");
+        Bench::check(run(a, box(100, 0, 200, 100), BooleanOp::Intersection).empty(),
+            "squares with a shared edge do not intersect");
+        united = run(a, box(100, 50, 200, 150), BooleanOp::Union);
+        Bench::check(united.size() == 1 && areaOf(united) == 20000, "partly shared edge merges");
+
+        Contour touching{ { 100, 50 }, { 200, 0 }, { 200, 100 } };
+        Bench::check(areaOf(run(a, touching, BooleanOp::Union)) == 15000, "vertex on an edge unites");
+        Bench::check(run(a, touching, BooleanOp::Intersection).empty(), "vertex on an edge does not intersect");
+
+        Contour outer = box(0, 0, 300, 300), hole = box(100, 100, 200, 200);
+        std::vector<Contour> rest = run(outer, hole, BooleanOp::Difference);
+        Bench::check(rest.size() == 2 && areaOf(rest) == 80000, "difference leaves a hole");
+        Bench::check(areaOf(run(outer, hole, BooleanOp::Intersection)) == 10000, "clip by an inner square");
+        Bench::check(areaOf(run(outer, hole, BooleanOp::Union)) == 90000, "union with an inner square");
+    }
+
+    // Малые звёзды - перебор пар рёбер, большие - заметание
+    {
+        Bench::Random rnd(25);
+        const int world = 200000;
+        checkOperations(makeStar(rnd, 90000, 100000, 80000, 40), makeStar(rnd, 110000, 100000, 80000, 50),
+            rnd, world, "stars 40 x 50");
+        checkOperations(makeStar(rnd, 95000, 100000, 90000, 3000), makeStar(rnd, 105000, 100000, 90000, 3000),
+            rnd, world, "stars 3000 x 3000");
+        checkOperations(makeStar(rnd, 100000, 100000, 90000, 200), makeStar(rnd, 100000, 100000, 60000, 5000),
+            rnd, world, "stars 200 x 5000");
+
+        Contour big = makeStar(rnd, 100000, 100000, 90000, 20000 * Bench::scale(), 0.1);
+        Contour other = makeStar(rnd, 110000, 100000, 90000, 20000 * Bench::scale(), 0.1);
+        std::vector<Contour> result;
+        double ms = Bench::measureMs([&] {
+            polygonBoolean(big.data(), big.size(), other.data(), other.size(), BooleanOp::Intersection, result);
+        });
+        Bench::report("intersect two 20k-vertex stars", ms, big.size() + other.size());
+        printf("  %zu contours\n", result.size());
+    }
+
+    // Пакет пар: последовательно и на пуле
+    {
+        Bench::Random rnd(7);
+        const int count = 4000 * Bench::scale();
+        std::vector<Contour> subjects, clips;
+        for (int i = 0; i < count; ++i) {
+            int cx = rnd.range(0, 10000), cy = rnd.range(0, 10000);
+            subjects.push_back(makeStar(rnd, cx, cy, 500, 64, 0.2));
+            clips.push_back(makeStar(rnd, cx + rnd.range(-300, 300), cy + rnd.range(-300, 300), 500, 64, 0.2));
+        }
+        std::vector<BooleanTask> tasks(count);
+        for (int i = 0; i < count; ++i) {
+            tasks[i].subject = &subjects[i];
+            tasks[i].clip = &clips[i];
+            tasks[i].op = BooleanOp::Difference;
+        }
+
+        std::vector<std::vector<Contour>> serial(count);
+        double ms = Bench::measureMs([&] {
+            for (int i = 0; i < count; ++i) {
+                polygonBoolean(subjects[i].data(), subjects[i].size(), clips[i].data(), clips[i].size(),
+                    BooleanOp::Difference, serial[i]);
+            }
+        });
+        Bench::report("difference of star pairs, serial", ms, count);
+
+        ThreadPool pool;
+        ms = Bench::measureMs([&] { polygonBooleanBatch(pool, tasks); });
+        Bench::report("difference of star pairs, pool", ms, count);
+        bool same = true;
+        for (int i = 0; i < count; ++i) same = same && sameContours(tasks[i].result, serial[i]);
+        Bench::check(same, "batch on the pool matches the serial results");
+    }
+
+    // Отсечение фигур сцены многоугольником и отмена одной правкой
+    {
+        Scene scene;
+        EditJournal journal(scene);
+        ThreadPool pool;
+        for (Shape* shape : Bench::makeScene(20000 * Bench::scale(), 20000)) scene.add(shape);
+        uint64_t initial = digestOf(scene.getShapes());
+
+        Polygon tool(std::vector<Point>{ Point(2000, 2000), Point(18000, 3000), Point(10000, 18000) });
+        std::vector<Shape*> replaced, pieces;
+        double ms = Bench::measureMs([&] {
+            booleanWithTool(pool, scene.getShapes(), tool, BooleanOp::Difference, replaced, pieces);
+        });
+        Bench::report("subtract a triangle from the scene", ms, scene.size());
+        printf("  %zu polygons replaced by %zu pieces\n", replaced.size(), pieces.size());
+        Bench::check(!replaced.empty(), "subtraction changes polygons under the tool");
+
+        journal.replace(replaced, pieces);
+        uint64_t subtracted = digestOf(scene.getShapes());
+        Bench::check(subtracted != initial, "replace changes the scene");
+        journal.undo();
+        Bench::check(digestOf(scene.getShapes()) == initial, "replace undoes in one step");
+        journal.redo();
+        Bench::check(digestOf(scene.getShapes()) == subtracted, "replace redoes");
+    }
+}
@@ -0,0 +1,149 @@
+﻿#include "BenchScene.h"
+#include "Scene.h"
+#include "SceneFile.h"
+
+#include <cmath>
+#include <cstdio>
+
+using namespace MyShapes;
+
+namespace {
+
+    // Звезда из count вершин: вогнутый многоугольник
+    std::vector<Point> makeStar(int count, int cx, int cy, int radius) {
+        std::vector<Point> points;
+        points.reserve(count);
+        for (int k = 0; k < count; ++k) {
+            double angle = 2 * M_PI * k / count;
+            double r = radius * (1 + 0.3 * sin(37 * angle));
+            points.push_back(Point(cx + (int)lrint(r * cos(angle)), cy + (int)lrint(r * sin(angle))));
+        }
+        return points;
+    }
+
+    std::vector<Point> pointsOf(const Shape& shape) {
+        std::vector<Vertex> anchors;
+        shape.writeAnchors(anchors);
+        std::vector<Point> points;
+        points.reserve(anchors.size());
+        for (const Vertex& v : anchors) points.push_back(Point(v.x, v.y));
+        return points;
+    }
+
+    uint64_t digestOf(const std::vector<Shape*>& shapes) {
+        Bench::CountingRenderer renderer;
+        for (Shape* shape : shapes) shape->draw(renderer);
+        return renderer.digest;
+    }
+
+    Rect boundsOfAnchors(const Shape& shape) {
+        std::vector<Vertex> anchors;
+        shape.writeAnchors(anchors);
+        Rect r;
+        for (const Vertex& v : anchors) r.include(v.x, v.y);
+        return r;
+    }
+
+}
+
+// Тысяча копий многоугольника из 10 000 вершин: экземпляры общей геометрии
+// против полных копий - память, копирование, рисование и попадание
+BENCH_CASE(copyInstances) {
+    const int vertexCount = 10000;
+    const int copies = 1000 * Bench::scale();
+    const std::vector<Point> star = makeStar(vertexCount, 2000, 2000, 1500);
+    Polygon original(star);
+    Bench::Random rnd(5);
+
+    std::vector<Shape*> instances, deep;
+    instances.reserve(copies);
+    deep.reserve(copies);
+    double ms = Bench::measureMs([&] {
+        for (int i = 0; i < copies; ++i) instances.push_back(original.copy());
+    });
+    Bench::report("copy() as instance", ms, copies);
+    ms = Bench::measureMs([&] {
+        for (int i = 0; i < copies; ++i) deep.push_back(new Polygon(star));
+    });
+    Bench::report("full copy", ms, copies);
+
+    size_t instanceBytes = (size_t)vertexCount * sizeof(Vertex) * 2 + copies * sizeof(Polygon);
+    size_t deepBytes = (size_t)copies * (sizeof(Polygon) + vertexCount * sizeof(Point));
+    printf("  instances ~%.2f MB (one shared array), full copies ~%.1f MB\n", instanceBytes / 1e6, deepBytes / 1e6);
+    Bench::check(instances[0]->isInstance() && !original.isInstance(), "copy() of a polygon is an instance");
+
+    // Сдвиг и отражение экземпляра дают те же вершины, что у полной копии
+    for (int i = 0; i < copies; ++i) {
+        int dx = rnd.range(-5000, 5000), dy = rnd.range(-5000, 5000);
+        instances[i]->move(dx, dy);
+        deep[i]->move(dx, dy);
+        if (i % 3 == 0) {
+            instances[i]->mirror(i % 2 == 0);
+            deep[i]->mirror(i % 2 == 0);
+        }
+    }
+    Bench::check(digestOf(instances) == digestOf(deep), "moved and mirrored instances draw like full copies");
+
+    ms = Bench::measureMs([&] { digestOf(instances); });
+    Bench::report("draw instances", ms, copies);
+    ms = Bench::measureMs([&] { digestOf(deep); });
+    Bench::report("draw full copies", ms, copies);
+
+    // Габарит по оболочке совпадает с габаритом всех вершин и после поворота
+    bool boundsExact = true;
+    for (int i = 0; i < copies; i += 7) {
+        instances[i]->rotate(rnd.range(1, 359));
+        if (!(instances[i]->bounds() == boundsOfAnchors(*instances[i]))) boundsExact = false;
+    }
+    Bench::check(boundsExact, "instance bounds from the hull are exact");
+
+    // Попадание по экземпляру - как по многоугольнику из тех же вершин
+    bool hitsAgree = true;
+    for (int i = 0; i < copies && hitsAgree; i += 50) {
+        Polygon materialized(pointsOf(*instances[i]));
+        Rect box = instances[i]->bounds();
+        for (int k = 0; k < 200; ++k) {
+            int x = rnd.range(box.left - 10, box.right + 10), y = rnd.range(box.top - 10, box.bottom + 10);
+            if (instances[i]->isClicked(x, y) != materialized.isClicked(x, y)) hitsAgree = false;
+        }
+    }
+    Bench::check(hitsAgree, "hit test on an instance matches its vertices");
+
+    // Поворот копит матрицу: 36 поворотов на 10 градусов возвращают копию на место
+    {
+        Shape* spun = original.copy();
+        uint64_t before = digestOf({ spun });
+        for (int k = 0; k < 36; ++k) spun->rotate(10);
+        Bench::check(spun->isInstance() && digestOf({ spun }) == before, "rotating an instance does not accumulate error");
+        delete spun;
+    }
+
+    // Обрезка даёт копии свои вершины и не трогает остальные
+    {
+        uint64_t others = digestOf(std::vector<Shape*>(instances.begin() + 1, instances.end()));
+        Rect box = instances[0]->bounds();
+        int middle = (box.left + box.right) / 2;
+        instances[0]->trim(Point(middle, box.top - 10), Point(middle, box.bottom + 10));
+        Bench::check(!instances[0]->isInstance() &&
+            digestOf(std::vector<Shape*>(instances.begin() + 1, instances.end())) == others,
+            "trim copies the vertices on write");
+    }
+
+    // Документ с экземплярами сохраняется и читается как обычный
+    {
+        const char* path = "shapes_bench_instances.bin";
+        Scene scene;
+        for (Shape* shape : instances) scene.add(shape->copy());
+        uint64_t expected = digestOf(scene.getShapes());
+        bool saved = SceneFile::save(path, scene.getShapes());
+        Scene loaded;
+        SceneFile file;
+        bool opened = saved && file.open(path);
+        if (opened) file.loadInto(loaded);
+        Bench::check(opened && digestOf(loaded.getShapes()) == expected, "instances save and load as plain polygons");
+        remove(path);
+    }
+
+    Bench::destroyScene(instances);
+    Bench::destroyScene(deep);
+}
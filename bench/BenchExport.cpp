@@ -0,0 +1,207 @@
+#include "BenchScene.h"
+#include "Scene.h"
+#include "VectorExport.h"
+#include "VectorImport.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace MyShapes;
+
+namespace {
+
+    long long fileSize(const char* path) {
+        long long bytes = 0;
+        if (FILE* file = fopen(path, "rb")) {
+            fseek(file, 0, SEEK_END);
+            bytes = ftell(file);
+            fclose(file);
+        }
+        return bytes;
+    }
+
+    uint64_t digestOf(Shape* shape) {
+        Bench::CountingRenderer renderer;
+        shape->draw(renderer);
+        return renderer.digest;
+    }
+
+    bool boundsClose(const Rect& a, const Rect& b) {
+        return abs(a.left - b.left) <= 2 && abs(a.top - b.top) <= 2 &&
+            abs(a.right - b.right) <= 2 && abs(a.bottom - b.bottom) <= 2;
+    }
+
+    // Сверяет сцену с тем, что вернул импорт экспортированного файла. Кольцо
+    // приходит двумя окружностями, треугольник и параллелограмм - многоугольником,
+    // поэтому сравниваются нарисованные примитивы. Дуги проходят через текстовые
+    // углы и сравниваются по габариту.
+    bool sameDrawing(const std::vector<Shape*>& expected, const std::vector<Shape*>& imported) {
+        size_t j = 0;
+        for (Shape* shape : expected) {
+            if (shape->kind() == ShapeKind::Ring) {
+                Ring* ring = static_cast<Ring*>(shape);
+                Bench::CountingRenderer a, b;
+                ring->draw(a);
+                if (j + 2 > imported.size()) return false;
+                imported[j]->draw(b);
+                imported[j + 1]->draw(b);
+                if (a.digest != b.digest) return false;
+                j += 2;
+                continue;
+            }
+            if (j >= imported.size()) return false;
+            Shape* other = imported[j++];
+            if (shape->kind() == ShapeKind::Arc) {
+                if (shape->getColor() != other->getColor() || !boundsClose(shape->bounds(), other->bounds())) return false;
+            }
+            else if (digestOf(shape) != digestOf(other)) {
+                return false;
+            }
+        }
+        return j == imported.size();
+    }
+
+    // Проверка структуры PDF: startxref ведёт на таблицу, записи таблицы - на объекты
+    bool validPdf(const char* path) {
+        FILE* file = fopen(path, "rb");
+        if (!file) return false;
+        std::vector<char> data((size_t)fileSize(path));
+        bool read = fread(data.data(), 1, data.size(), file) == data.size();
+        fclose(file);
+        if (!read || data.size() < 64 || memcmp(data.data(), "%PDF-", 5) != 0) return false;
+
+        std::string tail(data.end() - 64, data.end());
+        size_t at = tail.rfind("startxref\n");
+        if (at == std::string::npos) return false;
+        size_t xref = (size_t)atoll(tail.c_str() + at + 10);
+        if (xref + 20 > data.size() || memcmp(data.data() + xref, "xref\n0 6\n", 9) != 0) return false;
+
+        for (int i = 1; i <= 5; ++i) {
+            const char* entry = data.data() + xref + 9 + 20 * i;
+            size_t offset = (size_t)atoll(entry);
+            char header[16];
+            int length = snprintf(header, sizeof(header), "%d 0 obj", i);
+            if (offset + length > data.size() || memcmp(data.data() + offset, header, length) != 0) return false;
+        }
+        return true;
+    }
+
+}
+
+// Миллион фигур в SVG, DXF и PDF через один буфер вывода. Для сравнения -
+// запись того же объёма готовых байт: экспорт должен упираться в неё,
+// а не в форматирование
+BENCH_CASE(vectorExport) {
+    const int count = 1000000 * Bench::scale();
+    const int world = 50000;
+
+    std::vector<Shape*> shapes = Bench::makeScene(count, world);
+
+    struct Run {
+        const char* name;
+        const char* path;
+        ExportFormat format;
+    };
+    const Run runs[] = {
+        { "svg", "shapes_bench_export.svg", ExportFormat::Svg },
+        { "dxf", "shapes_bench_export.dxf", ExportFormat::Dxf },
+        { "pdf", "shapes_bench_export.pdf", ExportFormat::Pdf },
+    };
+
+    VectorExporter exporter;
+    std::vector<char> block(1 << 20, 'x');
+    for (const Run& run : runs) {
+        bool ok = false;
+        double ms = Bench::measureMs([&] { ok = exporter.exportFile(run.path, run.format, shapes); });
+        uint64_t bytes = exporter.bytesWritten();
+        Bench::report(run.name, ms, count);
+        Bench::check(ok && (long long)bytes == fileSize(run.path), "file is written completely");
+
+        // Те же байты одним fwrite за другим
+        double rawMs = Bench::measureMs([&] {
+            if (FILE* file = fopen("shapes_bench_raw.bin", "wb")) {
+                for (uint64_t left = bytes; left > 0;) {
+                    size_t n = (size_t)std::min<uint64_t>(left, block.size());
+                    fwrite(block.data(), 1, n, file);
+                    left -= n;
+                }
+                fclose(file);
+            }
+        });
+        printf("  %.1f MB, %.0f MB/s; raw write of the same size %.1f ms (%.0f MB/s)\n",
+            bytes / 1e6, bytes / 1e3 / ms, rawMs, bytes / 1e3 / rawMs);
+    }
+    remove("shapes_bench_raw.bin");
+
+    // SVG и DXF читаются обратно импортом
+    for (int i = 0; i < 2; ++i) {
+        Scene scene;
+        VectorImporter importer;
+        ImportResult result = importer.importFile(runs[i].path, scene);
+        Bench::check(result.ok && result.skipped == 0 && sameDrawing(shapes, scene.getShapes()),
+            i == 0 ? "svg export imports back to the same drawing" : "dxf export imports back to the same drawing");
+    }
+    Bench::check(validPdf(runs[2].path), "pdf cross-reference table points at every object");
+
+    for (const Run& run : runs) remove(run.path);
+    Bench::destroyScene(shapes);
+}
+
+// DXF пишется как R12 ($ACADVER AC1009): цвет - номером ACI в группе 62,
+// группы 420 там нет. Цвета палитры проходят туда и обратно без потерь,
+// остальные - ближайшим цветом палитры
+BENCH_CASE(dxfColors) {
+    std::vector<Shape*> shapes;
+    std::vector<Color> expected;
+    for (int i = 1; i < 256; ++i) {
+        shapes.push_back(new Line(Point(0, i), Point(100, i)));
+        shapes.back()->setColor(aciColor(i));
+        expected.push_back(aciColor(i));
+    }
+    const Color offPalette[] = { makeColor(250, 10, 5), makeColor(20, 90, 200), makeColor(255, 255, 255) };
+    for (Color color : offPalette) {
+        shapes.push_back(new Line(Point(0, 300), Point(100, 300 + (int)expected.size())));
+        shapes.back()->setColor(color);
+        expected.push_back(aciColor(nearestAci(color)));
+    }
+
+    const char* path = "shapes_bench_colors.dxf";
+    VectorExporter exporter;
+    bool ok = exporter.exportFile(path, ExportFormat::Dxf, shapes);
+
+    std::string text((size_t)fileSize(path), '\0');
+    if (FILE* file = fopen(path, "rb")) {
+        ok = fread(&text[0], 1, text.size(), file) == text.size() && ok;
+        fclose(file);
+    }
+    // Коды групп - каждая вторая строка, начиная с первой
+    bool trueColor = false;
+    bool code = true;
+    for (size_t at = 0; at < text.size();) {
+        size_t end = text.find('\n', at);
+        if (end == std::string::npos) end = text.size();
+        if (code && text.compare(at, end - at, "420") == 0) trueColor = true;
+        code = !code;
+        at = end + 1;
+    }
+    Bench::check(ok && text.find("AC1009") != std::string::npos && !trueColor,
+        "R12 file carries no true-colour groups");
+
+    Scene scene;
+    VectorImporter importer;
+    ImportResult result = importer.importFile(path, scene);
+    std::vector<Shape*> imported = scene.getShapes();
+    bool same = result.ok && imported.size() == expected.size();
+    for (size_t i = 0; same && i < expected.size(); ++i) {
+        same = imported[i]->getColor() == expected[i];
+    }
+    Bench::check(same, "palette colours survive export, others snap to the nearest");
+    for (Color color : offPalette) {
+        printf("  rgb(%d, %d, %d) -> ACI %d\n", colorRed(color), colorGreen(color), colorBlue(color), nearestAci(color));
+    }
+
+    remove(path);
+    Bench::destroyScene(shapes);
+}
@@ -0,0 +1,85 @@
+#include "BenchScene.h"
+#include "Scene.h"
+#include "SceneFile.h"
+
+#include <cstdio>
+
+using namespace MyShapes;
+
+// Миллион фигур: запись документа, открытие через отображение в память,
+// отрисовка прямо из файла и разбор в фигуры сцены для правки
+BENCH_CASE(sceneFileSaveLoad) {
+    const int count = 1000000 * Bench::scale();
+    const int world = 50000;
+    const char* path = "shapes_bench.msh";
+
+    std::vector<Shape*> shapes = Bench::makeScene(count, world);
+
+    bool saved = false;
+    double saveMs = Bench::measureMs([&] { saved = SceneFile::save(path, shapes); });
+    Bench::check(saved, "document is written");
+
+    long long bytes = 0;
+    if (FILE* file = fopen(path, "rb")) {
+        fseek(file, 0, SEEK_END);
+        bytes = ftell(file);
+        fclose(file);
+    }
+    Bench::report("save", saveMs, count);
+    printf("  %.1f MB, %.0f MB/s, %.1f bytes per shape\n",
+        bytes / 1e6, bytes / 1e3 / saveMs, (double)bytes / count);
+
+    SceneFile file;
+    bool opened = false;
+    double openMs = Bench::measureMs([&] { opened = file.open(path); });
+    Bench::report("open (map and validate)", openMs, count);
+    Bench::check(opened && file.size() == (size_t)count, "document opens with every shape");
+
+    Bench::CountingRenderer objects, mapped;
+    for (Shape* shape : shapes) shape->draw(objects);
+    double drawMs = Bench::measureMs([&] { file.draw(mapped); });
+    Bench::report("paint from the mapping", drawMs, count);
+    printf("  first frame after open: %.1f ms\n", openMs + drawMs);
+    Bench::check(objects.digest == mapped.digest, "mapped document draws the same primitives in the same order");
+
+    // Первый кадр редактора: окно и скрытые линии, как у visibleKinds
+    Rect window(0, 0, 1920, 1080);
+    KindMask visible = AllKinds & ~kindBit(ShapeKind::Line);
+    Bench::CountingRenderer windowObjects, windowMapped;
+    for (Shape* shape : shapes) {
+        if ((visible & kindBit(shape->kind())) && shape->bounds().intersects(window)) shape->draw(windowObjects);
+    }
+    double windowMs = Bench::measureMs([&] { file.draw(windowMapped, window, visible); });
+    printf("  editor's first frame after open: %.1f ms\n", openMs + windowMs);
+    Bench::check(windowObjects.digest == windowMapped.digest, "mapped window skips hidden kinds like the scene");
+
+    Scene scene;
+    double loadMs = Bench::measureMs([&] { file.loadInto(scene); });
+    Bench::report("load into scene", loadMs, count);
+
+    Bench::CountingRenderer loaded;
+    for (Shape* shape : scene.getShapes()) shape->draw(loaded);
+    Bench::check(scene.size() == (size_t)count && objects.digest == loaded.digest, "loaded shapes match the saved ones");
+
+    // Поверх сохранённого: повреждённый заголовок не должен открываться
+    file.close();
+    if (FILE* broken = fopen(path, "r+b")) {
+        fputc('X', broken);
+        fclose(broken);
+    }
+    Bench::check(!file.open(path), "file with a wrong magic is rejected");
+
+    // Параллелограмм не из четырёх вершин: сохраняется как есть, но не открывается
+    {
+        Parallelogram good(std::vector<Point>{ Point(0, 0), Point(10, 0), Point(15, 10), Point(5, 10) });
+        Parallelogram bad(std::vector<Point>{ Point(0, 0), Point(10, 0), Point(15, 10) });
+        SceneFile::save(path, std::vector<Shape*>{ &good });
+        Bench::check(file.open(path), "four-vertex parallelogram opens");
+        file.close();
+        SceneFile::save(path, std::vector<Shape*>{ &good, &bad });
+        Bench::check(!file.open(path), "parallelogram row without four vertices is rejected");
+    }
+
+    remove(path);
+    Bench::destroyScene(shapes);
+}
@@ -0,0 +1,317 @@
+#include "BenchScene.h"
+#include "Scene.h"
+#include "ThreadPool.h"
+#include "VectorImport.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace MyShapes;
+
+namespace {
+
+    // Фигуры, которые переживают SVG и DXF без потерь: отрезки, окружности,
+    // дуги с углами в целых градусах, ломаные и многоугольники
+    std::vector<Shape*> makeVectorScene(int count, int worldSize) {
+        Bench::Random rnd(7);
+        std::vector<Shape*> shapes;
+        shapes.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            Point p(rnd.range(0, worldSize), rnd.range(0, worldSize));
+            int size = rnd.range(4, 40);
+            Shape* shape;
+            switch (i % 5) {
+            case 0:
+                shape = new Line(p, Point(p.x + rnd.range(-size, size), p.y + rnd.range(-size, size)));
+                break;
+            case 1:
+                shape = new Circle(p, size);
+                break;
+            case 2:
+            {
+                int start = rnd.range(0, 359);
+                int span = rnd.range(30, 300);
+                shape = new Arc(p, size, start * M_PI / 180, (start + span) * M_PI / 180);
+                break;
+            }
+            default:
+            {
+                std::vector<Point> points;
+                int n = rnd.range(3, 12);
+                for (int k = 0; k < n; ++k) points.push_back(Point(p.x + rnd.range(-size, size), p.y + rnd.range(-size, size)));
+                if (i % 5 == 3) shape = new Polyline(points);
+                else shape = new Polygon(points);
+                break;
+            }
+            }
+            shape->setColor(makeColor(rnd.range(0, 255), rnd.range(0, 255), rnd.range(0, 255)));
+            shapes.push_back(shape);
+        }
+        return shapes;
+    }
+
+    void writeSvg(const char* path, const std::vector<Shape*>& shapes, int worldSize) {
+        FILE* file = fopen(path, "wb");
+        if (!file) return;
+        fprintf(file, "<?xml version=\"1.0\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\">\n",
+            worldSize, worldSize);
+        fprintf(file, "<defs><circle id=\"unused\" cx=\"0\" cy=\"0\" r=\"5\"/></defs>\n");
+        for (Shape* shape : shapes) {
+            Color c = shape->getColor();
+            char stroke[16];
+            snprintf(stroke, sizeof(stroke), "#%02x%02x%02x", colorRed(c), colorGreen(c), colorBlue(c));
+            switch (shape->kind()) {
+            case ShapeKind::Line:
+            {
+                Line* line = static_cast<Line*>(shape);
+                fprintf(file, "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" stroke=\"%s\"/>\n",
+                    line->getStart().x, line->getStart().y, line->getEnd().x, line->getEnd().y, stroke);
+                break;
+            }
+            case ShapeKind::Circle:
+            {
+                Circle* circle = static_cast<Circle*>(shape);
+                fprintf(file, "<circle cx=\"%d\" cy=\"%d\" r=\"%d\" style=\"fill:none;stroke:%s\"/>\n",
+                    circle->getCenter().x, circle->getCenter().y, circle->getRadius(), stroke);
+                break;
+            }
+            case ShapeKind::Arc:
+            {
+                Arc* arc = static_cast<Arc*>(shape);
+                double span = arc->endAngle - arc->startAngle;
+                fprintf(file, "<path d=\"M%.3f,%.3f A%d,%d 0 %d 1 %.3f,%.3f\" stroke=\"%s\"/>\n",
+                    arc->center.x + arc->radius * cos(arc->startAngle), arc->center.y + arc->radius * sin(arc->startAngle),
+                    arc->radius, arc->radius, span > M_PI ? 1 : 0,
+                    arc->center.x + arc->radius * cos(arc->endAngle), arc->center.y + arc->radius * sin(arc->endAngle), stroke);
+                break;
+            }
+            case ShapeKind::Polyline:
+            {
+                // Ломаная - путем, многоугольник - элементом polygon
+                Polyline* polyline = static_cast<Polyline*>(shape);
+                fprintf(file, "<path stroke=\"%s\" d=\"M", stroke);
+                for (size_t k = 0; k < polyline->points.size(); ++k) {
+                    fprintf(file, k == 0 ? "%d %d" : " L%d %d", polyline->points[k].x, polyline->points[k].y);
+                }
+                fprintf(file, "\"/>\n");
+                break;
+            }
+            default:
+            {
+                Polyline* polygon = static_cast<Polyline*>(shape);
+                fprintf(file, "<polygon stroke=\"%s\" points=\"", stroke);
+                for (const Point& p : polygon->points) fprintf(file, "%d,%d ", p.x, p.y);
+                fprintf(file, "\"/>\n");
+                break;
+            }
+            }
+        }
+        fprintf(file, "</svg>\n");
+        fclose(file);
+    }
+
+    // DXF без $EXTMIN/$EXTMAX: координаты импортируются как есть
+    void writeDxf(const char* path, const std::vector<Shape*>& shapes) {
+        FILE* file = fopen(path, "wb");
+        if (!file) return;
+        fprintf(file, "0\nSECTION\n2\nHEADER\n9\n$ACADVER\n1\nAC1015\n0\nENDSEC\n0\nSECTION\n2\nENTITIES\n");
+        for (Shape* shape : shapes) {
+            Color c = shape->getColor();
+            int rgb = (colorRed(c) << 16) | (colorGreen(c) << 8) | colorBlue(c);
+            switch (shape->kind()) {
+            case ShapeKind::Line:
+            {
+                Line* line = static_cast<Line*>(shape);
+                fprintf(file, "0\nLINE\n8\n0\n420\n%d\n10\n%d\n20\n%d\n30\n0\n11\n%d\n21\n%d\n31\n0\n",
+                    rgb, line->getStart().x, line->getStart().y, line->getEnd().x, line->getEnd().y);
+                break;
+            }
+            case ShapeKind::Circle:
+            {
+                Circle* circle = static_cast<Circle*>(shape);
+                fprintf(file, "0\nCIRCLE\n8\n0\n420\n%d\n10\n%d\n20\n%d\n30\n0\n40\n%d\n",
+                    rgb, circle->getCenter().x, circle->getCenter().y, circle->getRadius());
+                break;
+            }
+            case ShapeKind::Arc:
+            {
+                Arc* arc = static_cast<Arc*>(shape);
+                fprintf(file, "0\nARC\n8\n0\n420\n%d\n10\n%d\n20\n%d\n30\n0\n40\n%d\n50\n%ld\n51\n%ld\n",
+                    rgb, arc->center.x, arc->center.y, arc->radius,
+                    lrint(arc->startAngle * 180 / M_PI), lrint(arc->endAngle * 180 / M_PI));
+                break;
+            }
+            case ShapeKind::Polyline:
+            {
+                // Ломаная - старым POLYLINE с VERTEX, многоугольник - LWPOLYLINE
+                Polyline* polyline = static_cast<Polyline*>(shape);
+                fprintf(file, "0\nPOLYLINE\n8\n0\n420\n%d\n66\n1\n10\n0\n20\n0\n30\n0\n70\n0\n", rgb);
+                for (const Point& p : polyline->points) fprintf(file, "0\nVERTEX\n8\n0\n10\n%d\n20\n%d\n30\n0\n", p.x, p.y);
+                fprintf(file, "0\nSEQEND\n8\n0\n");
+                break;
+            }
+            default:
+            {
+                Polyline* polygon = static_cast<Polyline*>(shape);
+                fprintf(file, "0\nLWPOLYLINE\n8\n0\n420\n%d\n90\n%d\n70\n1\n", rgb, (int)polygon->points.size());
+                for (const Point& p : polygon->points) fprintf(file, "10\n%d\n20\n%d\n", p.x, p.y);
+                break;
+            }
+            }
+        }
+        fprintf(file, "0\nENDSEC\n0\nEOF\n");
+        fclose(file);
+    }
+
+    long long fileSize(const char* path) {
+        long long bytes = 0;
+        if (FILE* file = fopen(path, "rb")) {
+            fseek(file, 0, SEEK_END);
+            bytes = ftell(file);
+            fclose(file);
+        }
+        return bytes;
+    }
+
+    // Отпечаток всех фигур, кроме дуг: у них в SVG другие, но равные углы
+    uint64_t digestWithoutArcs(const std::vector<Shape*>& shapes) {
+        Bench::CountingRenderer renderer;
+        for (Shape* shape : shapes) {
+            if (shape->kind() != ShapeKind::Arc) shape->draw(renderer);
+        }
+        return renderer.digest;
+    }
+
+    uint64_t digestAll(const std::vector<Shape*>& shapes) {
+        Bench::CountingRenderer renderer;
+        for (Shape* shape : shapes) shape->draw(renderer);
+        return renderer.digest;
+    }
+
+    bool arcsClose(const std::vector<Shape*>& expected, const std::vector<Shape*>& actual) {
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (expected[i]->kind() != ShapeKind::Arc) continue;
+            if (actual[i]->kind() != ShapeKind::Arc) return false;
+            Rect a = expected[i]->bounds(), b = actual[i]->bounds();
+            if (abs(a.left - b.left) > 2 || abs(a.top - b.top) > 2 || abs(a.right - b.right) > 2 || abs(a.bottom - b.bottom) > 2) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+}
+
+// Миллион фигур из SVG и DXF: поток порциями по 1 МБ, разбор частей
+// в пуле и пакетная вставка с одной сборкой индекса
+BENCH_CASE(vectorImport) {
+    const int count = 1000000 * Bench::scale();
+    const int world = 50000;
+    const char* svgPath = "shapes_bench.svg";
+    const char* dxfPath = "shapes_bench.dxf";
+
+    std::vector<Shape*> shapes = makeVectorScene(count, world);
+    writeSvg(svgPath, shapes, world);
+    writeDxf(dxfPath, shapes);
+    uint64_t expectedAll = digestAll(shapes);
+    uint64_t expectedWithoutArcs = digestWithoutArcs(shapes);
+
+    ThreadPool pool;
+    printf("  %d threads\n", pool.size());
+
+    struct Run {
+        const char* name;
+        const char* path;
+        ThreadPool* pool;
+    };
+    const Run runs[] = {
+        { "svg, one thread", svgPath, nullptr },
+        { "svg, pool", svgPath, &pool },
+        { "dxf, one thread", dxfPath, nullptr },
+        { "dxf, pool", dxfPath, &pool },
+    };
+
+    uint64_t previous = 0;
+    for (const Run& run : runs) {
+        Scene scene;
+        VectorImporter importer(run.pool);
+        ImportResult result;
+        double ms = Bench::measureMs([&] { result = importer.importFile(run.path, scene); });
+        Bench::report(run.name, ms, count);
+        printf("  %.1f MB, %.0f MB/s\n", result.bytes / 1e6, result.bytes / 1e3 / ms);
+
+        const std::vector<Shape*>& imported = scene.getShapes();
+        Bench::check(result.ok && result.shapes == (size_t)count && imported.size() == (size_t)count,
+            "every shape is imported");
+
+        uint64_t digest = digestAll(imported);
+        if (run.path == dxfPath) {
+            Bench::check(digest == expectedAll, "dxf import reproduces the shapes exactly");
+        }
+        else {
+            Bench::check(digestWithoutArcs(imported) == expectedWithoutArcs && arcsClose(shapes, imported),
+                "svg import reproduces the shapes");
+            Bench::check(result.skipped == 0, "nothing in defs is imported or skipped");
+        }
+        if (run.pool) Bench::check(digest == previous, "parallel import equals the serial one");
+        previous = digest;
+    }
+
+    // Порция меньше элемента растёт, а результат тот же
+    {
+        Scene scene;
+        VectorImporter importer(&pool, 4096);
+        ImportResult result = importer.importFile(dxfPath, scene);
+        Bench::check(result.ok && digestAll(scene.getShapes()) == expectedAll, "small pieces give the same result");
+    }
+    printf("  svg file %.1f MB, dxf file %.1f MB, pooled import buffer %d MB\n",
+        fileSize(svgPath) / 1e6, fileSize(dxfPath) / 1e6, 2 * pool.size());
+
+    remove(svgPath);
+    remove(dxfPath);
+    for (Shape* shape : shapes) delete shape;
+}
+
+// Комментарии и CDATA, в которых лежат теги, длиннее части: граница части
+// и порции не может пройти внутри них, иначе закомментированные line
+// разбираются как фигуры
+BENCH_CASE(svgCommentsAcrossPieces) {
+    const char* path = "shapes_bench_comments.svg";
+    const int blocks = 1000;
+    const int visiblePerBlock = 5;
+    const int hiddenPerBlock = 60;
+
+    if (FILE* file = fopen(path, "wb")) {
+        fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\">\n");
+        for (int b = 0; b < blocks; ++b) {
+            for (int i = 0; i < visiblePerBlock; ++i) {
+                fprintf(file, "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" stroke=\"black\"/>\n", b, i, b + 10, i);
+            }
+            fprintf(file, b % 2 ? "<!-- hidden\n" : "<![CDATA[\n");
+            for (int i = 0; i < hiddenPerBlock; ++i) {
+                fprintf(file, "<line x1=\"%d\" y1=\"%d\" x2=\"%d\" y2=\"%d\" stroke=\"red\"/>\n", b, -i, b + 10, -i);
+            }
+            fprintf(file, b % 2 ? "-->\n" : "]]>\n");
+        }
+        fprintf(file, "</svg>\n");
+        fclose(file);
+    }
+
+    ThreadPool pool;
+    ThreadPool* pools[] = { nullptr, &pool };
+    for (ThreadPool* runPool : pools) {
+        Scene scene;
+        VectorImporter importer(runPool, 4096);
+        ImportResult result = importer.importFile(path, scene);
+        bool visibleOnly = result.ok && result.shapes == (size_t)(blocks * visiblePerBlock);
+        for (Shape* shape : scene.getShapes()) {
+            visibleOnly = visibleOnly && shape->getColor() == 0;
+        }
+        printf("  %s: %zu shapes of %d\n", runPool ? "pool" : "one thread", result.shapes, blocks * visiblePerBlock);
+        Bench::check(visibleOnly, "tags inside comments and CDATA are not imported");
+    }
+    printf("  file %.1f MB, pieces of 4 KB\n", fileSize(path) / 1e6);
+
+    remove(path);
+}
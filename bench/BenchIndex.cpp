@@ -0,0 +1,93 @@
+#include "BenchScene.h"
+#include "Scene.h"
+
+using namespace MyShapes;
+
+namespace {
+    // Эталон: прежний перебор всех фигур, но с выбором самой верхней.
+    // Габарит с допуском отсекает ложные попадания isClicked у отрезков,
+    // который меряет расстояние до бесконечной прямой.
+    Shape* pickLinear(const std::vector<Shape*>& shapes, int x, int y) {
+        for (size_t i = shapes.size(); i-- > 0;) {
+            Shape* shape = shapes[i];
+            if (shape->bounds().inflated(Scene::PickTolerance).contains(x, y) && shape->isClicked(x, y)) {
+                return shape;
+            }
+        }
+        return nullptr;
+    }
+}
+
+BENCH_CASE(pickIndexVsLinear) {
+    const int count = 100000 * Bench::scale();
+    const int world = 20000;
+    const int clicks = 2000;
+
+    Scene scene;
+    double buildMs = Bench::measureMs([&] {
+        for (Shape* shape : Bench::makeScene(count, world)) {
+            scene.add(shape);
+        }
+    });
+    Bench::report("Scene::add (index build)", buildMs, count);
+    printf("  tree height %d for %d shapes\n", scene.getIndex().height(), (int)scene.size());
+
+    std::vector<int> xs, ys;
+    Bench::Random rnd(3);
+    for (int c = 0; c < clicks; ++c) {
+        // Половина кликов - по вершинам фигур, чтобы были попадания
+        Rect b = scene.getShapes()[rnd.range(0, count - 1)]->bounds();
+        bool onShape = c % 2 == 0;
+        xs.push_back(onShape ? b.left : rnd.range(0, world));
+        ys.push_back(onShape ? (b.top + b.bottom) / 2 : rnd.range(0, world));
+    }
+
+    std::vector<Shape*> linearHits(clicks), indexHits(clicks);
+    double linearMs = Bench::measureMs([&] {
+        for (int c = 0; c < clicks; ++c) linearHits[c] = pickLinear(scene.getShapes(), xs[c], ys[c]);
+    });
+    Bench::report("pick, linear scan (per click)", linearMs, clicks);
+
+    double indexMs = Bench::measureMs([&] {
+        for (int c = 0; c < clicks; ++c) indexHits[c] = scene.pick(xs[c], ys[c]);
+    });
+    Bench::report("pick, spatial index (per click)", indexMs, clicks);
+    printf("  speedup x%.1f\n", linearMs / std::max(indexMs, 1e-6));
+
+    int hits = 0;
+    for (int c = 0; c < clicks; ++c) {
+        if (indexHits[c]) ++hits;
+    }
+    Bench::check(linearHits == indexHits, "index pick matches linear topmost pick");
+    Bench::check(hits > 0, "some clicks hit shapes");
+
+    // Перемещение всех фигур с обновлением индекса
+    double moveMs = Bench::measureMs([&] {
+        for (Shape* shape : scene.getShapes()) {
+            shape->move(10, 0);
+            scene.update(shape);
+        }
+    });
+    Bench::report("move + Scene::update", moveMs, count);
+
+    for (int c = 0; c < clicks; ++c) {
+        xs[c] += 10;
+        linearHits[c] = pickLinear(scene.getShapes(), xs[c], ys[c]);
+        indexHits[c] = scene.pick(xs[c], ys[c]);
+    }
+    Bench::check(linearHits == indexHits, "index pick matches linear pick after move");
+
+    // Удаление половины фигур
+    std::vector<Shape*> victims;
+    for (size_t i = 0; i < scene.size(); i += 2) victims.push_back(scene.getShapes()[i]);
+    double removeMs = Bench::measureMs([&] {
+        for (Shape* shape : victims) scene.remove(shape);
+    });
+    Bench::report("Scene::remove", removeMs, (long long)victims.size());
+
+    for (int c = 0; c < clicks; ++c) {
+        linearHits[c] = pickLinear(scene.getShapes(), xs[c], ys[c]);
+        indexHits[c] = scene.pick(xs[c], ys[c]);
+    }
+    Bench::check(linearHits == indexHits, "index pick matches linear pick after remove");
+}
@@ -0,0 +1,99 @@
+﻿#include "BenchScene.h"
+#include "Intersect.h"
+
+#include <cstdio>
+
+using namespace MyShapes;
+
+namespace {
+
+    // Случайное блуждание из count вершин: много пересечений с длинным отрезком
+    std::vector<Vertex> makeWalk(int count, int cx, int cy) {
+        Bench::Random rnd(23);
+        std::vector<Vertex> walk;
+        walk.reserve(count);
+        int x = cx, y = cy;
+        for (int i = 0; i < count; ++i) {
+            x += rnd.range(-30, 30);
+            y += rnd.range(-30, 30);
+            walk.push_back(Vertex{ x, y });
+        }
+        return walk;
+    }
+
+    // Те же общие точки скалярным segmentCrossing по каждому ребру
+    size_t countPairwise(const std::vector<Vertex>& walk, const Vertex& a, const Vertex& b) {
+        size_t found = 0;
+        bool previousAtEnd = false;
+        for (size_t i = 0; i + 1 < walk.size(); ++i) {
+            double t;
+            bool hit = segmentCrossing(walk[i], walk[i + 1], a, b, t);
+            if (hit && !(t == 0 && previousAtEnd)) ++found;
+            previousAtEnd = hit && t == 1;
+        }
+        return found;
+    }
+
+}
+
+// Точные предикаты на огромных и почти коллинеарных координатах; все
+// пересечения ломаной из миллиона вершин с отрезком обрезки
+BENCH_CASE(segmentIntersection) {
+    // Числа Фибоначчи: F45 * F43 - F44^2 = 1, а произведения ~5e17 в double округляются
+    const int F43 = 433494437, F44 = 701408733, F45 = 1134903170;
+    Vertex a{ -1000000000, -1000000000 };
+    Vertex b{ a.x + F45, a.y + F44 }, c{ a.x + F44, a.y + F43 };
+    Bench::check(orientation(a, b, c) == 1 && orientation(a, c, b) == -1, "orientation is exact when double rounds");
+    Vertex middle{ a.x + F45 / 2, a.y + F44 / 2 }, end{ a.x + F45 / 2 * 2, a.y + F44 / 2 * 2 };
+    Bench::check(orientation(a, end, middle) == 0, "collinear points give zero");
+
+    // Разности до 4e9: произведения не помещаются даже в long long
+    Vertex far1{ -2000000000, -2000000000 }, far2{ 2000000000, 2000000000 };
+    Vertex far3{ -2000000000, 2000000000 }, far4{ 2000000000, -2000000000 };
+    Bench::check(orientation(far1, far2, far3) == 1 && orientation(far1, far2, far4) == -1,
+        "orientation does not overflow");
+    Point crossing;
+    bool crossed = lineSegmentIntersection(Point(far1.x, far1.y), Point(far2.x, far2.y),
+        Point(far3.x, far3.y), Point(far4.x, far4.y), crossing);
+    Bench::check(crossed && crossing.x == 0 && crossing.y == 0, "diagonals of a huge square cross at the centre");
+
+    // Вершина на отрезке - одна общая точка, а не две
+    {
+        std::vector<Vertex> zigzag{ { 0, -10 }, { 10, 0 }, { 20, -10 }, { 30, 10 }, { 40, -10 } };
+        std::vector<SegmentCrossing> found;
+        polylineCrossings(zigzag.data(), zigzag.size(), Vertex{ -5, 0 }, Vertex{ 45, 0 }, found);
+        Bench::check(found.size() == 3 && found[0].point.x == 10 && found[1].segment == 2 && found[2].segment == 3,
+            "a vertex on the cut is reported once");
+    }
+
+    const int vertexCount = 1000000 * Bench::scale();
+    std::vector<Vertex> walk = makeWalk(vertexCount, 0, 0);
+    Rect box;
+    for (const Vertex& v : walk) box.include(v.x, v.y);
+    Vertex cutStart{ box.left - 10, (box.top + box.bottom) / 2 }, cutEnd{ box.right + 10, (box.top + box.bottom) / 2 + 7 };
+
+    std::vector<SegmentCrossing> found;
+    double ms = Bench::measureMs([&] { polylineCrossings(walk.data(), walk.size(), cutStart, cutEnd, found); });
+    Bench::report("polyline crossings (vector sides)", ms, walk.size());
+    size_t expected = 0;
+    ms = Bench::measureMs([&] { expected = countPairwise(walk, cutStart, cutEnd); });
+    Bench::report("segmentCrossing per edge", ms, walk.size());
+    printf("  %zu crossings with the cut\n", found.size());
+    Bench::check(found.size() == expected && expected > 10, "every crossing is found");
+
+    bool ordered = true;
+    for (size_t i = 1; i < found.size(); ++i) {
+        if (found[i].segment < found[i - 1].segment) ordered = false;
+    }
+    Bench::check(ordered, "crossings come in order along the polyline");
+
+    // Обрезка оставляет участок до первой общей точки
+    std::vector<Point> points;
+    points.reserve(walk.size());
+    for (const Vertex& v : walk) points.push_back(Point(v.x, v.y));
+    Polyline polyline(points);
+    polyline.trim(Point(cutStart.x, cutStart.y), Point(cutEnd.x, cutEnd.y));
+    const Point& last = polyline.points.back();
+    Bench::check(!found.empty() && polyline.points.size() <= found[0].segment + 2 &&
+        last.x == found[0].point.x && last.y == found[0].point.y, "trim cuts at the first crossing");
+}
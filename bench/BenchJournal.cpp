@@ -0,0 +1,199 @@
+﻿#include "BenchScene.h"
+#include "EditJournal.h"
+#include "Scene.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace MyShapes;
+
+namespace {
+
+    uint64_t digestOf(const std::vector<Shape*>& shapes) {
+        Bench::CountingRenderer renderer;
+        for (Shape* shape : shapes) shape->draw(renderer);
+        return renderer.digest;
+    }
+
+    // Случайное блуждание из count вершин вокруг (cx, cy)
+    std::vector<Point> makeWalk(int count, int cx, int cy) {
+        Bench::Random rnd(11);
+        std::vector<Point> points;
+        points.reserve(count);
+        int x = cx, y = cy;
+        for (int i = 0; i < count; ++i) {
+            x += rnd.range(-20, 20);
+            y += rnd.range(-20, 20);
+            points.push_back(Point(x, y));
+        }
+        return points;
+    }
+
+}
+
+// Правки ломаной из 100 000 вершин и сцены из 100 000 фигур через журнал:
+// запись, отмена и повтор, точность отмены и память записей против копий
+BENCH_CASE(editJournal) {
+    const int vertexCount = 100000;
+    const int count = 100000 * Bench::scale();
+    const int world = 20000;
+
+    for (int precise = 0; precise < 2; ++precise) {
+        Scene scene;
+        EditJournal journal(scene);
+        Polyline* walk = scene.create<Polyline>(makeWalk(vertexCount, world / 2, world / 2));
+        scene.setPrecise(precise != 0);
+        printf("  %s\n", precise ? "precise mode" : "integer mode");
+
+        const std::vector<Shape*> one(1, walk);
+        uint64_t initial = digestOf(scene.getShapes());
+        const int rotations = 36;
+        double ms = Bench::measureMs([&] {
+            for (int i = 0; i < rotations; ++i) {
+                double cx, cy;
+                walk->pivot(cx, cy);
+                journal.transform(one, Affine::rotation(cx, cy, 10));
+            }
+        });
+        Bench::report("rotate 100k-vertex polyline", ms, rotations);
+        journal.transform(one, Affine::translation(15, -7));
+        journal.transform(one, Affine::mirror(world / 2, world / 2, true));
+
+        Rect box = walk->bounds();
+        int middle = (box.left + box.right) / 2;
+        journal.trim(one, Point(middle, box.top - 10), Point(middle, box.bottom + 10));
+        size_t kept = walk->points.size();
+
+        uint64_t edited = digestOf(scene.getShapes());
+        size_t copyBytes = vertexCount * sizeof(Point) * journal.size();
+        printf("  %zu edits, journal %.1f KB, full copies would take %.1f MB; trim kept %zu vertices\n",
+            journal.size(), journal.memoryUsed() / 1e3, copyBytes / 1e6, kept);
+        Bench::check(journal.memoryUsed() * 8 < copyBytes, "journal is much smaller than copies of the shape");
+
+        size_t edits = journal.size();
+        ms = Bench::measureMs([&] { while (journal.canUndo()) journal.undo(); });
+        Bench::report("undo all", ms, edits);
+        Bench::check(digestOf(scene.getShapes()) == initial, "undo returns the polyline exactly");
+
+        ms = Bench::measureMs([&] { while (journal.canRedo()) journal.redo(); });
+        Bench::report("redo all", ms, edits);
+        Bench::check(digestOf(scene.getShapes()) == edited, "redo repeats the edits exactly");
+    }
+
+    // Обрезка отрезков и дуг записывает только то, что она изменила
+    {
+        Scene scene, alone;
+        EditJournal journal(scene), single(alone);
+        std::vector<Shape*> missed, both;
+        missed.push_back(scene.create<Line>(Point(1000, 1000), Point(1100, 1000)));
+        missed.push_back(scene.create<Arc>(Point(1000, 0), 50, 0.0, M_PI));
+        both = missed;
+        both.push_back(scene.create<Line>(Point(0, 0), Point(100, 0)));
+        both.push_back(scene.create<Arc>(Point(50, 0), 30, 0.0, M_PI));
+        uint64_t initial = digestOf(scene.getShapes());
+
+        Point start(50, -100), end(50, 100);
+        journal.trim(missed, start, end);
+        Bench::check(journal.size() == 0, "trim that misses every shape is not recorded");
+        journal.trim(both, start, end);
+        std::vector<Shape*> hit{ alone.create<Line>(Point(0, 0), Point(100, 0)),
+            alone.create<Arc>(Point(50, 0), 30, 0.0, M_PI) };
+        single.trim(hit, start, end);
+        Bench::check(journal.size() == 1 && journal.memoryUsed() == single.memoryUsed(),
+            "trim records only the shapes it changed");
+        journal.undo();
+        Bench::check(digestOf(scene.getShapes()) == initial, "undo restores the trimmed line and arc");
+    }
+
+    // Удаление и возврат части большой сцены: фигуры встают на свои места
+    {
+        Scene scene;
+        EditJournal journal(scene);
+        std::vector<Shape*> shapes = Bench::makeScene(count, world);
+        for (Shape* shape : shapes) scene.add(shape);
+        uint64_t initial = digestOf(scene.getShapes());
+
+        std::vector<Shape*> chosen;
+        for (size_t i = 0; i < shapes.size(); i += 10) chosen.push_back(shapes[i]);
+
+        double ms = Bench::measureMs([&] { journal.transform(chosen, Affine::rotation(world / 2, world / 2, 30)); });
+        Bench::report("rotate every tenth shape", ms, chosen.size());
+        uint64_t rotated = digestOf(scene.getShapes());
+
+        size_t heap = scene.heapCount();
+        ms = Bench::measureMs([&] { journal.remove(chosen); });
+        Bench::report("delete every tenth shape", ms, chosen.size());
+        Bench::check(scene.size() == shapes.size() - chosen.size(), "deleted shapes leave the scene");
+        printf("  journal %.1f KB for rotating and deleting %zu shapes\n", journal.memoryUsed() / 1e3, chosen.size());
+
+        ms = Bench::measureMs([&] { journal.undo(); });
+        Bench::report("undo delete", ms, chosen.size());
+        Bench::check(digestOf(scene.getShapes()) == rotated, "undo delete restores the draw order");
+        std::vector<Shape*> found;
+        scene.collect(chosen.back()->bounds(), found);
+        Bench::check(std::find(found.begin(), found.end(), chosen.back()) != found.end(), "restored shapes are in the index");
+        Bench::check(scene.heapCount() == heap, "undo delete counts heap shapes once");
+        journal.redo();
+        journal.undo();
+        Bench::check(scene.heapCount() == heap && digestOf(scene.getShapes()) == rotated, "redo and undo delete keep the heap count");
+
+        journal.undo();
+        Bench::check(digestOf(scene.getShapes()) == initial, "undo rotation restores every shape");
+
+        // Новая правка после отмены: повтор невозможен
+        journal.add(scene.create<Circle>(Point(5, 5), 3));
+        Bench::check(!journal.canRedo() && scene.size() == shapes.size() + 1, "a new edit drops the redo branch");
+        journal.undo();
+        Bench::check(scene.size() == shapes.size(), "undo add takes the shape off the scene");
+    }
+
+    // Лимит памяти вытесняет старые записи
+    {
+        Scene scene;
+        const size_t limit = 256 * 1024;
+        EditJournal journal(scene, limit);
+        Polyline* walk = scene.create<Polyline>(makeWalk(vertexCount, world / 2, world / 2));
+        const std::vector<Shape*> one(1, walk);
+        for (int i = 0; i < 100; ++i) {
+            journal.transform(one, Affine::rotation(world / 2, world / 2, 7));
+            journal.remove(std::vector<Shape*>(1, scene.create<Circle>(Point(i, i), 10)));
+        }
+        printf("  limit %zu KB: %zu edits kept, %.1f KB used\n", limit / 1024, journal.size(), journal.memoryUsed() / 1e3);
+        Bench::check(journal.memoryUsed() <= limit && journal.size() < 200, "journal stays within its limit");
+    }
+}
+
+// Удаление и отмена одной фигуры в сцене из миллиона: стоимость - от
+// изменённых данных, а не от размера сцены, и перерисовка между ними
+// (collect всей области) её не меняет
+BENCH_CASE(singleShapeUndo) {
+    const int count = 1000000 * Bench::scale();
+    const int world = 60000;
+    const int edits = 200;
+    Scene scene;
+    EditJournal journal(scene);
+    std::vector<Shape*> shapes = Bench::makeScene(count, world);
+    scene.beginBulkInsert(shapes.size());
+    for (Shape* shape : shapes) scene.add(shape);
+    scene.endBulkInsert();
+    uint64_t initial = digestOf(scene.getShapes());
+    size_t heap = scene.heapCount();
+
+    // Вторая серия - с перерисовкой всей сцены между удалением и отменой:
+    // время растёт от остывшего кэша, но не от размера сцены
+    Bench::Random rnd(23);
+    std::vector<Shape*> drawn;
+    for (int repaint = 0; repaint < 2; ++repaint) {
+        double removeMs = 0, undoMs = 0;
+        for (int i = 0; i < edits; ++i) {
+            const std::vector<Shape*> one(1, shapes[rnd.range(0, count - 1)]);
+            removeMs += Bench::measureMs([&] { journal.remove(one); });
+            if (repaint) scene.collect(Rect(0, 0, world, world), drawn);
+            undoMs += Bench::measureMs([&] { journal.undo(); });
+        }
+        Bench::report(repaint ? "delete one shape of 1M, repaint" : "delete one shape of 1M", removeMs, edits);
+        Bench::report(repaint ? "undo it after the repaint" : "undo delete of one shape", undoMs, edits);
+    }
+    Bench::check(scene.size() == shapes.size() && scene.heapCount() == heap, "single deletes undo to the same scene");
+    Bench::check(digestOf(scene.getShapes()) == initial, "single undo restores the draw order");
+}
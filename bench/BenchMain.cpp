@@ -0,0 +1,76 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+namespace Bench {
+
+    namespace {
+        struct Entry {
+            const char* name;
+            BenchFn fn;
+        };
+
+        std::vector<Entry>& registry() {
+            static std::vector<Entry> entries;
+            return entries;
+        }
+
+        int scaleFactor = 1;
+        int failures = 0;
+        volatile long long sink = 0;
+    }
+
+    Registrar::Registrar(const char* name, BenchFn fn) {
+        registry().push_back({ name, fn });
+    }
+
+    int scale() {
+        return scaleFactor;
+    }
+
+    void report(const std::string& name, double ms, long long items) {
+        double perItem = items > 0 ? ms * 1e6 / items : 0.0;
+        printf("  %-44s %10.3f ms  %12lld items  %10.2f ns/item\n", name.c_str(), ms, items, perItem);
+    }
+
+    void check(bool condition, const std::string& what) {
+        if (!condition) {
+            printf("  FAILED: %s\n", what.c_str());
+            ++failures;
+        }
+    }
+
+    void consume(long long value) {
+        sink = sink + value;
+    }
+}
+
+// shapes_bench [--scale=N] [имя ...]
+int main(int argc, char** argv) {
+    std::vector<const char*> filters;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--scale=", 8) == 0) {
+            Bench::scaleFactor = std::max(1, atoi(argv[i] + 8));
+        }
+        else {
+            filters.push_back(argv[i]);
+        }
+    }
+
+    for (const Bench::Entry& entry : Bench::registry()) {
+        bool selected = filters.empty();
+        for (const char* filter : filters) {
+            if (strstr(entry.name, filter)) selected = true;
+        }
+        if (!selected) continue;
+
+        printf("%s\n", entry.name);
+        entry.fn();
+    }
+
+    return Bench::failures == 0 ? 0 : 1;
+}
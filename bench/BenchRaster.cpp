@@ -0,0 +1,162 @@
+#include "BenchScene.h"
+#include "BatchRenderer.h"
+#include "SoftwareRenderer.h"
+#include "TiledRasterizer.h"
+
+#include <cmath>
+#include <thread>
+
+using namespace MyShapes;
+
+namespace {
+    const Color White = makeColor(255, 255, 255);
+
+    // Габарит всех нефоновых пикселей
+    Rect inkBounds(const Framebuffer& fb) {
+        Rect r;
+        for (int y = 0; y < fb.getHeight(); ++y) {
+            for (int x = 0; x < fb.getWidth(); ++x) {
+                if (fb.get(x, y) != White) r.include(x, y);
+            }
+        }
+        return r;
+    }
+}
+
+// Растеризация отдельных примитивов: проверки, на которые опираются эталонные картинки
+BENCH_CASE(rasterPrimitives) {
+    Framebuffer fb(64, 64);
+    SoftwareRenderer renderer(fb);
+
+    renderer.setPen(makeColor(255, 0, 0));
+    renderer.line(2, 2, 12, 2);
+    Bench::check(fb.get(2, 2) == makeColor(255, 0, 0) && fb.get(11, 2) == makeColor(255, 0, 0) &&
+        fb.get(12, 2) == White, "line covers its start and stops before its end, like LineTo");
+
+    // Окружность рисуется ровно в своём габарите, внутренность - фон
+    fb.clear(White);
+    Circle circle(Point(32, 32), 10);
+    fb.fillSpan(32, 25, 39, makeColor(0, 0, 255)); // Мусор внутри должен закраситься
+    circle.draw(renderer);
+    Bench::check(inkBounds(fb) == circle.bounds(), "circle outline fills exactly its bounds");
+    Bench::check(fb.get(32, 32) == White && fb.get(28, 32) == White, "circle interior is filled with background");
+    Bench::check(fb.get(22, 32) == 0 && fb.get(42, 32) == 0 && fb.get(32, 22) == 0, "circle outline passes the extreme points");
+
+    // Дуга от 0 до π/2 на экране идёт из правой точки в нижнюю
+    fb.clear(White);
+    Arc arc(Point(32, 32), 10, 0.0, M_PI / 2);
+    arc.draw(renderer);
+    Rect ink = inkBounds(fb);
+    Bench::check(ink.left >= 32 && ink.top >= 32, "quarter arc stays in its quadrant");
+    Bench::check(ink == arc.bounds(), "arc pixels match Arc::bounds");
+
+    // Отсечение: пиксели вне области не меняются
+    fb.clear(White);
+    renderer.setClip(Rect(0, 0, 31, 63));
+    Circle(Point(32, 32), 20).draw(renderer);
+    Bench::check(inkBounds(fb).right == 31, "clip rectangle limits output");
+}
+
+// Сцена 100k фигур в изображение 4000x4000: напрямую и через пакеты ломаных
+BENCH_CASE(rasterScene) {
+    const int count = 100000 * Bench::scale();
+    const int world = 4000;
+    std::vector<Shape*> shapes = Bench::makeScene(count, world);
+
+    Framebuffer direct(world, world);
+    double directMs = Bench::measureMs([&] {
+        SoftwareRenderer renderer(direct);
+        for (Shape* shape : shapes) shape->draw(renderer);
+    });
+    Bench::report("software raster, direct", directMs, count);
+
+    Framebuffer batched(world, world);
+    double batchedMs = Bench::measureMs([&] {
+        SoftwareRenderer raster(batched);
+        BatchRenderer renderer(raster);
+        for (Shape* shape : shapes) shape->draw(renderer);
+    });
+    Bench::report("software raster, batched polylines", batchedMs, count);
+
+    Framebuffer again(world, world);
+    {
+        SoftwareRenderer renderer(again);
+        for (Shape* shape : shapes) shape->draw(renderer);
+    }
+
+    uint64_t sum = direct.checksum();
+    printf("  checksum %016llx\n", (unsigned long long)sum);
+    Bench::check(sum == again.checksum(), "rendering is deterministic");
+    Bench::check(sum == batched.checksum(), "batched stream rasterizes to identical pixels");
+
+    Bench::destroyScene(shapes);
+}
+
+// Заливка строк широкими записями против поэлементного цикла;
+// изображение помещается в кэш, чтобы мерить запись, а не память
+BENCH_CASE(rasterSpanFill) {
+    const int size = 512;
+    const int passes = 2000 * Bench::scale();
+    Framebuffer fb(size, size);
+
+    double wideMs = Bench::measureMs([&] {
+        for (int pass = 0; pass < passes; ++pass) {
+            fb.clear(makeColor(pass, 0, 0));
+        }
+    });
+    Bench::report("fillSpan clear (per megapixel)", wideMs, (long long)passes * size * size / 1000000);
+
+    double scalarMs = Bench::measureMs([&] {
+        for (int pass = 0; pass < passes; ++pass) {
+            for (int y = 0; y < size; ++y) {
+                volatile uint32_t* p = fb.row(y);
+                for (int x = 0; x < size; ++x) p[x] = Framebuffer::toPixel(makeColor(0, pass, 0));
+            }
+        }
+    });
+    Bench::report("scalar clear (per megapixel)", scalarMs, (long long)passes * size * size / 1000000);
+
+    fb.fillSpan(7, 3, 10, makeColor(1, 2, 3));
+    Bench::check(fb.get(2, 7) != makeColor(1, 2, 3) && fb.get(3, 7) == makeColor(1, 2, 3) &&
+        fb.get(10, 7) == makeColor(1, 2, 3) && fb.get(11, 7) != makeColor(1, 2, 3), "fillSpan covers exactly [x0, x1]");
+}
+
+// Плиточная растеризация на 1..N потоках против обычного прохода в одном потоке
+BENCH_CASE(rasterTiled) {
+    const int count = 250000 * Bench::scale();
+    const int size = 4000;
+    std::vector<Shape*> shapes = Bench::makeScene(count, size);
+
+    Framebuffer reference(size, size);
+    double singleMs = Bench::measureMs([&] {
+        SoftwareRenderer renderer(reference);
+        for (Shape* shape : shapes) shape->draw(renderer);
+    });
+    Bench::report("single pass, one thread", singleMs, count);
+    uint64_t expected = reference.checksum();
+
+    int hardware = std::max(2, (int)std::thread::hardware_concurrency());
+    TiledRasterizer tiled;
+    bool identical = true;
+    double oneThreadMs = 0;
+    for (int threads = 1; threads <= hardware; threads *= 2) {
+        ThreadPool pool(threads);
+        Framebuffer fb(size, size);
+        double ms = Bench::measureMs([&] {
+            tiled.render(shapes, fb, &pool);
+        });
+        if (threads == 1) oneThreadMs = ms;
+
+        char name[64];
+        snprintf(name, sizeof(name), "tiled, %d thread(s)", threads);
+        Bench::report(name, ms, count);
+        printf("  speedup vs 1 thread x%.2f\n", oneThreadMs / ms);
+        identical = identical && fb.checksum() == expected;
+    }
+    printf("  %lld tile bins for %d shapes, %u hardware threads\n",
+        tiled.getBinnedCount(), count, std::thread::hardware_concurrency());
+
+    Bench::check(identical, "tiled output is pixel-identical to the single-threaded pass");
+
+    Bench::destroyScene(shapes);
+}
@@ -0,0 +1,134 @@
+#include "BenchScene.h"
+#include "Scene.h"
+
+using namespace MyShapes;
+
+// Удерживаемая стрелка: одна фигура сдвигается 100 раз, после каждого шага
+// окно перерисовывается целиком или только в повреждённой области
+BENCH_CASE(repaintDamageVsFull) {
+    const int count = 100000 * Bench::scale();
+    const int world = 20000;
+    const int steps = 100;
+
+    Scene scene;
+    for (Shape* shape : Bench::makeScene(count, world)) {
+        scene.add(shape);
+    }
+    scene.takeDamage();
+
+    Shape* moving = scene.getShapes()[count / 2];
+    Bench::CountingRenderer full, partial;
+
+    double fullMs = Bench::measureMs([&] {
+        for (int step = 0; step < steps; ++step) {
+            moving->move(10, 0);
+            scene.update(moving);
+            scene.takeDamage();
+            for (Shape* shape : scene.getShapes()) shape->draw(full);
+        }
+    });
+    Bench::report("full repaint per move", fullMs, steps);
+
+    std::vector<Shape*> visible;
+    long long redrawn = 0;
+    bool movingRedrawn = true;
+    double damageMs = Bench::measureMs([&] {
+        for (int step = 0; step < steps; ++step) {
+            moving->move(-10, 0);
+            scene.update(moving);
+            bool found = false;
+            for (const Rect& area : scene.takeDamage()) {
+                scene.collect(area.inflated(1), visible);
+                for (Shape* shape : visible) {
+                    shape->draw(partial);
+                    found = found || shape == moving;
+                }
+                redrawn += visible.size();
+            }
+            movingRedrawn = movingRedrawn && found;
+        }
+    });
+    Bench::report("damage-rect repaint per move", damageMs, steps);
+    printf("  shapes redrawn per move: %lld of %d\n", redrawn / steps, count);
+
+    Bench::check(movingRedrawn, "moved shape lies inside its damage area");
+    Bench::check(redrawn < (long long)count * steps / 100, "damage repaint touches a small part of the scene");
+}
+
+// Полная перерисовка при скрытых треугольниках и окружностях: прежняя цепочка
+// dynamic_cast по каждой фигуре против корзин сцены по виду фигуры
+BENCH_CASE(visibilityKindBuckets) {
+    const int count = 100000 * Bench::scale();
+    const int world = 20000;
+    const int frames = 20;
+
+    Scene scene;
+    for (Shape* shape : Bench::makeScene(count, world)) {
+        scene.add(shape);
+    }
+
+    bool showLines = true, showCircles = false, showArcs = true, showRings = true;
+    bool showPolylines = true, showPolygons = true, showTriangles = false, showParallelograms = true;
+    KindMask visibleKinds = AllKinds & ~kindBit(ShapeKind::Circle) & ~kindBit(ShapeKind::Triangle);
+
+    auto isVisible = [&](Shape* shape) {
+        return (dynamic_cast<Line*>(shape) && showLines) ||
+            (dynamic_cast<Circle*>(shape) && showCircles) ||
+            (dynamic_cast<Arc*>(shape) && showArcs) ||
+            (dynamic_cast<Ring*>(shape) && showRings) ||
+            (dynamic_cast<Polyline*>(shape) && showPolylines) ||
+            (dynamic_cast<Polygon*>(shape) && showPolygons) ||
+            (dynamic_cast<Triangle*>(shape) && showTriangles) ||
+            (dynamic_cast<Parallelogram*>(shape) && showParallelograms);
+    };
+
+    Bench::CountingRenderer chained, bucketed;
+    long long chainedDrawn = 0, bucketedDrawn = 0;
+
+    double chainMs = Bench::measureMs([&] {
+        for (int frame = 0; frame < frames; ++frame) {
+            for (Shape* shape : scene.getShapes()) {
+                if (isVisible(shape)) {
+                    shape->draw(chained);
+                    ++chainedDrawn;
+                }
+            }
+        }
+    });
+    Bench::report("dynamic_cast chain per frame", chainMs, frames);
+
+    std::vector<Shape*> visible;
+    Rect everything(-world, -world, world * 2, world * 2);
+    double bucketMs = Bench::measureMs([&] {
+        for (int frame = 0; frame < frames; ++frame) {
+            scene.collect(everything, visible, visibleKinds);
+            for (Shape* shape : visible) {
+                shape->draw(bucketed);
+            }
+            bucketedDrawn += visible.size();
+        }
+    });
+    Bench::report("kind buckets per frame", bucketMs, frames);
+
+    long long expected = 0;
+    for (Shape* shape : scene.getShapes()) {
+        if (visibleKinds & kindBit(shape->kind())) ++expected;
+    }
+    printf("  drawn per frame: chain %lld, buckets %lld, visible %lld\n",
+        chainedDrawn / frames, bucketedDrawn / frames, expected);
+
+    // Часть окна идёт через индекс: скрытые виды отсекаются масками узлов
+    Rect quarter(0, 0, world / 2, world / 2);
+    scene.collect(quarter, visible, visibleKinds);
+    std::vector<Shape*> filtered;
+    for (Shape* shape : scene.getShapes()) {
+        if ((visibleKinds & kindBit(shape->kind())) && shape->bounds().intersects(quarter)) {
+            filtered.push_back(shape);
+        }
+    }
+
+    Bench::check(bucketedDrawn == expected * frames, "buckets draw exactly the visible kinds");
+    Bench::check(visible == filtered, "indexed collect skips hidden kinds and keeps draw order");
+    Bench::check(scene.getShapes(ShapeKind::Triangle).size() == (size_t)count / 8, "triangles have their own bucket");
+    Bench::check(chainedDrawn > bucketedDrawn, "dynamic_cast chain still draws hidden triangles as polylines");
+}
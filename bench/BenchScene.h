@@ -0,0 +1,159 @@
+#pragma once
+
+#include <initializer_list>
+#include <vector>
+
+#include "Bench.h"
+
+#include <cstdio>
+#include "ShapeArena.h"
+#include "Shapes.h"
+
+namespace Bench {
+
+    template <typename T>
+    struct ShapeTag {
+        typedef T type;
+    };
+
+    // Случайная сцена из всех типов фигур в квадрате worldSize x worldSize.
+    // Для каждой фигуры вызывает make(ShapeTag<T>(), аргументы конструктора T...),
+    // так что одна и та же сцена строится в куче, в арене или сразу в Scene.
+    template <typename Make>
+    void generateScene(int count, int worldSize, uint64_t seed, Make&& make) {
+        using namespace MyShapes;
+        Random rnd(seed);
+
+        for (int i = 0; i < count; ++i) {
+            Point p(rnd.range(0, worldSize), rnd.range(0, worldSize));
+            int size = rnd.range(4, 40);
+
+            switch (i % 8) {
+            case 0:
+            {
+                int dx = rnd.range(-size, size);
+                int dy = rnd.range(-size, size);
+                make(ShapeTag<Line>(), p, Point(p.x + dx, p.y + dy));
+                break;
+            }
+            case 1:
+                make(ShapeTag<Circle>(), p, size);
+                break;
+            case 2:
+            {
+                double start = rnd.range(0, 6) * 1.0;
+                double end = rnd.range(0, 6) * 1.0;
+                make(ShapeTag<Arc>(), p, size, start, end);
+                break;
+            }
+            case 3:
+                make(ShapeTag<Ring>(), p, size, size / 2);
+                break;
+            case 4:
+            case 5:
+            {
+                std::vector<Point> points;
+                int n = rnd.range(3, 20);
+                for (int k = 0; k < n; ++k) {
+                    int dx = rnd.range(-size, size);
+                    int dy = rnd.range(-size, size);
+                    points.push_back(Point(p.x + dx, p.y + dy));
+                }
+                if (i % 8 == 4)
+                    make(ShapeTag<Polyline>(), points);
+                else
+                    make(ShapeTag<Polygon>(), points);
+                break;
+            }
+            case 6:
+                make(ShapeTag<Triangle>(), p, Point(p.x + size, p.y), Point(p.x, p.y + size));
+                break;
+            default:
+                make(ShapeTag<Parallelogram>(), p, Point(p.x + size, p.y), (double)rnd.range(0, 90));
+                break;
+            }
+        }
+    }
+
+    // Та же сцена отдельными объектами в куче или, если задана арена, в ней
+    inline std::vector<MyShapes::Shape*> makeScene(int count, int worldSize, uint64_t seed = 42,
+        MyShapes::ShapeArena* arena = nullptr) {
+        std::vector<MyShapes::Shape*> shapes;
+        shapes.reserve(count);
+
+        generateScene(count, worldSize, seed, [&](auto tag, auto&&... args) {
+            typedef typename decltype(tag)::type T;
+            if (arena) shapes.push_back(arena->create<T>(args...));
+            else shapes.push_back(new T(args...));
+        });
+        return shapes;
+    }
+
+    inline void destroyScene(std::vector<MyShapes::Shape*>& shapes) {
+        for (MyShapes::Shape* shape : shapes) {
+            delete shape;
+        }
+        shapes.clear();
+    }
+
+    // Рендерер, который только считает вызовы: меряем обход без растеризации.
+    // penChanges - сколько раз перо действительно пришлось бы выбрать в контекст.
+    // digest - свёртка всех нарисованных примитивов по порядку вместе с цветом
+    // пера: совпадает у рендереров, нарисовавших одно и то же.
+    class CountingRenderer : public MyShapes::Renderer {
+    public:
+        long long calls = 0;
+        long long penCalls = 0;
+        long long penChanges = 0;
+        long long segments = 0;
+        uint64_t digest = 0;
+        MyShapes::Pen pen = MyShapes::Pen(0xFFFFFFFF);
+
+        using MyShapes::Renderer::setPen;
+        void setPen(const MyShapes::Pen& newPen) override {
+            ++calls;
+            ++penCalls;
+            if (newPen != pen) {
+                pen = newPen;
+                ++penChanges;
+            }
+        }
+        void pixel(int x, int y, MyShapes::Color color) override {
+            ++calls;
+            mix({ 1, x, y, (int)color });
+        }
+        void line(int x1, int y1, int x2, int y2) override {
+            ++calls;
+            addSegment(x1, y1, x2, y2);
+        }
+        void polyPolyline(const MyShapes::Vertex* vertices, const uint32_t* counts, int polylineCount) override {
+            ++calls;
+            for (int i = 0; i < polylineCount; ++i) {
+                for (uint32_t k = 1; k < counts[i]; ++k) {
+                    addSegment(vertices[k - 1].x, vertices[k - 1].y, vertices[k].x, vertices[k].y);
+                }
+                vertices += counts[i];
+            }
+        }
+        void ellipse(int left, int top, int right, int bottom) override {
+            ++calls;
+            mix({ 3, left, top, right, bottom, (int)pen.color });
+        }
+        void arc(int left, int top, int right, int bottom, int xs, int ys, int xe, int ye) override {
+            ++calls;
+            mix({ 4, left, top, right, bottom, xs, ys, xe, ye, (int)pen.color });
+        }
+
+    private:
+        void addSegment(int x1, int y1, int x2, int y2) {
+            ++segments;
+            mix({ 2, x1, y1, x2, y2, (int)pen.color });
+        }
+
+        void mix(std::initializer_list<int> values) {
+            for (int v : values) {
+                digest = (digest ^ (uint32_t)v) * 0x100000001B3ull;
+            }
+        }
+    };
+}
@@ -0,0 +1,157 @@
+#include "BenchScene.h"
+#include "HitTest.h"
+#include "RegionQuery.h"
+#include "Scene.h"
+#include "ShapeKernels.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace MyShapes;
+
+namespace {
+    // Звезда из count вершин вокруг (cx, cy): вогнутое лассо
+    std::vector<Vertex> makeLasso(int cx, int cy, int radius, int count) {
+        std::vector<Vertex> lasso;
+        for (int k = 0; k < count; ++k) {
+            double angle = 2 * M_PI * k / count;
+            double r = radius * (1 + 0.3 * sin(7 * angle));
+            lasso.push_back(Vertex{ cx + (int)(r * cos(angle)), cy + (int)(r * sin(angle)) });
+        }
+        return lasso;
+    }
+
+    std::vector<Shape*> sorted(std::vector<Shape*> shapes) {
+        std::sort(shapes.begin(), shapes.end());
+        return shapes;
+    }
+
+    bool byAnchors(const Shape* shape) {
+        ShapeKind kind = shape->kind();
+        return kind != ShapeKind::Circle && kind != ShapeKind::Arc && kind != ShapeKind::Ring;
+    }
+
+    bool anchorsInside(const Shape* shape, const std::vector<Vertex>& lasso, bool all) {
+        std::vector<Vertex> anchors;
+        shape->writeAnchors(anchors);
+        for (const Vertex& v : anchors) {
+            bool inside = false;
+            for (size_t i = 0, j = lasso.size() - 1; i < lasso.size(); j = i++) {
+                if (crossesRay(lasso[i].x, lasso[i].y, lasso[j].x, lasso[j].y, v.x, v.y)) inside = !inside;
+            }
+            if (inside != all) return !all;
+        }
+        return all;
+    }
+}
+
+BENCH_CASE(regionSelect) {
+    const int count = 1000000 * Bench::scale();
+    const int world = 20000;
+
+    Scene scene;
+    Bench::generateScene(count, world, 42, [&](auto tag, auto&&... args) {
+        typedef typename decltype(tag)::type T;
+        scene.create<T>(args...);
+    });
+
+    ThreadPool pool;
+    RegionQuery serial;
+    RegionQuery parallel(&pool);
+    std::vector<Shape*> inside, touching, check;
+
+    // Рамка на четверть мира: габарит решает почти всё
+    Rect area(0, 0, world / 2, world / 2);
+    double rectInsideMs = Bench::measureMs([&] { parallel.selectRect(scene, area, RegionRule::Inside, inside); });
+    Bench::report("rect, inside", rectInsideMs, (long long)inside.size());
+    double rectTouchMs = Bench::measureMs([&] { parallel.selectRect(scene, area, RegionRule::Touching, touching); });
+    Bench::report("rect, touching", rectTouchMs, (long long)touching.size());
+
+    size_t expectedInside = 0;
+    for (Shape* shape : scene.getShapes()) {
+        expectedInside += area.contains(shape->bounds());
+    }
+    Bench::check(inside.size() == expectedInside, "rect inside equals bounds containment");
+    Bench::check(touching.size() >= inside.size(), "touching selects at least the inside shapes");
+
+    // Вогнутое лассо: точные проверки у всех фигур на его границе
+    std::vector<Vertex> lasso = makeLasso(world / 2, world / 2, world / 4, 256);
+    double linearMs = Bench::measureMs([&] {
+        check.clear();
+        for (Shape* shape : scene.getShapes()) {
+            if (anchorsInside(shape, lasso, true)) check.push_back(shape);
+        }
+    });
+    Bench::report("lasso, linear scan of anchors", linearMs, count);
+
+    double lassoSerialMs = Bench::measureMs([&] { serial.selectLasso(scene, lasso, RegionRule::Inside, inside); });
+    Bench::report("lasso, inside, one thread", lassoSerialMs, (long long)inside.size());
+    std::vector<Shape*> parallelInside;
+    double lassoInsideMs = Bench::measureMs([&] { parallel.selectLasso(scene, lasso, RegionRule::Inside, parallelInside); });
+    Bench::report("lasso, inside, thread pool", lassoInsideMs, (long long)parallelInside.size());
+    double lassoTouchMs = Bench::measureMs([&] { parallel.selectLasso(scene, lasso, RegionRule::Touching, touching); });
+    Bench::report("lasso, touching, thread pool", lassoTouchMs, (long long)touching.size());
+    printf("  %d threads; %zu inside, %zu touching, %zu with all anchors inside\n",
+        pool.size(), inside.size(), touching.size(), check.size());
+
+    Bench::check(sorted(inside) == sorted(parallelInside), "thread pool selects the same shapes");
+
+    // У ломаных контур проходит через опорные точки: выделенные лассо целиком
+    // лежат внутри всеми точками, не задетые - ни одной
+    bool consistent = true;
+    std::vector<Shape*> touched = sorted(touching);
+    for (Shape* shape : inside) {
+        consistent = consistent && (!byAnchors(shape) || anchorsInside(shape, lasso, true));
+    }
+    for (Shape* shape : scene.getShapes()) {
+        if (byAnchors(shape) && !std::binary_search(touched.begin(), touched.end(), shape)) {
+            consistent = consistent && !anchorsInside(shape, lasso, false);
+        }
+    }
+    Bench::check(consistent, "lasso selection agrees with the anchor test");
+}
+
+// Длинное лассо: главное окно складывает в него каждое движение мыши.
+// Построение сетки рёбер должно расти линейно по числу вершин.
+BENCH_CASE(largeLasso) {
+    const int world = 20000;
+
+    Scene scene;
+    Bench::generateScene(1000, world, 42, [&](auto tag, auto&&... args) {
+        typedef typename decltype(tag)::type T;
+        scene.create<T>(args...);
+    });
+
+    RegionQuery query;
+    std::vector<Shape*> inside;
+    for (int vertices : { 2000, 8000, 20000 }) {
+        std::vector<Vertex> lasso = makeLasso(world / 2, world / 2, world / 3, vertices);
+        double ms = Bench::measureMs([&] { query.selectLasso(scene, lasso, RegionRule::Inside, inside); });
+        char label[64];
+        snprintf(label, sizeof(label), "lasso of %d vertices, 1000 shapes", vertices);
+        Bench::report(label, ms, vertices);
+
+        size_t expected = 0;
+        for (Shape* shape : scene.getShapes()) {
+            expected += byAnchors(shape) && anchorsInside(shape, lasso, true);
+        }
+        size_t byAnchorsInside = 0;
+        for (Shape* shape : inside) byAnchorsInside += byAnchors(shape);
+        Bench::check(byAnchorsInside == expected, "long lasso selects the shapes with all anchors inside");
+    }
+
+    // Ячейки без рёбер, заполненные проходом по рядам, против прямой проверки точки
+    std::vector<Vertex> lasso = makeLasso(world / 2, world / 2, world / 3, 20000);
+    Rect bounds;
+    for (const Vertex& v : lasso) bounds.include(v.x, v.y);
+    RegionQuery::EdgeGrid grid;
+    grid.build(lasso, bounds);
+    Bench::Random rnd(11);
+    bool same = true;
+    for (int i = 0; i < 20000; ++i) {
+        int x = rnd.range(bounds.left, bounds.right), y = rnd.range(bounds.top, bounds.bottom);
+        same = same && grid.contains(x, y) == insidePolygon(lasso.data(), lasso.size(), x, y);
+    }
+    Bench::check(same, "edge grid agrees with the direct point test");
+}
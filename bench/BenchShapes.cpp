@@ -0,0 +1,625 @@
+#include "BenchScene.h"
+#include "BatchRenderer.h"
+#include "EditJournal.h"
+#include "HitTest.h"
+#include "Scene.h"
+#include "ShapeKernels.h"
+#include "Transform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace MyShapes;
+
+BENCH_CASE(hitTestLinearScan) {
+    const int count = 100000 * Bench::scale();
+    const int clicks = 200;
+    std::vector<Shape*> shapes = Bench::makeScene(count, 20000);
+
+    Bench::Random rnd(7);
+    long long hits = 0;
+    double ms = Bench::measureMs([&] {
+        for (int c = 0; c < clicks; ++c) {
+            int x = rnd.range(0, 20000);
+            int y = rnd.range(0, 20000);
+            for (Shape* shape : shapes) {
+                if (shape->isClicked(x, y)) {
+                    ++hits;
+                    break;
+                }
+            }
+        }
+    });
+    Bench::consume(hits);
+    Bench::report("isClicked, linear scan (per click)", ms, clicks);
+
+    Bench::destroyScene(shapes);
+}
+
+BENCH_CASE(transforms) {
+    const int count = 100000 * Bench::scale();
+    std::vector<Shape*> shapes = Bench::makeScene(count, 4000);
+
+    double ms = Bench::measureMs([&] {
+        for (Shape* shape : shapes) shape->move(3, -2);
+    });
+    Bench::report("move", ms, count);
+
+    ms = Bench::measureMs([&] {
+        for (Shape* shape : shapes) shape->rotate(10);
+    });
+    Bench::report("rotate 10", ms, count);
+
+    ms = Bench::measureMs([&] {
+        for (Shape* shape : shapes) shape->mirror(true);
+    });
+    Bench::report("mirror", ms, count);
+
+    Bench::destroyScene(shapes);
+}
+
+// Поворот выделения из 100 тысяч вершин вокруг общего центра: по точке через
+// Point::rotateAround (синус и косинус на каждую точку) против одной матрицы
+// BatchTransform для всех вершин
+BENCH_CASE(hitTestKernels) {
+    const int shapeCount = 2000 * Bench::scale();
+    const int perShape = 64;
+    const int clicks = 200;
+
+    Bench::Random rnd(13);
+    std::vector<Vertex> packed;
+    std::vector<uint32_t> counts;
+    for (int s = 0; s < shapeCount; ++s) {
+        int cx = rnd.range(0, 4000), cy = rnd.range(0, 4000);
+        for (int k = 0; k < perShape; ++k) {
+            packed.push_back(Vertex{ cx + rnd.range(-60, 60), cy + rnd.range(-60, 60) });
+        }
+        counts.push_back(perShape);
+    }
+    std::vector<Vertex> points(clicks);
+    for (Vertex& p : points) p = Vertex{ rnd.range(0, 4000), rnd.range(0, 4000) };
+
+    // Прежняя проверка: расстояние до прямой через отрезок, с корнем и делением
+    auto nearLine = [](const Vertex& a, const Vertex& b, int x, int y) {
+        double A = b.y - a.y, B = a.x - b.x;
+        double C = (double)(b.x - a.x) * a.y - (double)(b.y - a.y) * a.x;
+        return std::abs(A * x + B * y + C) / std::sqrt(A * A + B * B) < ClickTolerance;
+    };
+
+    long long legacyHits = 0;
+    double legacyMs = Bench::measureMs([&] {
+        for (const Vertex& p : points) {
+            const Vertex* v = packed.data();
+            for (uint32_t n : counts) {
+                for (uint32_t k = 0; k + 1 < n; ++k) {
+                    if (nearLine(v[k], v[k + 1], p.x, p.y)) {
+                        ++legacyHits;
+                        break;
+                    }
+                }
+                v += n;
+            }
+        }
+    });
+    long long segments = (long long)clicks * shapeCount * (perShape - 1);
+    Bench::report("distance to infinite line, scalar", legacyMs, segments);
+
+    long long scalarHits = 0;
+    std::vector<uint8_t> expected;
+    double scalarMs = Bench::measureMs([&] {
+        for (const Vertex& p : points) {
+            const Vertex* v = packed.data();
+            for (uint32_t n : counts) {
+                bool hit = false;
+                for (uint32_t k = 0; k + 1 < n && !hit; ++k) {
+                    hit = nearSegment(v[k].x, v[k].y, v[k + 1].x, v[k + 1].y, p.x, p.y);
+                }
+                scalarHits += hit;
+                expected.push_back(hit);
+                v += n;
+            }
+        }
+    });
+    Bench::report("nearSegment, scalar", scalarMs, segments);
+
+    long long kernelHits = 0;
+    double kernelMs = Bench::measureMs([&] {
+        for (const Vertex& p : points) {
+            const Vertex* v = packed.data();
+            for (uint32_t n : counts) {
+                kernelHits += nearPolyline(v, n, p.x, p.y);
+                v += n;
+            }
+        }
+    });
+    Bench::report("nearPolyline, per shape", kernelMs, segments);
+
+    std::vector<uint8_t> hits(shapeCount), batched;
+    double batchMs = Bench::measureMs([&] {
+        for (const Vertex& p : points) {
+            nearPolylines(packed.data(), counts.data(), counts.size(), p.x, p.y, hits.data());
+            batched.insert(batched.end(), hits.begin(), hits.end());
+        }
+    });
+    Bench::report("nearPolylines, one point vs all", batchMs, segments);
+    printf("  hits: %lld to the infinite line, %lld to the segments\n", legacyHits, scalarHits);
+    Bench::check(kernelHits == scalarHits && batched == expected, "vector distance kernels match nearSegment");
+
+    // Чётность пересечений: скалярный crossesRay против ядер
+    std::vector<uint8_t> insideExpected;
+    double rayMs = Bench::measureMs([&] {
+        for (const Vertex& p : points) {
+            const Vertex* v = packed.data();
+            for (uint32_t n : counts) {
+                bool inside = false;
+                for (uint32_t i = 0, j = n - 1; i < n; j = i++) {
+                    if (crossesRay(v[i].x, v[i].y, v[j].x, v[j].y, p.x, p.y)) inside = !inside;
+                }
+                insideExpected.push_back(inside);
+                v += n;
+            }
+        }
+    });
+    Bench::report("crossesRay, scalar", rayMs, segments);
+
+    std::vector<uint8_t> insideBatched;
+    double insideMs = Bench::measureMs([&] {
+        for (const Vertex& p : points) {
+            insidePolygons(packed.data(), counts.data(), counts.size(), p.x, p.y, hits.data());
+            insideBatched.insert(insideBatched.end(), hits.begin(), hits.end());
+        }
+    });
+    Bench::report("insidePolygons, one point vs all", insideMs, segments);
+    Bench::check(insideBatched == insideExpected, "vector crossing kernel matches crossesRay");
+
+    // Много точек против одной фигуры (лассо): каждая точка сцены против контура
+    std::vector<Vertex> lasso;
+    for (int k = 0; k < 256; ++k) {
+        double angle = 2 * M_PI * k / 256;
+        double r = 1500 + 400 * sin(5 * angle);
+        lasso.push_back(Vertex{ 2000 + (int)(r * cos(angle)), 2000 + (int)(r * sin(angle)) });
+    }
+    std::vector<uint8_t> inLasso(packed.size()), nearLasso(packed.size());
+    double lassoMs = Bench::measureMs([&] {
+        insidePolygonMany(lasso.data(), lasso.size(), packed.data(), packed.size(), inLasso.data());
+    });
+    Bench::report("insidePolygonMany, lasso", lassoMs, (long long)packed.size() * lasso.size());
+    nearPolylineMany(lasso.data(), lasso.size(), packed.data(), packed.size(), nearLasso.data());
+
+    bool manyExact = true;
+    for (size_t i = 0; i < packed.size(); ++i) {
+        manyExact = manyExact && inLasso[i] == insidePolygon(lasso.data(), lasso.size(), packed[i].x, packed[i].y);
+        manyExact = manyExact && nearLasso[i] == nearPolyline(lasso.data(), lasso.size(), packed[i].x, packed[i].y);
+    }
+    Bench::check(manyExact, "many-points kernels match the single-point ones");
+
+    // Клик на продолжении отрезка больше не попадает в него
+    Line line(Point(0, 0), Point(10, 0));
+    Bench::check(line.isClicked(5, 3) && !line.isClicked(100, 0), "Line::isClicked measures distance to the segment");
+}
+
+BENCH_CASE(batchTransform) {
+    const int vertexCount = 100000 * Bench::scale();
+    const int perShape = 50;
+
+    Bench::Random rnd(5);
+    std::vector<Shape*> legacy, batched;
+    Rect area;
+    for (int i = 0; i < vertexCount / perShape; ++i) {
+        std::vector<Point> points;
+        for (int k = 0; k < perShape; ++k) {
+            points.push_back(Point(rnd.range(0, 4000), rnd.range(0, 4000)));
+        }
+        legacy.push_back(new Polyline(points));
+        batched.push_back(new Polyline(points));
+        area.unite(legacy.back()->bounds());
+    }
+    Point center((area.left + area.right) / 2, (area.top + area.bottom) / 2);
+
+    // Десять поворотов подряд, как при удержании команды: буферы уже выделены
+    const int steps = 10;
+    double legacyMs = Bench::measureMs([&] {
+        for (int step = 0; step < steps; ++step) {
+            for (Shape* shape : legacy) {
+                for (Point& p : static_cast<Polyline*>(shape)->points) {
+                    p.rotateAround(center, 10);
+                }
+            }
+        }
+    });
+    Bench::report("Point::rotateAround per vertex", legacyMs, (long long)vertexCount * steps);
+
+    BatchTransform batch;
+    Affine rotation = Affine::rotation(center.x, center.y, 10);
+    double batchMs = Bench::measureMs([&] {
+        for (int step = 0; step < steps; ++step) {
+            batch.apply(batched, rotation);
+        }
+    });
+    Bench::report("BatchTransform rotate", batchMs, (long long)vertexCount * steps);
+
+    // Только векторный цикл по плотному массиву вершин (так хранит вершины SceneStore)
+    std::vector<Vertex> packed(vertexCount);
+    for (int i = 0; i < vertexCount; ++i) packed[i] = Vertex{ rnd.range(0, 4000), rnd.range(0, 4000) };
+    double kernelMs = Bench::measureMs([&] {
+        transformVertices(rotation, packed.data(), packed.size());
+    });
+    Bench::report("transformVertices, packed", kernelMs, vertexCount);
+
+    // Ещё один поворот: векторный цикл против скалярной формулы с тем же округлением
+    std::vector<Point> snapshot;
+    for (Shape* shape : batched) {
+        const Polyline* polyline = static_cast<Polyline*>(shape);
+        snapshot.insert(snapshot.end(), polyline->points.begin(), polyline->points.end());
+    }
+    batch.apply(batched, rotation);
+
+    bool exact = true;
+    size_t index = 0;
+    for (Shape* shape : batched) {
+        for (const Point& p : static_cast<Polyline*>(shape)->points) {
+            double x, y;
+            rotation.apply(snapshot[index].x, snapshot[index].y, x, y);
+            exact = exact && p.x == (int)lrint(x) && p.y == (int)lrint(y);
+            ++index;
+        }
+    }
+    Bench::check(exact, "vectorized transform matches the scalar formula");
+
+    // Двойное отражение возвращает вершины на место
+    const Polyline* sample = static_cast<Polyline*>(batched[0]);
+    std::vector<Point> before(sample->points.begin(), sample->points.end());
+    Affine flip = Affine::mirror(center.x, center.y, true);
+    batch.apply(batched, flip);
+    batch.apply(batched, flip);
+    bool restored = true;
+    for (size_t k = 0; k < before.size(); ++k) {
+        restored = restored && sample->points[k].x == before[k].x && sample->points[k].y == before[k].y;
+    }
+    Bench::check(restored, "mirroring twice restores the vertices");
+
+    Bench::destroyScene(legacy);
+    Bench::destroyScene(batched);
+}
+
+BENCH_CASE(precisionRotate) {
+    const int count = 20000 * Bench::scale();
+    std::vector<Shape*> legacy = Bench::makeScene(count, 4000);
+    std::vector<Shape*> precise = Bench::makeScene(count, 4000);
+    for (Shape* shape : precise) {
+        shape->setPrecise(true);
+    }
+
+    // Опорные точки и габарит: углы дуги после полного оборота могут
+    // отличаться на 2*pi, габарит это учитывает
+    auto snapshot = [](const std::vector<Shape*>& shapes) {
+        std::vector<int> state;
+        std::vector<Vertex> anchors;
+        for (const Shape* shape : shapes) {
+            anchors.clear();
+            shape->writeAnchors(anchors);
+            for (const Vertex& v : anchors) {
+                state.push_back(v.x);
+                state.push_back(v.y);
+            }
+            Rect r = shape->bounds();
+            state.insert(state.end(), { r.left, r.top, r.right, r.bottom });
+        }
+        return state;
+    };
+    std::vector<int> before = snapshot(legacy);
+    Bench::check(snapshot(precise) == before, "precise scene starts equal to the legacy one");
+
+    // 36 нажатий "Rotate Selected" по 10 градусов для всего выделения
+    auto rotateFullTurn = [](const std::vector<Shape*>& shapes) {
+        BatchTransform batch;
+        for (int step = 0; step < 36; ++step) {
+            double cx = 0, cy = 0;
+            for (const Shape* shape : shapes) {
+                double x, y;
+                shape->pivot(x, y);
+                cx += x;
+                cy += y;
+            }
+            batch.apply(shapes, Affine::rotation(cx / shapes.size(), cy / shapes.size(), 10));
+        }
+    };
+
+    double legacyMs = Bench::measureMs([&] { rotateFullTurn(legacy); });
+    Bench::report("36 x 10 deg, rounded every step", legacyMs, (long long)count * 36);
+
+    double preciseMs = Bench::measureMs([&] { rotateFullTurn(precise); });
+    Bench::report("36 x 10 deg, accumulated matrix", preciseMs, (long long)count * 36);
+
+    std::vector<int> legacyAfter = snapshot(legacy);
+    long long drifted = 0;
+    for (size_t i = 0; i < before.size(); ++i) {
+        if (legacyAfter[i] != before[i]) ++drifted;
+    }
+    printf("  rounded every step: %lld of %zu coordinates drifted\n", drifted, before.size());
+    Bench::check(snapshot(precise) == before, "full turn in precision mode restores every shape");
+
+    // Треугольник вращается вокруг точного центра, а не целочисленного
+    Triangle triangle(Point(0, 0), Point(10, 0), Point(0, 10));
+    triangle.setPrecise(true);
+    for (int step = 0; step < 36; ++step) {
+        triangle.rotate(10);
+    }
+    Bench::check(triangle.points[1].x == 10 && triangle.points[2].y == 10, "Triangle::rotate full turn");
+
+    // Поворот дуги задаётся в градусах, как у остальных фигур
+    Arc arc(Point(0, 0), 10, 0, M_PI / 2);
+    arc.rotate(90);
+    Bench::check(fabs(arc.startAngle - M_PI / 2) < 1e-9 && fabs(arc.endAngle - M_PI) < 1e-9,
+        "Arc::rotate takes degrees");
+
+    Bench::destroyScene(legacy);
+    Bench::destroyScene(precise);
+}
+
+BENCH_CASE(trimPolylines) {
+    const int count = 20000 * Bench::scale();
+    Bench::Random rnd(11);
+    std::vector<Polyline*> polylines;
+    long long segments = 0;
+    for (int i = 0; i < count; ++i) {
+        std::vector<Point> points;
+        for (int k = 0; k < 64; ++k) {
+            points.push_back(Point(k * 10, rnd.range(0, 400)));
+        }
+        segments += points.size() - 1;
+        polylines.push_back(new Polyline(points));
+    }
+
+    double ms = Bench::measureMs([&] {
+        for (Polyline* polyline : polylines) {
+            polyline->trim(Point(500, -10), Point(500, 410));
+        }
+    });
+    Bench::report("Polyline::trim, vertical cut", ms, segments);
+
+    bool allCut = true;
+    for (Polyline* polyline : polylines) {
+        if (polyline->points.back().x > 500) allCut = false;
+        delete polyline;
+    }
+    Bench::check(allCut, "every polyline is cut at x = 500");
+}
+
+namespace {
+
+    uint64_t digestOf(const std::vector<Shape*>& shapes) {
+        Bench::CountingRenderer renderer;
+        for (Shape* shape : shapes) shape->draw(renderer);
+        return renderer.digest;
+    }
+
+    bool onLine(const Arc& arc, double angle, double y) {
+        return std::fabs(arc.center.y + arc.radius * std::sin(angle) - y) < 1e-6;
+    }
+
+}
+
+// Обрезка кругов, дуг, колец и треугольников в закрытой форме: что остаётся
+// с левой стороны отрезка, время на миллионе кругов, отмена через журнал
+BENCH_CASE(trimCurves) {
+    std::vector<Shape*> pieces;
+    auto take = [&](const Shape& shape, Point a, Point b) {
+        for (Shape* piece : pieces) delete piece;
+        pieces.clear();
+        return shape.trimPieces(a, b, pieces);
+    };
+
+    // Хорда y = 520 слева направо: остаётся верхняя (на экране) большая дуга
+    Circle circle(Point(500, 500), 100);
+    bool cut = take(circle, Point(300, 520), Point(700, 520));
+    const Arc* arc = pieces.size() == 1 && pieces[0]->kind() == ShapeKind::Arc ? static_cast<const Arc*>(pieces[0]) : nullptr;
+    double middle = arc ? arc->startAngle + std::fmod(arc->endAngle - arc->startAngle + 2 * M_PI, 2 * M_PI) / 2 : 0;
+    Bench::check(cut && arc && onLine(*arc, arc->startAngle, 520) && onLine(*arc, arc->endAngle, 520) &&
+        arc->center.y + arc->radius * std::sin(middle) < 500, "circle becomes the arc left of the cut");
+    take(circle, Point(700, 520), Point(300, 520));
+    arc = pieces.size() == 1 ? static_cast<const Arc*>(pieces[0]) : nullptr;
+    middle = arc ? arc->startAngle + std::fmod(arc->endAngle - arc->startAngle + 2 * M_PI, 2 * M_PI) / 2 : 0;
+    Bench::check(arc && arc->center.y + arc->radius * std::sin(middle) > 520, "reversed cut keeps the other arc");
+    Bench::check(!take(circle, Point(300, 520), Point(500, 520)), "a cut that stops inside leaves the circle");
+
+    // Дуга по нижней половине, разрез по x = 500: остаётся до середины
+    Arc half(Point(500, 500), 100, 0, M_PI);
+    half.trim(Point(500, 300), Point(500, 700));
+    Bench::check(std::fabs(half.endAngle - M_PI / 2) < 1e-9 && half.startAngle == 0, "arc ends at the first crossing");
+
+    Ring ring(Point(500, 500), 100, 50);
+    take(ring, Point(300, 520), Point(700, 520));
+    size_t arcs = std::count_if(pieces.begin(), pieces.end(), [](Shape* s) { return s->kind() == ShapeKind::Arc; });
+    Bench::check(pieces.size() == 4 && arcs == 2, "ring cut through the hole: two arcs and two edges");
+    take(ring, Point(300, 570), Point(700, 570));
+    Bench::check(pieces.size() == 3 && pieces[2]->kind() == ShapeKind::Circle, "hole on the kept side stays whole");
+
+    // Вертикальный разрез сверху вниз оставляет часть правее (слева по ходу)
+    Triangle triangle(Point(0, 0), Point(400, 0), Point(0, 400));
+    take(triangle, Point(100, -10), Point(100, 500));
+    Bench::check(pieces.size() == 1 && pieces[0]->kind() == ShapeKind::Triangle &&
+        pieces[0]->bounds().left == 100 && pieces[0]->bounds().bottom == 300, "triangle keeps its corner");
+    take(triangle, Point(100, 500), Point(100, -10));
+    Bench::check(pieces.size() == 1 && pieces[0]->kind() == ShapeKind::Polygon &&
+        static_cast<const Polygon*>(pieces[0])->points.size() == 4, "the other side is a quadrilateral");
+    Bench::check(!take(triangle, Point(100, -10), Point(100, 50)), "a cut that stops inside leaves the triangle");
+
+    const int count = 1000000 * Bench::scale();
+    Bench::Random rnd(17);
+    std::vector<Circle> circles;
+    circles.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        circles.emplace_back(Point(rnd.range(0, 1000), rnd.range(0, 1000)), rnd.range(5, 200));
+    }
+    for (Shape* piece : pieces) delete piece;
+    pieces.clear();
+    pieces.reserve(count);
+    double ms = Bench::measureMs([&] {
+        for (const Circle& c : circles) c.trimPieces(Point(-10, 480), Point(1010, 530), pieces);
+    });
+    Bench::report("Circle::trimPieces, long cut", ms, count);
+    printf("  %zu circles cut into arcs\n", pieces.size());
+    for (Shape* piece : pieces) delete piece;
+    pieces.clear();
+
+    // Замена кусками отменяется и повторяется одной правкой
+    Scene scene;
+    EditJournal journal(scene);
+    std::vector<Shape*> shapes{ new Circle(Point(500, 500), 100), new Ring(Point(800, 500), 100, 50),
+        new Triangle(Point(0, 300), Point(400, 300), Point(0, 700)), new Arc(Point(200, 500), 80, 0, M_PI) };
+    for (Shape* shape : shapes) scene.add(shape);
+    uint64_t before = digestOf(scene.getShapes());
+    journal.trim(shapes, Point(-10, 520), Point(1000, 520));
+    uint64_t after = digestOf(scene.getShapes());
+    size_t trimmedSize = scene.size();
+    journal.undo();
+    Bench::check(digestOf(scene.getShapes()) == before && scene.size() == shapes.size(), "undo brings the shapes back");
+    journal.redo();
+    Bench::check(digestOf(scene.getShapes()) == after && scene.size() == trimmedSize && trimmedSize == 7,
+        "redo puts the pieces back");
+}
+
+BENCH_CASE(drawTraversal) {
+    const int count = 100000 * Bench::scale();
+    std::vector<Shape*> shapes = Bench::makeScene(count, 4000);
+
+    Bench::CountingRenderer renderer;
+    double ms = Bench::measureMs([&] {
+        for (Shape* shape : shapes) shape->draw(renderer);
+    });
+    Bench::consume(renderer.calls);
+    Bench::report("draw into counting renderer", ms, count);
+
+    // Все фигуры чёрные: GdiRenderer выбирает перо из кэша один раз на проход,
+    // прежде на каждый setPen создавалось, выбиралось и удалялось новое перо
+    printf("  pen selects: %lld setPen calls, %lld pen changes\n", renderer.penCalls, renderer.penChanges);
+    Bench::check(renderer.penChanges == 1, "consecutive shapes of one style share a pen select");
+
+    Bench::destroyScene(shapes);
+}
+
+// Отрезки всех фигур напрямую (MoveToEx/LineTo на каждый) и через пакеты ломаных
+BENCH_CASE(batchedPolylines) {
+    const int count = 100000 * Bench::scale();
+    std::vector<Shape*> shapes = Bench::makeScene(count, 4000);
+
+    Bench::CountingRenderer direct;
+    double directMs = Bench::measureMs([&] {
+        for (Shape* shape : shapes) shape->draw(direct);
+    });
+    Bench::report("draw, segment per call", directMs, count);
+
+    Bench::CountingRenderer target;
+    long long batches = 0, vertices = 0;
+    double batchedMs = Bench::measureMs([&] {
+        BatchRenderer batch(target);
+        for (Shape* shape : shapes) shape->draw(batch);
+        batch.flush();
+        batches = batch.getBatchCount();
+        vertices = batch.getVertexCount();
+    });
+    Bench::report("draw, batched polylines", batchedMs, count);
+
+    printf("  output calls: %lld direct, %lld batched (%lld PolyPolyline batches, %lld vertices for %lld segments)\n",
+        direct.calls, target.calls, batches, vertices, direct.segments);
+
+    Bench::check(target.segments == direct.segments && target.digest == direct.digest,
+        "batched stream draws the same primitives in the same order");
+    Bench::check(vertices < direct.segments * 2, "polylines share vertices instead of MoveToEx/LineTo pairs");
+
+    // Вызовы счётчика ничего не стоят, поэтому прослойка здесь - чистая добавка;
+    // выигрыш - в числе вызовов target, у GDI каждый из них - вызов gdi32
+    printf("  batching saves %.0f%% of target calls; a free target like this one only pays for the layer\n",
+        100.0 * (direct.calls - target.calls) / direct.calls);
+
+    // Длинные ломаные подряд (как из SceneStore) проходят пакет без копии
+    const uint32_t walkLength = 5000;
+    const int walks = 200;
+    std::vector<Vertex> pool;
+    std::vector<uint32_t> walkCounts(walks, walkLength);
+    Bench::Random rnd(17);
+    for (int i = 0; i < walks * (int)walkLength; ++i) pool.push_back(Vertex{ rnd.range(0, 4000), rnd.range(0, 4000) });
+    // Лучшее из нескольких прогонов: оба пути делают одну и ту же работу.
+    // Прямой путь тоже идёт через Renderer*, как у фигур, иначе компилятор
+    // встроит счётчик в цикл и сравнит не то
+    Bench::CountingRenderer walkDirect, walkTarget;
+    Renderer* volatile directTarget = &walkDirect;
+    double walkDirectMs = 1e9, walkBatchedMs = 1e9;
+    for (int pass = 0; pass < 5; ++pass) {
+        walkDirect = Bench::CountingRenderer();
+        walkDirectMs = std::min(walkDirectMs, Bench::measureMs([&] {
+            directTarget->setPen(Pen(0));
+            directTarget->polyPolyline(pool.data(), walkCounts.data(), walks);
+        }));
+        walkTarget = Bench::CountingRenderer();
+        walkBatchedMs = std::min(walkBatchedMs, Bench::measureMs([&] {
+            BatchRenderer batch(walkTarget);
+            batch.setPen(Pen(0));
+            batch.polyPolyline(pool.data(), walkCounts.data(), walks);
+        }));
+    }
+    Bench::report("long polylines, direct", walkDirectMs, walks);
+    Bench::report("long polylines, through the batch", walkBatchedMs, walks);
+    Bench::check(walkTarget.digest == walkDirect.digest, "long polylines pass through the batch unchanged");
+
+    Bench::destroyScene(shapes);
+}
+
+BENCH_CASE(boundsCache) {
+    const int count = 100000 * Bench::scale();
+    std::vector<Shape*> shapes = Bench::makeScene(count, 4000);
+
+    long long sum = 0;
+    double firstMs = Bench::measureMs([&] {
+        for (Shape* shape : shapes) sum += shape->bounds().left;
+    });
+    Bench::report("bounds(), first call (computes)", firstMs, count);
+
+    double cachedMs = Bench::measureMs([&] {
+        for (int pass = 0; pass < 10; ++pass)
+            for (Shape* shape : shapes) sum += shape->bounds().left;
+    });
+    Bench::report("bounds(), cached", cachedMs, 10LL * count);
+    Bench::consume(sum);
+
+    // После мутаторов габарит должен совпадать с пересчитанным заново
+    bool consistent = true;
+    for (Shape* shape : shapes) {
+        shape->move(5, 7);
+        shape->rotate(10);
+        shape->mirror(true);
+        Shape* fresh = shape->copy();
+        if (fresh->bounds() != shape->bounds()) consistent = false;
+        delete fresh;
+    }
+    Bench::check(consistent, "cached bounds match recomputed bounds after move/rotate/mirror");
+
+    // Точный габарит дуги: все точки дуги внутри, а крайние касаются границ
+    bool arcsExact = true;
+    Bench::Random rnd(5);
+    for (int i = 0; i < 1000; ++i) {
+        Arc arc(Point(rnd.range(-500, 500), rnd.range(-500, 500)), rnd.range(1, 300),
+            rnd.range(0, 628) / 100.0, rnd.range(0, 628) / 100.0);
+        Rect b = arc.bounds();
+        double from = fmod(arc.startAngle + 2 * M_PI, 2 * M_PI);
+        double to = fmod(arc.endAngle + 2 * M_PI, 2 * M_PI);
+        if (to < from) to += 2 * M_PI;
+
+        Rect sampled;
+        for (int k = 0; k <= 2000; ++k) {
+            double a = from + (to - from) * k / 2000;
+            double px = arc.center.x + arc.radius * cos(a);
+            double py = arc.center.y + arc.radius * sin(a);
+            sampled.include((int)floor(px), (int)floor(py));
+            sampled.include((int)ceil(px), (int)ceil(py));
+        }
+        if (!b.contains(sampled) || (b.inflated(-1).contains(sampled) && sampled.width() > 2)) {
+            arcsExact = false;
+        }
+    }
+    Bench::check(arcsExact, "Arc bounds cover the arc and are tight");
+
+    Bench::destroyScene(shapes);
+}
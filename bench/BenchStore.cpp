@@ -0,0 +1,95 @@
+#include "BenchScene.h"
+#include "SceneStore.h"
+#include "ShapeKernels.h"
+
+using namespace MyShapes;
+
+// Миллион фигур: полный обход отрисовки и выбор кликом линейным просмотром.
+// vector<Shape*> с виртуальными вызовами против таблиц SceneStore.
+BENCH_CASE(storePaintPick) {
+    const int count = 1000000 * Bench::scale();
+    const int world = 50000;
+    const int clicks = 200;
+
+    std::vector<Shape*> shapes = Bench::makeScene(count, world);
+    SceneStore store;
+    double loadMs = Bench::measureMs([&] {
+        for (Shape* shape : shapes) store.add(*shape);
+    });
+    Bench::report("store load", loadMs, count);
+
+    Bench::CountingRenderer objects, table;
+    double objectsMs = Bench::measureMs([&] {
+        for (Shape* shape : shapes) shape->draw(objects);
+    });
+    Bench::report("paint vector<Shape*>", objectsMs, count);
+
+    double tableMs = Bench::measureMs([&] {
+        store.draw(table);
+    });
+    Bench::report("paint SceneStore", tableMs, count);
+    Bench::check(objects.digest == table.digest, "store draws the same primitives in the same order");
+
+    // Окно в 1/16 мира: почти всё время уходит на отсечение по габаритам
+    Rect viewport(0, 0, world / 4, world / 4);
+    Bench::CountingRenderer objectsView, tableView;
+    double objectsViewMs = Bench::measureMs([&] {
+        for (Shape* shape : shapes) {
+            if (shape->bounds().intersects(viewport)) shape->draw(objectsView);
+        }
+    });
+    Bench::report("viewport paint vector<Shape*>", objectsViewMs, count);
+
+    double tableViewMs = Bench::measureMs([&] {
+        store.draw(tableView, viewport);
+    });
+    Bench::report("viewport paint SceneStore", tableViewMs, count);
+    Bench::check(objectsView.digest == tableView.digest, "store culls the same shapes");
+
+    // Клик в окрестности случайной фигуры, чтобы попадания действительно были
+    Bench::Random rnd(7);
+    std::vector<Point> points;
+    for (int i = 0; i < clicks; ++i) {
+        Rect b = shapes[rnd.range(0, count - 1)]->bounds();
+        points.push_back(Point(rnd.range(b.left, b.right), rnd.range(b.top, b.bottom)));
+    }
+
+    std::vector<int> expected(clicks, -1), actual(clicks, -1);
+    double pickObjectsMs = Bench::measureMs([&] {
+        for (int i = 0; i < clicks; ++i) {
+            for (int k = count - 1; k >= 0; --k) {
+                if (shapes[k]->bounds().inflated(ClickTolerance).contains(points[i].x, points[i].y) &&
+                    shapes[k]->isClicked(points[i].x, points[i].y)) {
+                    expected[i] = k;
+                    break;
+                }
+            }
+        }
+    });
+    Bench::report("pick vector<Shape*>", pickObjectsMs, clicks);
+
+    double pickTableMs = Bench::measureMs([&] {
+        for (int i = 0; i < clicks; ++i) {
+            ShapeHandle hit = store.pick(points[i].x, points[i].y);
+            actual[i] = hit.isNull() ? -1 : (int)hit.index; // Без удалений index = номер добавления
+        }
+    });
+    Bench::report("pick SceneStore", pickTableMs, clicks);
+    Bench::check(expected == actual, "store picks the same topmost shape");
+
+    // Удаление каждой третьей фигуры и уплотнение не меняют порядок остальных
+    std::vector<ShapeHandle> handles;
+    for (int k = 0; k < count; ++k) handles.push_back(ShapeHandle((uint32_t)k, 0));
+    Bench::CountingRenderer kept, compacted;
+    for (int k = 0; k < count; ++k) {
+        if (k % 3 == 0) store.remove(handles[k]);
+        else shapes[k]->draw(kept);
+    }
+    store.compact();
+    store.draw(compacted);
+    Bench::check(kept.digest == compacted.digest, "compaction keeps the drawing order");
+    Bench::check(!store.contains(handles[0]) && store.contains(handles[1]), "removed handles become invalid");
+    Bench::check(store.bounds(handles[1]) == shapes[1]->bounds(), "handles survive compaction");
+
+    Bench::destroyScene(shapes);
+}
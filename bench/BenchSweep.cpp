@@ -0,0 +1,186 @@
+#include "BenchScene.h"
+#include "EditJournal.h"
+#include "Intersect.h"
+#include "Scene.h"
+#include "SegmentSweep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+using namespace MyShapes;
+
+namespace {
+
+    struct Segment {
+        Vertex a, b;
+    };
+
+    std::vector<Segment> randomSegments(int count, int world, int maxLength, uint64_t seed) {
+        Bench::Random rnd(seed);
+        std::vector<Segment> segments;
+        segments.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            Vertex a{ rnd.range(0, world), rnd.range(0, world) };
+            Vertex b{ a.x + rnd.range(-maxLength, maxLength), a.y + rnd.range(-maxLength, maxLength) };
+            segments.push_back(Segment{ a, b });
+        }
+        return segments;
+    }
+
+    // Пары (меньший, больший номер) пересекающихся отрезков: заметанием
+    std::vector<uint64_t> sweepPairs(SegmentSweep& sweep, const std::vector<Segment>& segments) {
+        sweep.clear();
+        for (size_t i = 0; i < segments.size(); ++i) {
+            sweep.addSegment(segments[i].a, segments[i].b, (uint32_t)i, 0);
+        }
+        std::vector<SweepCrossing> crossings;
+        sweep.run(crossings);
+        std::vector<uint64_t> pairs;
+        for (const SweepCrossing& c : crossings) {
+            uint32_t lo = std::min(c.firstOwner, c.secondOwner), hi = std::max(c.firstOwner, c.secondOwner);
+            pairs.push_back((uint64_t)lo << 32 | hi);
+        }
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+
+    // Те же пары перебором всех
+    std::vector<uint64_t> bruteForcePairs(const std::vector<Segment>& segments) {
+        std::vector<uint64_t> pairs;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            for (size_t j = i + 1; j < segments.size(); ++j) {
+                double t;
+                if (segmentCrossing(segments[i].a, segments[i].b, segments[j].a, segments[j].b, t)) {
+                    pairs.push_back((uint64_t)i << 32 | j);
+                }
+            }
+        }
+        return pairs;
+    }
+
+    uint64_t digestOf(const std::vector<Shape*>& shapes) {
+        Bench::CountingRenderer renderer;
+        for (Shape* shape : shapes) shape->draw(renderer);
+        return renderer.digest;
+    }
+
+}
+
+// Заметание против перебора пар: совпадение ответа на случайных и вырожденных
+// наборах, время на 200 000 отрезков, обрезка всех фигур, задетых отрезком
+BENCH_CASE(segmentSweep) {
+    SegmentSweep sweep;
+
+    {
+        std::vector<Segment> segments = randomSegments(4000, 5000, 300, 3);
+        std::vector<uint64_t> swept = sweepPairs(sweep, segments);
+        std::vector<uint64_t> expected = bruteForcePairs(segments);
+        printf("  4000 random segments: %zu crossings\n", expected.size());
+        Bench::check(swept == expected, "sweep finds the same pairs as brute force");
+    }
+
+    // Решётка, пучок через одну точку, касания концами и Т-образные стыки
+    {
+        std::vector<Segment> segments;
+        for (int k = 0; k < 20; ++k) {
+            segments.push_back(Segment{ { 0, k * 50 }, { 1000, k * 50 } });
+            segments.push_back(Segment{ { k * 50, 0 }, { k * 50, 1000 } });
+        }
+        for (int k = 0; k < 24; ++k) {
+            double angle = k * M_PI / 24;
+            int dx = (int)lrint(400 * cos(angle)), dy = (int)lrint(400 * sin(angle));
+            segments.push_back(Segment{ { 500 - dx, 500 - dy }, { 500 + dx, 500 + dy } });
+        }
+        segments.push_back(Segment{ { 100, 100 }, { 100, 30 } });    // Конец на узле решётки
+        segments.push_back(Segment{ { 120, 100 }, { 180, 160 } });   // Начало на горизонтали
+        segments.push_back(Segment{ { 0, 0 }, { -100, 0 } });        // Касание углом
+        std::vector<uint64_t> swept = sweepPairs(sweep, segments);
+        std::vector<uint64_t> expected = bruteForcePairs(segments);
+        Bench::check(swept == expected, "degenerate crossings match brute force");
+    }
+
+    {
+        std::vector<Segment> segments = randomSegments(200000 * Bench::scale(), 100000, 400, 9);
+        std::vector<uint64_t> swept;
+        double ms = Bench::measureMs([&] { swept = sweepPairs(sweep, segments); });
+        Bench::report("sweep 200k segments", ms, segments.size());
+        printf("  %zu crossings; brute force would test %.1e pairs\n", swept.size(),
+            segments.size() * (segments.size() - 1) / 2.0);
+    }
+
+    // Обрезка всего, что задевает отрезок: кандидаты - по индексу, задетые -
+    // проверкой каждого с отрезком; сверка - заметанием по всем кандидатам
+    {
+        const int count = 100000 * Bench::scale();
+        const int world = 20000;
+        Scene scene;
+        EditJournal journal(scene);
+        for (Shape* shape : Bench::makeScene(count, world)) scene.add(shape);
+        uint64_t initial = digestOf(scene.getShapes());
+
+        Point start(100, world / 2), end(world - 100, world / 2 + 300);
+        Rect area(start.x, start.y, start.x, start.y);
+        area.include(end.x, end.y);
+        std::vector<Shape*> candidates, crossed;
+        scene.collect(area, candidates);
+
+        double ms = Bench::measureMs([&] { crossedShapes(candidates, start, end, crossed); });
+        Bench::report("shapes crossed by a cut", ms, candidates.size());
+
+        // Рёбра сверяются одним заметанием по всем кандидатам и отрезку
+        // (оно перебирает и пересечения кандидатов между собой)
+        const uint32_t cutOwner = UINT32_MAX;
+        std::vector<SweepCrossing> crossings;
+        ms = Bench::measureMs([&] {
+            sweep.clear();
+            for (size_t i = 0; i < candidates.size(); ++i) sweep.addShape(*candidates[i], (uint32_t)i);
+            sweep.addSegment(Vertex{ start.x, start.y }, Vertex{ end.x, end.y }, cutOwner, 0);
+            sweep.run(crossings);
+        });
+        Bench::report("the same by one sweep", ms, candidates.size());
+        std::vector<uint8_t> hit(candidates.size(), 0);
+        for (const SweepCrossing& c : crossings) {
+            if (c.firstOwner == cutOwner && c.secondOwner != cutOwner) hit[c.secondOwner] = 1;
+            if (c.secondOwner == cutOwner && c.firstOwner != cutOwner) hit[c.firstOwner] = 1;
+        }
+
+        // Круги и кольца - по окружности, дуги - только в своём угловом промежутке
+        std::vector<Shape*> expected;
+        size_t arcsOffSpan = 0;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            Shape* shape = candidates[i];
+            ShapeKind kind = shape->kind();
+            const Circle* circle = kind == ShapeKind::Circle ? static_cast<const Circle*>(shape) :
+                kind == ShapeKind::Ring ? &static_cast<const Ring*>(shape)->getOuterCircle() : nullptr;
+            double t[2];
+            if (circle) {
+                hit[i] = circleCrossings(Vertex{ start.x, start.y }, Vertex{ end.x, end.y },
+                    circle->getCenter().x, circle->getCenter().y, circle->getRadius(), t) > 0;
+            }
+            if (kind == ShapeKind::Arc) {
+                const Arc* arc = static_cast<const Arc*>(shape);
+                int count = circleCrossings(Vertex{ start.x, start.y }, Vertex{ end.x, end.y },
+                    arc->center.x, arc->center.y, arc->radius, t);
+                double from = std::fmod(arc->startAngle + 2 * M_PI, 2 * M_PI);
+                double to = std::fmod(arc->endAngle + 2 * M_PI, 2 * M_PI);
+                for (int k = 0; k < count; ++k) {
+                    double x = start.x + t[k] * ((double)end.x - start.x);
+                    double y = start.y + t[k] * ((double)end.y - start.y);
+                    double angle = std::fmod(std::atan2(y - arc->center.y, x - arc->center.x) + 2 * M_PI, 2 * M_PI);
+                    if (from == to || (from < to ? angle >= from && angle <= to : angle >= from || angle <= to)) hit[i] = 1;
+                }
+                if (count > 0 && !hit[i]) ++arcsOffSpan;
+            }
+            if (hit[i]) expected.push_back(shape);
+        }
+        printf("  %zu of %zu candidates crossed, %zu arcs cross only the rest of their circle\n",
+            crossed.size(), candidates.size(), arcsOffSpan);
+        Bench::check(crossed == expected, "per-shape test picks the shapes the cut crosses");
+
+        ms = Bench::measureMs([&] { journal.trim(crossed, start, end); });
+        Bench::report("trim crossed shapes", ms, crossed.size());
+        journal.undo();
+        Bench::check(digestOf(scene.getShapes()) == initial, "multi-shape trim undoes in one step");
+    }
+}